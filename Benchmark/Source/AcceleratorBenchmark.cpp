@@ -0,0 +1,643 @@
+#include "Benchmark.h"
+#include "../../RayTracer/Source/common/math/AnimatedTransform.h"
+#include "../../RayTracer/Source/common/math/Bounds3.h"
+#include "../../RayTracer/Source/common/math/Constants.h"
+#include "../../RayTracer/Source/common/math/Mat4.h"
+#include "../../RayTracer/Source/common/math/Ray.h"
+#include "../../RayTracer/Source/common/math/Transform.h"
+#include "../../RayTracer/Source/common/math/Vec3.h"
+#include "../../RayTracer/Source/common/tool/AcceleratorStats.h"
+#include "../../RayTracer/Source/common/tool/MultiThread.h"
+#include "../../RayTracer/Source/common/tool/bvh/BVHAccelerator.h"
+#include "../../RayTracer/Source/common/tool/bvh/MotionBVHAccelerator.h"
+#include "../../RayTracer/Source/common/tool/kdtree/KDTreeAccelerator.h"
+#include "../../RayTracer/Source/core/interaction/SurfaceInteraction.h"
+#include "../../RayTracer/Source/core/primitive/Primitive.h"
+#include "../../RayTracer/Source/core/primitive/TransformedPrimitive.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+// Compares KDTreeAccelerator with BVHAccelerator for each split method and
+// with MotionBVHAccelerator on the same primitives. Scenes are spheres of
+// widely varying size, either scattered evenly through the scene, half of
+// them in dense clusters, or moving and spinning while the shutter is open
+// through TransformedPrimitive, or the triangles of an OBJ file. Rays are
+// given random times over the shutter interval [0, 1]. For every accelerator it reports the build
+// time and the shape of the result (memory, nodes, primitive references,
+// SAH cost), then rays per second on all threads for closest hit
+// (Intersect) and any hit (IntersectP), with coherent camera rays and with
+// incoherent rays of random origin and direction. Nodes visited and
+// primitives tested per ray are counted in a separate untimed pass through
+// the accelerators' CountTraversal traversals, so the timed passes run the
+// same code as the renderer.
+//
+//     Benchmark accelerator [--scene uniform|clustered|moving|file.obj]
+//         [--prims n[,n...]] [--rays n] [--seconds s]
+//
+// Without _--scene_ the three sphere scenes are measured, at each of the _--prims_
+// sizes.
+
+
+// The intersection routines only find t; no interaction is filled in, so
+// the one a TransformedPrimitive maps to world space is left as it was
+class SpherePrimitive : public core::primitive::Primitive
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    SpherePrimitive(const common::math::Vec3f &center, Float radius)
+        : center(center), radius(radius)
+    {}
+
+
+    common::math::Bounds3f WorldBound() const
+    {
+        return common::math::Bounds3f(center - common::math::Vec3f(radius), center + common::math::Vec3f(radius));
+    }
+
+    bool Intersect(const common::math::Rayf &r, core::interaction::SurfaceInteraction *) const
+    {
+        Float tHit;
+        if (!hit(r, &tHit))
+        {
+            return false;
+        }
+        r.t_max = tHit;
+        return true;
+    }
+
+    bool IntersectP(const common::math::Rayf &r) const
+    {
+        Float tHit;
+        return hit(r, &tHit);
+    }
+
+    const core::light::AreaLight *GetAreaLight() const
+    {
+        return nullptr;
+    }
+
+    const core::material::Material *GetMaterial() const
+    {
+        return nullptr;
+    }
+
+    void ComputeScatteringFunctions(core::interaction::SurfaceInteraction *isect,
+        common::tool::MemoryArena &arena,
+        core::material::TransportMode mode,
+        bool allowMultipleLobes) const
+    {}
+
+private:
+
+    bool hit(const common::math::Rayf &r, Float *tHit) const
+    {
+        common::math::Vec3f oc = r.origin - center;
+        Float a = Dot(r.dir, r.dir);
+        Float b = Dot(oc, r.dir);
+        Float c = Dot(oc, oc) - radius * radius;
+        Float discriminant = b * b - a * c;
+        if (discriminant < FLOAT_0)
+        {
+            return false;
+        }
+        Float root = std::sqrt(discriminant);
+        Float t = (-b - root) / a;
+        if (t <= FLOAT_0)
+        {
+            t = (-b + root) / a;
+        }
+        if (t <= FLOAT_0 || t >= r.t_max)
+        {
+            return false;
+        }
+        *tHit = t;
+        return true;
+    }
+
+
+    common::math::Vec3f center;
+    Float radius;
+};
+
+
+// Moller-Trumbore, with the same interface as SpherePrimitive
+class TrianglePrimitive : public core::primitive::Primitive
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    TrianglePrimitive(const common::math::Vec3f &p0, const common::math::Vec3f &p1, const common::math::Vec3f &p2)
+        : p0(p0), e1(p1 - p0), e2(p2 - p0)
+    {}
+
+
+    common::math::Bounds3f WorldBound() const
+    {
+        return Union(common::math::Bounds3f(p0, p0 + e1), p0 + e2);
+    }
+
+    bool Intersect(const common::math::Rayf &r, core::interaction::SurfaceInteraction *) const
+    {
+        Float tHit;
+        if (!hit(r, &tHit))
+        {
+            return false;
+        }
+        r.t_max = tHit;
+        return true;
+    }
+
+    bool IntersectP(const common::math::Rayf &r) const
+    {
+        Float tHit;
+        return hit(r, &tHit);
+    }
+
+    const core::light::AreaLight *GetAreaLight() const
+    {
+        return nullptr;
+    }
+
+    const core::material::Material *GetMaterial() const
+    {
+        return nullptr;
+    }
+
+    void ComputeScatteringFunctions(core::interaction::SurfaceInteraction *isect,
+        common::tool::MemoryArena &arena,
+        core::material::TransportMode mode,
+        bool allowMultipleLobes) const
+    {}
+
+private:
+
+    bool hit(const common::math::Rayf &r, Float *tHit) const
+    {
+        common::math::Vec3f pvec = Cross(r.dir, e2);
+        Float det = Dot(e1, pvec);
+        if (FLOAT_0 == det)
+        {
+            return false;
+        }
+        Float invDet = FLOAT_1 / det;
+        common::math::Vec3f tvec = r.origin - p0;
+        Float u = Dot(tvec, pvec) * invDet;
+        if (u < FLOAT_0 || u > FLOAT_1)
+        {
+            return false;
+        }
+        common::math::Vec3f qvec = Cross(tvec, e1);
+        Float v = Dot(r.dir, qvec) * invDet;
+        if (v < FLOAT_0 || u + v > FLOAT_1)
+        {
+            return false;
+        }
+        Float t = Dot(e2, qvec) * invDet;
+        if (t <= FLOAT_0 || t >= r.t_max)
+        {
+            return false;
+        }
+        *tHit = t;
+        return true;
+    }
+
+
+    common::math::Vec3f p0, e1, e2;
+};
+
+
+typedef std::vector<std::shared_ptr<core::primitive::Primitive>> PrimitiveList;
+
+static PrimitiveList makeSpheres(int count, bool clustered)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<Float> uniform(FLOAT_0, FLOAT_1);
+    std::normal_distribution<Float> normal(FLOAT_0, FLOAT_1);
+    auto uniformPoint = [&]()
+    {
+        return common::math::Vec3f(uniform(rng), uniform(rng), uniform(rng)) * static_cast<Float>(100.0F);
+    };
+
+    const int clusterNumber = 16;
+    std::vector<common::math::Vec3f> clusters;
+    for (int i = 0; i < clusterNumber; ++i)
+    {
+        clusters.push_back(uniformPoint());
+    }
+
+    // Radii are log-uniform over three orders of magnitude
+    PrimitiveList spheres;
+    spheres.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        Float radius = static_cast<Float>(0.01F) * std::pow(static_cast<Float>(1000.0F), uniform(rng));
+        common::math::Vec3f center;
+        if (!clustered || 0 == (i & 1))
+        {
+            center = uniformPoint();
+        }
+        else
+        {
+            center = clusters[i / 2 % clusterNumber] +
+                common::math::Vec3f(normal(rng), normal(rng), normal(rng)) * static_cast<Float>(2.0F);
+            radius *= static_cast<Float>(0.1F);
+        }
+        spheres.push_back(std::make_shared<SpherePrimitive>(center, radius));
+    }
+    return spheres;
+}
+
+// Translation by _c_ after a rotation of _theta_ radians about z, with its
+// inverse written out rather than computed
+static common::math::Transformf translateRotateZ(const common::math::Vec3f &c, Float theta)
+{
+    Float cosTheta = std::cos(theta), sinTheta = std::sin(theta);
+    common::math::Mat4<Float> m(cosTheta, -sinTheta, FLOAT_0, c.x,
+        sinTheta, cosTheta, FLOAT_0, c.y,
+        FLOAT_0, FLOAT_0, FLOAT_1, c.z,
+        FLOAT_0, FLOAT_0, FLOAT_0, FLOAT_1);
+    common::math::Mat4<Float> inverse(cosTheta, sinTheta, FLOAT_0, -(cosTheta * c.x + sinTheta * c.y),
+        -sinTheta, cosTheta, FLOAT_0, sinTheta * c.x - cosTheta * c.y,
+        FLOAT_0, FLOAT_0, FLOAT_1, -c.z,
+        FLOAT_0, FLOAT_0, FLOAT_0, FLOAT_1);
+    return common::math::Transformf(m, inverse);
+}
+
+// Spheres sized and scattered as in the uniform scene, each circling a
+// pivot at up to twice its radius and turning up to a quarter turn about
+// it while the pivot moves up to 5 along each axis. The AnimatedTransforms
+// point into _transforms_, which must outlive the primitives.
+static PrimitiveList makeMovingSpheres(int count, std::vector<common::math::Transformf> *transforms)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<Float> uniform(FLOAT_0, FLOAT_1);
+    std::uniform_real_distribution<Float> velocity(static_cast<Float>(-5.0F), static_cast<Float>(5.0F));
+    const Float quarterTurn = static_cast<Float>(0.5F * 3.14159265F);
+
+    transforms->clear();
+    transforms->reserve(2 * count);
+    PrimitiveList spheres;
+    spheres.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        Float radius = static_cast<Float>(0.01F) * std::pow(static_cast<Float>(1000.0F), uniform(rng));
+        common::math::Vec3f pivot = common::math::Vec3f(uniform(rng), uniform(rng), uniform(rng))
+            * static_cast<Float>(100.0F);
+        common::math::Vec3f move(velocity(rng), velocity(rng), velocity(rng));
+        Float theta = quarterTurn * uniform(rng);
+        Float spin = quarterTurn * uniform(rng);
+        Float orbit = FLOAT_2 * radius * uniform(rng);
+        transforms->push_back(translateRotateZ(pivot, theta));
+        transforms->push_back(translateRotateZ(pivot + move, theta + spin));
+        common::math::AnimatedTransformf motion(&(*transforms)[2 * i], FLOAT_0, &(*transforms)[2 * i + 1], FLOAT_1);
+        spheres.push_back(std::make_shared<core::primitive::TransformedPrimitive>(
+            std::make_shared<SpherePrimitive>(common::math::Vec3f(orbit, FLOAT_0, FLOAT_0), radius), motion));
+    }
+    return spheres;
+}
+
+// Vertices and faces of _filename_, with faces of more than three vertices
+// split into fans; everything else in the file is skipped
+static PrimitiveList loadObj(const char *filename)
+{
+    PrimitiveList triangles;
+    FILE *file = fopen(filename, "r");
+    if (nullptr == file)
+    {
+        return triangles;
+    }
+    std::vector<common::math::Vec3f> vertices;
+    char line[1024];
+    while (nullptr != fgets(line, sizeof(line), file))
+    {
+        if ('v' == line[0] && ' ' == line[1])
+        {
+            float x, y, z;
+            if (3 == sscanf(line + 2, "%f %f %f", &x, &y, &z))
+            {
+                vertices.push_back(common::math::Vec3f(x, y, z));
+            }
+        }
+        else if ('f' == line[0] && ' ' == line[1])
+        {
+            // Each corner is v, v/vt, v//vn or v/vt/vn; negative indices
+            // count back from the latest vertex
+            std::vector<int> face;
+            char *token = strtok(line + 2, " \t\r\n");
+            while (nullptr != token)
+            {
+                int index = atoi(token);
+                index = index < 0 ? static_cast<int>(vertices.size()) + index : index - 1;
+                if (index >= 0 && index < static_cast<int>(vertices.size()))
+                {
+                    face.push_back(index);
+                }
+                token = strtok(nullptr, " \t\r\n");
+            }
+            for (size_t i = 2; i < face.size(); ++i)
+            {
+                triangles.push_back(std::make_shared<TrianglePrimitive>(
+                    vertices[face[0]], vertices[face[i - 1]], vertices[face[i]]));
+            }
+        }
+    }
+    fclose(file);
+    return triangles;
+}
+
+
+// Camera rays from outside _bounds_ that cover it, in 8 x 8 pixel tiles as
+// a tile renderer would trace them
+static std::vector<common::math::Rayf> makeCoherentRays(const common::math::Bounds3f &bounds, int count)
+{
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<Float> uniform(FLOAT_0, FLOAT_1);
+    int res = (std::max)(8, static_cast<int>(std::sqrt(static_cast<double>(count))) / 8 * 8);
+    common::math::Vec3f center = (bounds.point_min + bounds.point_max) * FLOAT_INV_2;
+    Float radius = Length(bounds.Diagonal()) * FLOAT_INV_2;
+    common::math::Vec3f forward = Normalize(common::math::Vec3f(static_cast<Float>(-0.3F),
+        static_cast<Float>(-0.2F), FLOAT_1));
+    common::math::Vec3f eye = center - forward * (static_cast<Float>(2.5F) * radius);
+    common::math::Vec3f right = Normalize(Cross(common::math::Vec3f(FLOAT_0, FLOAT_1, FLOAT_0), forward));
+    common::math::Vec3f up = Cross(forward, right);
+    Float tanHalfFov = static_cast<Float>(0.45F);
+
+    std::vector<common::math::Rayf> rays;
+    rays.reserve(res * res);
+    for (int tileY = 0; tileY < res; tileY += 8)
+    {
+        for (int tileX = 0; tileX < res; tileX += 8)
+        {
+            for (int y = tileY; y < tileY + 8; ++y)
+            {
+                for (int x = tileX; x < tileX + 8; ++x)
+                {
+                    Float sx = (FLOAT_2 * (x + FLOAT_INV_2) / res - FLOAT_1) * tanHalfFov;
+                    Float sy = (FLOAT_2 * (y + FLOAT_INV_2) / res - FLOAT_1) * tanHalfFov;
+                    rays.push_back(common::math::Rayf(eye, Normalize(forward + right * sx + up * sy),
+                        (std::numeric_limits<Float>::max)(), FLOAT_0, uniform(rng)));
+                }
+            }
+        }
+    }
+    return rays;
+}
+
+// Rays starting anywhere in _bounds_ in any direction, like the bounces of
+// a path tracer
+static std::vector<common::math::Rayf> makeIncoherentRays(const common::math::Bounds3f &bounds, int count)
+{
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<Float> uniform(FLOAT_0, FLOAT_1);
+    std::vector<common::math::Rayf> rays;
+    rays.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        common::math::Vec3f origin = bounds.Lerp(common::math::Vec3f(uniform(rng), uniform(rng), uniform(rng)));
+        Float z = FLOAT_1 - FLOAT_2 * uniform(rng);
+        Float r = std::sqrt((std::max)(FLOAT_0, FLOAT_1 - z * z));
+        Float phi = static_cast<Float>(2.0F * 3.14159265F) * uniform(rng);
+        rays.push_back(common::math::Rayf(origin, common::math::Vec3f(r * std::cos(phi), r * std::sin(phi), z),
+            (std::numeric_limits<Float>::max)(), FLOAT_0, uniform(rng)));
+    }
+    return rays;
+}
+
+
+// Rays of _rays_ traced per second on all threads, and the work per ray
+struct TraceResult
+{
+    double raysPerSecond;
+    double nodesPerRay;
+    double primitivesPerRay;
+};
+
+static void traceAll(const core::primitive::Primitive &accelerator, const std::vector<common::math::Rayf> &rays,
+    bool anyHit)
+{
+    const int chunkSize = 1024;
+    int64_t chunks = (rays.size() + chunkSize - 1) / chunkSize;
+    std::atomic<int64_t> hits(0);
+    common::tool::ParallelFor([&](int64_t chunk)
+    {
+        size_t end = (std::min)(rays.size(), static_cast<size_t>((chunk + 1) * chunkSize));
+        int chunkHits = 0;
+        core::interaction::SurfaceInteraction isect;
+        for (size_t i = chunk * chunkSize; i < end; ++i)
+        {
+            // Intersect() shortens the ray, so each pass traces a copy
+            common::math::Rayf ray = rays[i];
+            chunkHits += anyHit ? accelerator.IntersectP(ray) : accelerator.Intersect(ray, &isect);
+        }
+        hits += chunkHits;
+    }, chunks);
+    DoNotOptimize(static_cast<Float>(hits.load()));
+}
+
+template <typename Accelerator>
+static TraceResult benchmarkTrace(const Accelerator &accelerator, const std::vector<common::math::Rayf> &rays,
+    bool anyHit, double seconds)
+{
+    TraceResult result = {};
+    result.raysPerSecond = MeasureRate([&]()
+    {
+        traceAll(accelerator, rays, anyHit);
+    }, rays.size(), seconds);
+
+    common::tool::InitAcceleratorStats();
+    common::tool::ParallelFor([&](int64_t i)
+    {
+        common::math::Rayf ray = rays[i];
+        core::interaction::SurfaceInteraction isect;
+        common::tool::CountTraversal count;
+        if (anyHit)
+        {
+            accelerator.IntersectP(ray, count);
+        }
+        else
+        {
+            accelerator.Intersect(ray, &isect, count);
+        }
+    }, rays.size(), 1024);
+    common::tool::AcceleratorTraversalStats stats = common::tool::GetAcceleratorStats();
+    common::tool::CleanupAcceleratorStats();
+    result.nodesPerRay = static_cast<double>(stats.nodesVisited) / stats.rays;
+    result.primitivesPerRay = static_cast<double>(stats.primitivesTested) / stats.rays;
+    return result;
+}
+
+template <typename Accelerator>
+static void benchmarkAccelerator(const char *name, const std::function<Accelerator *()> &build,
+    const std::vector<common::math::Rayf> rays[2], int primitiveNumber, double seconds)
+{
+    // Builds are slow enough that timing a single one is accurate
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::unique_ptr<Accelerator> accelerator(build());
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    common::tool::AcceleratorStructureStats stats = accelerator->StructureStats();
+    printf("  %-10s  build %9.2f ms  %8.2f MB  %9lld nodes  %5.2f refs/prim  SAH cost %8.2f\n", name,
+        1e3 * buildSeconds, stats.bytes / (1024.0 * 1024.0), static_cast<long long>(stats.nodes),
+        static_cast<double>(stats.primitiveReferences) / primitiveNumber, static_cast<double>(stats.sahCost));
+
+    static const char *rayNames[] = { "coherent", "incoherent" };
+    for (int r = 0; r < 2; ++r)
+    {
+        for (int anyHit = 0; anyHit < 2; ++anyHit)
+        {
+            TraceResult result = benchmarkTrace(*accelerator, rays[r], 0 != anyHit, seconds);
+            printf("  %-10s  %-10s %-7s  %8.2f Mrays/s  %8.2f nodes  %8.2f prims per ray\n", "", rayNames[r],
+                anyHit ? "any" : "closest", result.raysPerSecond * 1e-6, result.nodesPerRay, result.primitivesPerRay);
+        }
+    }
+}
+
+static void benchmarkScene(const char *sceneName, const PrimitiveList &primitives, int rayNumber, double seconds)
+{
+    common::math::Bounds3f bounds;
+    for (const std::shared_ptr<core::primitive::Primitive> &primitive : primitives)
+    {
+        bounds = Union(bounds, primitive->WorldBound());
+    }
+    std::vector<common::math::Rayf> rays[2] =
+    {
+        makeCoherentRays(bounds, rayNumber), makeIncoherentRays(bounds, rayNumber)
+    };
+    printf("%s, %d primitives, %d threads\n", sceneName, static_cast<int>(primitives.size()),
+        common::tool::MaxThreadIndex());
+
+    benchmarkAccelerator<common::tool::kdtree::KDTreeAccelerator>("kdtree", [&]()
+    {
+        return new common::tool::kdtree::KDTreeAccelerator(primitives);
+    }, rays, primitives.size(), seconds);
+
+    typedef common::tool::bvh::BVHAccelerator BVH;
+    static const BVH::SplitMethod splitMethods[] =
+    {
+        BVH::SplitMethod::SAH, BVH::SplitMethod::HLBVH, BVH::SplitMethod::Middle, BVH::SplitMethod::EqualCounts
+    };
+    static const char *splitNames[] = { "bvh sah", "bvh hlbvh", "bvh middle", "bvh equal" };
+    for (int s = 0; s < 4; ++s)
+    {
+        benchmarkAccelerator<BVH>(splitNames[s], [&]()
+        {
+            return new BVH(primitives, 4, splitMethods[s]);
+        }, rays, primitives.size(), seconds);
+    }
+
+    benchmarkAccelerator<common::tool::bvh::MotionBVHAccelerator>("motion bvh", [&]()
+    {
+        return new common::tool::bvh::MotionBVHAccelerator(primitives, FLOAT_0, FLOAT_1, 4);
+    }, rays, primitives.size(), seconds);
+}
+
+int RunAcceleratorBenchmark(int argc, char *argv[])
+{
+    const char *scene = nullptr;
+    std::vector<int> counts;
+    int rayNumber = 1 << 18;
+    double seconds = 1.0;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--scene") && i + 1 < argc)
+        {
+            scene = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--prims") && i + 1 < argc)
+        {
+            char *p = argv[++i];
+            do
+            {
+                counts.push_back(static_cast<int>(strtol(p, &p, 10)));
+            }
+            while (',' == *p++);
+            if ('\0' != p[-1])
+            {
+                fprintf(stderr, "Benchmark accelerator: bad primitive counts \"%s\"\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (0 == strcmp(argv[i], "--rays") && i + 1 < argc)
+        {
+            rayNumber = atoi(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "--seconds") && i + 1 < argc)
+        {
+            seconds = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: Benchmark accelerator [--scene uniform|clustered|moving|file.obj] [--prims n[,n...]] "
+                "[--rays n] [--seconds s]\n");
+            return 1;
+        }
+    }
+    if (counts.empty())
+    {
+        counts.push_back(1 << 16);
+    }
+    for (int count : counts)
+    {
+        if (count <= 0)
+        {
+            fprintf(stderr, "Benchmark accelerator: primitive counts must be positive\n");
+            return 1;
+        }
+    }
+    if (rayNumber <= 0)
+    {
+        fprintf(stderr, "Benchmark accelerator: ray count must be positive\n");
+        return 1;
+    }
+
+    common::tool::ParallelInit();
+    int result = 0;
+    if (nullptr != scene && 0 != strcmp(scene, "uniform") && 0 != strcmp(scene, "clustered")
+        && 0 != strcmp(scene, "moving"))
+    {
+        PrimitiveList triangles = loadObj(scene);
+        if (triangles.empty())
+        {
+            fprintf(stderr, "Benchmark accelerator: no triangles in \"%s\"\n", scene);
+            result = 1;
+        }
+        else
+        {
+            benchmarkScene(scene, triangles, rayNumber, seconds);
+        }
+    }
+    else
+    {
+        static const char *sceneNames[] = { "uniform", "clustered", "moving" };
+        for (int count : counts)
+        {
+            for (int s = 0; s < 3; ++s)
+            {
+                if (nullptr != scene && 0 != strcmp(scene, sceneNames[s]))
+                {
+                    continue;
+                }
+                std::vector<common::math::Transformf> transforms;
+                PrimitiveList spheres = 2 == s ? makeMovingSpheres(count, &transforms) : makeSpheres(count, 1 == s);
+                benchmarkScene(sceneNames[s], spheres, rayNumber, seconds);
+            }
+        }
+    }
+    common::tool::ParallelCleanup();
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../../RayTracer/Source/ForwardDeclaration.h"
+#include <cstdint>
+#include <functional>
+
+
+// Calls _func_, which performs _opsPerCall_ operations, until at least
+// _minSeconds_ have passed and returns the operations per second of the
+// fastest call
+double MeasureRate(const std::function<void()> &func, int64_t opsPerCall, double minSeconds);
+
+// Keeps the compiler from discarding a result that is otherwise unused
+void DoNotOptimize(Float value);
+
+
+int RunTextureBenchmark(int argc, char *argv[]);
+
+int RunSpectrumBenchmark(int argc, char *argv[]);
+
+int RunAcceleratorBenchmark(int argc, char *argv[]);
\ No newline at end of file
@@ -0,0 +1,330 @@
+#include "Benchmark.h"
+#include "../../RayTracer/Source/common/math/Constants.h"
+#include "../../RayTracer/Source/core/color/CoefficientSpectrum.h"
+#include "../../RayTracer/Source/core/color/RGBToSpectrumTable.h"
+#include "../../RayTracer/Source/core/color/SampledSpectrum.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+// Measures CoefficientSpectrum against a plain per-sample loop on the
+// operations a path tracer runs at every vertex: the throughput update
+// beta *= f * AbsDot(wi, n) / pdf, L += beta * Le and the IsBlack() and
+// MaxComponentValue() tests, for RGB, hero wavelength and binned sizes.
+// Also compares SampledSpectrum::FromRGB() with the Smits basis spectra
+// against the sigmoid polynomial table, read from _--table_ or fitted at a
+// low resolution when none is given.
+//
+//     Benchmark spectrum [--seconds s] [--table file.spec]
+
+
+// CoefficientSpectrum as it was before it used SIMD lanes
+template <int N>
+class ScalarSpectrum
+{
+public:
+    static const int SAMPLE_NUMBER = N;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    ScalarSpectrum(Float v = FLOAT_0)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            c[i] = v;
+        }
+    }
+
+
+    Float &operator[](size_t i)
+    {
+        return c[i];
+    }
+
+    bool IsBlack() const
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            if (FLOAT_0 != c[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Float MaxComponentValue() const
+    {
+        Float m = c[0];
+        for (int i = 1; i < N; ++i)
+        {
+            m = (std::max)(m, c[i]);
+        }
+        return m;
+    }
+
+    ScalarSpectrum &operator+=(const ScalarSpectrum &s2)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            c[i] += s2.c[i];
+        }
+        return *this;
+    }
+
+    ScalarSpectrum &operator*=(const ScalarSpectrum &s2)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            c[i] *= s2.c[i];
+        }
+        return *this;
+    }
+
+    ScalarSpectrum operator*(const ScalarSpectrum &s2) const
+    {
+        ScalarSpectrum ret = *this;
+        for (int i = 0; i < N; ++i)
+        {
+            ret.c[i] *= s2.c[i];
+        }
+        return ret;
+    }
+
+    ScalarSpectrum operator*(Float a) const
+    {
+        ScalarSpectrum ret = *this;
+        for (int i = 0; i < N; ++i)
+        {
+            ret.c[i] *= a;
+        }
+        return ret;
+    }
+
+    ScalarSpectrum operator/(Float a) const
+    {
+        ScalarSpectrum ret = *this;
+        for (int i = 0; i < N; ++i)
+        {
+            ret.c[i] /= a;
+        }
+        return ret;
+    }
+
+private:
+    Float c[N];
+};
+
+
+struct VertexSample
+{
+    Float cosTheta, pdf;
+};
+
+static const int VERTEX_NUMBER = 4096;
+
+// Vertices per path; beta starts over at one after each path
+static const int PATH_LENGTH = 8;
+
+template <typename S>
+static std::vector<S> makeSpectra(std::mt19937 &rng, Float low, Float high)
+{
+    std::uniform_real_distribution<Float> uniform(low, high);
+    std::vector<S> spectra(VERTEX_NUMBER);
+    for (S &s : spectra)
+    {
+        for (int i = 0; i < S::SAMPLE_NUMBER; ++i)
+        {
+            s[i] = uniform(rng);
+        }
+    }
+    return spectra;
+}
+
+// Runs the per-vertex work over every sample once; _Fused_ selects the
+// single pass MulScaled() / AddProduct() forms
+template <typename S, bool Fused>
+struct VertexLoop;
+
+template <typename S>
+struct VertexLoop<S, false>
+{
+    static Float Run(const std::vector<S> &f, const std::vector<S> &Le, const std::vector<VertexSample> &samples)
+    {
+        S L(FLOAT_0), beta(FLOAT_1);
+        Float m = FLOAT_0;
+        for (int k = 0; k < VERTEX_NUMBER; ++k)
+        {
+            beta *= f[k] * samples[k].cosTheta / samples[k].pdf;
+            L += beta * Le[k];
+            if (beta.IsBlack() || PATH_LENGTH - 1 == (k % PATH_LENGTH))
+            {
+                beta = S(FLOAT_1);
+            }
+            m += beta.MaxComponentValue();
+        }
+        return m + L.MaxComponentValue();
+    }
+};
+
+template <typename S>
+struct VertexLoop<S, true>
+{
+    static Float Run(const std::vector<S> &f, const std::vector<S> &Le, const std::vector<VertexSample> &samples)
+    {
+        S L(FLOAT_0), beta(FLOAT_1);
+        Float m = FLOAT_0;
+        for (int k = 0; k < VERTEX_NUMBER; ++k)
+        {
+            beta.MulScaled(f[k], samples[k].cosTheta / samples[k].pdf);
+            L.AddProduct(beta, Le[k]);
+            if (beta.IsBlack() || PATH_LENGTH - 1 == (k % PATH_LENGTH))
+            {
+                beta = S(FLOAT_1);
+            }
+            m += beta.MaxComponentValue();
+        }
+        return m + L.MaxComponentValue();
+    }
+};
+
+template <typename S, bool Fused>
+static double measure(const std::vector<VertexSample> &samples, double seconds)
+{
+    std::mt19937 rng(11);
+    std::vector<S> f = makeSpectra<S>(rng, static_cast<Float>(0.5F), static_cast<Float>(1.5F));
+    std::vector<S> Le = makeSpectra<S>(rng, FLOAT_0, FLOAT_1);
+    return MeasureRate([&]()
+    {
+        DoNotOptimize(VertexLoop<S, Fused>::Run(f, Le, samples));
+    }, VERTEX_NUMBER, seconds);
+}
+
+template <int N>
+static void benchmarkSize(const char *name, const std::vector<VertexSample> &samples, double seconds)
+{
+    typedef core::color::CoefficientSpectrum<N> Spectrum;
+    double scalarRate = measure<ScalarSpectrum<N>, false>(samples, seconds);
+    double simdRate = measure<Spectrum, false>(samples, seconds);
+    double fusedRate = measure<Spectrum, true>(samples, seconds);
+    printf("%-6s %3d samples (%3d padded)  scalar %8.2f M/s  simd %8.2f M/s (%.2fx)  fused %8.2f M/s (%.2fx)\n",
+        name, N, Spectrum::PADDED_SAMPLE_NUMBER, scalarRate * 1e-6, simdRate * 1e-6, simdRate / scalarRate,
+        fusedRate * 1e-6, fusedRate / scalarRate);
+}
+
+// Conversions per second and the mean ToRGB() round trip error
+static double measureFromRGB(const std::vector<Float> &rgb, double seconds, double *meanError)
+{
+    const int count = static_cast<int>(rgb.size() / 3);
+    *meanError = 0.0;
+    for (int k = 0; k < count; ++k)
+    {
+        Float out[3];
+        core::color::SampledSpectrum::FromRGB(&rgb[3 * k]).ToRGB(out);
+        for (int j = 0; j < 3; ++j)
+        {
+            *meanError += std::abs(out[j] - rgb[3 * k + j]);
+        }
+    }
+    *meanError /= 3 * count;
+
+    return MeasureRate([&]()
+    {
+        Float sum = FLOAT_0;
+        for (int k = 0; k < count; ++k)
+        {
+            sum += core::color::SampledSpectrum::FromRGB(&rgb[3 * k])[k % SPECTRAL_SAMPLES_NUMBER];
+        }
+        DoNotOptimize(sum);
+    }, count, seconds);
+}
+
+static void benchmarkFromRGB(const char *tableFile, double seconds)
+{
+    std::unique_ptr<core::color::RGBToSpectrumTable> table;
+    if (tableFile)
+    {
+        table = core::color::RGBToSpectrumTable::Read(tableFile);
+        if (!table)
+        {
+            fprintf(stderr, "unable to read \"%s\", fitting a table instead\n", tableFile);
+        }
+    }
+    if (!table)
+    {
+        table = core::color::RGBToSpectrumTable::Optimize(16);
+    }
+
+    core::color::SampledSpectrum::Init();
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<Float> uniform(FLOAT_0, FLOAT_1);
+    std::vector<Float> rgb(3 * VERTEX_NUMBER);
+    for (Float &v : rgb)
+    {
+        v = uniform(rng);
+    }
+
+    double smitsError, tableError;
+    core::color::SetRGBToSpectrumTable(nullptr);
+    double smitsRate = measureFromRGB(rgb, seconds, &smitsError);
+    int resolution = table->Resolution();
+    core::color::SetRGBToSpectrumTable(std::move(table));
+    double tableRate = measureFromRGB(rgb, seconds, &tableError);
+    core::color::SetRGBToSpectrumTable(nullptr);
+
+    printf("FromRGB, %d bins: smits %8.2f M/s (error %.4f)  table %d^3 %8.2f M/s (error %.4f)\n",
+        SPECTRAL_SAMPLES_NUMBER, smitsRate * 1e-6, smitsError, resolution, tableRate * 1e-6, tableError);
+}
+
+int RunSpectrumBenchmark(int argc, char *argv[])
+{
+    double seconds = 1.0;
+    const char *tableFile = nullptr;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--seconds") && i + 1 < argc)
+        {
+            seconds = atof(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "--table") && i + 1 < argc)
+        {
+            tableFile = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: Benchmark spectrum [--seconds s] [--table file.spec]\n");
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<Float> uniform(static_cast<Float>(0.05F), FLOAT_1);
+    std::vector<VertexSample> samples(VERTEX_NUMBER);
+    for (VertexSample &sample : samples)
+    {
+        sample.cosTheta = uniform(rng);
+        sample.pdf = sample.cosTheta;
+    }
+
+#if defined(SPECTRUM_AVX)
+    printf("AVX lanes, path vertex updates per second\n");
+#elif defined(SPECTRUM_SSE)
+    printf("SSE lanes, path vertex updates per second\n");
+#else
+    printf("scalar lanes, path vertex updates per second\n");
+#endif
+    benchmarkSize<3>("rgb", samples, seconds);
+    benchmarkSize<4>("hero", samples, seconds);
+    benchmarkSize<8>("hero", samples, seconds);
+    benchmarkSize<16>("binned", samples, seconds);
+    benchmarkSize<SPECTRAL_SAMPLES_NUMBER>("binned", samples, seconds);
+    benchmarkFromRGB(tableFile, seconds);
+    return 0;
+}
\ No newline at end of file
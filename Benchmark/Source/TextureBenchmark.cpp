@@ -0,0 +1,181 @@
+#include "Benchmark.h"
+#include "../../RayTracer/Source/common/math/Constants.h"
+#include "../../RayTracer/Source/common/math/Vec2.h"
+#include "../../RayTracer/Source/common/tool/MIPMap.h"
+#include "../../RayTracer/Source/common/tool/MultiThread.h"
+#include "../../RayTracer/Source/core/color/RGBSpectrum.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+// Measures MIPMap::Lookup throughput on one thread for the three filters
+// ImageTexture can use (bilinear at the finest level, trilinear and EWA),
+// for single-channel and RGB textures in every texel format.
+//
+//     Benchmark texture [--res n] [--seconds s]
+
+
+struct LookupQuery
+{
+    common::math::Vec2f st;
+    common::math::Vec2f dst0, dst1;
+};
+
+// Footprints range from a texel at the finest level up to a sixteenth of
+// the texture, with anisotropy up to the MIPMap's limit of 8
+static std::vector<LookupQuery> makeQueries(int count, int res)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<Float> uniform(FLOAT_0, FLOAT_1);
+    Float minLog = std::log(FLOAT_1 / res), maxLog = std::log(static_cast<Float>(1.0F / 16.0F));
+    std::vector<LookupQuery> queries(count);
+    for (LookupQuery &query : queries)
+    {
+        query.st = common::math::Vec2f(uniform(rng), uniform(rng));
+        Float major = std::exp(minLog + (maxLog - minLog) * uniform(rng));
+        Float minor = major / (FLOAT_1 + static_cast<Float>(7.0F) * uniform(rng));
+        Float theta = static_cast<Float>(2.0F * 3.14159265F) * uniform(rng);
+        Float c = std::cos(theta), s = std::sin(theta);
+        query.dst0 = common::math::Vec2f(major * c, major * s);
+        query.dst1 = common::math::Vec2f(-minor * s, minor * c);
+    }
+    return queries;
+}
+
+// A smooth pattern with some high frequency detail so that neighbouring
+// texels and levels differ
+template <typename T>
+static std::unique_ptr<T[]> makeImage(int res);
+
+template <>
+std::unique_ptr<Float[]> makeImage<Float>(int res)
+{
+    std::unique_ptr<Float[]> image(new Float[res * res]);
+    for (int y = 0; y < res; ++y)
+    {
+        for (int x = 0; x < res; ++x)
+        {
+            Float u = static_cast<Float>(x) / res, v = static_cast<Float>(y) / res;
+            image[y * res + x] = FLOAT_INV_2 + FLOAT_INV_2 * std::sin(static_cast<Float>(40.0F) * u * v)
+                * (((x ^ y) & 8) ? static_cast<Float>(0.9F) : FLOAT_1);
+        }
+    }
+    return image;
+}
+
+template <>
+std::unique_ptr<core::color::RGBSpectrum[]> makeImage<core::color::RGBSpectrum>(int res)
+{
+    std::unique_ptr<Float[]> luminance = makeImage<Float>(res);
+    std::unique_ptr<core::color::RGBSpectrum[]> image(new core::color::RGBSpectrum[res * res]);
+    for (int i = 0; i < res * res; ++i)
+    {
+        Float rgb[3] = { luminance[i], FLOAT_1 - luminance[i], luminance[i] * luminance[i] };
+        image[i] = core::color::RGBSpectrum::FromRGB(rgb);
+    }
+    return image;
+}
+
+static Float firstChannel(Float v)
+{
+    return v;
+}
+
+static Float firstChannel(const core::color::RGBSpectrum &v)
+{
+    return v[0];
+}
+
+template <typename T>
+static void benchmarkType(const char *typeName, int res, double seconds, const std::vector<LookupQuery> &queries)
+{
+    static const common::tool::TexelFormat formats[] =
+    {
+        common::tool::TexelFormat::Float, common::tool::TexelFormat::Half, common::tool::TexelFormat::SRGB8
+    };
+    static const char *formatNames[] = { "float", "half", "srgb8" };
+
+    std::unique_ptr<T[]> image = makeImage<T>(res);
+    common::math::Vec2i resolution(res, res);
+    for (int f = 0; f < 3; ++f)
+    {
+        common::tool::MIPMap<T> trilinear(resolution, image.get(), true, static_cast<Float>(8.0F),
+            common::tool::ImageWrap::Repeat, formats[f]);
+        common::tool::MIPMap<T> ewa(resolution, image.get(), false, static_cast<Float>(8.0F),
+            common::tool::ImageWrap::Repeat, formats[f]);
+
+        double bilinearRate = MeasureRate([&]()
+        {
+            Float sum = FLOAT_0;
+            for (const LookupQuery &query : queries)
+            {
+                sum += firstChannel(trilinear.Lookup(query.st));
+            }
+            DoNotOptimize(sum);
+        }, queries.size(), seconds);
+        double trilinearRate = MeasureRate([&]()
+        {
+            Float sum = FLOAT_0;
+            for (const LookupQuery &query : queries)
+            {
+                sum += firstChannel(trilinear.Lookup(query.st, query.dst0, query.dst1));
+            }
+            DoNotOptimize(sum);
+        }, queries.size(), seconds);
+        double ewaRate = MeasureRate([&]()
+        {
+            Float sum = FLOAT_0;
+            for (const LookupQuery &query : queries)
+            {
+                sum += firstChannel(ewa.Lookup(query.st, query.dst0, query.dst1));
+            }
+            DoNotOptimize(sum);
+        }, queries.size(), seconds);
+
+        printf("%-4s %-6s  bilinear %8.2f M/s  trilinear %8.2f M/s  ewa %8.2f M/s\n", typeName, formatNames[f],
+            bilinearRate * 1e-6, trilinearRate * 1e-6, ewaRate * 1e-6);
+    }
+}
+
+int RunTextureBenchmark(int argc, char *argv[])
+{
+    int res = 1024;
+    double seconds = 1.0;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--res") && i + 1 < argc)
+        {
+            res = atoi(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "--seconds") && i + 1 < argc)
+        {
+            seconds = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: Benchmark texture [--res n] [--seconds s]\n");
+            return 1;
+        }
+    }
+    if (res <= 0)
+    {
+        fprintf(stderr, "Benchmark texture: resolution must be positive\n");
+        return 1;
+    }
+
+    // The MIPMap constructors build levels with ParallelFor; lookups are
+    // timed on the main thread only
+    common::tool::ParallelInit();
+    std::vector<LookupQuery> queries = makeQueries(1 << 14, res);
+    printf("%d x %d texture, %d lookups per pass, lookups per second on one thread\n",
+        res, res, static_cast<int>(queries.size()));
+    benchmarkType<Float>("y", res, seconds, queries);
+    benchmarkType<core::color::RGBSpectrum>("rgb", res, seconds, queries);
+    common::tool::ParallelCleanup();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "Benchmark.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+// Micro benchmarks for the renderer's hot loops, built against the same
+// sources as RayTracer.
+//
+//     Benchmark <suite> [suite options]
+//
+// Each suite prints one line per configuration it measures.
+
+
+struct Suite
+{
+    const char *name;
+    const char *description;
+    int (*run)(int argc, char *argv[]);
+};
+
+static const Suite suites[] =
+{
+    { "texture", "MIPMap lookups per second for each filter and texel format", RunTextureBenchmark },
+    { "spectrum", "Path vertex spectrum updates and FromRGB() conversions per second", RunSpectrumBenchmark },
+    { "accelerator", "k-d tree and BVH build and traversal statistics and rays per second", RunAcceleratorBenchmark }
+};
+
+
+static volatile Float sink;
+
+void DoNotOptimize(Float value)
+{
+    sink = value;
+}
+
+double MeasureRate(const std::function<void()> &func, int64_t opsPerCall, double minSeconds)
+{
+    // One untimed call to fault in pages and warm the caches. The fastest
+    // call is reported, which filters out time lost to other processes.
+    func();
+    double fastest = 0.0, elapsed = 0.0;
+    do
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        func();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fastest = (0.0 == fastest || seconds < fastest) ? seconds : fastest;
+        elapsed += seconds;
+    }
+    while (elapsed < minSeconds);
+    return static_cast<double>(opsPerCall) / fastest;
+}
+
+
+static void usage()
+{
+    fprintf(stderr, "usage: Benchmark <suite> [suite options]\n\nsuites:\n");
+    for (const Suite &suite : suites)
+    {
+        fprintf(stderr, "    %-12s  %s\n", suite.name, suite.description);
+    }
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        usage();
+    }
+    for (const Suite &suite : suites)
+    {
+        if (0 == strcmp(argv[1], suite.name))
+        {
+            return suite.run(argc - 2, argv + 2);
+        }
+    }
+    usage();
+    return 1;
+}
\ No newline at end of file
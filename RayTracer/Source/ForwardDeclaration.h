@@ -153,6 +153,12 @@ class RandomNumberGenerator;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class MappedFile;
+class TiledTextureFile;
+class TextureCache;
+
+////////////////////////////////////////////////////////////////////////////////
+
 }
 
 }
@@ -173,6 +179,7 @@ namespace bxdf
 
 class BxDF;
 class BSDF;
+struct DirectionBatch;
 struct FourierBSDFTable;
 class FourierBSDF;
 class LambertianReflection;
@@ -193,6 +200,7 @@ namespace distribution
 {
 
 class MicrofacetDistribution;
+class MicrofacetAlbedo;
 class BeckmannDistribution;
 class TrowbridgeReitzDistribution;
 
@@ -219,6 +227,8 @@ template <int SPECTRUM_SAMPLE_NUMBER>
 class CoefficientSpectrum;
 class RGBSpectrum;
 class SampledSpectrum;
+class HeroSpectrum;
+class SampledWavelengths;
 
 #define SAMPLED_SPECTRUM
 #ifdef SAMPLED_SPECTRUM
@@ -255,6 +265,12 @@ class Integrator;
 class SamplerIntegrator;
 class DirectLightingIntegrator;
 class PathIntegrator;
+class VolPathIntegrator;
+class BDPTIntegrator;
+class SPPMIntegrator;
+
+struct EndpointInteraction;
+struct Vertex;
 
 class LightDistribution;
 class UniformLightDistribution;
@@ -273,8 +289,12 @@ class SurfaceInteraction;
 class MediumInteraction;
 
 class PhaseFunction;
+class HenyeyGreenstein;
 class Medium;
+class HomogeneousMedium;
+class GridDensityMedium;
 struct MediumInterface;
+struct MediumBoundaries;
 
 }
 
@@ -312,6 +332,7 @@ namespace primitive
 
 class Primitive;
 class GeometricPrimitive;
+class TransformedPrimitive;
 
 }
 
@@ -357,6 +378,9 @@ namespace texture
 
 template <typename T>
 class Texture;
+class TextureMapping2D;
+class TextureProgram;
+class TextureCompiler;
 
 }
 ////////////////////////////////////////////////////////////////////////////////
@@ -6,29 +6,152 @@
 #include "Quaternion.h"
 #include "Mat4.h"
 #include "Transform.h"
+#include "Bounds3.h"
+#include "Ray.h"
+#include "RayDifferential.h"
+
+// SSE2 is part of every x64 target; double precision builds stay scalar
+#ifndef FLOAT_AS_DOUBLE
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANIMATED_TRANSFORM_SSE
+#include <emmintrin.h>
+#endif
+#endif
 
 namespace common
 {
 namespace math
 {
 
+
+// The upper 3x4 block of an affine matrix, stored by columns padded to four
+// lanes so that applying it is three multiply-adds of whole columns; column
+// 3 is the translation
+template<typename T>
+struct AffineColumns
+{
+    alignas(16) T col[4][4];
+
+
+    Vec3<T> ApplyPoint(const Vec3<T> &p) const
+    {
+        return Vec3<T>(col[0][0] * p.x + col[1][0] * p.y + col[2][0] * p.z + col[3][0]
+            , col[0][1] * p.x + col[1][1] * p.y + col[2][1] * p.z + col[3][1]
+            , col[0][2] * p.x + col[1][2] * p.y + col[2][2] * p.z + col[3][2]);
+    }
+
+    Vec3<T> ApplyVector(const Vec3<T> &v) const
+    {
+        return Vec3<T>(col[0][0] * v.x + col[1][0] * v.y + col[2][0] * v.z
+            , col[0][1] * v.x + col[1][1] * v.y + col[2][1] * v.z
+            , col[0][2] * v.x + col[1][2] * v.y + col[2][2] * v.z);
+    }
+
+    // Rounding error bound of ApplyPoint(), as Transform::operator() bounds it
+    Vec3<T> PointError(const Vec3<T> &p) const
+    {
+        const T gamma = static_cast<T>(Gamma(3));
+        return Vec3<T>(gamma * (std::abs(col[0][0] * p.x) + std::abs(col[1][0] * p.y) + std::abs(col[2][0] * p.z)
+                + std::abs(col[3][0]))
+            , gamma * (std::abs(col[0][1] * p.x) + std::abs(col[1][1] * p.y) + std::abs(col[2][1] * p.z)
+                + std::abs(col[3][1]))
+            , gamma * (std::abs(col[0][2] * p.x) + std::abs(col[1][2] * p.y) + std::abs(col[2][2] * p.z)
+                + std::abs(col[3][2])));
+    }
+
+    // Exact bounds of the image of _b_ (Arvo): the center maps like a point
+    // and the half extent through the absolute values of the matrix
+    Bounds3<T> ApplyBounds(const Bounds3<T> &b) const
+    {
+        Vec3<T> center = static_cast<T>(0.5F) * (b.point_min + b.point_max);
+        Vec3<T> half = static_cast<T>(0.5F) * (b.point_max - b.point_min);
+        Vec3<T> c = ApplyPoint(center);
+        Vec3<T> e(std::abs(col[0][0]) * half.x + std::abs(col[1][0]) * half.y + std::abs(col[2][0]) * half.z
+            , std::abs(col[0][1]) * half.x + std::abs(col[1][1]) * half.y + std::abs(col[2][1]) * half.z
+            , std::abs(col[0][2]) * half.x + std::abs(col[1][2]) * half.y + std::abs(col[2][2]) * half.z);
+        Bounds3<T> ret;
+        ret.point_min = c - e;
+        ret.point_max = c + e;
+        return ret;
+    }
+
+    static AffineColumns FromMat4(const Mat4<T> &m)
+    {
+        AffineColumns a;
+        for (int j = 0; j < 4; ++j)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                a.col[j][i] = m[i][j];
+            }
+            a.col[j][3] = static_cast<T>(0.0F);
+        }
+        return a;
+    }
+};
+
+
+#ifdef ANIMATED_TRANSFORM_SSE
+template<> __forceinline
+Vec3<float> AffineColumns<float>::ApplyPoint(const Vec3<float> &p) const
+{
+    __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(col[0]), _mm_set1_ps(p.x)),
+        _mm_mul_ps(_mm_load_ps(col[1]), _mm_set1_ps(p.y))),
+        _mm_add_ps(_mm_mul_ps(_mm_load_ps(col[2]), _mm_set1_ps(p.z)), _mm_load_ps(col[3])));
+    alignas(16) float out[4];
+    _mm_store_ps(out, r);
+    return Vec3<float>(out[0], out[1], out[2]);
+}
+
+template<> __forceinline
+Vec3<float> AffineColumns<float>::ApplyVector(const Vec3<float> &v) const
+{
+    __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(col[0]), _mm_set1_ps(v.x)),
+        _mm_mul_ps(_mm_load_ps(col[1]), _mm_set1_ps(v.y))),
+        _mm_mul_ps(_mm_load_ps(col[2]), _mm_set1_ps(v.z)));
+    alignas(16) float out[4];
+    _mm_store_ps(out, r);
+    return Vec3<float>(out[0], out[1], out[2]);
+}
+#endif
+
+
+// Interpolates between two transforms by decomposing each into translation,
+// rotation and scale (Shoemake and Duff). The decomposition, the slerp
+// terms and the scale and translation deltas are computed once, so that
+// applying the transform at a time costs a sin, a cos and a 3x3 product and
+// never builds a Transform or inverts a matrix. Points and ray origins are
+// translated; Vec3 arguments of operator() are transformed as vectors, the
+// way Transform::operator() does.
 template<typename T>
 class AnimatedTransform
 {
 public:
 
+    // Keyframes of the interpolated matrix kept for MotionBounds()
+    static constexpr int MOTION_STEPS = 16;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
 
     AnimatedTransform(const Transform<T> *p_start_transform, const T &start_time
         , const Transform<T> *p_end_transform, const T &end_time)
+        : p_start_transform(p_start_transform),
+        p_end_transform(p_end_transform),
+        is_actually_animated(!SameMatrix(p_start_transform->mat4, p_end_transform->mat4)),
+        start_time(start_time),
+        end_time(end_time),
+        has_rotation(false),
+        theta(static_cast<T>(0.0F)),
+        motion_curvature(static_cast<T>(0.0F))
     {
-        if (!is_actually_animated) return;
-
-        translations.resize(2);
-        rotations.resize(2);
-        scales.resize(2);
+        ends[0] = AffineColumns<T>::FromMat4(p_start_transform->mat4);
+        ends[1] = AffineColumns<T>::FromMat4(p_end_transform->mat4);
+        if (!is_actually_animated)
+        {
+            return;
+        }
 
         Decompose(p_start_transform->mat4, &(translations[0]), &(rotations[0]), &(scales[0]));
         Decompose(p_end_transform->mat4, &(translations[1]), &(rotations[1]), &(scales[1]));
@@ -38,436 +161,39 @@ public:
         {
             rotations[1] = -rotations[1];
         }
-        has_rotation = Dot(rotations[0], rotations[1]) < static_cast<T>(0.9995F);
-        // Compute terms of motion derivative function
+        T cos_theta = Dot(rotations[0], rotations[1]);
+        has_rotation = cos_theta < static_cast<T>(0.9995F);
+        theta = std::acos((std::min)((std::max)(cos_theta, static_cast<T>(-1.0F)), static_cast<T>(1.0F)));
         if (has_rotation)
         {
-            T cos_theta = Dot(rotations[0], rotations[1]);
-            T theta = std::acos(Clamp(cos_theta, -1, 1));
-            Quaternion<T> qperp = Normalize(rotations[1] - rotations[0] * cos_theta);
-
-            T t0_x = translations[0].x;
-            T t0_y = translations[0].y;
-            T t0_z = translations[0].z;
-            T t1_x = translations[1].x;
-            T t1_y = translations[1].y;
-            T t1_z = translations[1].z;
-            T q1_x = rotations[0].v.x;
-            T q1_y = rotations[0].v.y;
-            T q1_z = rotations[0].v.z;
-            T q1_w = rotations[0].w;
-            T qperp_x = qperp.v.x;
-            T qperp_y = qperp.v.y;
-            T qperp_z = qperp.v.z;
-            T qperp_w = qperp.w;
-            T s0_00 = (scales[0])[0][0];
-            T s0_01 = (scales[0])[0][1];
-            T s0_02 = (scales[0])[0][2];
-            T s0_10 = (scales[0])[1][0];
-            T s0_11 = (scales[0])[1][1];
-            T s0_12 = (scales[0])[1][2];
-            T s0_20 = (scales[0])[2][0];
-            T s0_21 = (scales[0])[2][1];
-            T s0_22 = (scales[0])[2][2];
-            T s1_00 = (scales[1])[0][0];
-            T s1_01 = (scales[1])[0][1];
-            T s1_02 = (scales[1])[0][2];
-            T s1_10 = (scales[1])[1][0];
-            T s1_11 = (scales[1])[1][1];
-            T s1_12 = (scales[1])[1][2];
-            T s1_20 = (scales[1])[2][0];
-            T s1_21 = (scales[1])[2][1];
-            T s1_22 = (scales[1])[2][2];
-
-            c1[0] = DerivativeTerm(-t0_x + t1_x
-                , (-static_cast<T>(1.0F) + q1_y * q1_y + q1_z * q1_z + qperp_y * qperp_y + qperp_z * qperp_z) * s0_00
-                + q1_w * q1_z * s0_10 - qperp_x * qperp_y * s0_10 + qperp_w * qperp_z * s0_10 - q1_w * q1_y * s0_20
-                - qperp_w * qperp_y * s0_20 - qperp_x * qperp_z * s0_20 + s1_00 - q1_y * q1_y * s1_00
-                - q1_z * q1_z * s1_00 - qperp_y * qperp_y * s1_00 - qperp_z * qperp_z * s1_00 - q1_w * q1_z * s1_10
-                + qperp_x * qperp_y * s1_10 - qperp_w * qperp_z * s1_10 + q1_w * q1_y * s1_20 + qperp_w * qperp_y * s1_20
-                + qperp_x * qperp_z * s1_20 + q1_x * (-(q1_y * s0_10) - q1_z * s0_20 + q1_y * s1_10 + q1_z * s1_20)
-                , (-static_cast<T>(1.0F) + q1_y * q1_y + q1_z * q1_z + qperp_y * qperp_y + qperp_z * qperp_z) * s0_01
-                + q1_w * q1_z * s0_11 - qperp_x * qperp_y * s0_11 + qperp_w * qperp_z * s0_11 - q1_w * q1_y * s0_21
-                - qperp_w * qperp_y * s0_21 - qperp_x * qperp_z * s0_21 + s1_01 - q1_y * q1_y * s1_01
-                - q1_z * q1_z * s1_01 - qperp_y * qperp_y * s1_01 - qperp_z * qperp_z * s1_01 - q1_w * q1_z * s1_11
-                + qperp_x * qperp_y * s1_11 - qperp_w * qperp_z * s1_11 + q1_w * q1_y * s1_21 + qperp_w * qperp_y * s1_21
-                + qperp_x * qperp_z * s1_21 + q1_x * (-(q1_y * s0_11) - q1_z * s0_21 + q1_y * s1_11 + q1_z * s1_21)
-                , (-static_cast<T>(1.0F) + q1_y * q1_y + q1_z * q1_z + qperp_y * qperp_y + qperp_z * qperp_z) * s0_02
-                + q1_w * q1_z * s0_12 - qperp_x * qperp_y * s0_12 + qperp_w * qperp_z * s0_12 - q1_w * q1_y * s0_22
-                - qperp_w * qperp_y * s0_22 - qperp_x * qperp_z * s0_22 + s1_02 - q1_y * q1_y * s1_02
-                - q1_z * q1_z * s1_02 - qperp_y * qperp_y * s1_02 - qperp_z * qperp_z * s1_02 - q1_w * q1_z * s1_12
-                + qperp_x * qperp_y * s1_12 - qperp_w * qperp_z * s1_12 + q1_w * q1_y * s1_22 + qperp_w * qperp_y * s1_22
-                + qperp_x * qperp_z * s1_22 + q1_x * (-(q1_y * s0_12) - q1_z * s0_22 + q1_y * s1_12 + q1_z * s1_22));
-
-            c2[0] = DerivativeTerm(static_cast<T>(0.0F), -(qperp_y * qperp_y * s0_00) - qperp_z * qperp_z * s0_00
-                + qperp_x * qperp_y * s0_10 - qperp_w * qperp_z * s0_10 + qperp_w * qperp_y * s0_20
-                + qperp_x * qperp_z * s0_20 + q1_y * q1_y * (s0_00 - s1_00) + q1_z * q1_z * (s0_00 - s1_00)
-                + qperp_y * qperp_y * s1_00 + qperp_z * qperp_z * s1_00 - qperp_x * qperp_y * s1_10
-                + qperp_w * qperp_z * s1_10 - qperp_w * qperp_y * s1_20 - qperp_x * qperp_z * s1_20
-                + static_cast<T>(2.0F) * q1_x * qperp_y * s0_10 * theta - static_cast<T>(2.0F) * q1_w * qperp_z * s0_10 * theta
-                + static_cast<T>(2.0F) * q1_w * qperp_y * s0_20 * theta + static_cast<T>(2.0F) * q1_x * qperp_z * s0_20 * theta
-                + q1_y * (q1_x * (-s0_10 + s1_10) + q1_w * (-s0_20 + s1_20)
-                    + static_cast<T>(2.0F) * (-static_cast<T>(2.0F) * qperp_y * s0_00
-                        + qperp_x * s0_10 + qperp_w * s0_20) * theta) + q1_z * (q1_w * (s0_10 - s1_10)
-                            + q1_x * (-s0_20 + s1_20) - static_cast<T>(2.0F) * (static_cast<T>(2.0F) * qperp_z * s0_00
-                                + qperp_w * s0_10 - qperp_x * s0_20) * theta)
-                , -(qperp_y * qperp_y * s0_01) - qperp_z * qperp_z * s0_01 + qperp_x * qperp_y * s0_11
-                - qperp_w * qperp_z * s0_11 + qperp_w * qperp_y * s0_21 + qperp_x * qperp_z * s0_21
-                + q1_y * q1_y * (s0_01 - s1_01) + q1_z * q1_z * (s0_01 - s1_01) + qperp_y * qperp_y * s1_01
-                + qperp_z * qperp_z * s1_01 - qperp_x * qperp_y * s1_11 + qperp_w * qperp_z * s1_11
-                - qperp_w * qperp_y * s1_21 - qperp_x * qperp_z * s1_21 + static_cast<T>(2.0F) * q1_x * qperp_y * s0_11 * theta
-                - static_cast<T>(2.0F) * q1_w * qperp_z * s0_11 * theta + static_cast<T>(2.0F) * q1_w * qperp_y * s0_21 * theta
-                + static_cast<T>(2.0F) * q1_x * qperp_z * s0_21 * theta + q1_y * (q1_x * (-s0_11 + s1_11) + q1_w * (-s0_21 + s1_21)
-                    + static_cast<T>(2.0F) * (-static_cast<T>(2.0F) * qperp_y * s0_01 + qperp_x * s0_11 + qperp_w * s0_21) * theta)
-                + q1_z * (q1_w * (s0_11 - s1_11) + q1_x * (-s0_21 + s1_21)
-                    - static_cast<T>(2.0F) * (static_cast<T>(2.0F) * qperp_z * s0_01
-                        + qperp_w * s0_11 - qperp_x * s0_21) * theta)
-                , -(qperp_y * qperp_y * s0_02) - qperp_z * qperp_z * s0_02 + qperp_x * qperp_y * s0_12
-                - qperp_w * qperp_z * s0_12 + qperp_w * qperp_y * s0_22 + qperp_x * qperp_z * s0_22
-                + q1_y * q1_y * (s0_02 - s1_02) + q1_z * q1_z * (s0_02 - s1_02) + qperp_y * qperp_y * s1_02
-                + qperp_z * qperp_z * s1_02 - qperp_x * qperp_y * s1_12 + qperp_w * qperp_z * s1_12 -
-                qperp_w * qperp_y * s1_22 - qperp_x * qperp_z * s1_22 + static_cast<T>(2.0F) * q1_x * qperp_y * s0_12 * theta
-                - static_cast<T>(2.0F) * q1_w * qperp_z * s0_12 * theta + static_cast<T>(2.0F) * q1_w * qperp_y * s0_22 * theta
-                + static_cast<T>(2.0F) * q1_x * qperp_z * s0_22 * theta + q1_y * (q1_x * (-s0_12 + s1_12) + q1_w * (-s0_22 + s1_22)
-                    + static_cast<T>(2.0F) * (-static_cast<T>(2.0F) * qperp_y * s0_02 + qperp_x * s0_12 + qperp_w * s0_22) * theta)
-                + q1_z * (q1_w * (s0_12 - s1_12) + q1_x * (-s0_22 + s1_22)
-                    - static_cast<T>(2.0F) * (static_cast<T>(2.0F) * qperp_z * s0_02 + qperp_w * s0_12 - qperp_x * s0_22) * theta));
-
-            c3[0] = DerivativeTerm(static_cast<T>(0.0F), -static_cast<T>(2.0F) * (q1_x * qperp_y * s0_10 - q1_w * qperp_z * s0_10
-                + q1_w * qperp_y * s0_20 + q1_x * qperp_z * s0_20 - q1_x * qperp_y * s1_10 + q1_w * qperp_z * s1_10
-                - q1_w * qperp_y * s1_20 - q1_x * qperp_z * s1_20 + q1_y * (-static_cast<T>(2.0F) * qperp_y * s0_00
-                    + qperp_x * s0_10 + qperp_w * s0_20 + static_cast<T>(2.0F) * qperp_y * s1_00 - qperp_x * s1_10 - qperp_w * s1_20)
-                + q1_z * (-static_cast<T>(2.0F) * qperp_z * s0_00 - qperp_w * s0_10 + qperp_x * s0_20
-                    + static_cast<T>(2.0F) * qperp_z * s1_00 + qperp_w * s1_10 - qperp_x * s1_20)) * theta
-                , -static_cast<T>(2.0F) * (q1_x * qperp_y * s0_11 - q1_w * qperp_z * s0_11 + q1_w * qperp_y * s0_21
-                    + q1_x * qperp_z * s0_21 - q1_x * qperp_y * s1_11 + q1_w * qperp_z * s1_11 - q1_w * qperp_y * s1_21
-                    - q1_x * qperp_z * s1_21 + q1_y * (-static_cast<T>(2.0F) * qperp_y * s0_01 + qperp_x * s0_11 + qperp_w * s0_21
-                        + static_cast<T>(2.0F) * qperp_y * s1_01 - qperp_x * s1_11 - qperp_w * s1_21)
-                    + q1_z * (-static_cast<T>(2.0F) * qperp_z * s0_01 - qperp_w * s0_11 + qperp_x * s0_21
-                        + static_cast<T>(2.0F) * qperp_z * s1_01 + qperp_w * s1_11 - qperp_x * s1_21)) * theta
-                , -static_cast<T>(2.0F) * (q1_x * qperp_y * s0_12 - q1_w * qperp_z * s0_12 + q1_w * qperp_y * s0_22
-                    + q1_x * qperp_z * s0_22 - q1_x * qperp_y * s1_12 + q1_w * qperp_z * s1_12 - q1_w * qperp_y * s1_22
-                    - q1_x * qperp_z * s1_22 + q1_y * (-static_cast<T>(2.0F) * qperp_y * s0_02 + qperp_x * s0_12 + qperp_w * s0_22
-                        + static_cast<T>(2.0F) * qperp_y * s1_02 - qperp_x * s1_12 - qperp_w * s1_22)
-                    + q1_z * (-static_cast<T>(2.0F) * qperp_z * s0_02 - qperp_w * s0_12 + qperp_x * s0_22
-                        + static_cast<T>(2.0F) * qperp_z * s1_02 + qperp_w * s1_12 - qperp_x * s1_22)) * theta);
-
-            c4[0] = DerivativeTerm(static_cast<T>(0.0F), -(q1_x * qperp_y * s0_10) + q1_w * qperp_z * s0_10 - q1_w * qperp_y * s0_20
-                - q1_x * qperp_z * s0_20 + q1_x * qperp_y * s1_10 - q1_w * qperp_z * s1_10 + q1_w * qperp_y * s1_20
-                + q1_x * qperp_z * s1_20 + static_cast<T>(2.0F) * q1_y * q1_y * s0_00 * theta
-                + static_cast<T>(2.0F) * q1_z * q1_z * s0_00 * theta
-                - static_cast<T>(2.0F) * qperp_y * qperp_y * s0_00 * theta - static_cast<T>(2.0F) * qperp_z * qperp_z * s0_00 * theta
-                + static_cast<T>(2.0F) * qperp_x * qperp_y * s0_10 * theta - static_cast<T>(2.0F) * qperp_w * qperp_z * s0_10 * theta
-                + static_cast<T>(2.0F) * qperp_w * qperp_y * s0_20 * theta + static_cast<T>(2.0F) * qperp_x * qperp_z * s0_20 * theta
-                + q1_y * (-(qperp_x * s0_10) - qperp_w * s0_20 + static_cast<T>(2.0F) * qperp_y * (s0_00 - s1_00) + qperp_x * s1_10
-                    + qperp_w * s1_20 - static_cast<T>(2.0F) * q1_x * s0_10 * theta - static_cast<T>(2.0F) * q1_w * s0_20 * theta)
-                + q1_z * (static_cast<T>(2.0F) * qperp_z * s0_00 + qperp_w * s0_10 - qperp_x * s0_20
-                    - static_cast<T>(2.0F) * qperp_z * s1_00
-                    - qperp_w * s1_10 + qperp_x * s1_20 + static_cast<T>(2.0F) * q1_w * s0_10 * theta
-                    - static_cast<T>(2.0F) * q1_x * s0_20 * theta)
-                , -(q1_x * qperp_y * s0_11) + q1_w * qperp_z * s0_11 - q1_w * qperp_y * s0_21 - q1_x * qperp_z * s0_21
-                + q1_x * qperp_y * s1_11 - q1_w * qperp_z * s1_11 + q1_w * qperp_y * s1_21 + q1_x * qperp_z * s1_21
-                + static_cast<T>(2.0F) * q1_y * q1_y * s0_01 * theta + static_cast<T>(2.0F) * q1_z * q1_z * s0_01 * theta
-                - static_cast<T>(2.0F) * qperp_y * qperp_y * s0_01 * theta - static_cast<T>(2.0F) * qperp_z * qperp_z * s0_01 * theta
-                + static_cast<T>(2.0F) * qperp_x * qperp_y * s0_11 * theta - static_cast<T>(2.0F) * qperp_w * qperp_z * s0_11 * theta
-                + static_cast<T>(2.0F) * qperp_w * qperp_y * s0_21 * theta + static_cast<T>(2.0F) * qperp_x * qperp_z * s0_21 * theta
-                + q1_y * (-(qperp_x * s0_11) - qperp_w * s0_21 + static_cast<T>(2.0F) * qperp_y * (s0_01 - s1_01) + qperp_x * s1_11
-                    + qperp_w * s1_21 - static_cast<T>(2.0F) * q1_x * s0_11 * theta - static_cast<T>(2.0F) * q1_w * s0_21 * theta)
-                + q1_z * (static_cast<T>(2.0F) * qperp_z * s0_01 + qperp_w * s0_11 - qperp_x * s0_21
-                    - static_cast<T>(2.0F) * qperp_z * s1_01
-                    - qperp_w * s1_11 + qperp_x * s1_21 + static_cast<T>(2.0F) * q1_w * s0_11 * theta
-                    - static_cast<T>(2.0F) * q1_x * s0_21 * theta)
-                , -(q1_x * qperp_y * s0_12) + q1_w * qperp_z * s0_12 - q1_w * qperp_y * s0_22 - q1_x * qperp_z * s0_22
-                + q1_x * qperp_y * s1_12 - q1_w * qperp_z * s1_12 + q1_w * qperp_y * s1_22 + q1_x * qperp_z * s1_22
-                + static_cast<T>(2.0F) * q1_y * q1_y * s0_02 * theta + static_cast<T>(2.0F) * q1_z * q1_z * s0_02 * theta
-                - static_cast<T>(2.0F) * qperp_y * qperp_y * s0_02 * theta - static_cast<T>(2.0F) * qperp_z * qperp_z * s0_02 * theta
-                + static_cast<T>(2.0F) * qperp_x * qperp_y * s0_12 * theta - static_cast<T>(2.0F) * qperp_w * qperp_z * s0_12 * theta
-                + static_cast<T>(2.0F) * qperp_w * qperp_y * s0_22 * theta + static_cast<T>(2.0F) * qperp_x * qperp_z * s0_22 * theta
-                + q1_y * (-(qperp_x * s0_12) - qperp_w * s0_22 + static_cast<T>(2.0F) * qperp_y * (s0_02 - s1_02) + qperp_x * s1_12
-                    + qperp_w * s1_22 - static_cast<T>(2.0F) * q1_x * s0_12 * theta - static_cast<T>(2.0F) * q1_w * s0_22 * theta)
-                + q1_z * (static_cast<T>(2.0F) * qperp_z * s0_02 + qperp_w * s0_12 - qperp_x * s0_22
-                    - static_cast<T>(2.0F) * qperp_z * s1_02 - qperp_w * s1_12 + qperp_x * s1_22
-                    + static_cast<T>(2.0F) * q1_w * s0_12 * theta - static_cast<T>(2.0F) * q1_x * s0_22 * theta));
-
-            c5[0] = DerivativeTerm(static_cast<T>(0.0F), static_cast<T>(2.0F) * (qperp_y * qperp_y * s0_00 + qperp_z * qperp_z * s0_00
-                - qperp_x * qperp_y * s0_10 + qperp_w * qperp_z * s0_10 - qperp_w * qperp_y * s0_20 - qperp_x * qperp_z * s0_20
-                - qperp_y * qperp_y * s1_00 - qperp_z * qperp_z * s1_00 + q1_y * q1_y * (-s0_00 + s1_00) + q1_z * q1_z * (-s0_00 + s1_00)
-                + qperp_x * qperp_y * s1_10 - qperp_w * qperp_z * s1_10 + q1_y * (q1_x * (s0_10 - s1_10) + q1_w * (s0_20 - s1_20))
-                + qperp_w * qperp_y * s1_20 + qperp_x * qperp_z * s1_20 + q1_z * (-(q1_w * s0_10) + q1_x * s0_20 + q1_w * s1_10
-                    - q1_x * s1_20)) * theta
-                , static_cast<T>(2.0F) * (qperp_y * qperp_y * s0_01 + qperp_z * qperp_z * s0_01 - qperp_x * qperp_y * s0_11
-                    + qperp_w * qperp_z * s0_11 - qperp_w * qperp_y * s0_21 - qperp_x * qperp_z * s0_21 - qperp_y * qperp_y * s1_01
-                    - qperp_z * qperp_z * s1_01 + q1_y * q1_y * (-s0_01 + s1_01) + q1_z * q1_z * (-s0_01 + s1_01)
-                    + qperp_x * qperp_y * s1_11 - qperp_w * qperp_z * s1_11 + q1_y * (q1_x * (s0_11 - s1_11) + q1_w * (s0_21 - s1_21))
-                    + qperp_w * qperp_y * s1_21 + qperp_x * qperp_z * s1_21 + q1_z * (-(q1_w * s0_11) + q1_x * s0_21
-                        + q1_w * s1_11 - q1_x * s1_21)) * theta
-                , static_cast<T>(2.0F) * (qperp_y * qperp_y * s0_02 + qperp_z * qperp_z * s0_02 - qperp_x * qperp_y * s0_12
-                    + qperp_w * qperp_z * s0_12 - qperp_w * qperp_y * s0_22 - qperp_x * qperp_z * s0_22 - qperp_y * qperp_y * s1_02
-                    - qperp_z * qperp_z * s1_02 + q1_y * q1_y * (-s0_02 + s1_02) + q1_z * q1_z * (-s0_02 + s1_02)
-                    + qperp_x * qperp_y * s1_12 - qperp_w * qperp_z * s1_12 + q1_y * (q1_x * (s0_12 - s1_12) + q1_w * (s0_22 - s1_22))
-                    + qperp_w * qperp_y * s1_22 + qperp_x * qperp_z * s1_22 + q1_z * (-(q1_w * s0_12) + q1_x * s0_22
-                        + q1_w * s1_12 - q1_x * s1_22)) * theta);
-
-            c1[1] = DerivativeTerm(-t0_y + t1_y, -(qperp_x * qperp_y * s0_00) - qperp_w * qperp_z * s0_00 - s0_10
-                + q1_z * q1_z * s0_10 + qperp_x * qperp_x * s0_10 + qperp_z * qperp_z * s0_10 - q1_y * q1_z * s0_20
-                + qperp_w * qperp_x * s0_20 - qperp_y * qperp_z * s0_20 + qperp_x * qperp_y * s1_00 + qperp_w * qperp_z * s1_00
-                + q1_w * q1_z * (-s0_00 + s1_00) + q1_x * q1_x * (s0_10 - s1_10) + s1_10 - q1_z * q1_z * s1_10
-                - qperp_x * qperp_x * s1_10 - qperp_z * qperp_z * s1_10 + q1_x * (q1_y * (-s0_00 + s1_00) + q1_w * (s0_20 - s1_20))
-                + q1_y * q1_z * s1_20 - qperp_w * qperp_x * s1_20 + qperp_y * qperp_z * s1_20
-                , -(qperp_x * qperp_y * s0_01) - qperp_w * qperp_z * s0_01 - s0_11 + q1_z * q1_z * s0_11 + qperp_x * qperp_x * s0_11
-                + qperp_z * qperp_z * s0_11 - q1_y * q1_z * s0_21 + qperp_w * qperp_x * s0_21 - qperp_y * qperp_z * s0_21
-                + qperp_x * qperp_y * s1_01 + qperp_w * qperp_z * s1_01 + q1_w * q1_z * (-s0_01 + s1_01) + q1_x * q1_x * (s0_11 - s1_11)
-                + s1_11 - q1_z * q1_z * s1_11 - qperp_x * qperp_x * s1_11 - qperp_z * qperp_z * s1_11 + q1_x * (q1_y * (-s0_01 + s1_01)
-                    + q1_w * (s0_21 - s1_21)) + q1_y * q1_z * s1_21 - qperp_w * qperp_x * s1_21 + qperp_y * qperp_z * s1_21
-                , -(qperp_x * qperp_y * s0_02) - qperp_w * qperp_z * s0_02 - s0_12 + q1_z * q1_z * s0_12 + qperp_x * qperp_x * s0_12
-                + qperp_z * qperp_z * s0_12 - q1_y * q1_z * s0_22 + qperp_w * qperp_x * s0_22 - qperp_y * qperp_z * s0_22
-                + qperp_x * qperp_y * s1_02 + qperp_w * qperp_z * s1_02 + q1_w * q1_z * (-s0_02 + s1_02) + q1_x * q1_x * (s0_12 - s1_12)
-                + s1_12 - q1_z * q1_z * s1_12 - qperp_x * qperp_x * s1_12 - qperp_z * qperp_z * s1_12 + q1_x * (q1_y * (-s0_02 + s1_02)
-                    + q1_w * (s0_22 - s1_22)) + q1_y * q1_z * s1_22 - qperp_w * qperp_x * s1_22 + qperp_y * qperp_z * s1_22);
-
-            c2[1] = DerivativeTerm(static_cast<T>(0.0F), qperp_x * qperp_y * s0_00 + qperp_w * qperp_z * s0_00 + q1_z * q1_z * s0_10
-                - qperp_x * qperp_x * s0_10 - qperp_z * qperp_z * s0_10 - q1_y * q1_z * s0_20 - qperp_w * qperp_x * s0_20
-                + qperp_y * qperp_z * s0_20 - qperp_x * qperp_y * s1_00 - qperp_w * qperp_z * s1_00 + q1_x * q1_x * (s0_10 - s1_10)
-                - q1_z * q1_z * s1_10 + qperp_x * qperp_x * s1_10 + qperp_z * qperp_z * s1_10 + q1_y * q1_z * s1_20
-                + qperp_w * qperp_x * s1_20 - qperp_y * qperp_z * s1_20 + static_cast<T>(2.0F) * q1_z * qperp_w * s0_00 * theta
-                + static_cast<T>(2.0F) * q1_y * qperp_x * s0_00 * theta - static_cast<T>(4.0F) * q1_z * qperp_z * s0_10 * theta
-                + static_cast<T>(2.0F) * q1_z * qperp_y * s0_20 * theta + static_cast<T>(2.0F) * q1_y * qperp_z * s0_20 * theta
-                + q1_x * (q1_w * s0_20 + q1_y * (-s0_00 + s1_00) - q1_w * s1_20 + static_cast<T>(2.0F) * qperp_y * s0_00 * theta
-                    - static_cast<T>(4.0F) * qperp_x * s0_10 * theta - static_cast<T>(2.0F) * qperp_w * s0_20 * theta)
-                + q1_w * (-(q1_z * s0_00) + q1_z * s1_00 + static_cast<T>(2.0F) * qperp_z * s0_00 * theta
-                    - static_cast<T>(2.0F) * qperp_x * s0_20 * theta)
-                , qperp_x * qperp_y * s0_01 + qperp_w * qperp_z * s0_01 + q1_z * q1_z * s0_11 - qperp_x * qperp_x * s0_11
-                - qperp_z * qperp_z * s0_11 - q1_y * q1_z * s0_21 - qperp_w * qperp_x * s0_21 + qperp_y * qperp_z * s0_21
-                - qperp_x * qperp_y * s1_01 - qperp_w * qperp_z * s1_01 + q1_x * q1_x * (s0_11 - s1_11) - q1_z * q1_z * s1_11
-                + qperp_x * qperp_x * s1_11 + qperp_z * qperp_z * s1_11 + q1_y * q1_z * s1_21 + qperp_w * qperp_x * s1_21
-                - qperp_y * qperp_z * s1_21 + static_cast<T>(2.0F) * q1_z * qperp_w * s0_01 * theta
-                + static_cast<T>(2.0F) * q1_y * qperp_x * s0_01 * theta
-                - static_cast<T>(4.0F) * q1_z * qperp_z * s0_11 * theta + static_cast<T>(2.0F) * q1_z * qperp_y * s0_21 * theta
-                + static_cast<T>(2.0F) * q1_y * qperp_z * s0_21 * theta + q1_x * (q1_w * s0_21 + q1_y * (-s0_01 + s1_01) - q1_w * s1_21
-                    + static_cast<T>(2.0F) * qperp_y * s0_01 * theta - static_cast<T>(4.0F) * qperp_x * s0_11 * theta
-                    - static_cast<T>(2.0F) * qperp_w * s0_21 * theta) + q1_w * (-(q1_z * s0_01) + q1_z * s1_01
-                        + static_cast<T>(2.0F) * qperp_z * s0_01 * theta
-                        - static_cast<T>(2.0F) * qperp_x * s0_21 * theta)
-                , qperp_x * qperp_y * s0_02 + qperp_w * qperp_z * s0_02 + q1_z * q1_z * s0_12 - qperp_x * qperp_x * s0_12
-                - qperp_z * qperp_z * s0_12 - q1_y * q1_z * s0_22 - qperp_w * qperp_x * s0_22 + qperp_y * qperp_z * s0_22
-                - qperp_x * qperp_y * s1_02 - qperp_w * qperp_z * s1_02 + q1_x * q1_x * (s0_12 - s1_12) - q1_z * q1_z * s1_12
-                + qperp_x * qperp_x * s1_12 + qperp_z * qperp_z * s1_12 + q1_y * q1_z * s1_22 + qperp_w * qperp_x * s1_22
-                - qperp_y * qperp_z * s1_22 + static_cast<T>(2.0F) * q1_z * qperp_w * s0_02 * theta
-                + static_cast<T>(2.0F) * q1_y * qperp_x * s0_02 * theta
-                - static_cast<T>(4.0F) * q1_z * qperp_z * s0_12 * theta + static_cast<T>(2.0F) * q1_z * qperp_y * s0_22 * theta
-                + static_cast<T>(2.0F) * q1_y * qperp_z * s0_22 * theta + q1_x * (q1_w * s0_22 + q1_y * (-s0_02 + s1_02) - q1_w * s1_22
-                    + static_cast<T>(2.0F) * qperp_y * s0_02 * theta - static_cast<T>(4.0F) * qperp_x * s0_12 * theta
-                    - static_cast<T>(2.0F) * qperp_w * s0_22 * theta) + q1_w * (-(q1_z * s0_02) + q1_z * s1_02
-                        + static_cast<T>(2.0F) * qperp_z * s0_02 * theta
-                        - static_cast<T>(2.0F) * qperp_x * s0_22 * theta));
-
-            c3[1] = DerivativeTerm(static_cast<T>(0.0F), static_cast<T>(2.0F) * (-(q1_x * qperp_y * s0_00) - q1_w * qperp_z * s0_00
-                + static_cast<T>(2.0F) * q1_x * qperp_x * s0_10 + q1_x * qperp_w * s0_20 + q1_w * qperp_x * s0_20
-                + q1_x * qperp_y * s1_00 + q1_w * qperp_z * s1_00 - static_cast<T>(2.0F) * q1_x * qperp_x * s1_10
-                - q1_x * qperp_w * s1_20 - q1_w * qperp_x * s1_20 + q1_z * (static_cast<T>(2.0F) * qperp_z * s0_10
-                    - qperp_y * s0_20 + qperp_w * (-s0_00 + s1_00) - static_cast<T>(2.0F) * qperp_z * s1_10
-                    + qperp_y * s1_20) + q1_y * (-(qperp_x * s0_00) - qperp_z * s0_20 + qperp_x * s1_00 + qperp_z * s1_20)) * theta
-                , static_cast<T>(2.0F) * (-(q1_x * qperp_y * s0_01) - q1_w * qperp_z * s0_01
-                    + static_cast<T>(2.0F) * q1_x * qperp_x * s0_11 + q1_x * qperp_w * s0_21
-                    + q1_w * qperp_x * s0_21 + q1_x * qperp_y * s1_01 + q1_w * qperp_z * s1_01
-                    - static_cast<T>(2.0F) * q1_x * qperp_x * s1_11 - q1_x * qperp_w * s1_21 - q1_w * qperp_x * s1_21
-                    + q1_z * (static_cast<T>(2.0F) * qperp_z * s0_11 - qperp_y * s0_21
-                        + qperp_w * (-s0_01 + s1_01) - static_cast<T>(2.0F) * qperp_z * s1_11 + qperp_y * s1_21)
-                    + q1_y * (-(qperp_x * s0_01) - qperp_z * s0_21 + qperp_x * s1_01 + qperp_z * s1_21)) * theta
-                , static_cast<T>(2.0F) * (-(q1_x * qperp_y * s0_02) - q1_w * qperp_z * s0_02
-                    + static_cast<T>(2.0F) * q1_x * qperp_x * s0_12 + q1_x * qperp_w * s0_22
-                    + q1_w * qperp_x * s0_22 + q1_x * qperp_y * s1_02 + q1_w * qperp_z * s1_02
-                    - static_cast<T>(2.0F) * q1_x * qperp_x * s1_12 - q1_x * qperp_w * s1_22 - q1_w * qperp_x * s1_22
-                    + q1_z * (static_cast<T>(2.0F) * qperp_z * s0_12 - qperp_y * s0_22
-                        + qperp_w * (-s0_02 + s1_02) - static_cast<T>(2.0F) * qperp_z * s1_12 + qperp_y * s1_22)
-                    + q1_y * (-(qperp_x * s0_02) - qperp_z * s0_22 + qperp_x * s1_02 + qperp_z * s1_22)) * theta);
-
-            c4[1] = DerivativeTerm(static_cast<T>(0.0F), -(q1_x * qperp_y * s0_00) - q1_w * qperp_z * s0_00
-                + static_cast<T>(2.0F) * q1_x * qperp_x * s0_10 + q1_x * qperp_w * s0_20 + q1_w * qperp_x * s0_20
-                + q1_x * qperp_y * s1_00 + q1_w * qperp_z * s1_00 - static_cast<T>(2.0F) * q1_x * qperp_x * s1_10
-                - q1_x * qperp_w * s1_20 - q1_w * qperp_x * s1_20 + static_cast<T>(2.0F) * qperp_x * qperp_y * s0_00 * theta
-                + static_cast<T>(2.0F) * qperp_w * qperp_z * s0_00 * theta + static_cast<T>(2.0F) * q1_x * q1_x * s0_10 * theta
-                + static_cast<T>(2.0F) * q1_z * q1_z * s0_10 * theta - static_cast<T>(2.0F) * qperp_x * qperp_x * s0_10 * theta
-                - static_cast<T>(2.0F) * qperp_z * qperp_z * s0_10 * theta + static_cast<T>(2.0F) * q1_w * q1_x * s0_20 * theta
-                - static_cast<T>(2.0F) * qperp_w * qperp_x * s0_20 * theta + static_cast<T>(2.0F) * qperp_y * qperp_z * s0_20 * theta
-                + q1_y * (-(qperp_x * s0_00) - qperp_z * s0_20 + qperp_x * s1_00 + qperp_z * s1_20
-                    - static_cast<T>(2.0F) * q1_x * s0_00 * theta) + q1_z * (static_cast<T>(2.0F) * qperp_z * s0_10
-                        - qperp_y * s0_20 + qperp_w * (-s0_00 + s1_00) - static_cast<T>(2.0F) * qperp_z * s1_10 + qperp_y * s1_20
-                        - static_cast<T>(2.0F) * q1_w * s0_00 * theta - static_cast<T>(2.0F) * q1_y * s0_20 * theta)
-                , -(q1_x * qperp_y * s0_01) - q1_w * qperp_z * s0_01 + static_cast<T>(2.0F) * q1_x * qperp_x * s0_11
-                + q1_x * qperp_w * s0_21 + q1_w * qperp_x * s0_21 + q1_x * qperp_y * s1_01 + q1_w * qperp_z * s1_01
-                - static_cast<T>(2.0F) * q1_x * qperp_x * s1_11 - q1_x * qperp_w * s1_21 - q1_w * qperp_x * s1_21
-                + static_cast<T>(2.0F) * qperp_x * qperp_y * s0_01 * theta + static_cast<T>(2.0F) * qperp_w * qperp_z * s0_01 * theta
-                + static_cast<T>(2.0F) * q1_x * q1_x * s0_11 * theta + static_cast<T>(2.0F) * q1_z * q1_z * s0_11 * theta
-                - static_cast<T>(2.0F) * qperp_x * qperp_x * s0_11 * theta - static_cast<T>(2.0F) * qperp_z * qperp_z * s0_11 * theta
-                + static_cast<T>(2.0F) * q1_w * q1_x * s0_21 * theta - static_cast<T>(2.0F) * qperp_w * qperp_x * s0_21 * theta
-                + static_cast<T>(2.0F) * qperp_y * qperp_z * s0_21 * theta + q1_y * (-(qperp_x * s0_01) - qperp_z * s0_21
-                    + qperp_x * s1_01 + qperp_z * s1_21 - static_cast<T>(2.0F) * q1_x * s0_01 * theta)
-                + q1_z * (static_cast<T>(2.0F) * qperp_z * s0_11 - qperp_y * s0_21 + qperp_w * (-s0_01 + s1_01)
-                    - static_cast<T>(2.0F) * qperp_z * s1_11 + qperp_y * s1_21 - static_cast<T>(2.0F) * q1_w * s0_01 * theta
-                    - static_cast<T>(2.0F) * q1_y * s0_21 * theta)
-                , -(q1_x * qperp_y * s0_02) - q1_w * qperp_z * s0_02 + static_cast<T>(2.0F) * q1_x * qperp_x * s0_12
-                + q1_x * qperp_w * s0_22 + q1_w * qperp_x * s0_22 + q1_x * qperp_y * s1_02 + q1_w * qperp_z * s1_02
-                - static_cast<T>(2.0F) * q1_x * qperp_x * s1_12 - q1_x * qperp_w * s1_22 - q1_w * qperp_x * s1_22
-                + static_cast<T>(2.0F) * qperp_x * qperp_y * s0_02 * theta + static_cast<T>(2.0F) * qperp_w * qperp_z * s0_02 * theta
-                + static_cast<T>(2.0F) * q1_x * q1_x * s0_12 * theta + static_cast<T>(2.0F) * q1_z * q1_z * s0_12 * theta
-                - static_cast<T>(2.0F) * qperp_x * qperp_x * s0_12 * theta - static_cast<T>(2.0F) * qperp_z * qperp_z * s0_12 * theta
-                + static_cast<T>(2.0F) * q1_w * q1_x * s0_22 * theta - static_cast<T>(2.0F) * qperp_w * qperp_x * s0_22 * theta
-                + static_cast<T>(2.0F) * qperp_y * qperp_z * s0_22 * theta + q1_y * (-(qperp_x * s0_02) - qperp_z * s0_22
-                    + qperp_x * s1_02 + qperp_z * s1_22 - static_cast<T>(2.0F) * q1_x * s0_02 * theta)
-                + q1_z * (static_cast<T>(2.0F) * qperp_z * s0_12 - qperp_y * s0_22 + qperp_w * (-s0_02 + s1_02)
-                    - static_cast<T>(2.0F) * qperp_z * s1_12 + qperp_y * s1_22 - static_cast<T>(2.0F) * q1_w * s0_02 * theta
-                    - static_cast<T>(2.0F) * q1_y * s0_22 * theta));
-
-            c5[1] = DerivativeTerm(static_cast<T>(0.0F), -static_cast<T>(2.0F) * (qperp_x * qperp_y * s0_00 + qperp_w * qperp_z * s0_00
-                + q1_z * q1_z * s0_10 - qperp_x * qperp_x * s0_10 - qperp_z * qperp_z * s0_10 - q1_y * q1_z * s0_20
-                - qperp_w * qperp_x * s0_20 + qperp_y * qperp_z * s0_20 - qperp_x * qperp_y * s1_00 - qperp_w * qperp_z * s1_00
-                + q1_w * q1_z * (-s0_00 + s1_00) + q1_x * q1_x * (s0_10 - s1_10) - q1_z * q1_z * s1_10 + qperp_x * qperp_x * s1_10
-                + qperp_z * qperp_z * s1_10 + q1_x * (q1_y * (-s0_00 + s1_00) + q1_w * (s0_20 - s1_20)) + q1_y * q1_z * s1_20
-                + qperp_w * qperp_x * s1_20 - qperp_y * qperp_z * s1_20) * theta
-                , -static_cast<T>(2.0F) * (qperp_x * qperp_y * s0_01 + qperp_w * qperp_z * s0_01 + q1_z * q1_z * s0_11
-                    - qperp_x * qperp_x * s0_11 - qperp_z * qperp_z * s0_11 - q1_y * q1_z * s0_21 - qperp_w * qperp_x * s0_21
-                    + qperp_y * qperp_z * s0_21 - qperp_x * qperp_y * s1_01 - qperp_w * qperp_z * s1_01 + q1_w * q1_z * (-s0_01 + s1_01)
-                    + q1_x * q1_x * (s0_11 - s1_11) - q1_z * q1_z * s1_11 + qperp_x * qperp_x * s1_11 + qperp_z * qperp_z * s1_11
-                    + q1_x * (q1_y * (-s0_01 + s1_01) + q1_w * (s0_21 - s1_21)) + q1_y * q1_z * s1_21 + qperp_w * qperp_x * s1_21
-                    - qperp_y * qperp_z * s1_21) * theta
-                , -static_cast<T>(2.0F) * (qperp_x * qperp_y * s0_02 + qperp_w * qperp_z * s0_02 + q1_z * q1_z * s0_12
-                    - qperp_x * qperp_x * s0_12 - qperp_z * qperp_z * s0_12 - q1_y * q1_z * s0_22 - qperp_w * qperp_x * s0_22
-                    + qperp_y * qperp_z * s0_22 - qperp_x * qperp_y * s1_02 - qperp_w * qperp_z * s1_02 + q1_w * q1_z * (-s0_02 + s1_02)
-                    + q1_x * q1_x * (s0_12 - s1_12) - q1_z * q1_z * s1_12 + qperp_x * qperp_x * s1_12 + qperp_z * qperp_z * s1_12
-                    + q1_x * (q1_y * (-s0_02 + s1_02) + q1_w * (s0_22 - s1_22)) + q1_y * q1_z * s1_22 + qperp_w * qperp_x * s1_22
-                    - qperp_y * qperp_z * s1_22) * theta);
-
-            c1[2] = DerivativeTerm(-t0_z + t1_z, (qperp_w * qperp_y * s0_00 - qperp_x * qperp_z * s0_00
-                - q1_y * q1_z * s0_10 - qperp_w * qperp_x * s0_10 - qperp_y * qperp_z * s0_10 - s0_20 + q1_y * q1_y * s0_20
-                + qperp_x * qperp_x * s0_20 + qperp_y * qperp_y * s0_20 - qperp_w * qperp_y * s1_00 + qperp_x * qperp_z * s1_00
-                + q1_x * q1_z * (-s0_00 + s1_00) + q1_y * q1_z * s1_10 + qperp_w * qperp_x * s1_10 + qperp_y * qperp_z * s1_10
-                + q1_w * (q1_y * (s0_00 - s1_00) + q1_x * (-s0_10 + s1_10)) + q1_x * q1_x * (s0_20 - s1_20) + s1_20 - q1_y * q1_y * s1_20
-                - qperp_x * qperp_x * s1_20 - qperp_y * qperp_y * s1_20)
-                , (qperp_w * qperp_y * s0_01 - qperp_x * qperp_z * s0_01 - q1_y * q1_z * s0_11 - qperp_w * qperp_x * s0_11
-                    - qperp_y * qperp_z * s0_11 - s0_21 + q1_y * q1_y * s0_21 + qperp_x * qperp_x * s0_21 + qperp_y * qperp_y * s0_21
-                    - qperp_w * qperp_y * s1_01 + qperp_x * qperp_z * s1_01 + q1_x * q1_z * (-s0_01 + s1_01) + q1_y * q1_z * s1_11
-                    + qperp_w * qperp_x * s1_11 + qperp_y * qperp_z * s1_11 + q1_w * (q1_y * (s0_01 - s1_01) + q1_x * (-s0_11 + s1_11))
-                    + q1_x * q1_x * (s0_21 - s1_21) + s1_21 - q1_y * q1_y * s1_21 - qperp_x * qperp_x * s1_21 - qperp_y * qperp_y * s1_21)
-                , (qperp_w * qperp_y * s0_02 - qperp_x * qperp_z * s0_02 - q1_y * q1_z * s0_12 - qperp_w * qperp_x * s0_12
-                    - qperp_y * qperp_z * s0_12 - s0_22 + q1_y * q1_y * s0_22 + qperp_x * qperp_x * s0_22 + qperp_y * qperp_y * s0_22
-                    - qperp_w * qperp_y * s1_02 + qperp_x * qperp_z * s1_02 + q1_x * q1_z * (-s0_02 + s1_02) + q1_y * q1_z * s1_12
-                    + qperp_w * qperp_x * s1_12 + qperp_y * qperp_z * s1_12 + q1_w * (q1_y * (s0_02 - s1_02) + q1_x * (-s0_12 + s1_12))
-                    + q1_x * q1_x * (s0_22 - s1_22) + s1_22 - q1_y * q1_y * s1_22 - qperp_x * qperp_x * s1_22 - qperp_y * qperp_y * s1_22));
-
-            c2[2] = DerivativeTerm(static_cast<T>(0.0F), (q1_w * q1_y * s0_00 - q1_x * q1_z * s0_00 - qperp_w * qperp_y * s0_00
-                + qperp_x * qperp_z * s0_00 - q1_w * q1_x * s0_10 - q1_y * q1_z * s0_10 + qperp_w * qperp_x * s0_10
-                + qperp_y * qperp_z * s0_10 + q1_x * q1_x * s0_20 + q1_y * q1_y * s0_20 - qperp_x * qperp_x * s0_20
-                - qperp_y * qperp_y * s0_20 - q1_w * q1_y * s1_00 + q1_x * q1_z * s1_00 + qperp_w * qperp_y * s1_00
-                - qperp_x * qperp_z * s1_00 + q1_w * q1_x * s1_10 + q1_y * q1_z * s1_10 - qperp_w * qperp_x * s1_10
-                - qperp_y * qperp_z * s1_10 - q1_x * q1_x * s1_20 - q1_y * q1_y * s1_20 + qperp_x * qperp_x * s1_20
-                + qperp_y * qperp_y * s1_20 - static_cast<T>(2.0F) * q1_y * qperp_w * s0_00 * theta
-                + static_cast<T>(2.0F) * q1_z * qperp_x * s0_00 * theta
-                - static_cast<T>(2.0F) * q1_w * qperp_y * s0_00 * theta + static_cast<T>(2.0F) * q1_x * qperp_z * s0_00 * theta
-                + static_cast<T>(2.0F) * q1_x * qperp_w * s0_10 * theta + static_cast<T>(2.0F) * q1_w * qperp_x * s0_10 * theta
-                + static_cast<T>(2.0F) * q1_z * qperp_y * s0_10 * theta + static_cast<T>(2.0F) * q1_y * qperp_z * s0_10 * theta
-                - static_cast<T>(4.0F) * q1_x * qperp_x * s0_20 * theta
-                - static_cast<T>(4.0F) * q1_y * qperp_y * s0_20 * theta)
-                , (q1_w * q1_y * s0_01 - q1_x * q1_z * s0_01 - qperp_w * qperp_y * s0_01 + qperp_x * qperp_z * s0_01
-                    - q1_w * q1_x * s0_11 - q1_y * q1_z * s0_11 + qperp_w * qperp_x * s0_11 + qperp_y * qperp_z * s0_11
-                    + q1_x * q1_x * s0_21 + q1_y * q1_y * s0_21 - qperp_x * qperp_x * s0_21 - qperp_y * qperp_y * s0_21
-                    - q1_w * q1_y * s1_01 + q1_x * q1_z * s1_01 + qperp_w * qperp_y * s1_01 - qperp_x * qperp_z * s1_01
-                    + q1_w * q1_x * s1_11 + q1_y * q1_z * s1_11 - qperp_w * qperp_x * s1_11 - qperp_y * qperp_z * s1_11
-                    - q1_x * q1_x * s1_21 - q1_y * q1_y * s1_21 + qperp_x * qperp_x * s1_21 + qperp_y * qperp_y * s1_21
-                    - static_cast<T>(2.0F) * q1_y * qperp_w * s0_01 * theta + static_cast<T>(2.0F) * q1_z * qperp_x * s0_01 * theta
-                    - static_cast<T>(2.0F) * q1_w * qperp_y * s0_01 * theta + static_cast<T>(2.0F) * q1_x * qperp_z * s0_01 * theta
-                    + static_cast<T>(2.0F) * q1_x * qperp_w * s0_11 * theta + static_cast<T>(2.0F) * q1_w * qperp_x * s0_11 * theta
-                    + static_cast<T>(2.0F) * q1_z * qperp_y * s0_11 * theta + static_cast<T>(2.0F) * q1_y * qperp_z * s0_11 * theta
-                    - static_cast<T>(4.0F) * q1_x * qperp_x * s0_21 * theta - 4 * q1_y * qperp_y * s0_21 * theta)
-                , (q1_w * q1_y * s0_02 - q1_x * q1_z * s0_02 - qperp_w * qperp_y * s0_02 + qperp_x * qperp_z * s0_02
-                    - q1_w * q1_x * s0_12 - q1_y * q1_z * s0_12 + qperp_w * qperp_x * s0_12 + qperp_y * qperp_z * s0_12
-                    + q1_x * q1_x * s0_22 + q1_y * q1_y * s0_22 - qperp_x * qperp_x * s0_22 - qperp_y * qperp_y * s0_22
-                    - q1_w * q1_y * s1_02 + q1_x * q1_z * s1_02 + qperp_w * qperp_y * s1_02 - qperp_x * qperp_z * s1_02
-                    + q1_w * q1_x * s1_12 + q1_y * q1_z * s1_12 - qperp_w * qperp_x * s1_12 - qperp_y * qperp_z * s1_12
-                    - q1_x * q1_x * s1_22 - q1_y * q1_y * s1_22 + qperp_x * qperp_x * s1_22 + qperp_y * qperp_y * s1_22
-                    - static_cast<T>(2.0F) * q1_y * qperp_w * s0_02 * theta + static_cast<T>(2.0F) * q1_z * qperp_x * s0_02 * theta
-                    - static_cast<T>(2.0F) * q1_w * qperp_y * s0_02 * theta + static_cast<T>(2.0F) * q1_x * qperp_z * s0_02 * theta
-                    + static_cast<T>(2.0F) * q1_x * qperp_w * s0_12 * theta + static_cast<T>(2.0F) * q1_w * qperp_x * s0_12 * theta
-                    + static_cast<T>(2.0F) * q1_z * qperp_y * s0_12 * theta
-                    + static_cast<T>(2.0F) * q1_y * qperp_z * s0_12 * theta - static_cast<T>(4.0F) * q1_x * qperp_x * s0_22 * theta
-                    - static_cast<T>(4.0F) * q1_y * qperp_y * s0_22 * theta));
-
-            c3[2] = DerivativeTerm(static_cast<T>(0.0F), -static_cast<T>(2.0F) * (-(q1_w * qperp_y * s0_00) + q1_x * qperp_z * s0_00
-                + q1_x * qperp_w * s0_10 + q1_w * qperp_x * s0_10 - static_cast<T>(2.0F) * q1_x * qperp_x * s0_20 + q1_w * qperp_y * s1_00
-                - q1_x * qperp_z * s1_00 - q1_x * qperp_w * s1_10 - q1_w * qperp_x * s1_10 + q1_z * (qperp_x * s0_00
-                    + qperp_y * s0_10 - qperp_x * s1_00 - qperp_y * s1_10) + static_cast<T>(2.0F) * q1_x * qperp_x * s1_20
-                + q1_y * (qperp_z * s0_10 - static_cast<T>(2.0F) * qperp_y * s0_20 + qperp_w * (-s0_00 + s1_00) - qperp_z * s1_10
-                    + static_cast<T>(2.0F) * qperp_y * s1_20)) * theta
-                , -static_cast<T>(2.0F) * (-(q1_w * qperp_y * s0_01) + q1_x * qperp_z * s0_01 + q1_x * qperp_w * s0_11
-                    + q1_w * qperp_x * s0_11 - static_cast<T>(2.0F) * q1_x * qperp_x * s0_21 + q1_w * qperp_y * s1_01
-                    - q1_x * qperp_z * s1_01 - q1_x * qperp_w * s1_11 - q1_w * qperp_x * s1_11 + q1_z * (qperp_x * s0_01
-                        + qperp_y * s0_11 - qperp_x * s1_01 - qperp_y * s1_11) + static_cast<T>(2.0F) * q1_x * qperp_x * s1_21
-                    + q1_y * (qperp_z * s0_11 - static_cast<T>(2.0F) * qperp_y * s0_21 + qperp_w * (-s0_01 + s1_01) - qperp_z * s1_11
-                        + static_cast<T>(2.0F) * qperp_y * s1_21)) * theta
-                , -static_cast<T>(2.0F) * (-(q1_w * qperp_y * s0_02) + q1_x * qperp_z * s0_02 + q1_x * qperp_w * s0_12 + q1_w * qperp_x * s0_12
-                    - static_cast<T>(2.0F) * q1_x * qperp_x * s0_22 + q1_w * qperp_y * s1_02 - q1_x * qperp_z * s1_02 - q1_x * qperp_w * s1_12
-                    - q1_w * qperp_x * s1_12 + q1_z * (qperp_x * s0_02 + qperp_y * s0_12 - qperp_x * s1_02 - qperp_y * s1_12)
-                    + static_cast<T>(2.0F) * q1_x * qperp_x * s1_22 + q1_y * (qperp_z * s0_12 - static_cast<T>(2.0F) * qperp_y * s0_22
-                        + qperp_w * (-s0_02 + s1_02) - qperp_z * s1_12 + static_cast<T>(2.0F) * qperp_y * s1_22)) * theta);
-
-            c4[2] = DerivativeTerm(static_cast<T>(0.0F), q1_w * qperp_y * s0_00 - q1_x * qperp_z * s0_00 - q1_x * qperp_w * s0_10
-                - q1_w * qperp_x * s0_10 + static_cast<T>(2.0F) * q1_x * qperp_x * s0_20 - q1_w * qperp_y * s1_00 + q1_x * qperp_z * s1_00
-                + q1_x * qperp_w * s1_10 + q1_w * qperp_x * s1_10 - static_cast<T>(2.0F) * q1_x * qperp_x * s1_20
-                - static_cast<T>(2.0F) * qperp_w * qperp_y * s0_00 * theta + static_cast<T>(2.0F) * qperp_x * qperp_z * s0_00 * theta
-                - static_cast<T>(2.0F) * q1_w * q1_x * s0_10 * theta + static_cast<T>(2.0F) * qperp_w * qperp_x * s0_10 * theta
-                + static_cast<T>(2.0F) * qperp_y * qperp_z * s0_10 * theta + static_cast<T>(2.0F) * q1_x * q1_x * s0_20 * theta
-                + static_cast<T>(2.0F) * q1_y * q1_y * s0_20 * theta - static_cast<T>(2.0F) * qperp_x * qperp_x * s0_20 * theta
-                - static_cast<T>(2.0F) * qperp_y * qperp_y * s0_20 * theta + q1_z * (-(qperp_x * s0_00) - qperp_y * s0_10
-                    + qperp_x * s1_00 + qperp_y * s1_10 - static_cast<T>(2.0F) * q1_x * s0_00 * theta) + q1_y * (-(qperp_z * s0_10)
-                        + static_cast<T>(2.0F) * qperp_y * s0_20 + qperp_w * (s0_00 - s1_00) + qperp_z * s1_10
-                        - static_cast<T>(2.0F) * qperp_y * s1_20
-                        + static_cast<T>(2.0F) * q1_w * s0_00 * theta - static_cast<T>(2.0F) * q1_z * s0_10 * theta)
-                , q1_w * qperp_y * s0_01 - q1_x * qperp_z * s0_01 - q1_x * qperp_w * s0_11 - q1_w * qperp_x * s0_11
-                + static_cast<T>(2.0F) * q1_x * qperp_x * s0_21 - q1_w * qperp_y * s1_01 + q1_x * qperp_z * s1_01 + q1_x * qperp_w * s1_11
-                + q1_w * qperp_x * s1_11 - static_cast<T>(2.0F) * q1_x * qperp_x * s1_21
-                - static_cast<T>(2.0F) * qperp_w * qperp_y * s0_01 * theta
-                + static_cast<T>(2.0F) * qperp_x * qperp_z * s0_01 * theta - static_cast<T>(2.0F) * q1_w * q1_x * s0_11 * theta
-                + static_cast<T>(2.0F) * qperp_w * qperp_x * s0_11 * theta + static_cast<T>(2.0F) * qperp_y * qperp_z * s0_11 * theta
-                + static_cast<T>(2.0F) * q1_x * q1_x * s0_21 * theta + static_cast<T>(2.0F) * q1_y * q1_y * s0_21 * theta
-                - static_cast<T>(2.0F) * qperp_x * qperp_x * s0_21 * theta - static_cast<T>(2.0F) * qperp_y * qperp_y * s0_21 * theta
-                + q1_z * (-(qperp_x * s0_01) - qperp_y * s0_11 + qperp_x * s1_01 + qperp_y * s1_11 - static_cast<T>(2.0F) * q1_x * s0_01 * theta)
-                + q1_y * (-(qperp_z * s0_11) + static_cast<T>(2.0F) * qperp_y * s0_21 + qperp_w * (s0_01 - s1_01) + qperp_z * s1_11
-                    - static_cast<T>(2.0F) * qperp_y * s1_21 + static_cast<T>(2.0F) * q1_w * s0_01 * theta
-                    - static_cast<T>(2.0F) * q1_z * s0_11 * theta)
-                , q1_w * qperp_y * s0_02 - q1_x * qperp_z * s0_02 - q1_x * qperp_w * s0_12 - q1_w * qperp_x * s0_12
-                + static_cast<T>(2.0F) * q1_x * qperp_x * s0_22 - q1_w * qperp_y * s1_02 + q1_x * qperp_z * s1_02 + q1_x * qperp_w * s1_12
-                + q1_w * qperp_x * s1_12 - static_cast<T>(2.0F) * q1_x * qperp_x * s1_22
-                - static_cast<T>(2.0F) * qperp_w * qperp_y * s0_02 * theta
-                + static_cast<T>(2.0F) * qperp_x * qperp_z * s0_02 * theta - static_cast<T>(2.0F) * q1_w * q1_x * s0_12 * theta
-                + static_cast<T>(2.0F) * qperp_w * qperp_x * s0_12 * theta + static_cast<T>(2.0F) * qperp_y * qperp_z * s0_12 * theta
-                + static_cast<T>(2.0F) * q1_x * q1_x * s0_22 * theta + static_cast<T>(2.0F) * q1_y * q1_y * s0_22 * theta
-                - static_cast<T>(2.0F) * qperp_x * qperp_x * s0_22 * theta - static_cast<T>(2.0F) * qperp_y * qperp_y * s0_22 * theta
-                + q1_z * (-(qperp_x * s0_02) - qperp_y * s0_12 + qperp_x * s1_02 + qperp_y * s1_12
-                    - static_cast<T>(2.0F) * q1_x * s0_02 * theta)
-                + q1_y * (-(qperp_z * s0_12) + static_cast<T>(2.0F) * qperp_y * s0_22 + qperp_w * (s0_02 - s1_02) + qperp_z * s1_12
-                    - static_cast<T>(2.0F) * qperp_y * s1_22 + static_cast<T>(2.0F) * q1_w * s0_02 * theta
-                    - static_cast<T>(2.0F) * q1_z * s0_12 * theta));
-
-            c5[2] = DerivativeTerm(static_cast<T>(0.0F), static_cast<T>(2.0F) * (qperp_w * qperp_y * s0_00 - qperp_x * qperp_z * s0_00
-                + q1_y * q1_z * s0_10 - qperp_w * qperp_x * s0_10 - qperp_y * qperp_z * s0_10 - q1_y * q1_y * s0_20
-                + qperp_x * qperp_x * s0_20 + qperp_y * qperp_y * s0_20 + q1_x * q1_z * (s0_00 - s1_00)
-                - qperp_w * qperp_y * s1_00 + qperp_x * qperp_z * s1_00 + q1_w * (q1_y * (-s0_00 + s1_00)
-                    + q1_x * (s0_10 - s1_10)) - q1_y * q1_z * s1_10 + qperp_w * qperp_x * s1_10 + qperp_y * qperp_z * s1_10
-                + q1_y * q1_y * s1_20 - qperp_x * qperp_x * s1_20 - qperp_y * qperp_y * s1_20
-                + q1_x * q1_x * (-s0_20 + s1_20)) * theta
-                , static_cast<T>(2.0F) * (qperp_w * qperp_y * s0_01 - qperp_x * qperp_z * s0_01 + q1_y * q1_z * s0_11
-                    - qperp_w * qperp_x * s0_11 - qperp_y * qperp_z * s0_11 - q1_y * q1_y * s0_21 + qperp_x * qperp_x * s0_21
-                    + qperp_y * qperp_y * s0_21 + q1_x * q1_z * (s0_01 - s1_01) - qperp_w * qperp_y * s1_01
-                    + qperp_x * qperp_z * s1_01 + q1_w * (q1_y * (-s0_01 + s1_01) + q1_x * (s0_11 - s1_11))
-                    - q1_y * q1_z * s1_11 + qperp_w * qperp_x * s1_11 + qperp_y * qperp_z * s1_11 + q1_y * q1_y * s1_21
-                    - qperp_x * qperp_x * s1_21 - qperp_y * qperp_y * s1_21 + q1_x * q1_x * (-s0_21 + s1_21)) * theta
-                , static_cast<T>(2.0F) * (qperp_w * qperp_y * s0_02 - qperp_x * qperp_z * s0_02 + q1_y * q1_z * s0_12
-                    - qperp_w * qperp_x * s0_12
-                    - qperp_y * qperp_z * s0_12 - q1_y * q1_y * s0_22 + qperp_x * qperp_x * s0_22 + qperp_y * qperp_y * s0_22
-                    + q1_x * q1_z * (s0_02 - s1_02) - qperp_w * qperp_y * s1_02 + qperp_x * qperp_z * s1_02
-                    + q1_w * (q1_y * (-s0_02 + s1_02) + q1_x * (s0_12 - s1_12)) - q1_y * q1_z * s1_12 + qperp_w * qperp_x * s1_12
-                    + qperp_y * qperp_z * s1_12 + q1_y * q1_y * s1_22 - qperp_x * qperp_x * s1_22 - qperp_y * qperp_y * s1_22
-                    + q1_x * q1_x * (-s0_22 + s1_22)) * theta);
+            rotation_perp = Normalize(rotations[1] - rotations[0] * cos_theta);
+        }
+
+        delta_translation = translations[1] - translations[0];
+        T scale_norm[2] = { static_cast<T>(0.0F), static_cast<T>(0.0F) };
+        T delta_scale_norm = static_cast<T>(0.0F);
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                delta_scales[i][j] = (scales[1])[i][j] - (scales[0])[i][j];
+                scale_norm[0] += (scales[0])[i][j] * (scales[0])[i][j];
+                scale_norm[1] += (scales[1])[i][j] * (scales[1])[i][j];
+                delta_scale_norm += delta_scales[i][j] * delta_scales[i][j];
+            }
+        }
+
+        // x(t) = R(t) S(t) p + T(t) with T and S linear and R turning at a
+        // constant rate 2 theta about a fixed axis, so |x''| <= |p| times
+        // (2 theta)^2 |S| + 2 (2 theta) |S'|, with Frobenius norms bounding
+        // the spectral ones
+        T omega = static_cast<T>(2.0F) * theta;
+        motion_curvature = omega * omega * std::sqrt((std::max)(scale_norm[0], scale_norm[1]))
+            + static_cast<T>(2.0F) * omega * std::sqrt(delta_scale_norm);
+
+        for (int i = 0; i <= MOTION_STEPS; ++i)
+        {
+            Evaluate(static_cast<T>(i) / MOTION_STEPS, &(keyframes[i]));
         }
     }
 
@@ -479,28 +205,30 @@ public:
         translation->y = m[1][3];
         translation->z = m[2][3];
 
-        // Compute new transformation matrix _M_ without translation
-        Mat4<T> M = m;
+        // The upper 3x3 block _M_ holds rotation and scale; it is inverted
+        // directly, as Mat4 Inverse() is not implemented yet
+        T M[3][3], rotation[3][3];
         for (int i = 0; i < 3; ++i)
         {
-            M[i][3] = M[3][i] = static_cast<T>(0.0F);
+            for (int j = 0; j < 3; ++j)
+            {
+                M[i][j] = rotation[i][j] = m[i][j];
+            }
         }
-        M[3][3] = static_cast<T>(1.0F);
 
         // Extract rotation _R_ from transformation matrix
         T norm;
         int count = 0;
-        Mat4<T> rotation = M;
         do
         {
             // Compute next matrix _Rnext_ in series
-            Mat4<T> Rnext;
-            Mat4<T> Rit = Inverse(Transpose(rotation));
-            for (int i = 0; i < 4; ++i)
+            T Rnext[3][3], Ri[3][3];
+            Inverse3(rotation, Ri);
+            for (int i = 0; i < 3; ++i)
             {
-                for (int j = 0; j < 4; ++j)
+                for (int j = 0; j < 3; ++j)
                 {
-                    Rnext[i][j] = static_cast<T>(0.5F) * (rotation[i][j] + Rit[i][j]);
+                    Rnext[i][j] = static_cast<T>(0.5F) * (rotation[i][j] + Ri[j][i]);
                 }
             }
 
@@ -512,15 +240,33 @@ public:
                     + std::abs(rotation[i][1] - Rnext[i][1])
                     + std::abs(rotation[i][2] - Rnext[i][2]);
                 norm = (std::max)(norm, n);
+                for (int j = 0; j < 3; ++j)
+                {
+                    rotation[i][j] = Rnext[i][j];
+                }
             }
-            rotation = Rnext;
         }
         while (++count < 100 && norm > static_cast<T>(0.0001F));
         // XXX TODO FIXME deal with flip...
-        *rotation_quat = Quaternion<T>(rotation);
 
-        // Compute scale _S_ using rotation and original matrix
-        *scale = Mul(Inverse(rotation), M);
+        // Compute scale _S_ = R^T M using rotation and original matrix
+        Mat4<T> R;
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                if (i < 3 && j < 3)
+                {
+                    R[i][j] = rotation[i][j];
+                    (*scale)[i][j] = rotation[0][i] * M[0][j] + rotation[1][i] * M[1][j] + rotation[2][i] * M[2][j];
+                }
+                else
+                {
+                    R[i][j] = (*scale)[i][j] = i == j ? static_cast<T>(1.0F) : static_cast<T>(0.0F);
+                }
+            }
+        }
+        *rotation_quat = Quaternion<T>(Transform<T>(R, Transpose(R)));
     }
 
     void Interpolate(T time, Transform<T> *t) const
@@ -536,26 +282,51 @@ public:
             *t = *p_end_transform;
             return;
         }
-        T dt = (time - start_time) / (end_time - start_time);
-        // Interpolate translation at _dt_
-        Vec3<T> trans = (static_cast<T>(1.0F) - dt) * translations[0] + dt * translations[1];
-
-        // Interpolate rotation at _dt_
-        Quaternion<T> rotate = Slerp(dt, rotations[0], rotations[1]);
 
-        // Interpolate scale at _dt_
-        Mat4<T> scale;
+        T dt = (time - start_time) / (end_time - start_time);
+        Vec3<T> trans;
+        T rotation[3][3], scale[3][3];
+        Components(dt, &trans, rotation, scale);
+
+        // M = T R S, and its inverse S^-1 R^T T^-1 needs only the 3x3 inverse
+        // of the interpolated scale
+        T inv_scale[3][3];
+        Inverse3(scale, inv_scale);
+        Mat4<T> m, inv_m;
         for (int i = 0; i < 3; ++i)
         {
             for (int j = 0; j < 3; ++j)
             {
-                scale[i][j] = Lerp(dt, (scales[0])[i][j], (scales[1])[i][j]);
+                m[i][j] = rotation[i][0] * scale[0][j] + rotation[i][1] * scale[1][j] + rotation[i][2] * scale[2][j];
+                inv_m[i][j] = inv_scale[i][0] * rotation[j][0] + inv_scale[i][1] * rotation[j][1]
+                    + inv_scale[i][2] * rotation[j][2];
             }
         }
+        for (int i = 0; i < 3; ++i)
+        {
+            m[i][3] = trans[i];
+            inv_m[i][3] = -(inv_m[i][0] * trans.x + inv_m[i][1] * trans.y + inv_m[i][2] * trans.z);
+            m[3][i] = inv_m[3][i] = static_cast<T>(0.0F);
+        }
+        m[3][3] = inv_m[3][3] = static_cast<T>(1.0F);
+        *t = Transform<T>(m, inv_m);
+    }
 
-        // Compute interpolated matrix as product of interpolated components
-        // TOOO
-        //*t = Translate(trans) * rotate.ToTransform() * Transform(scale);
+    // The matrix at _time_ without building a Transform
+    void Interpolate(T time, AffineColumns<T> *a) const
+    {
+        if (!is_actually_animated || time <= start_time)
+        {
+            *a = ends[0];
+        }
+        else if (time >= end_time)
+        {
+            *a = ends[1];
+        }
+        else
+        {
+            Evaluate((time - start_time) / (end_time - start_time), a);
+        }
     }
 
     bool HasScale() const
@@ -564,125 +335,257 @@ public:
     }
 
 
+    Vec3<T> ApplyPoint(T time, const Vec3<T> &p) const
+    {
+        AffineColumns<T> a;
+        Interpolate(time, &a);
+        return a.ApplyPoint(p);
+    }
+
+    Vec3<T> ApplyVector(T time, const Vec3<T> &v) const
+    {
+        AffineColumns<T> a;
+        Interpolate(time, &a);
+        return a.ApplyVector(v);
+    }
+
     Ray<T> operator()(const Ray<T> &r) const
     {
-        if (!is_actually_animated || r.time <= start_time)
+        AffineColumns<T> a;
+        Interpolate(r.time, &a);
+        return Apply(a, r);
+    }
+
+    RayDifferential<T> operator()(const RayDifferential<T> &r) const
+    {
+        AffineColumns<T> a;
+        Interpolate(r.time, &a);
+        RayDifferential<T> ret(Apply(a, static_cast<const Ray<T> &>(r)));
+        ret.has_differentials = r.has_differentials;
+        ret.rx_origin = a.ApplyPoint(r.rx_origin);
+        ret.ry_origin = a.ApplyPoint(r.ry_origin);
+        ret.rx_direction = a.ApplyVector(r.rx_direction);
+        ret.ry_direction = a.ApplyVector(r.ry_direction);
+        return ret;
+    }
+
+    Vec3<T> operator()(T time, const Vec3<T> &v) const
+    {
+        return ApplyVector(time, v);
+    }
+
+
+    // Bounds of _b_ over the whole motion: the union of its exact bounds at
+    // MOTION_STEPS + 1 precomputed keyframes, grown by how far a corner's
+    // path can bulge out of the chords between them. The bulge is at most
+    // |x''| h^2 / 8 for keyframe spacing h, which keeps the bounds within a
+    // fraction of a percent of the swept volume without solving for the
+    // zeros of the motion derivative.
+    Bounds3<T> MotionBounds(const Bounds3<T> &b) const
+    {
+        if (!is_actually_animated)
         {
-            return (*p_start_transform)(r);
+            return ends[0].ApplyBounds(b);
         }
-        else if (r.time >= end_time)
+        T radius = Length(Max(Abs(b.point_min), Abs(b.point_max)));
+        if (!has_rotation)
         {
-            return (*p_end_transform)(r);
+            // Scale and translation are linear in time, and the small
+            // rotation left is lerped, so a single chord between the ends
+            // bulges by little
+            return Pad(Union(ends[0].ApplyBounds(b), ends[1].ApplyBounds(b)), radius, static_cast<T>(1.0F));
         }
-        else
+
+        Bounds3<T> bounds = keyframes[0].ApplyBounds(b);
+        for (int i = 1; i <= MOTION_STEPS; ++i)
         {
-            Transform<T> t;
-            Interpolate(r.time, &t);
-            return t(r);
+            bounds = Union(bounds, keyframes[i].ApplyBounds(b));
         }
+        return Pad(bounds, radius, static_cast<T>(1.0F) / MOTION_STEPS);
     }
 
-    RayDifferential<T> operator()(const RayDifferential<T> &r) const
+    // Bounds of _b_ over [time0, time1] only. The transforms interpolated at
+    // two times are joined by the same slerp and the same linear scale and
+    // translation, so that part of the motion is itself an AnimatedTransform.
+    Bounds3<T> MotionBounds(const Bounds3<T> &b, T time0, T time1) const
     {
-        if (!is_actually_animated || r.time <= start_time) return (*p_start_transform)(r);
-        else if (r.time >= end_time) return (*p_end_transform)(r);
-        else
+        if (!is_actually_animated || (time0 <= start_time && time1 >= end_time))
         {
-            Transform<T> t;
-            Interpolate(r.time, &t);
-            return t(r);
+            return MotionBounds(b);
         }
+        Transform<T> t0, t1;
+        Interpolate(time0, &t0);
+        Interpolate(time1, &t1);
+        return AnimatedTransform(&t0, time0, &t1, time1).MotionBounds(b);
     }
 
-    Vec3<T> operator()(T time, const Vec3<T> &v) const
+    Bounds3<T> BoundPointMotion(const Vec3<T> &p) const
     {
-        if (!is_actually_animated || time <= start_time) return (*p_start_transform)(v);
-        else if (time >= end_time) return (*p_end_transform)(v);
-        else
+        if (!is_actually_animated)
         {
-            Transform<T> t;
-            Interpolate(time, &t);
-            return t(v);
+            return Bounds3<T>(ends[0].ApplyPoint(p));
         }
-    }
 
+        Bounds3<T> bounds(ends[0].ApplyPoint(p), ends[1].ApplyPoint(p));
+        if (!has_rotation)
+        {
+            return Pad(bounds, Length(p), static_cast<T>(1.0F));
+        }
+        for (int i = 1; i < MOTION_STEPS; ++i)
+        {
+            bounds = Union(bounds, keyframes[i].ApplyPoint(p));
+        }
+        return Pad(bounds, Length(p), static_cast<T>(1.0F) / MOTION_STEPS);
+    }
 
-    Bounds3<T> MotionBounds(const Bounds3<T> &b) const
+    // Maps _r_ by _a_, offsetting its origin past the rounding error as
+    // Transform::operator() does
+    static Ray<T> Apply(const AffineColumns<T> &a, const Ray<T> &r)
     {
-        if (!is_actually_animated) return (*p_start_transform)(b);
-        if (!has_rotation) return Union((*p_start_transform)(b), (*p_end_transform)(b));
-
-        // Return motion bounds accounting for animated rotation
-        Bounds3<T> bounds;
-        for (int corner = 0; corner < 8; ++corner)
+        Vec3<T> origin = a.ApplyPoint(r.origin);
+        Vec3<T> origin_error = a.PointError(r.origin);
+        Vec3<T> dir = a.ApplyVector(r.dir);
+
+        // Offset ray origin to edge of error bounds and compute _tMax_
+        T length_squared = LengthSquared(dir);
+        T t_max = r.t_max;
+        if (length_squared > static_cast<T>(0.0F))
         {
-            bounds = Union(bounds, BoundPointMotion(b.Corner(corner)));
+            T dt = Dot(Abs(dir), origin_error) / length_squared;
+            origin += dir * dt;
+            t_max -= dt;
         }
-        return bounds;
+
+        return Ray<T>(origin, dir, t_max, r.t_min, r.time, r.medium);
     }
 
-    Bounds3<T> BoundPointMotion(const Vec3<T> &p) const
-    {
-        if (!is_actually_animated) return Bounds3<T>((*p_start_transform)(p));
+private:
 
-        Bounds3<T> bounds((*p_start_transform)(p), (*p_end_transform)(p));
-        T cos_theta = Dot(rotations[0], rotations[1]);
-        T theta = std::acos(Clamp(cos_theta, -1, 1));
-        for (int c = 0; c < 3; ++c)
+    static bool SameMatrix(const Mat4<T> &m1, const Mat4<T> &m2)
+    {
+        for (int i = 0; i < 4; ++i)
         {
-            // Find any motion derivative zeros for the component _c_
-            T zeros[8];
-            int zeros_number = 0;
-            // TODO
-            /*
-            IntervalFindZeros(c1[c].Eval(p), c2[c].Eval(p), c3[c].Eval(p),
-                c4[c].Eval(p), c5[c].Eval(p), theta, Interval(0., 1.),
-                zeros, &zeros_number);
-                */
-            CHECK_LE(zeros_number, sizeof(zeros) / sizeof(zeros[0]));
-
-            // Expand bounding box for any motion derivative zeros found
-            for (int i = 0; i < zeros_number; ++i)
+            for (int j = 0; j < 4; ++j)
             {
-                Vec3<T> pz = (*this)(Lerp(zeros[i], start_time, end_time), p);
-                bounds = Union(bounds, pz);
+                if (m1[i][j] != m2[i][j])
+                {
+                    return false;
+                }
             }
         }
+        return true;
+    }
 
-        return bounds;
+    static void Inverse3(const T m[3][3], T inv[3][3])
+    {
+        T c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+        T c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+        T c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+        T inv_det = static_cast<T>(1.0F) / (m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02);
+        inv[0][0] = c00 * inv_det;
+        inv[1][0] = c01 * inv_det;
+        inv[2][0] = c02 * inv_det;
+        inv[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+        inv[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+        inv[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+        inv[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+        inv[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+        inv[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
     }
 
-private:
+    // Translation, rotation matrix and scale at _dt_ in [0, 1]
+    void Components(T dt, Vec3<T> *trans, T rotation[3][3], T scale[3][3]) const
+    {
+        *trans = translations[0] + dt * delta_translation;
 
-    const Transform<T> *p_start_transform, *p_end_transform;
-    const bool is_actually_animated;
-    const T start_time, end_time;
+        // Slerp with the angle and perpendicular quaternion of the
+        // constructor; nearly parallel rotations are lerped, as Slerp() does
+        Quaternion<T> q;
+        if (has_rotation)
+        {
+            T theta_p = theta * dt;
+            q = rotations[0] * std::cos(theta_p) + rotation_perp * std::sin(theta_p);
+        }
+        else
+        {
+            q = Normalize((static_cast<T>(1.0F) - dt) * rotations[0] + dt * rotations[1]);
+        }
 
-    std::vector<Vec3<T>> translations;
-    std::vector<Quaternion<T>> rotations;
-    std::vector<Mat4<T>> scales;
+        T xx = q.v.x * q.v.x, yy = q.v.y * q.v.y, zz = q.v.z * q.v.z;
+        T xy = q.v.x * q.v.y, xz = q.v.x * q.v.z, yz = q.v.y * q.v.z;
+        T wx = q.v.x * q.w, wy = q.v.y * q.w, wz = q.v.z * q.w;
+        rotation[0][0] = static_cast<T>(1.0F) - static_cast<T>(2.0F) * (yy + zz);
+        rotation[0][1] = static_cast<T>(2.0F) * (xy - wz);
+        rotation[0][2] = static_cast<T>(2.0F) * (xz + wy);
+        rotation[1][0] = static_cast<T>(2.0F) * (xy + wz);
+        rotation[1][1] = static_cast<T>(1.0F) - static_cast<T>(2.0F) * (xx + zz);
+        rotation[1][2] = static_cast<T>(2.0F) * (yz - wx);
+        rotation[2][0] = static_cast<T>(2.0F) * (xz - wy);
+        rotation[2][1] = static_cast<T>(2.0F) * (yz + wx);
+        rotation[2][2] = static_cast<T>(1.0F) - static_cast<T>(2.0F) * (xx + yy);
 
-    bool has_rotation;
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                scale[i][j] = (scales[0])[i][j] + dt * delta_scales[i][j];
+            }
+        }
+    }
 
+    void Evaluate(T dt, AffineColumns<T> *a) const
+    {
+        Vec3<T> trans;
+        T rotation[3][3], scale[3][3];
+        Components(dt, &trans, rotation, scale);
 
-    struct DerivativeTerm
+        // Column j of R S is R times column j of S
+        for (int j = 0; j < 3; ++j)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                a->col[j][i] = rotation[i][0] * scale[0][j] + rotation[i][1] * scale[1][j]
+                    + rotation[i][2] * scale[2][j];
+            }
+            a->col[j][3] = static_cast<T>(0.0F);
+        }
+        a->col[3][0] = trans.x;
+        a->col[3][1] = trans.y;
+        a->col[3][2] = trans.z;
+        a->col[3][3] = static_cast<T>(0.0F);
+    }
+
+    // Grows _bounds_ by the chord error of a point at distance _radius_
+    // from the origin, for chords _h_ of the motion long
+    Bounds3<T> Pad(const Bounds3<T> &bounds, T radius, T h) const
     {
-        DerivativeTerm()
-        {}
+        T pad = motion_curvature * radius * h * h * static_cast<T>(0.125F);
+        Bounds3<T> ret;
+        ret.point_min = bounds.point_min - Vec3<T>(pad, pad, pad);
+        ret.point_max = bounds.point_max + Vec3<T>(pad, pad, pad);
+        return ret;
+    }
 
-        DerivativeTerm(T c, T x, T y, T z)
-            : kc(c), kx(x), ky(y), kz(z)
-        {}
 
-        T kc, kx, ky, kz;
+    const Transform<T> *p_start_transform, *p_end_transform;
+    bool is_actually_animated;
+    T start_time, end_time;
 
-        T Eval(const Vec3<T> &p) const
-        {
-            return kc + kx * p.x + ky * p.y + kz * p.z;
-        }
-    };
+    Vec3<T> translations[2];
+    Quaternion<T> rotations[2];
+    Mat4<T> scales[2];
 
-    DerivativeTerm c1[3], c2[3], c3[3], c4[3], c5[3];
+    // Precomputed interpolation terms
+    bool has_rotation;
+    T theta;
+    Quaternion<T> rotation_perp;
+    Vec3<T> delta_translation;
+    T delta_scales[3][3];
+
+    AffineColumns<T> ends[2];
+    AffineColumns<T> keyframes[MOTION_STEPS + 1];
+    // Bound on |x''(t)| / |p| over the motion, t in [0, 1]
+    T motion_curvature;
 };
 
 
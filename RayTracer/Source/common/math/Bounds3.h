@@ -21,15 +21,10 @@ public:
     /// Construction
     ////////////////////////////////////////////////////////////////////////////////
 
+    // Empty box, so that Union() with it yields the other operand
     Bounds3()
-    {
-        /*
-        T min_num = std::numeric_limits<T>::lowest();
-        T max_num = (std::numeric_limits<T>::max)();
-        point_min = Vec3<T>(min_num);
-        point_max = Vec3<T>(max_num);
-        */
-    }
+        : point_min((std::numeric_limits<T>::max)()), point_max(std::numeric_limits<T>::lowest())
+    {}
 
     explicit
         Bounds3(const Vec3<T> &p) : point_min(p), point_max(p)
@@ -266,7 +266,7 @@ Float Erf(Float x)
     constexpr Float p = static_cast<Float>(0.3275911F);
 
     // Save the sign of x
-    int sign = x < FLOAT_0 ? 1 : -1;
+    int sign = x < FLOAT_0 ? -1 : 1;
     x = std::abs(x);
 
     // A&S formula 7.1.26
@@ -132,7 +132,7 @@ Quaternion<T> operator +(const Quaternion<T> &a)
 template<typename T> __forceinline
 Quaternion<T> operator -(const Quaternion<T> &a)
 {
-    return Quaternion<T>(-a.v, -a.w);
+    return Quaternion<T>(-a.w, -a.v);
 }
 
 template<typename T> __forceinline
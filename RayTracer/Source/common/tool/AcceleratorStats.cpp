@@ -0,0 +1,58 @@
+#include "AcceleratorStats.h"
+#include "MultiThread.h"
+#include <vector>
+
+namespace common
+{
+namespace tool
+{
+
+
+// Padded so that threads don't share cache lines for their counters
+struct alignas(64) AcceleratorCounters
+{
+    int64_t rays = 0;
+    int64_t nodesVisited = 0;
+    int64_t primitivesTested = 0;
+};
+
+static std::vector<AcceleratorCounters> acceleratorCounters;
+
+
+void InitAcceleratorStats()
+{
+    acceleratorCounters.assign(MaxThreadIndex(), AcceleratorCounters());
+}
+
+void CleanupAcceleratorStats()
+{
+    acceleratorCounters.clear();
+}
+
+void RecordAcceleratorTraversal(int nodesVisited, int primitivesTested)
+{
+    if (acceleratorCounters.empty())
+    {
+        return;
+    }
+    AcceleratorCounters &counters = acceleratorCounters[ThreadIndex];
+    ++counters.rays;
+    counters.nodesVisited += nodesVisited;
+    counters.primitivesTested += primitivesTested;
+}
+
+AcceleratorTraversalStats GetAcceleratorStats()
+{
+    AcceleratorTraversalStats stats;
+    for (const AcceleratorCounters &counters : acceleratorCounters)
+    {
+        stats.rays += counters.rays;
+        stats.nodesVisited += counters.nodesVisited;
+        stats.primitivesTested += counters.primitivesTested;
+    }
+    return stats;
+}
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "../math/Constants.h"
+#include <cstdint>
+
+namespace common
+{
+namespace tool
+{
+
+
+// Shape of a built accelerator. _sahCost_ is the number of nodes plus
+// primitives a ray crossing the root bounds is expected to visit, each node
+// weighted by the fraction of the root's surface area it covers; there are
+// no early exits, so it compares builds rather than predicting traversals.
+struct AcceleratorStructureStats
+{
+    int64_t nodes = 0;
+    int64_t leaves = 0;
+    // Primitives summed over the leaves, counting each leaf a k-d tree
+    // duplicates a primitive into
+    int64_t primitiveReferences = 0;
+    int64_t bytes = 0;
+    Float sahCost = FLOAT_0;
+};
+
+// Work summed over the traversals made since InitAcceleratorStats()
+struct AcceleratorTraversalStats
+{
+    int64_t rays = 0;
+    int64_t nodesVisited = 0;
+    int64_t primitivesTested = 0;
+};
+
+
+// Traversals are only counted between these two calls
+void InitAcceleratorStats();
+
+void CleanupAcceleratorStats();
+
+void RecordAcceleratorTraversal(int nodesVisited, int primitivesTested);
+
+AcceleratorTraversalStats GetAcceleratorStats();
+
+
+// KDTreeAccelerator, BVHAccelerator and MotionBVHAccelerator traverse
+// through a template taking one of these. Their Primitive overrides pass a
+// NoTraversalCount, which compiles to nothing, so only callers that ask
+// for the counts pay for them.
+struct NoTraversalCount
+{
+    void NodeVisited()
+    {}
+
+    void PrimitiveTested()
+    {}
+};
+
+// Counts the work of one traversal in registers and records it once, when
+// it goes out of scope
+class CountTraversal
+{
+public:
+
+    ~CountTraversal()
+    {
+        RecordAcceleratorTraversal(nodesVisited, primitivesTested);
+    }
+
+
+    void NodeVisited()
+    {
+        ++nodesVisited;
+    }
+
+    void PrimitiveTested()
+    {
+        ++primitivesTested;
+    }
+
+private:
+
+    int nodesVisited = 0;
+    int primitivesTested = 0;
+};
+
+
+}
+}
\ No newline at end of file
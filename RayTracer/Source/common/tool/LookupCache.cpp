@@ -0,0 +1,90 @@
+#include "LookupCache.h"
+#include "MultiThread.h"
+#include <vector>
+
+namespace common
+{
+namespace tool
+{
+
+
+// Padded so that threads don't share cache lines for their counters
+struct alignas(64) LookupCacheCounters
+{
+    int64_t lookups = 0;
+    int64_t hits = 0;
+    Float maxError = FLOAT_0;
+};
+
+static LookupCacheMode lookupCacheMode = LookupCacheMode::Off;
+static Float lookupCacheTolerance = FLOAT_0;
+static std::vector<LookupCacheCounters> lookupCacheCounters;
+
+thread_local uint32_t LookupCachePixel;
+
+
+void InitLookupCache(LookupCacheMode mode, Float tolerance)
+{
+    CHECK_GE(tolerance, FLOAT_0);
+    lookupCacheMode = mode;
+    lookupCacheTolerance = tolerance;
+    lookupCacheCounters.assign(MaxThreadIndex(), LookupCacheCounters());
+}
+
+void CleanupLookupCache()
+{
+    lookupCacheMode = LookupCacheMode::Off;
+    lookupCacheCounters.clear();
+}
+
+LookupCacheMode GetLookupCacheMode()
+{
+    return lookupCacheMode;
+}
+
+Float GetLookupCacheTolerance()
+{
+    return lookupCacheTolerance;
+}
+
+void RecordLookupCacheLookup(bool hit, Float error)
+{
+    LookupCacheCounters &counters = lookupCacheCounters[ThreadIndex];
+    ++counters.lookups;
+    if (hit)
+    {
+        ++counters.hits;
+        counters.maxError = (std::max)(counters.maxError, error);
+    }
+}
+
+LookupCacheStats GetLookupCacheStats()
+{
+    LookupCacheStats stats;
+    for (const LookupCacheCounters &counters : lookupCacheCounters)
+    {
+        stats.lookups += counters.lookups;
+        stats.hits += counters.hits;
+        stats.maxError = (std::max)(stats.maxError, counters.maxError);
+    }
+    return stats;
+}
+
+void PrintLookupCacheStats(FILE *dest)
+{
+    LookupCacheStats stats = GetLookupCacheStats();
+    static const char *modeNames[] = { "off", "on", "validate" };
+    fprintf(dest, "Filtered lookup cache (%s, tolerance %g)\n", modeNames[static_cast<int>(lookupCacheMode)],
+        static_cast<double>(lookupCacheTolerance));
+    fprintf(dest, "    Filtered lookups                   %12lld\n", static_cast<long long>(stats.lookups));
+    fprintf(dest, "    Reusable                           %12lld (%.2f%%)\n", static_cast<long long>(stats.hits),
+        stats.lookups > 0 ? 100.0 * stats.hits / stats.lookups : 0.0);
+    if (LookupCacheMode::Validate == lookupCacheMode)
+    {
+        fprintf(dest, "    Max reuse error                    %12g\n", static_cast<double>(stats.maxError));
+    }
+}
+
+
+}
+}
\ No newline at end of file
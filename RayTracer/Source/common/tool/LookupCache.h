@@ -0,0 +1,178 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "../math/Vec2.h"
+#include "MIPMap.h"
+#include "../../core/color/CoefficientSpectrum.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+namespace common
+{
+namespace tool
+{
+
+
+enum class LookupCacheMode
+{
+    // Every lookup is filtered
+    Off,
+    // Lookups close enough to an earlier one of the same pixel reuse it
+    On,
+    // Every lookup is filtered, and the error reuse would have caused is
+    // measured instead
+    Validate
+};
+
+struct LookupCacheStats
+{
+    int64_t lookups = 0;
+    int64_t hits = 0;
+    // Largest per channel difference between a reused and an exact result;
+    // only measured in Validate mode
+    Float maxError = FLOAT_0;
+};
+
+
+extern thread_local uint32_t LookupCachePixel;
+
+// Selects how image textures filter their lookups; the cache is off until
+// this is called. _tolerance_ is the error bound described at
+// FilteredLookupCache.
+void InitLookupCache(LookupCacheMode mode, Float tolerance = static_cast<Float>(0.125F));
+
+void CleanupLookupCache();
+
+LookupCacheMode GetLookupCacheMode();
+
+Float GetLookupCacheTolerance();
+
+// Called before the first sample of each pixel; results are only reused
+// among the samples of one pixel
+inline void LookupCacheStartPixel()
+{
+    ++LookupCachePixel;
+}
+
+void RecordLookupCacheLookup(bool hit, Float error);
+
+LookupCacheStats GetLookupCacheStats();
+
+void PrintLookupCacheStats(FILE *dest);
+
+
+inline Float LookupCacheError(Float a, Float b)
+{
+    return std::abs(a - b);
+}
+
+template <int SPECTRUM_SAMPLES_NUMBER>
+Float LookupCacheError(const core::color::CoefficientSpectrum<SPECTRUM_SAMPLES_NUMBER> &a,
+    const core::color::CoefficientSpectrum<SPECTRUM_SAMPLES_NUMBER> &b)
+{
+    Float error = FLOAT_0;
+    for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+    {
+        error = (std::max)(error, std::abs(a[i] - b[i]));
+    }
+    return error;
+}
+
+
+// Per-thread cache of filtered MIPMap lookups, reused across the samples
+// of a pixel: primary hits of one pixel land on nearly the same footprint,
+// and filtering it again for every sample is wasted work.
+//
+// Let _w_ be the footprint width, the largest component of either
+// derivative. A lookup reuses an earlier result of the same MIPMap when
+// every component of its center _st_ and of both derivatives is within
+// _tolerance * w_ of the earlier lookup's. The reused value is therefore
+// the exact filter over a footprint moved and reshaped by at most that
+// fraction of its own size.
+template <typename T>
+class FilteredLookupCache
+{
+public:
+
+    static constexpr int CACHE_SIZE = 256;
+
+
+    static T Lookup(const MIPMap<T> &mipmap, const common::math::Vec2f &st,
+        const common::math::Vec2f &dst0, const common::math::Vec2f &dst1);
+
+private:
+
+    struct Entry
+    {
+        const MIPMap<T> *mipmap = nullptr;
+        uint32_t pixel = 0;
+        common::math::Vec2f st, dst0, dst1;
+        T value;
+    };
+
+    static bool Close(const common::math::Vec2f &a, const common::math::Vec2f &b, Float bound)
+    {
+        return std::abs(a[0] - b[0]) <= bound && std::abs(a[1] - b[1]) <= bound;
+    }
+
+
+    static thread_local Entry entries[CACHE_SIZE];
+};
+
+template <typename T>
+T FilteredLookupCache<T>::Lookup(const MIPMap<T> &mipmap, const common::math::Vec2f &st,
+    const common::math::Vec2f &dst0, const common::math::Vec2f &dst1)
+{
+    LookupCacheMode mode = GetLookupCacheMode();
+    Float width = (std::max)((std::max)(std::abs(dst0[0]), std::abs(dst0[1])),
+        (std::max)(std::abs(dst1[0]), std::abs(dst1[1])));
+    if (LookupCacheMode::Off == mode || FLOAT_0 == width)
+    {
+        return mipmap.Lookup(st, dst0, dst1);
+    }
+
+    // Hash the footprint's size and its center, on a grid of cells no
+    // larger than the error bound, to pick the entry
+    Float bound = GetLookupCacheTolerance() * width;
+    int exponent;
+    std::frexp(bound, &exponent);
+    Float invCell = std::ldexp(FLOAT_1, 1 - exponent);
+    uint64_t hash = reinterpret_cast<uintptr_t>(&mipmap) >> 4;
+    hash = hash * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(exponent);
+    hash = hash * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(static_cast<int>(std::floor(st[0] * invCell)));
+    hash = hash * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(static_cast<int>(std::floor(st[1] * invCell)));
+    Entry &entry = entries[(hash >> 32) & (CACHE_SIZE - 1)];
+
+    bool hit = &mipmap == entry.mipmap && LookupCachePixel == entry.pixel
+        && Close(st, entry.st, bound) && Close(dst0, entry.dst0, bound) && Close(dst1, entry.dst1, bound);
+    if (hit && LookupCacheMode::On == mode)
+    {
+        RecordLookupCacheLookup(true, FLOAT_0);
+        return entry.value;
+    }
+
+    T value = mipmap.Lookup(st, dst0, dst1);
+    if (hit)
+    {
+        // Validate: keep the entry as it is, so later lookups are measured
+        // against the same value On mode would have returned
+        RecordLookupCacheLookup(true, LookupCacheError(entry.value, value));
+        return value;
+    }
+    entry.mipmap = &mipmap;
+    entry.pixel = LookupCachePixel;
+    entry.st = st;
+    entry.dst0 = dst0;
+    entry.dst1 = dst1;
+    entry.value = value;
+    RecordLookupCacheLookup(false, FLOAT_0);
+    return value;
+}
+
+template <typename T>
+thread_local typename FilteredLookupCache<T>::Entry FilteredLookupCache<T>::entries[CACHE_SIZE];
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#include "MIPMap.h"
+
+namespace common
+{
+namespace tool
+{
+
+
+// The MIPMap templates in the header count through these
+StatCounter nTrilerpLookups("Texture/Trilinear MIPMap lookups");
+StatCounter nEWALookups("Texture/EWA MIPMap lookups");
+
+
+}
+}
\ No newline at end of file
@@ -3,9 +3,15 @@
 #include "../math/Vec2.h"
 #include "MemoryArena.h"
 #include "MultiThread.h"
+#include "TexelFormat.h"
+#include "MappedFile.h"
+#include "TextureCache.h"
 #include "../../core/color/RGBSpectrum.h"
 #include "../../core/color/SampledSpectrum.h"
 #include "../../core/texture/Texture.h"
+#include "Stats.h"
+#include <cstring>
+#include <mutex>
 
 namespace common
 {
@@ -13,6 +19,11 @@ namespace tool
 {
 
 
+// Defined in MIPMap.cpp
+extern StatCounter nTrilerpLookups;
+extern StatCounter nEWALookups;
+
+
 enum class ImageWrap
 {
     Repeat,
@@ -35,7 +46,19 @@ public:
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
 
+    // Builds the pyramid in full precision, then converts every level to
+    // _format_
     MIPMap(const common::math::Vec2i &resolution, const T *data, bool doTri = false,
+        Float maxAniso = static_cast<Float>(8.0F), ImageWrap wrapMode = ImageWrap::Repeat,
+        TexelFormat format = TexelFormat::Float);
+
+    // Pyramid read in place from a tiled texture file mapped in memory;
+    // the file must pass ReadTiledTextureHeader()
+    MIPMap(std::shared_ptr<const MappedFile> mapping, bool doTri = false,
+        Float maxAniso = static_cast<Float>(8.0F), ImageWrap wrapMode = ImageWrap::Repeat);
+
+    // Pyramid whose texels are paged in on demand through _cache_
+    MIPMap(TextureCache *cache, int textureId, bool doTri = false,
         Float maxAniso = static_cast<Float>(8.0F), ImageWrap wrapMode = ImageWrap::Repeat);
 
 
@@ -51,17 +74,49 @@ public:
 
     int Levels() const
     {
-        return pyramid.size();
+        return static_cast<int>(levelResolution.size());
     }
 
-    const T &Texel(int level, int s, int t) const;
+    TexelFormat Format() const
+    {
+        return format;
+    }
+
+    static size_t TexelSize(TexelFormat format)
+    {
+        switch (format)
+        {
+        case TexelFormat::Half:
+            return sizeof(HalfTexel);
+        case TexelFormat::SRGB8:
+            return sizeof(SRGB8Texel);
+        default:
+            return sizeof(T);
+        }
+    }
+
+    // Whether a tiled texture file holds texels this MIPMap can read
+    static bool IsCompatible(const TiledTextureHeader &header)
+    {
+        return header.texelFormat <= static_cast<uint32_t>(TexelFormat::SRGB8)
+            && header.texelSize == TexelSize(static_cast<TexelFormat>(header.texelFormat));
+    }
+
+    T Texel(int level, int s, int t) const;
 
     T Lookup(const common::math::Vec2f &st, Float width = FLOAT_0) const;
 
     T Lookup(const common::math::Vec2f &st, common::math::Vec2f dstdx, common::math::Vec2f dstdy) const;
 
+    // Writes the pyramid as a tiled texture file that the mapped and cached
+    // constructors can read back
+    bool WriteTiled(const std::string &filename) const;
+
 private:
 
+    typedef typename TexelStorage<T>::Half HalfTexel;
+    typedef typename TexelStorage<T>::SRGB8 SRGB8Texel;
+
     std::unique_ptr<ResampleWeight[]> resampleWeights(int oldRes, int newRes)
     {
         CHECK_GE(newRes, oldRes);
@@ -104,29 +159,83 @@ private:
     }
 
 
+    // EWA filter ellipse $A s^2 + B s t + C t^2 < 1$ around _st_, in texel
+    // units of one level, and the texel bounds of the ellipse
+    struct EWAFootprint
+    {
+        Float A, B, C;
+        common::math::Vec2f st;
+        int s0, s1, t0, t1;
+    };
+
+    // Whether texels $[s0,s1] \times [t0,t1]$ of _level_ can be read straight
+    // from the in-memory pyramid, without wrapping or going through the cache
+    bool IsInterior(int level, int s0, int s1, int t0, int t1) const
+    {
+        const common::math::Vec2i &res = levelResolution[level];
+        return nullptr == cache && s0 >= 0 && s1 < res[0] && t0 >= 0 && t1 < res[1];
+    }
+
+    // Decodes the _n_ texels of row _t_ starting at column _s_ into _out_;
+    // the span must be interior. Block addressing is done once per block
+    // the span touches rather than once per texel.
+    template <typename S, typename Decode>
+    static void DecodeSpan(const common::tool::BlockedArray<S> &texels, int s, int t, int n, T *out,
+        Decode decode);
+
+    void TexelSpan(int level, int s, int t, int n, T *out) const;
+
     T triangle(int level, const common::math::Vec2f &st) const;
 
     T EWA(int level, common::math::Vec2f st, common::math::Vec2f dst0, common::math::Vec2f dst1) const;
 
+    // Weighted sum over the footprint. Each row is clipped to the ellipse
+    // and read as contiguous spans, _fetchRow(s, t, n, out)_ decoding texels
+    // $[s,s+n) \times \{t\}$ of the level being filtered into _out_.
+    template <typename FetchRow>
+    T EWASum(const EWAFootprint &footprint, FetchRow fetchRow) const;
+
+    static void InitWeightLut();
+
+    void Compress(TexelFormat target);
+
+    template <typename S>
+    void MapLevels(std::vector<std::unique_ptr<common::tool::BlockedArray<S>>> *levelArrays,
+        const std::vector<TiledTextureLevel> &levels, int logBlockSize);
+
+    template <typename S>
+    bool WriteLevels(const std::string &filename,
+        const std::vector<std::unique_ptr<common::tool::BlockedArray<S>>> &levelArrays) const;
+
 
     const bool doTrilinear;
     const Float maxAnisotropy;
     const ImageWrap wrapMode;
     common::math::Vec2i resolution;
+    TexelFormat format = TexelFormat::Float;
+    // Only the pyramid matching _format_ is populated
     std::vector<std::unique_ptr<common::tool::BlockedArray<T>>> pyramid;
+    std::vector<std::unique_ptr<common::tool::BlockedArray<HalfTexel>>> halfPyramid;
+    std::vector<std::unique_ptr<common::tool::BlockedArray<SRGB8Texel>>> srgb8Pyramid;
+    std::vector<common::math::Vec2i> levelResolution;
+    std::shared_ptr<const MappedFile> mapping;
+    TextureCache *cache = nullptr;
+    int textureId = -1;
     static constexpr int WeightLUTSize = 128;
+    // Longest span of a row EWASum() decodes at once
+    static constexpr int EWA_SPAN = 32;
     static Float weightLut[WeightLUTSize];
 };
 
 template <typename T>
 MIPMap<T>::MIPMap(const common::math::Vec2i &res, const T *img, bool doTrilinear,
-    Float maxAnisotropy, ImageWrap wrapMode)
+    Float maxAnisotropy, ImageWrap wrapMode, TexelFormat targetFormat)
     : doTrilinear(doTrilinear),
     maxAnisotropy(maxAnisotropy),
     wrapMode(wrapMode),
     resolution(res)
 {
-    //ProfilePhase _(Prof::MIPMapCreation);
+    common::tool::ProfilePhase _(common::tool::Prof::MIPMapCreation);
 
     std::unique_ptr<T[]> resampledImage = nullptr;
     if (!common::math::IsPowerOf2(resolution[0]) || !common::math::IsPowerOf2(resolution[1]))
@@ -219,12 +328,14 @@ MIPMap<T>::MIPMap(const common::math::Vec2i &res, const T *img, bool doTrilinear
     // Initialize most detailed level of MIPMap
     pyramid[0].reset(new common::tool::BlockedArray<T>(resolution[0], resolution[1],
             resampledImage ? resampledImage.get() : img));
+    levelResolution.push_back(resolution);
     for (int i = 1; i < nLevels; ++i)
     {
         // Initialize $i$th MIPMap level from $i-1$st level
         int sRes = (std::max)(1, pyramid[i - 1]->uSize() / 2);
         int tRes = (std::max)(1, pyramid[i - 1]->vSize() / 2);
         pyramid[i].reset(new common::tool::BlockedArray<T>(sRes, tRes));
+        levelResolution.push_back(common::math::Vec2i(sRes, tRes));
 
         // Filter four texels from finer level of pyramid
         common::tool::ParallelFor([&](int t)
@@ -240,8 +351,189 @@ MIPMap<T>::MIPMap(const common::math::Vec2i &res, const T *img, bool doTrilinear
         }, tRes, 16);
     }
 
-    // Initialize EWA filter weights if needed
-    if (FLOAT_0 == weightLut[0])
+    if (TexelFormat::Float != targetFormat)
+    {
+        Compress(targetFormat);
+    }
+
+    InitWeightLut();
+    //mipMapMemory += (4 * resolution[0] * resolution[1] * TexelSize(format)) / 3;
+}
+
+template <typename T>
+MIPMap<T>::MIPMap(std::shared_ptr<const MappedFile> file, bool doTrilinear,
+    Float maxAnisotropy, ImageWrap wrapMode)
+    : doTrilinear(doTrilinear),
+    maxAnisotropy(maxAnisotropy),
+    wrapMode(wrapMode),
+    mapping(std::move(file))
+{
+    TiledTextureHeader header;
+    std::vector<TiledTextureLevel> levels;
+    bool valid = ReadTiledTextureHeader(mapping->Data(), mapping->Size(), &header, &levels);
+    CHECK(valid && IsCompatible(header));
+
+    // Levels are views of the mapping; nothing is copied
+    format = static_cast<TexelFormat>(header.texelFormat);
+    switch (format)
+    {
+    case TexelFormat::Half:
+        MapLevels(&halfPyramid, levels, header.logBlockSize);
+        break;
+    case TexelFormat::SRGB8:
+        MapLevels(&srgb8Pyramid, levels, header.logBlockSize);
+        break;
+    default:
+        MapLevels(&pyramid, levels, header.logBlockSize);
+        break;
+    }
+    resolution = levelResolution[0];
+    InitWeightLut();
+}
+
+template <typename T>
+MIPMap<T>::MIPMap(TextureCache *cache, int textureId, bool doTrilinear,
+    Float maxAnisotropy, ImageWrap wrapMode)
+    : doTrilinear(doTrilinear),
+    maxAnisotropy(maxAnisotropy),
+    wrapMode(wrapMode),
+    cache(cache),
+    textureId(textureId)
+{
+    // Only the level table is read here; texels are paged in by _Texel()_
+    const TiledTextureFile &texture = cache->Texture(textureId);
+    CHECK(IsCompatible(texture.header));
+    format = static_cast<TexelFormat>(texture.header.texelFormat);
+    for (const TiledTextureLevel &level : texture.levels)
+    {
+        levelResolution.push_back(common::math::Vec2i(level.uRes, level.vRes));
+    }
+    resolution = levelResolution[0];
+    InitWeightLut();
+}
+
+template <typename T>
+bool MIPMap<T>::WriteTiled(const std::string &filename) const
+{
+    CHECK(nullptr == cache);
+    switch (format)
+    {
+    case TexelFormat::Half:
+        return WriteLevels(filename, halfPyramid);
+    case TexelFormat::SRGB8:
+        return WriteLevels(filename, srgb8Pyramid);
+    default:
+        return WriteLevels(filename, pyramid);
+    }
+}
+
+template <typename T>
+template <typename S>
+bool MIPMap<T>::WriteLevels(const std::string &filename,
+    const std::vector<std::unique_ptr<common::tool::BlockedArray<S>>> &levelArrays) const
+{
+    CHECK(!levelArrays.empty());
+    TiledTextureHeader header;
+    header.texelSize = sizeof(S);
+    header.texelFormat = static_cast<uint32_t>(format);
+    header.logBlockSize = common::math::Log2Int(levelArrays[0]->BlockSize());
+    header.nLevels = Levels();
+    header.wrapMode = static_cast<int32_t>(wrapMode);
+
+    // Lay the levels out one after the other, each on a page boundary
+    std::vector<TiledTextureLevel> levels(Levels());
+    uint64_t offset = sizeof(TiledTextureHeader) + levels.size() * sizeof(TiledTextureLevel);
+    for (int i = 0; i < Levels(); ++i)
+    {
+        const common::tool::BlockedArray<S> &level = *levelArrays[i];
+        offset = (offset + TILED_TEXTURE_ALIGNMENT - 1) & ~(TILED_TEXTURE_ALIGNMENT - 1);
+        levels[i].uRes = level.uSize();
+        levels[i].vRes = level.vSize();
+        levels[i].offset = offset;
+        offset += static_cast<uint64_t>(level.RoundUp(levels[i].uRes)) * level.RoundUp(levels[i].vRes) * sizeof(S);
+    }
+
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = 1 == fwrite(&header, sizeof(TiledTextureHeader), 1, file)
+        && levels.size() == fwrite(levels.data(), sizeof(TiledTextureLevel), levels.size(), file);
+    uint64_t written = sizeof(TiledTextureHeader) + levels.size() * sizeof(TiledTextureLevel);
+    static const uint8_t zeros[TILED_TEXTURE_ALIGNMENT] = {};
+    for (int i = 0; ok && i < Levels(); ++i)
+    {
+        const common::tool::BlockedArray<S> &level = *levelArrays[i];
+        size_t padding = static_cast<size_t>(levels[i].offset - written);
+        size_t count = static_cast<size_t>(level.RoundUp(levels[i].uRes)) * level.RoundUp(levels[i].vRes);
+        ok = padding == fwrite(zeros, 1, padding, file)
+            && count == fwrite(level.BlockData(), sizeof(S), count, file);
+        written = levels[i].offset + count * sizeof(S);
+    }
+    return 0 == fclose(file) && ok;
+}
+
+template <typename T>
+template <typename S>
+void MIPMap<T>::MapLevels(std::vector<std::unique_ptr<common::tool::BlockedArray<S>>> *levelArrays,
+    const std::vector<TiledTextureLevel> &levels, int logBlockSize)
+{
+    for (const TiledTextureLevel &level : levels)
+    {
+        levelArrays->push_back(std::unique_ptr<common::tool::BlockedArray<S>>(new common::tool::BlockedArray<S>(
+            reinterpret_cast<const S *>(mapping->Data() + level.offset), level.uRes, level.vRes)));
+        levelResolution.push_back(common::math::Vec2i(level.uRes, level.vRes));
+    }
+    CHECK_EQ(1 << logBlockSize, (*levelArrays)[0]->BlockSize());
+}
+
+template <typename T>
+void MIPMap<T>::Compress(TexelFormat target)
+{
+    for (int i = 0; i < Levels(); ++i)
+    {
+        const common::tool::BlockedArray<T> &level = *pyramid[i];
+        int uRes = level.uSize(), vRes = level.vSize();
+        if (TexelFormat::Half == target)
+        {
+            halfPyramid.push_back(std::unique_ptr<common::tool::BlockedArray<HalfTexel>>(
+                new common::tool::BlockedArray<HalfTexel>(uRes, vRes)));
+        }
+        else
+        {
+            srgb8Pyramid.push_back(std::unique_ptr<common::tool::BlockedArray<SRGB8Texel>>(
+                new common::tool::BlockedArray<SRGB8Texel>(uRes, vRes)));
+        }
+        common::tool::ParallelFor([&](int64_t v)
+        {
+            int t = static_cast<int>(v);
+            for (int s = 0; s < uRes; ++s)
+            {
+                if (TexelFormat::Half == target)
+                {
+                    (*halfPyramid[i])(s, t) = TexelStorage<T>::EncodeHalf(level(s, t));
+                }
+                else
+                {
+                    (*srgb8Pyramid[i])(s, t) = TexelStorage<T>::EncodeSRGB8(level(s, t));
+                }
+            }
+        }, vRes, 16);
+    }
+
+    // The full precision levels are no longer needed
+    pyramid.clear();
+    format = target;
+}
+
+template <typename T>
+void MIPMap<T>::InitWeightLut()
+{
+    // Initialize EWA filter weights once; textures are built on several
+    // threads, and none may read the table before it is complete
+    static std::once_flag weightLutInitialized;
+    std::call_once(weightLutInitialized, []()
     {
         for (int i = 0; i < WeightLUTSize; ++i)
         {
@@ -249,44 +541,115 @@ MIPMap<T>::MIPMap(const common::math::Vec2i &res, const T *img, bool doTrilinear
             Float r2 = static_cast<Float>(i) / (static_cast<Float>(WeightLUTSize) - FLOAT_1);
             weightLut[i] = std::exp(-alpha * r2) - std::exp(-alpha);
         }
-    }
-    //mipMapMemory += (4 * resolution[0] * resolution[1] * sizeof(T)) / 3;
+    });
 }
 
 template <typename T>
-const T &MIPMap<T>::Texel(int level, int s, int t) const
+T MIPMap<T>::Texel(int level, int s, int t) const
 {
-    CHECK_LT(level, pyramid.size());
-    const common::tool::BlockedArray<T> &l = *pyramid[level];
+    CHECK_LT(level, Levels());
+    const common::math::Vec2i &res = levelResolution[level];
     // Compute texel $(s,t)$ accounting for boundary conditions
     switch (wrapMode)
     {
     case ImageWrap::Repeat:
-        s = common::math::Mod(s, l.uSize());
-        t = common::math::Mod(t, l.vSize());
+        s = common::math::Mod(s, res[0]);
+        t = common::math::Mod(t, res[1]);
         break;
     case ImageWrap::Clamp:
-        s = common::math::Clamp(s, 0, l.uSize() - 1);
-        t = common::math::Clamp(t, 0, l.vSize() - 1);
+        s = common::math::Clamp(s, 0, res[0] - 1);
+        t = common::math::Clamp(t, 0, res[1] - 1);
         break;
     case ImageWrap::Black:
     {
-        static const T black = FLOAT_0;
-        if (s < 0 || s >= l.uSize() || t < 0 || t >= l.vSize())
+        if (s < 0 || s >= res[0] || t < 0 || t >= res[1])
         {
-            return black;
+            return T(FLOAT_0);
         }
         break;
     }
     }
-    return l(s, t);
+    if (cache)
+    {
+        const uint8_t *bytes = cache->Texel(textureId, level, s, t);
+        switch (format)
+        {
+        case TexelFormat::Half:
+        {
+            HalfTexel texel;
+            std::memcpy(&texel, bytes, sizeof(HalfTexel));
+            return TexelStorage<T>::DecodeHalf(texel);
+        }
+        case TexelFormat::SRGB8:
+        {
+            SRGB8Texel texel;
+            std::memcpy(&texel, bytes, sizeof(SRGB8Texel));
+            return TexelStorage<T>::DecodeSRGB8(texel);
+        }
+        default:
+        {
+            T texel;
+            std::memcpy(&texel, bytes, sizeof(T));
+            return texel;
+        }
+        }
+    }
+    switch (format)
+    {
+    case TexelFormat::Half:
+        return TexelStorage<T>::DecodeHalf((*halfPyramid[level])(s, t));
+    case TexelFormat::SRGB8:
+        return TexelStorage<T>::DecodeSRGB8((*srgb8Pyramid[level])(s, t));
+    default:
+        return (*pyramid[level])(s, t);
+    }
+}
+
+template <typename T>
+template <typename S, typename Decode>
+void MIPMap<T>::DecodeSpan(const common::tool::BlockedArray<S> &texels, int s, int t, int n, T *out,
+    Decode decode)
+{
+    while (n > 0)
+    {
+        // Texels are contiguous up to the end of the block
+        int run = (std::min)(n, texels.BlockSize() - texels.Offset(s));
+        const S *src = &texels(s, t);
+        for (int i = 0; i < run; ++i)
+        {
+            out[i] = decode(src[i]);
+        }
+        out += run;
+        s += run;
+        n -= run;
+    }
+}
+
+template <typename T>
+void MIPMap<T>::TexelSpan(int level, int s, int t, int n, T *out) const
+{
+    CHECK(IsInterior(level, s, s + n - 1, t, t));
+    switch (format)
+    {
+    case TexelFormat::Half:
+        DecodeSpan(*halfPyramid[level], s, t, n, out,
+            [](const HalfTexel &texel) { return TexelStorage<T>::DecodeHalf(texel); });
+        break;
+    case TexelFormat::SRGB8:
+        DecodeSpan(*srgb8Pyramid[level], s, t, n, out,
+            [](const SRGB8Texel &texel) { return TexelStorage<T>::DecodeSRGB8(texel); });
+        break;
+    default:
+        DecodeSpan(*pyramid[level], s, t, n, out, [](const T &texel) { return texel; });
+        break;
+    }
 }
 
 template <typename T>
 T MIPMap<T>::Lookup(const common::math::Vec2f &st, Float width) const
 {
-    //++nTrilerpLookups;
-    //ProfilePhase p(Prof::TexFiltTrilerp);
+    ++nTrilerpLookups;
+    common::tool::ProfilePhase p(common::tool::Prof::TexFiltTrilerp);
     // Compute MIPMap level for trilinear filtering
     Float level = Levels() - FLOAT_1 + common::math::Log2((std::max)(width, static_cast<Float>(1e-8)));
 
@@ -311,14 +674,28 @@ template <typename T>
 T MIPMap<T>::triangle(int level, const common::math::Vec2f &st) const
 {
     level = common::math::Clamp(level, 0, Levels() - 1);
-    Float s = st[0] * pyramid[level]->uSize() - FLOAT_INV_2;
-    Float t = st[1] * pyramid[level]->vSize() - FLOAT_INV_2;
+    Float s = st[0] * levelResolution[level][0] - FLOAT_INV_2;
+    Float t = st[1] * levelResolution[level][1] - FLOAT_INV_2;
     int s0 = static_cast<int>(std::floor(s)), t0 = static_cast<int>(std::floor(t));
     Float ds = s - s0, dt = t - t0;
-    return (FLOAT_1 - ds) * (FLOAT_1 - dt) * Texel(level, s0, t0)
-        + (FLOAT_1 - ds) * dt * Texel(level, s0, t0 + 1)
-        + ds * (FLOAT_1 - dt) * Texel(level, s0 + 1, t0)
-        + ds * dt * Texel(level, s0 + 1, t0 + 1);
+    T texels[4];
+    if (IsInterior(level, s0, s0 + 1, t0, t0 + 1))
+    {
+        // Both texels of a row are decoded together, with no wrapping
+        TexelSpan(level, s0, t0, 2, texels);
+        TexelSpan(level, s0, t0 + 1, 2, texels + 2);
+    }
+    else
+    {
+        texels[0] = Texel(level, s0, t0);
+        texels[1] = Texel(level, s0 + 1, t0);
+        texels[2] = Texel(level, s0, t0 + 1);
+        texels[3] = Texel(level, s0 + 1, t0 + 1);
+    }
+    return (FLOAT_1 - ds) * (FLOAT_1 - dt) * texels[0]
+        + (FLOAT_1 - ds) * dt * texels[2]
+        + ds * (FLOAT_1 - dt) * texels[1]
+        + ds * dt * texels[3];
 }
 
 template <typename T>
@@ -330,8 +707,8 @@ T MIPMap<T>::Lookup(const common::math::Vec2f &st, common::math::Vec2f dst0, com
             (std::max)(std::abs(dst1[0]), std::abs(dst1[1])));
         return Lookup(st, FLOAT_2 * width);
     }
-    //++nEWALookups;
-    //ProfilePhase p(Prof::TexFiltEWA);
+    ++nEWALookups;
+    common::tool::ProfilePhase p(common::tool::Prof::TexFiltEWA);
     // Compute ellipse minor and major axes
     if (LengthSquared(dst0) < LengthSquared(dst1))
     {
@@ -367,12 +744,12 @@ T MIPMap<T>::EWA(int level, common::math::Vec2f st, common::math::Vec2f dst0, co
         return Texel(Levels() - 1, 0, 0);
     }
     // Convert EWA coordinates to appropriate scale for level
-    st[0] = st[0] * pyramid[level]->uSize() - FLOAT_INV_2;
-    st[1] = st[1] * pyramid[level]->vSize() - FLOAT_INV_2;
-    dst0[0] *= pyramid[level]->uSize();
-    dst0[1] *= pyramid[level]->vSize();
-    dst1[0] *= pyramid[level]->uSize();
-    dst1[1] *= pyramid[level]->vSize();
+    st[0] = st[0] * levelResolution[level][0] - FLOAT_INV_2;
+    st[1] = st[1] * levelResolution[level][1] - FLOAT_INV_2;
+    dst0[0] *= levelResolution[level][0];
+    dst0[1] *= levelResolution[level][1];
+    dst1[0] *= levelResolution[level][0];
+    dst1[1] *= levelResolution[level][1];
 
     // Compute ellipse coefficients to bound EWA filter region
     Float A = dst0[1] * dst0[1] + dst1[1] * dst1[1] + FLOAT_1;
@@ -384,31 +761,79 @@ T MIPMap<T>::EWA(int level, common::math::Vec2f st, common::math::Vec2f dst0, co
     C *= invF;
 
     // Compute the ellipse's $(s,t)$ bounding box in texture space
+    EWAFootprint footprint;
+    footprint.A = A;
+    footprint.B = B;
+    footprint.C = C;
+    footprint.st = st;
     Float det = -B * B + static_cast<Float>(4.0F) * A * C;
     Float invDet = FLOAT_1 / det;
     Float uSqrt = std::sqrt(det * C), vSqrt = std::sqrt(A * det);
-    int s0 = std::ceil(st[0] - FLOAT_2 * invDet * uSqrt);
-    int s1 = std::floor(st[0] + FLOAT_2 * invDet * uSqrt);
-    int t0 = std::ceil(st[1] - FLOAT_2 * invDet * vSqrt);
-    int t1 = std::floor(st[1] + FLOAT_2 * invDet * vSqrt);
+    footprint.s0 = std::ceil(st[0] - FLOAT_2 * invDet * uSqrt);
+    footprint.s1 = std::floor(st[0] + FLOAT_2 * invDet * uSqrt);
+    footprint.t0 = std::ceil(st[1] - FLOAT_2 * invDet * vSqrt);
+    footprint.t1 = std::floor(st[1] + FLOAT_2 * invDet * vSqrt);
+
+    // Footprints that need no wrapping decode whole row spans straight from
+    // the level's blocks
+    if (IsInterior(level, footprint.s0, footprint.s1, footprint.t0, footprint.t1))
+    {
+        return EWASum(footprint, [this, level](int s, int t, int n, T *out)
+        {
+            TexelSpan(level, s, t, n, out);
+        });
+    }
+    return EWASum(footprint, [this, level](int s, int t, int n, T *out)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            out[i] = Texel(level, s + i, t);
+        }
+    });
+}
 
-    // Scan over ellipse bound and compute quadratic equation
+template <typename T>
+template <typename FetchRow>
+T MIPMap<T>::EWASum(const EWAFootprint &footprint, FetchRow fetchRow) const
+{
+    Float A = footprint.A, B = footprint.B, C = footprint.C;
+    const common::math::Vec2f &st = footprint.st;
+
+    T texels[EWA_SPAN];
+    Float weights[EWA_SPAN];
     T sum(FLOAT_0);
     Float sumWts = FLOAT_0;
-    for (int it = t0; it <= t1; ++it)
+    for (int it = footprint.t0; it <= footprint.t1; ++it)
     {
+        // Along the row the squared radius $A ss^2 + b ss + c$ is a quadratic
+        // in _ss_; only the texels between its roots are inside the ellipse
         Float tt = it - st[1];
-        for (int is = s0; is <= s1; ++is)
+        Float b = B * tt, c = C * tt * tt;
+        Float discriminant = b * b - static_cast<Float>(4.0F) * A * (c - FLOAT_1);
+        if (discriminant <= FLOAT_0)
         {
-            Float ss = is - st[0];
-            // Compute squared radius and filter texel if inside ellipse
-            Float r2 = A * ss * ss + B * ss * tt + C * tt * tt;
-            if (r2 < FLOAT_1)
+            continue;
+        }
+        Float root = std::sqrt(discriminant), inv2A = FLOAT_INV_2 / A;
+        int rowS0 = (std::max)(footprint.s0, static_cast<int>(std::ceil(st[0] + (-b - root) * inv2A)));
+        int rowS1 = (std::min)(footprint.s1, static_cast<int>(std::floor(st[0] + (-b + root) * inv2A)));
+
+        for (int s = rowS0; s <= rowS1; s += EWA_SPAN)
+        {
+            int n = (std::min)(EWA_SPAN, rowS1 - s + 1);
+            for (int i = 0; i < n; ++i)
+            {
+                Float ss = (s + i) - st[0];
+                Float r2 = (A * ss + b) * ss + c;
+                // Rounding at the roots can put a texel just outside
+                weights[i] = r2 < FLOAT_1
+                    ? weightLut[(std::min)(static_cast<int>(r2 * WeightLUTSize), WeightLUTSize - 1)] : FLOAT_0;
+            }
+            fetchRow(s, it, n, texels);
+            for (int i = 0; i < n; ++i)
             {
-                int index = (std::min)((int)(r2 * WeightLUTSize), WeightLUTSize - 1);
-                Float weight = weightLut[index];
-                sum += Texel(level, is, it) * weight;
-                sumWts += weight;
+                sum += texels[i] * weights[i];
+                sumWts += weights[i];
             }
         }
     }
@@ -0,0 +1,93 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace common
+{
+namespace tool
+{
+
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if (data)
+    {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle && INVALID_HANDLE_VALUE != fileHandle)
+    {
+        CloseHandle(fileHandle);
+    }
+#else
+    if (data)
+    {
+        munmap(const_cast<uint8_t *>(data), size);
+    }
+#endif
+}
+
+std::shared_ptr<const MappedFile> MappedFile::Open(const std::string &filename)
+{
+    std::shared_ptr<MappedFile> file(new MappedFile);
+#ifdef _WIN32
+    file->fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (INVALID_HANDLE_VALUE == file->fileHandle)
+    {
+        return nullptr;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file->fileHandle, &fileSize) || 0 == fileSize.QuadPart)
+    {
+        return nullptr;
+    }
+    file->mappingHandle = CreateFileMappingA(file->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!file->mappingHandle)
+    {
+        return nullptr;
+    }
+    file->data = static_cast<const uint8_t *>(MapViewOfFile(file->mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!file->data)
+    {
+        return nullptr;
+    }
+    file->size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat st;
+    if (0 != fstat(fd, &st) || 0 == st.st_size)
+    {
+        close(fd);
+        return nullptr;
+    }
+    void *ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (MAP_FAILED == ptr)
+    {
+        return nullptr;
+    }
+    file->data = static_cast<const uint8_t *>(ptr);
+    file->size = static_cast<size_t>(st.st_size);
+#endif
+    return file;
+}
+
+
+}
+}
\ No newline at end of file
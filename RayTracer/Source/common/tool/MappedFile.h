@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace common
+{
+namespace tool
+{
+
+
+// Read-only memory mapping of a whole file. Pages come straight from the
+// OS page cache, so several processes mapping the same file share them.
+class MappedFile
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Returns nullptr if _filename_ can't be opened or mapped
+    static std::shared_ptr<const MappedFile> Open(const std::string &filename);
+
+
+    const uint8_t *Data() const
+    {
+        return data;
+    }
+
+    size_t Size() const
+    {
+        return size;
+    }
+
+private:
+
+    MappedFile() = default;
+
+
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
+
+
+}
+}
\ No newline at end of file
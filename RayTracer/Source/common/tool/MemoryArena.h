@@ -170,8 +170,19 @@ public:
         }
     }
 
+    // Wraps texels that are already laid out in block order, such as a
+    // mapped file; the array neither copies nor frees them
+    BlockedArray(const T *blocked, int uRes, int vRes)
+        : data(const_cast<T *>(blocked)), uRes(uRes), vRes(vRes), uBlocks(RoundUp(uRes) >> logBlockSize),
+        ownsData(false)
+    {}
+
     ~BlockedArray()
     {
+        if (!ownsData)
+        {
+            return;
+        }
         for (int i = 0; i < uRes * vRes; ++i)
         {
             data[i].~T();
@@ -230,6 +241,12 @@ public:
         return data[offset];
     }
 
+    // Texels in block order, _RoundUp(uRes) * RoundUp(vRes)_ of them
+    const T *BlockData() const
+    {
+        return data;
+    }
+
     void GetLinearArray(T *a) const
     {
         for (int v = 0; v < vRes; ++v)
@@ -245,6 +262,7 @@ private:
 
     T *data;
     const int uRes, vRes, uBlocks;
+    const bool ownsData = true;
 };
 
 
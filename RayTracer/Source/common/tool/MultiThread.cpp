@@ -1,157 +1,393 @@
 #include "MultiThread.h"
+#include "Stats.h"
 #include "../math/Vec2.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace common
 {
 namespace tool
 {
 
-// TODO
-// ̳߳
+
+class ParallelForLoop
+{
+public:
+
+    std::function<void(int64_t)> func1D;
+    std::function<void(common::math::Vec2i)> func2D;
+    const int64_t maxIndex;
+    const int chunkSize;
+    int64_t nextIndex = 0;
+    int activeWorkers = 0;
+    ParallelForLoop *next = nullptr;
+    int nX = -1;
+    // Phases of the thread that started the loop; workers run its
+    // iterations in them, so the profiler charges the work to the caller
+    const uint64_t profilerState = ProfilerState.load(std::memory_order_relaxed);
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    ParallelForLoop(std::function<void(int64_t)> func1D, int64_t maxIndex, int chunkSize)
+        : func1D(std::move(func1D)), maxIndex(maxIndex), chunkSize(chunkSize)
+    {}
+
+    ParallelForLoop(const std::function<void(common::math::Vec2i)> &f, const common::math::Vec2i &count)
+        : func2D(f), maxIndex(count.x * count.y), chunkSize(1)
+    {
+        nX = count.x;
+    }
+
+
+    bool Finished() const
+    {
+        return nextIndex >= maxIndex && 0 == activeWorkers;
+    }
+
+    void RunIndex(int64_t index)
+    {
+        if (func1D)
+        {
+            func1D(index);
+        }
+        // Handle other types of loops
+        else
+        {
+            CHECK(nullptr != func2D);
+            func2D(common::math::Vec2i(static_cast<int>(index % nX), static_cast<int>(index / nX)));
+        }
+    }
+};
+
+
+class Barrier
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    Barrier(int count) : count(count)
+    {
+        CHECK_GT(count, 0);
+    }
+
+    ~Barrier()
+    {
+        CHECK_EQ(0, count);
+    }
+
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        CHECK_GT(count, 0);
+        if (0 == --count)
+        {
+            // This is the last thread to reach the barrier; wake up all of the
+            // other ones before exiting.
+            cv.notify_all();
+        }
+        else
+        {
+            // Otherwise there are still threads that haven't reached it. Give
+            // up the lock and wait to be notified.
+            cv.wait(lock, [this] { return 0 == count; });
+        }
+    }
+
+private:
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int count;
+};
+
 
 static std::vector<std::thread> threads;
+static bool shutdownThreads = false;
+static ParallelForLoop *workList = nullptr;
+static std::mutex workListMutex;
+static std::condition_variable workListCondition;
+// Guarded by _workListMutex_ as well
+static std::deque<std::shared_ptr<AsyncJob>> asyncJobs;
+static std::mutex asyncDoneMutex;
+static std::condition_variable asyncDoneCondition;
+
 thread_local int ThreadIndex;
 
-int NumSystemCores()
-{
-    return (std::max)(1u, std::thread::hardware_concurrency());
-}
 
-int MaxThreadIndex()
+static void WorkerThreadFunc(int tIndex, std::shared_ptr<Barrier> barrier)
 {
-    return NumSystemCores();
-}
+    ThreadIndex = tIndex;
+    StatsThreadInit();
 
+    // The main thread sets up a barrier so that it can be sure that all
+    // workers have started before it continues.
+    barrier->Wait();
 
-void ParallelFor(std::function<void(int64_t)> func, int64_t count, int chunkSize)
-{
-    CHECK(threads.size() > 0 || 1 == MaxThreadIndex());
+    // Release our reference to the Barrier so that it's freed once all of
+    // the threads have cleared it.
+    barrier.reset();
 
-    // Run iterations immediately if not using threads or if _count_ is small
-    if (threads.empty() || count < chunkSize)
+    std::unique_lock<std::mutex> lock(workListMutex);
+    while (!shutdownThreads)
     {
-        for (int64_t i = 0; i < count; ++i) func(i);
-        return;
+        if (!workList && !asyncJobs.empty())
+        {
+            // Parallel loops come first; with none queued, run an
+            // asynchronous job
+            std::shared_ptr<AsyncJob> job = std::move(asyncJobs.front());
+            asyncJobs.pop_front();
+            lock.unlock();
+            job->TryRun();
+            lock.lock();
+        }
+        else if (!workList)
+        {
+            // Sleep until there are more tasks to run
+            workListCondition.wait(lock);
+        }
+        else
+        {
+            // Get work from _workList_ and run loop iterations
+            ParallelForLoop &loop = *workList;
+
+            // Find the set of loop iterations to run next
+            int64_t indexStart = loop.nextIndex;
+            int64_t indexEnd = (std::min)(indexStart + loop.chunkSize, loop.maxIndex);
+
+            // Update _loop_ to reflect iterations this thread will run
+            loop.nextIndex = indexEnd;
+            if (loop.nextIndex == loop.maxIndex)
+            {
+                workList = loop.next;
+            }
+            ++loop.activeWorkers;
+
+            // Run loop indices in _[indexStart, indexEnd)_
+            lock.unlock();
+            ProfilerState.store(loop.profilerState, std::memory_order_relaxed);
+            for (int64_t index = indexStart; index < indexEnd; ++index)
+            {
+                loop.RunIndex(index);
+            }
+            ProfilerState.store(0, std::memory_order_relaxed);
+            lock.lock();
+
+            // Update _loop_ to reflect completion of iterations
+            --loop.activeWorkers;
+            if (loop.Finished())
+            {
+                workListCondition.notify_all();
+            }
+        }
     }
-    /* TODO
-    // Create and enqueue _ParallelForLoop_ for this loop
-    ParallelForLoop loop(std::move(func), count, chunkSize,
-        CurrentProfilerState());
-    workListMutex.lock();
-    loop.next = workList;
-    workList = &loop;
-    workListMutex.unlock();
+    lock.unlock();
 
-    // Notify worker threads of work to be done
+    StatsThreadCleanup();
+}
+
+// Help out with parallel loop iterations in the calling thread until every
+// index of _loop_ has been handed out and finished.
+static void RunLoop(ParallelForLoop &loop)
+{
+    // Enqueue _loop_ and notify worker threads of work to be done
     std::unique_lock<std::mutex> lock(workListMutex);
+    loop.next = workList;
+    workList = &loop;
     workListCondition.notify_all();
 
-    // Help out with parallel loop iterations in the current thread
     while (!loop.Finished())
     {
         // Run a chunk of loop iterations for _loop_
 
         // Find the set of loop iterations to run next
         int64_t indexStart = loop.nextIndex;
-        int64_t indexEnd = std::min(indexStart + loop.chunkSize, loop.maxIndex);
+        int64_t indexEnd = (std::min)(indexStart + loop.chunkSize, loop.maxIndex);
+        if (indexStart == indexEnd)
+        {
+            // Every index is handed out; wait for the other workers to
+            // finish, as idle as far as the profiler is concerned
+            ProfilerState.store(0, std::memory_order_relaxed);
+            workListCondition.wait(lock);
+            ProfilerState.store(loop.profilerState, std::memory_order_relaxed);
+            continue;
+        }
 
         // Update _loop_ to reflect iterations this thread will run
         loop.nextIndex = indexEnd;
-        if (loop.nextIndex == loop.maxIndex) workList = loop.next;
-        loop.activeWorkers++;
-
-        // Run loop indices in _[indexStart, indexEnd)_
-        lock.unlock();
-        for (int64_t index = indexStart; index < indexEnd; ++index)
+        if (loop.nextIndex == loop.maxIndex)
         {
-            uint64_t oldState = ProfilerState;
-            ProfilerState = loop.profilerState;
-            if (loop.func1D)
+            // _loop_ may not be at the head of the list if another thread
+            // pushed a nested loop in the meantime
+            ParallelForLoop **prev = &workList;
+            while (*prev && *prev != &loop)
             {
-                loop.func1D(index);
+                prev = &(*prev)->next;
             }
-            // Handle other types of loops
-            else
+            if (*prev)
             {
-                CHECK(loop.func2D);
-                loop.func2D(common::math::Vec2i(index % loop.nX, index / loop.nX));
+                *prev = loop.next;
             }
-            ProfilerState = oldState;
+        }
+        ++loop.activeWorkers;
+
+        // Run loop indices in _[indexStart, indexEnd)_
+        lock.unlock();
+        for (int64_t index = indexStart; index < indexEnd; ++index)
+        {
+            loop.RunIndex(index);
         }
         lock.lock();
 
         // Update _loop_ to reflect completion of iterations
-        loop.activeWorkers--;
+        --loop.activeWorkers;
     }
-    */
 }
 
-void ParallelFor2D(std::function<void(common::math::Vec2i)> func, const common::math::Vec2i &count)
+
+int NumSystemCores()
 {
-    CHECK(threads.size() > 0 || 1 == MaxThreadIndex());
+    return (std::max)(1u, std::thread::hardware_concurrency());
+}
 
-    if (threads.empty() || count.x * count.y <= 1)
+int MaxThreadIndex()
+{
+    return NumSystemCores();
+}
+
+
+void ParallelInit()
+{
+    CHECK_EQ(threads.size(), 0);
+    int nThreads = MaxThreadIndex();
+    ThreadIndex = 0;
+    StatsThreadInit();
+
+    // Create a barrier so that we can be sure all worker threads have
+    // started and set their _ThreadIndex_ before we return from this
+    // function.
+    std::shared_ptr<Barrier> barrier = std::make_shared<Barrier>(nThreads);
+
+    // Launch one fewer worker thread than the total number we want doing
+    // work, since the main thread helps out, too.
+    for (int i = 0; i < nThreads - 1; ++i)
     {
-        for (int y = 0; y < count.y; ++y)
-        {
-            for (int x = 0; x < count.x; ++x) func(common::math::Vec2i(x, y));
-            {
-                return;
-            }
-        }
+        threads.push_back(std::thread(WorkerThreadFunc, i + 1, barrier));
+    }
+
+    barrier->Wait();
+}
+
+void ParallelCleanup()
+{
+    if (threads.empty())
+    {
+        return;
     }
 
-    /* TODO
-    ParallelForLoop loop(std::move(func), count, CurrentProfilerState());
     {
         std::lock_guard<std::mutex> lock(workListMutex);
-        loop.next = workList;
-        workList = &loop;
+        shutdownThreads = true;
+        workListCondition.notify_all();
     }
 
-    std::unique_lock<std::mutex> lock(workListMutex);
-    workListCondition.notify_all();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    threads.erase(threads.begin(), threads.end());
+    shutdownThreads = false;
+}
 
-    // Help out with parallel loop iterations in the current thread
-    while (!loop.Finished())
+
+void ParallelFor(std::function<void(int64_t)> func, int64_t count, int chunkSize)
+{
+    CHECK(threads.size() > 0 || 1 == MaxThreadIndex());
+
+    // Run iterations immediately if not using threads or if _count_ is small
+    if (threads.empty() || count < chunkSize)
     {
-        // Run a chunk of loop iterations for _loop_
+        for (int64_t i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+        return;
+    }
 
-        // Find the set of loop iterations to run next
-        int64_t indexStart = loop.nextIndex;
-        int64_t indexEnd = std::min(indexStart + loop.chunkSize, loop.maxIndex);
+    ParallelForLoop loop(std::move(func), count, chunkSize);
+    RunLoop(loop);
+}
 
-        // Update _loop_ to reflect iterations this thread will run
-        loop.nextIndex = indexEnd;
-        if (loop.nextIndex == loop.maxIndex) workList = loop.next;
-        loop.activeWorkers++;
+void ParallelFor2D(std::function<void(common::math::Vec2i)> func, const common::math::Vec2i &count)
+{
+    CHECK(threads.size() > 0 || 1 == MaxThreadIndex());
 
-        // Run loop indices in _[indexStart, indexEnd)_
-        lock.unlock();
-        for (int64_t index = indexStart; index < indexEnd; ++index)
+    if (threads.empty() || count.x * count.y <= 1)
+    {
+        for (int y = 0; y < count.y; ++y)
         {
-            uint64_t oldState = ProfilerState;
-            ProfilerState = loop.profilerState;
-            if (loop.func1D)
+            for (int x = 0; x < count.x; ++x)
             {
-                loop.func1D(index);
+                func(common::math::Vec2i(x, y));
             }
-            // Handle other types of loops
-            else
-            {
-                CHECK(loop.func2D);
-                loop.func2D(common::math::Vec2i(index % loop.nX, index / loop.nX));
-            }
-            ProfilerState = oldState;
         }
-        lock.lock();
+        return;
+    }
 
-        // Update _loop_ to reflect completion of iterations
-        loop.activeWorkers--;
+    ParallelForLoop loop(func, count);
+    RunLoop(loop);
+}
+
+
+bool AsyncJob::TryRun()
+{
+    bool expected = false;
+    if (!started.compare_exchange_strong(expected, true))
+    {
+        return false;
+    }
+    func();
+    {
+        std::lock_guard<std::mutex> lock(asyncDoneMutex);
+        done = true;
+    }
+    asyncDoneCondition.notify_all();
+    return true;
+}
+
+void AsyncJob::Wait()
+{
+    if (done || TryRun())
+    {
+        return;
     }
-    */
+    std::unique_lock<std::mutex> lock(asyncDoneMutex);
+    asyncDoneCondition.wait(lock, [this] { return done.load(); });
 }
 
+std::shared_ptr<AsyncJob> RunAsync(std::function<void()> func)
+{
+    std::shared_ptr<AsyncJob> job = std::make_shared<AsyncJob>(std::move(func));
+    if (threads.empty())
+    {
+        job->TryRun();
+        return job;
+    }
 
+    std::lock_guard<std::mutex> lock(workListMutex);
+    asyncJobs.push_back(job);
+    workListCondition.notify_all();
+    return job;
+}
+
+
+}
 }
-}
\ No newline at end of file
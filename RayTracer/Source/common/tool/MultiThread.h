@@ -1,6 +1,10 @@
 #pragma once
 
 #include "../../ForwardDeclaration.h"
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <thread>
 
 namespace common
@@ -8,8 +12,6 @@ namespace common
 namespace tool
 {
 
-// TODO
-// ̳߳
 
 extern thread_local int ThreadIndex;
 
@@ -18,10 +20,116 @@ int NumSystemCores();
 int MaxThreadIndex();
 
 
+void ParallelInit();
+
+void ParallelCleanup();
+
 void ParallelFor(std::function<void(int64_t)> func, int64_t count, int chunkSize = 1);
 
 void ParallelFor2D(std::function<void(common::math::Vec2i)> func, const common::math::Vec2i &count);
 
 
+// A function queued with RunAsync(). Worker threads pick queued jobs up
+// whenever they have no ParallelFor() iterations to run.
+class AsyncJob
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    explicit AsyncJob(std::function<void()> func) : func(std::move(func))
+    {}
+
+
+    bool IsReady() const
+    {
+        return done;
+    }
+
+    // Returns once the job has run; a job no thread has started yet is run
+    // by the caller
+    void Wait();
+
+    // Runs the job unless another thread already started it
+    bool TryRun();
+
+private:
+
+    std::function<void()> func;
+    std::atomic<bool> started{ false };
+    std::atomic<bool> done{ false };
+};
+
+// Queues _func_ to run on a worker thread; it runs right away when there
+// are no worker threads. Jobs may themselves call ParallelFor().
+std::shared_ptr<AsyncJob> RunAsync(std::function<void()> func);
+
+
+// std::atomic<float> has no fetch_add before C++20, so splatting into
+// shared film pixels goes through a compare-and-swap on the raw bits.
+class AtomicFloat
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    explicit AtomicFloat(Float v = FLOAT_0)
+    {
+        bits = FloatToBits(v);
+    }
+
+
+    operator Float() const
+    {
+        return BitsToFloat(bits);
+    }
+
+    Float operator=(Float v)
+    {
+        bits = FloatToBits(v);
+        return v;
+    }
+
+    void Add(Float v)
+    {
+        Bits oldBits = bits, newBits;
+        do
+        {
+            newBits = FloatToBits(BitsToFloat(oldBits) + v);
+        }
+        while (!bits.compare_exchange_weak(oldBits, newBits));
+    }
+
+private:
+
+#ifdef FLOAT_AS_DOUBLE
+    typedef uint64_t Bits;
+#else
+    typedef uint32_t Bits;
+#endif
+
+    static Bits FloatToBits(Float v)
+    {
+        Bits ui;
+        std::memcpy(&ui, &v, sizeof(Float));
+        return ui;
+    }
+
+    static Float BitsToFloat(Bits ui)
+    {
+        Float v;
+        std::memcpy(&v, &ui, sizeof(Float));
+        return v;
+    }
+
+
+    std::atomic<Bits> bits;
+};
+
+
+}
 }
-}
\ No newline at end of file
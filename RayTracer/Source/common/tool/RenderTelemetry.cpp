@@ -0,0 +1,177 @@
+#include "RenderTelemetry.h"
+#include "MultiThread.h"
+#include "Stats.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace common
+{
+namespace tool
+{
+
+
+RenderTelemetry::RenderTelemetry(int nTiles)
+    : startTime(std::chrono::steady_clock::now()), tiles(nTiles), startPhaseSeconds(GetProfilePhaseSeconds())
+{
+    // Every ray the integrators trace goes through Scene, which counts them
+    rayCounters[0] = FindStatCounter("Intersections/Regular ray intersection tests");
+    rayCounters[1] = FindStatCounter("Intersections/Shadow ray intersection tests");
+}
+
+
+int64_t RenderTelemetry::ThreadRays() const
+{
+    return ThreadStatCounterValue(rayCounters[0]) + ThreadStatCounterValue(rayCounters[1]);
+}
+
+void RenderTelemetry::Finish()
+{
+    totalSeconds = Seconds();
+    phaseSeconds = GetProfilePhaseSeconds();
+    for (size_t i = 0; i < phaseSeconds.size(); ++i)
+    {
+        phaseSeconds[i] -= startPhaseSeconds[i];
+    }
+}
+
+std::vector<double> RenderTelemetry::Utilization(int nBins) const
+{
+    std::vector<double> busy(nBins, 0.0);
+    double binWidth = totalSeconds / nBins;
+    if (binWidth <= 0.0)
+    {
+        return busy;
+    }
+    for (const TileTelemetry &tile : tiles)
+    {
+        // Spread the tile's interval over the bins it overlaps
+        int first = (std::min)(static_cast<int>(tile.start / binWidth), nBins - 1);
+        int last = (std::min)(static_cast<int>(tile.end / binWidth), nBins - 1);
+        for (int b = first; b <= last; ++b)
+        {
+            double overlap = (std::min)(tile.end, (b + 1) * binWidth) - (std::max)(tile.start, b * binWidth);
+            busy[b] += (std::max)(0.0, overlap);
+        }
+    }
+    for (double &b : busy)
+    {
+        b /= binWidth * MaxThreadIndex();
+    }
+    return busy;
+}
+
+
+bool RenderTelemetry::WriteHeatmap(const std::string &filename, const common::math::Bounds2i &imageBounds) const
+{
+    common::math::Vec2i extent = imageBounds.Diagonal();
+    if (extent.x <= 0 || extent.y <= 0)
+    {
+        return false;
+    }
+    std::vector<float> rgb(3 * static_cast<size_t>(extent.x) * extent.y, 0.0F);
+    for (const TileTelemetry &tile : tiles)
+    {
+        common::math::Bounds2i overlap = Intersect(tile.bounds, imageBounds);
+        if (tile.threadIndex < 0 || overlap.point_min.x >= overlap.point_max.x
+            || overlap.point_min.y >= overlap.point_max.y)
+        {
+            continue;
+        }
+        int area = tile.bounds.Area();
+        float value[3] = { static_cast<float>(1000.0 * (tile.end - tile.start)),
+            static_cast<float>(tile.rays) / area, static_cast<float>(tile.samples) / area };
+        for (common::math::Vec2i p : overlap)
+        {
+            // PFM stores its scanlines bottom to top
+            size_t offset = 3 * (static_cast<size_t>(imageBounds.point_max.y - 1 - p.y) * extent.x
+                + (p.x - imageBounds.point_min.x));
+            std::copy(value, value + 3, &rgb[offset]);
+        }
+    }
+
+    FILE *f = fopen(filename.c_str(), "wb");
+    if (!f)
+    {
+        return false;
+    }
+    // A negative scale marks the floats as little endian
+    fprintf(f, "PF\n%d %d\n-1\n", extent.x, extent.y);
+    bool written = rgb.size() == fwrite(rgb.data(), sizeof(float), rgb.size(), f);
+    return 0 == fclose(f) && written;
+}
+
+bool RenderTelemetry::WriteSummaryJSON(const std::string &filename) const
+{
+    FILE *f = fopen(filename.c_str(), "w");
+    if (!f)
+    {
+        return false;
+    }
+
+    int64_t rays = 0, samples = 0;
+    for (const TileTelemetry &tile : tiles)
+    {
+        rays += tile.rays;
+        samples += tile.samples;
+    }
+    fprintf(f, "{\n  \"seconds\": %g,\n  \"threads\": %d,\n  \"tiles\": %d,\n", totalSeconds, MaxThreadIndex(),
+        static_cast<int>(tiles.size()));
+    fprintf(f, "  \"rays\": %lld,\n  \"raysPerSecond\": %g,\n  \"samples\": %lld,\n  \"samplesPerSecond\": %g,\n",
+        static_cast<long long>(rays), totalSeconds > 0.0 ? rays / totalSeconds : 0.0,
+        static_cast<long long>(samples), totalSeconds > 0.0 ? samples / totalSeconds : 0.0);
+
+    // Thread seconds, so they add up to more than _seconds_ when the pool
+    // is busy; only phases the profiler saw are listed
+    fprintf(f, "  \"phaseSeconds\": {");
+    bool first = true;
+    for (size_t i = 0; i < phaseSeconds.size(); ++i)
+    {
+        if (phaseSeconds[i] > 0.0)
+        {
+            fprintf(f, "%s\n    \"%s\": %g", first ? "" : ",", ProfName(static_cast<Prof>(i)), phaseSeconds[i]);
+            first = false;
+        }
+    }
+    fprintf(f, "\n  },\n");
+
+    const int nBins = 100;
+    std::vector<double> utilization = Utilization(nBins);
+    fprintf(f, "  \"utilization\": {\n    \"binSeconds\": %g,\n    \"busyFraction\": [", totalSeconds / nBins);
+    for (int b = 0; b < nBins; ++b)
+    {
+        fprintf(f, "%s%s%.4f", 0 == b ? "" : ",", 0 == b % 10 ? "\n      " : " ", utilization[b]);
+    }
+    fprintf(f, "\n    ]\n  },\n");
+
+    fprintf(f, "  \"tileList\": [");
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        const TileTelemetry &tile = tiles[i];
+        fprintf(f, "%s\n    { \"x0\": %d, \"y0\": %d, \"x1\": %d, \"y1\": %d, \"thread\": %d, \"start\": %g, \"end\": %g, "
+            "\"rays\": %lld, \"samples\": %lld }", 0 == i ? "" : ",",
+            tile.bounds.point_min.x, tile.bounds.point_min.y, tile.bounds.point_max.x, tile.bounds.point_max.y,
+            tile.threadIndex, tile.start, tile.end, static_cast<long long>(tile.rays),
+            static_cast<long long>(tile.samples));
+    }
+    fprintf(f, "\n  ]\n}\n");
+
+    return 0 == fclose(f);
+}
+
+void RenderTelemetry::Write(const std::string &imageFilename, const common::math::Bounds2i &imageBounds) const
+{
+    std::string heatmapFilename = imageFilename + ".tiles.pfm";
+    if (!WriteHeatmap(heatmapFilename, imageBounds))
+    {
+        fprintf(stderr, "Unable to write tile heatmap to \"%s\"\n", heatmapFilename.c_str());
+    }
+    std::string summaryFilename = imageFilename + ".telemetry.json";
+    if (!WriteSummaryJSON(summaryFilename))
+    {
+        fprintf(stderr, "Unable to write render telemetry to \"%s\"\n", summaryFilename.c_str());
+    }
+}
+
+
+}
+}
\ No newline at end of file
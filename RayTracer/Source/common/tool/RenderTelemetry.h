@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "../math/Bounds2.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace common
+{
+namespace tool
+{
+
+
+// What it took to render one image tile. Times are seconds since the
+// RenderTelemetry was created.
+struct TileTelemetry
+{
+    common::math::Bounds2i bounds;
+    int threadIndex = -1;
+    double start = 0.0;
+    double end = 0.0;
+    // Camera rays plus every ray traced on their paths
+    int64_t rays = 0;
+    int64_t samples = 0;
+};
+
+// Per tile timing of one parallel render, and the summary built from it:
+// rays per second, time per profiler phase and thread utilization over
+// time. Each tile is recorded into its own slot by the thread that
+// rendered it, so recording takes no lock.
+class RenderTelemetry
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    explicit RenderTelemetry(int nTiles);
+
+
+    double Seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    // Rays the calling thread traced so far; taken before and after a tile
+    int64_t ThreadRays() const;
+
+    void RecordTile(int tileIndex, const TileTelemetry &tile)
+    {
+        tiles[tileIndex] = tile;
+    }
+
+    // Called once every tile is recorded
+    void Finish();
+
+    // Float image over _imageBounds_ where each pixel holds its tile's wall
+    // time in milliseconds, rays traced per pixel and samples per pixel as
+    // R, G and B. Written as PFM, which any HDR viewer opens next to the
+    // beauty pass.
+    bool WriteHeatmap(const std::string &filename, const common::math::Bounds2i &imageBounds) const;
+
+    bool WriteSummaryJSON(const std::string &filename) const;
+
+    // Writes both next to the image, as _imageFilename_ + ".tiles.pfm" and
+    // _imageFilename_ + ".telemetry.json"
+    void Write(const std::string &imageFilename, const common::math::Bounds2i &imageBounds) const;
+
+private:
+
+    // Fraction of the pool's threads busy with a tile in each of _nBins_
+    // equal intervals of the render
+    std::vector<double> Utilization(int nBins) const;
+
+
+    std::chrono::steady_clock::time_point startTime;
+    std::vector<TileTelemetry> tiles;
+    std::vector<double> startPhaseSeconds;
+    std::vector<double> phaseSeconds;
+    double totalSeconds = 0.0;
+    int rayCounters[2];
+};
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,459 @@
+#include "Stats.h"
+#include "LookupCache.h"
+#include "MultiThread.h"
+#include "TextureCache.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace common
+{
+namespace tool
+{
+
+
+static const char *profNames[] =
+{
+    "AccelConstruction",
+    "TextureLoading",
+    "MIPMapCreation",
+
+    "IntegratorRender",
+    "SamplerIntegratorLi",
+    "SPPMCameraPass",
+    "SPPMGridConstruction",
+    "SPPMPhotonPass",
+    "SPPMStatsUpdate",
+    "BDPTGenerateSubpath",
+    "BDPTConnectSubpaths",
+    "LightDistribLookup",
+    "LightDistribSpinWait",
+    "LightDistribCreation",
+    "DirectLighting",
+    "BSDFEvaluation",
+    "BSDFSampling",
+    "BSDFPdf",
+    "BSSRDFEvaluation",
+    "BSSRDFSampling",
+    "PhaseFuncEvaluation",
+    "PhaseFuncSampling",
+    "AccelIntersect",
+    "AccelIntersectP",
+    "LightSample",
+    "LightPdf",
+    "MediumSample",
+    "MediumTr",
+    "TriIntersect",
+    "TriIntersectP",
+    "ComputeScatteringFuncs",
+    "GenerateCameraRay",
+    "MergeFilmTile",
+    "SplatFilm",
+    "AddFilmSample",
+    "StartPixel",
+    "GetSample",
+    "TexFiltTrilerp",
+    "TexFiltEWA",
+};
+
+static_assert(sizeof(profNames) / sizeof(profNames[0]) == static_cast<size_t>(Prof::NumProfCategories),
+    "profNames must list every Prof");
+
+const char *ProfName(Prof p)
+{
+    return profNames[static_cast<int>(p)];
+}
+
+
+thread_local std::atomic<uint64_t> ProfilerState;
+thread_local std::atomic<int64_t> ThreadStatCounters[MAX_STAT_COUNTERS];
+
+// Counters are registered while static objects are constructed, before
+// _main_ and any other thread starts
+static std::vector<std::string> &StatCounterTitles()
+{
+    static std::vector<std::string> titles;
+    return titles;
+}
+
+int RegisterStatCounter(const char *title)
+{
+    std::vector<std::string> &titles = StatCounterTitles();
+    std::vector<std::string>::iterator it = std::find(titles.begin(), titles.end(), title);
+    if (titles.end() != it)
+    {
+        return static_cast<int>(it - titles.begin());
+    }
+    CHECK_LT(titles.size(), static_cast<size_t>(MAX_STAT_COUNTERS));
+    titles.push_back(title);
+    return static_cast<int>(titles.size()) - 1;
+}
+
+int FindStatCounter(const char *title)
+{
+    const std::vector<std::string> &titles = StatCounterTitles();
+    std::vector<std::string>::const_iterator it = std::find(titles.begin(), titles.end(), title);
+    return titles.end() == it ? -1 : static_cast<int>(it - titles.begin());
+}
+
+
+struct RegisteredThread
+{
+    std::atomic<uint64_t> *profilerState;
+    std::atomic<int64_t> *counters;
+    // Into _threadSamples_, which outlives the thread
+    size_t slot;
+};
+
+struct ThreadSamples
+{
+    int threadIndex = 0;
+    // Profiler samples taken of the thread, and how many of them found it
+    // inside some phase
+    int64_t samples = 0;
+    int64_t busySamples = 0;
+};
+
+// Guards everything below. The profiler thread holds it for one sweep over
+// _registeredThreads_ per sample, so the threads being profiled only ever
+// take it to register or unregister.
+static std::mutex statsMutex;
+static std::vector<RegisteredThread> registeredThreads;
+static std::vector<ThreadSamples> threadSamples;
+// Counts of threads that already exited
+static int64_t counterTotals[MAX_STAT_COUNTERS];
+// Samples per set of phases; only busy samples are kept
+static std::map<uint64_t, int64_t> profileSamples;
+static int64_t profileTicks = 0;
+static double profileSeconds = 0.0;
+
+static std::thread profilerThread;
+static std::condition_variable profilerCondition;
+static bool shutdownProfiler = false;
+
+
+void StatsThreadInit()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    for (const RegisteredThread &thread : registeredThreads)
+    {
+        if (&ProfilerState == thread.profilerState)
+        {
+            return;
+        }
+    }
+    ThreadSamples samples;
+    samples.threadIndex = ThreadIndex;
+    threadSamples.push_back(samples);
+    registeredThreads.push_back({ &ProfilerState, ThreadStatCounters, threadSamples.size() - 1 });
+}
+
+void StatsThreadCleanup()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    for (std::vector<RegisteredThread>::iterator it = registeredThreads.begin(); it != registeredThreads.end(); ++it)
+    {
+        if (&ProfilerState == it->profilerState)
+        {
+            for (int i = 0; i < MAX_STAT_COUNTERS; ++i)
+            {
+                counterTotals[i] += ThreadStatCounters[i].load(std::memory_order_relaxed);
+            }
+            registeredThreads.erase(it);
+            return;
+        }
+    }
+}
+
+
+static void ProfilerThreadFunc(std::chrono::milliseconds period)
+{
+    std::unique_lock<std::mutex> lock(statsMutex);
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+    while (!profilerCondition.wait_for(lock, period, [] { return shutdownProfiler; }))
+    {
+        // Timer resolution varies between platforms, so each sample stands
+        // for the average measured interval rather than _period_
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        profileSeconds += std::chrono::duration<double>(now - last).count();
+        last = now;
+        ++profileTicks;
+
+        for (const RegisteredThread &thread : registeredThreads)
+        {
+            uint64_t state = thread.profilerState->load(std::memory_order_relaxed);
+            ThreadSamples &samples = threadSamples[thread.slot];
+            ++samples.samples;
+            if (0 != state)
+            {
+                ++samples.busySamples;
+                ++profileSamples[state];
+            }
+        }
+    }
+}
+
+void InitProfiler(int samplePeriodMs)
+{
+    CHECK(!profilerThread.joinable());
+    shutdownProfiler = false;
+    profilerThread = std::thread(ProfilerThreadFunc, std::chrono::milliseconds((std::max)(1, samplePeriodMs)));
+}
+
+void CleanupProfiler()
+{
+    if (!profilerThread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        shutdownProfiler = true;
+    }
+    profilerCondition.notify_all();
+    profilerThread.join();
+}
+
+void ClearStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    // Threads only write their own counters, so this must not race with
+    // parallel work
+    for (const RegisteredThread &thread : registeredThreads)
+    {
+        for (int i = 0; i < MAX_STAT_COUNTERS; ++i)
+        {
+            thread.counters[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    std::fill(counterTotals, counterTotals + MAX_STAT_COUNTERS, 0);
+    for (ThreadSamples &samples : threadSamples)
+    {
+        samples.samples = 0;
+        samples.busySamples = 0;
+    }
+    profileSamples.clear();
+    profileTicks = 0;
+    profileSeconds = 0.0;
+}
+
+
+struct ProfileNode
+{
+    // Samples in this phase set or any set nested in it, and in exactly it
+    int64_t inclusive = 0;
+    int64_t exclusive = 0;
+};
+
+// Everything a report needs, copied out under _statsMutex_
+struct StatsSnapshot
+{
+    std::vector<std::pair<std::string, int64_t>> counters;
+    // Keyed by the phases of a set in Prof order, so that a set directly
+    // follows the set it is nested in
+    std::map<std::vector<int>, ProfileNode> profile;
+    std::vector<ThreadSamples> threads;
+    int64_t busySamples = 0;
+    double secondsPerSample = 0.0;
+};
+
+static StatsSnapshot TakeStatsSnapshot()
+{
+    StatsSnapshot snapshot;
+    std::lock_guard<std::mutex> lock(statsMutex);
+
+    const std::vector<std::string> &titles = StatCounterTitles();
+    for (size_t i = 0; i < titles.size(); ++i)
+    {
+        int64_t total = counterTotals[i];
+        for (const RegisteredThread &thread : registeredThreads)
+        {
+            total += thread.counters[i].load(std::memory_order_relaxed);
+        }
+        snapshot.counters.push_back(std::make_pair(titles[i], total));
+    }
+    std::sort(snapshot.counters.begin(), snapshot.counters.end());
+
+    for (const std::pair<const uint64_t, int64_t> &samples : profileSamples)
+    {
+        std::vector<int> path;
+        for (int i = 0; i < static_cast<int>(Prof::NumProfCategories); ++i)
+        {
+            if (0 != (samples.first & (1ULL << i)))
+            {
+                path.push_back(i);
+                snapshot.profile[path].inclusive += samples.second;
+            }
+        }
+        snapshot.profile[path].exclusive += samples.second;
+        snapshot.busySamples += samples.second;
+    }
+
+    snapshot.threads = threadSamples;
+    snapshot.secondsPerSample = profileTicks > 0 ? profileSeconds / profileTicks : 0.0;
+    return snapshot;
+}
+
+std::vector<double> GetProfilePhaseSeconds()
+{
+    std::vector<double> seconds(static_cast<size_t>(Prof::NumProfCategories), 0.0);
+    std::lock_guard<std::mutex> lock(statsMutex);
+    double secondsPerSample = profileTicks > 0 ? profileSeconds / profileTicks : 0.0;
+    for (const std::pair<const uint64_t, int64_t> &samples : profileSamples)
+    {
+        for (int i = 0; i < static_cast<int>(Prof::NumProfCategories); ++i)
+        {
+            if (0 != (samples.first & (1ULL << i)))
+            {
+                seconds[i] += samples.second * secondsPerSample;
+            }
+        }
+    }
+    return seconds;
+}
+
+static std::string ProfilePath(const std::vector<int> &path)
+{
+    std::string name;
+    for (int p : path)
+    {
+        if (!name.empty())
+        {
+            name += '/';
+        }
+        name += profNames[p];
+    }
+    return name;
+}
+
+static double Percent(int64_t part, int64_t total)
+{
+    return total > 0 ? 100.0 * part / total : 0.0;
+}
+
+
+void PrintStats(FILE *dest)
+{
+    StatsSnapshot snapshot = TakeStatsSnapshot();
+
+    fprintf(dest, "Statistics:\n");
+    std::string category;
+    for (const std::pair<std::string, int64_t> &counter : snapshot.counters)
+    {
+        size_t slash = counter.first.find('/');
+        std::string counterCategory = counter.first.substr(0, slash);
+        std::string title = std::string::npos == slash ? counter.first : counter.first.substr(slash + 1);
+        if (counterCategory != category)
+        {
+            category = counterCategory;
+            fprintf(dest, "  %s\n", category.c_str());
+        }
+        fprintf(dest, "    %-48s %14lld\n", title.c_str(), static_cast<long long>(counter.second));
+    }
+
+    fprintf(dest, "Profile (%lld busy thread samples, %.3f ms apart; times sum over threads):\n",
+        static_cast<long long>(snapshot.busySamples), 1000.0 * snapshot.secondsPerSample);
+    for (const std::pair<const std::vector<int>, ProfileNode> &node : snapshot.profile)
+    {
+        // Indent each phase under the set it is nested in
+        int indent = 2 * static_cast<int>(node.first.size());
+        fprintf(dest, "%*s%-*s %6.2f%% %10.3f s (self %6.2f%%)\n", indent, "", 52 - indent,
+            profNames[node.first.back()], Percent(node.second.inclusive, snapshot.busySamples),
+            node.second.inclusive * snapshot.secondsPerSample, Percent(node.second.exclusive, snapshot.busySamples));
+    }
+
+    fprintf(dest, "Thread utilization:\n");
+    for (const ThreadSamples &thread : snapshot.threads)
+    {
+        fprintf(dest, "    Thread %-3d %6.2f%% busy of %10.3f s\n", thread.threadIndex,
+            Percent(thread.busySamples, thread.samples), thread.samples * snapshot.secondsPerSample);
+    }
+}
+
+static void WriteJSONString(FILE *f, const std::string &s)
+{
+    fputc('"', f);
+    for (char c : s)
+    {
+        if ('"' == c || '\\' == c)
+        {
+            fputc('\\', f);
+        }
+        fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+bool WriteStatsJSON(const std::string &filename)
+{
+    StatsSnapshot snapshot = TakeStatsSnapshot();
+    FILE *f = fopen(filename.c_str(), "w");
+    if (!f)
+    {
+        return false;
+    }
+
+    fprintf(f, "{\n  \"counters\": {");
+    for (size_t i = 0; i < snapshot.counters.size(); ++i)
+    {
+        fprintf(f, "%s\n    ", 0 == i ? "" : ",");
+        WriteJSONString(f, snapshot.counters[i].first);
+        fprintf(f, ": %lld", static_cast<long long>(snapshot.counters[i].second));
+    }
+    fprintf(f, "\n  },\n");
+
+    fprintf(f, "  \"profile\": {\n    \"samplePeriodSeconds\": %g,\n    \"busySamples\": %lld,\n    \"phases\": [",
+        snapshot.secondsPerSample, static_cast<long long>(snapshot.busySamples));
+    bool first = true;
+    for (const std::pair<const std::vector<int>, ProfileNode> &node : snapshot.profile)
+    {
+        fprintf(f, "%s\n      { \"path\": ", first ? "" : ",");
+        WriteJSONString(f, ProfilePath(node.first));
+        fprintf(f, ", \"samples\": %lld, \"selfSamples\": %lld, \"seconds\": %g, \"percent\": %g }",
+            static_cast<long long>(node.second.inclusive), static_cast<long long>(node.second.exclusive),
+            node.second.inclusive * snapshot.secondsPerSample, Percent(node.second.inclusive, snapshot.busySamples));
+        first = false;
+    }
+    fprintf(f, "\n    ]\n  },\n");
+
+    fprintf(f, "  \"threads\": [");
+    for (size_t i = 0; i < snapshot.threads.size(); ++i)
+    {
+        const ThreadSamples &thread = snapshot.threads[i];
+        fprintf(f, "%s\n    { \"index\": %d, \"samples\": %lld, \"busySamples\": %lld, \"utilization\": %g }",
+            0 == i ? "" : ",", thread.threadIndex, static_cast<long long>(thread.samples),
+            static_cast<long long>(thread.busySamples),
+            thread.samples > 0 ? static_cast<double>(thread.busySamples) / thread.samples : 0.0);
+    }
+    fprintf(f, "\n  ]\n}\n");
+
+    return 0 == fclose(f);
+}
+
+void ReportRenderStats(const std::string &imageFilename)
+{
+    PrintStats(stdout);
+    if (LookupCacheMode::Off != GetLookupCacheMode())
+    {
+        PrintLookupCacheStats(stdout);
+    }
+    TextureCache *textureCache = GetTextureCache();
+    if (nullptr != textureCache)
+    {
+        textureCache->PrintStats(stdout);
+    }
+    std::string filename = imageFilename + ".stats.json";
+    if (!WriteStatsJSON(filename))
+    {
+        fprintf(stderr, "Unable to write render statistics to \"%s\"\n", filename.c_str());
+    }
+}
+
+
+}
+}
\ No newline at end of file
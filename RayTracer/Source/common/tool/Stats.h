@@ -0,0 +1,209 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace common
+{
+namespace tool
+{
+
+
+// Phases the sampling profiler tells apart. A thread is usually in several
+// at once (e.g. AccelIntersect inside SamplerIntegratorLi inside
+// IntegratorRender); each sample is charged to that whole set, and the
+// report nests the phases of a set in the order they are listed here.
+enum class Prof
+{
+    AccelConstruction,
+    TextureLoading,
+    MIPMapCreation,
+
+    IntegratorRender,
+    SamplerIntegratorLi,
+    SPPMCameraPass,
+    SPPMGridConstruction,
+    SPPMPhotonPass,
+    SPPMStatsUpdate,
+    BDPTGenerateSubpath,
+    BDPTConnectSubpaths,
+    LightDistribLookup,
+    LightDistribSpinWait,
+    LightDistribCreation,
+    DirectLighting,
+    BSDFEvaluation,
+    BSDFSampling,
+    BSDFPdf,
+    BSSRDFEvaluation,
+    BSSRDFSampling,
+    PhaseFuncEvaluation,
+    PhaseFuncSampling,
+    AccelIntersect,
+    AccelIntersectP,
+    LightSample,
+    LightPdf,
+    MediumSample,
+    MediumTr,
+    TriIntersect,
+    TriIntersectP,
+    ComputeScatteringFuncs,
+    GenerateCameraRay,
+    MergeFilmTile,
+    SplatFilm,
+    AddFilmSample,
+    StartPixel,
+    GetSample,
+    TexFiltTrilerp,
+    TexFiltEWA,
+
+    NumProfCategories
+};
+
+static_assert(static_cast<int>(Prof::NumProfCategories) <= 64, "Profiler phases must fit in a 64 bit mask");
+
+inline uint64_t ProfToBits(Prof p)
+{
+    return 1ULL << static_cast<int>(p);
+}
+
+const char *ProfName(Prof p);
+
+
+// Bit _i_ is set while the thread is inside a ProfilePhase of Prof _i_. Only
+// the owning thread writes it; the profiler thread reads it, so it is atomic,
+// but relaxed loads and stores compile to plain moves.
+extern thread_local std::atomic<uint64_t> ProfilerState;
+
+// Marks the thread as being in phase _p_ for the lifetime of the object.
+// Entering a phase the thread is already in (recursion) leaves the bit to
+// the outer ProfilePhase.
+class ProfilePhase
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    explicit ProfilePhase(Prof p) : categoryBit(ProfToBits(p))
+    {
+        uint64_t state = ProfilerState.load(std::memory_order_relaxed);
+        reset = 0 == (state & categoryBit);
+        ProfilerState.store(state | categoryBit, std::memory_order_relaxed);
+    }
+
+    ~ProfilePhase()
+    {
+        if (reset)
+        {
+            ProfilerState.store(ProfilerState.load(std::memory_order_relaxed) & ~categoryBit,
+                std::memory_order_relaxed);
+        }
+    }
+
+    ProfilePhase(const ProfilePhase &) = delete;
+    ProfilePhase &operator=(const ProfilePhase &) = delete;
+
+private:
+
+    const uint64_t categoryBit;
+    bool reset;
+};
+
+
+constexpr int MAX_STAT_COUNTERS = 128;
+
+// Every StatCounter of the thread, indexed by StatCounter registration
+// order. Like _ProfilerState_, only the owning thread writes its array, so
+// increments need no atomic read-modify-write.
+extern thread_local std::atomic<int64_t> ThreadStatCounters[MAX_STAT_COUNTERS];
+
+// Returns the slot of the counter named _title_, so counters of the same
+// title share one. Titles are "Category/Description".
+int RegisterStatCounter(const char *title);
+
+class StatCounter
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    explicit StatCounter(const char *title) : index(RegisterStatCounter(title))
+    {}
+
+
+    StatCounter &operator++()
+    {
+        return *this += 1;
+    }
+
+    StatCounter &operator+=(int64_t value)
+    {
+        std::atomic<int64_t> &counter = ThreadStatCounters[index];
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        return *this;
+    }
+
+private:
+
+    const int index;
+};
+
+// Defines a counter local to a .cpp. A header that counts declares an
+// _extern StatCounter_ instead and one .cpp defines it, or every
+// translation unit including the header would construct its own copy.
+#define STAT_COUNTER(title, var) static common::tool::StatCounter var(title)
+
+// Slot of the counter named _title_, or -1 if no translation unit defines it
+int FindStatCounter(const char *title);
+
+// The calling thread's count so far; differences of it measure the work
+// the thread did in between
+inline int64_t ThreadStatCounterValue(int index)
+{
+    return index < 0 ? 0 : ThreadStatCounters[index].load(std::memory_order_relaxed);
+}
+
+
+// Makes the calling thread visible to the profiler and to the counter
+// merge; counts of threads that never call it are lost. ParallelInit()
+// calls it for the main thread and every worker.
+void StatsThreadInit();
+
+// Folds the calling thread's counters into the totals before it exits
+void StatsThreadCleanup();
+
+// Starts the thread sampling every registered thread's _ProfilerState_
+// about once per _samplePeriodMs_
+void InitProfiler(int samplePeriodMs = 1);
+
+void CleanupProfiler();
+
+// Drops the samples and counts gathered so far, e.g. those of scene setup
+void ClearStats();
+
+// Thread seconds the profiler found in each phase so far, including time
+// in phases nested in it; indexed by Prof
+std::vector<double> GetProfilePhaseSeconds();
+
+// Hierarchical profile, per thread utilization and counter totals
+void PrintStats(FILE *dest);
+
+// The same report as JSON; returns false if _filename_ can't be written
+bool WriteStatsJSON(const std::string &filename);
+
+// Called by the integrators once the image is written: prints the report,
+// with the filtered lookup cache's counters unless the cache is off and the
+// texture tile cache's if there is one, and saves its JSON as
+// _imageFilename_ + ".stats.json"
+void ReportRenderStats(const std::string &imageFilename);
+
+
+}
+}
\ No newline at end of file
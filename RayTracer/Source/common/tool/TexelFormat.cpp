@@ -0,0 +1,32 @@
+#include "TexelFormat.h"
+
+namespace common
+{
+namespace tool
+{
+
+
+static Float SRGB8ToLinearEntry(int code)
+{
+    return common::math::InverseGammaCorrect(static_cast<Float>(code) / static_cast<Float>(255.0F));
+}
+
+#define SRGB8_ROW(i) \
+    SRGB8ToLinearEntry(i + 0), SRGB8ToLinearEntry(i + 1), SRGB8ToLinearEntry(i + 2), SRGB8ToLinearEntry(i + 3), \
+    SRGB8ToLinearEntry(i + 4), SRGB8ToLinearEntry(i + 5), SRGB8ToLinearEntry(i + 6), SRGB8ToLinearEntry(i + 7), \
+    SRGB8ToLinearEntry(i + 8), SRGB8ToLinearEntry(i + 9), SRGB8ToLinearEntry(i + 10), SRGB8ToLinearEntry(i + 11), \
+    SRGB8ToLinearEntry(i + 12), SRGB8ToLinearEntry(i + 13), SRGB8ToLinearEntry(i + 14), SRGB8ToLinearEntry(i + 15)
+
+const Float SRGB8ToLinear[256] =
+{
+    SRGB8_ROW(0), SRGB8_ROW(16), SRGB8_ROW(32), SRGB8_ROW(48),
+    SRGB8_ROW(64), SRGB8_ROW(80), SRGB8_ROW(96), SRGB8_ROW(112),
+    SRGB8_ROW(128), SRGB8_ROW(144), SRGB8_ROW(160), SRGB8_ROW(176),
+    SRGB8_ROW(192), SRGB8_ROW(208), SRGB8_ROW(224), SRGB8_ROW(240)
+};
+
+#undef SRGB8_ROW
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "../math/Constants.h"
+#include "../../core/color/RGBSpectrum.h"
+#include <cstdint>
+#include <cstring>
+
+namespace common
+{
+namespace tool
+{
+
+
+// How MIPMap stores its texels. Lookups always decode to full precision;
+// the compact formats only change the memory footprint.
+enum class TexelFormat : uint32_t
+{
+    // The texel type itself, one Float per channel
+    Float = 0,
+    // IEEE 754 binary16 per channel
+    Half,
+    // 8-bit sRGB encoded per channel, decoded through a table; values are
+    // clamped to [0,1], so use it only for low dynamic range textures
+    SRGB8
+};
+
+
+inline
+uint16_t FloatToHalf(float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(float));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    bits &= 0x7fffffff;
+
+    // Overflow, infinity and NaN
+    if (bits >= 0x47800000)
+    {
+        return sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+
+    // Values that become half subnormals or zero
+    if (bits < 0x38800000)
+    {
+        if (bits < 0x33000000)
+        {
+            return sign;
+        }
+        uint32_t mantissa = (bits & 0x7fffff) | 0x800000;
+        uint32_t shift = 126 - (bits >> 23);
+        uint32_t half = mantissa >> shift;
+        uint32_t rem = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (half & 1)))
+        {
+            ++half;
+        }
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    // Rebias the exponent and round to nearest even; a carry out of the
+    // mantissa correctly bumps the exponent
+    uint32_t half = (bits - 0x38000000) >> 13;
+    uint32_t rem = bits & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+    {
+        ++half;
+    }
+    return sign | static_cast<uint16_t>(half);
+}
+
+inline
+float HalfToFloat(uint16_t h)
+{
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1f, mantissa = h & 0x3ff;
+    uint32_t bits;
+    if (0 == exponent)
+    {
+        if (0 == mantissa)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Renormalize the subnormal
+            exponent = 113;
+            while (0 == (mantissa & 0x400))
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }
+    else if (31 == exponent)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(float));
+    return f;
+}
+
+
+// Linear values of the 256 sRGB codes
+extern const Float SRGB8ToLinear[256];
+
+inline
+uint8_t LinearToSRGB8(Float value)
+{
+    if (value <= FLOAT_0)
+    {
+        return 0;
+    }
+    if (value >= FLOAT_1)
+    {
+        return 255;
+    }
+    return static_cast<uint8_t>(common::math::GammaCorrect(value) * static_cast<Float>(255.0F) + FLOAT_INV_2);
+}
+
+
+// Stored representations of a texel type for each compact format
+template <typename T>
+struct TexelStorage;
+
+template <>
+struct TexelStorage<Float>
+{
+    typedef uint16_t Half;
+    typedef uint8_t SRGB8;
+
+    static Half EncodeHalf(Float v)
+    {
+        return FloatToHalf(static_cast<float>(v));
+    }
+
+    static Float DecodeHalf(Half v)
+    {
+        return static_cast<Float>(HalfToFloat(v));
+    }
+
+    static SRGB8 EncodeSRGB8(Float v)
+    {
+        return LinearToSRGB8(v);
+    }
+
+    static Float DecodeSRGB8(SRGB8 v)
+    {
+        return SRGB8ToLinear[v];
+    }
+};
+
+template <>
+struct TexelStorage<core::color::RGBSpectrum>
+{
+    struct Half
+    {
+        uint16_t c[3];
+    };
+
+    struct SRGB8
+    {
+        uint8_t c[3];
+    };
+
+    static Half EncodeHalf(const core::color::RGBSpectrum &v)
+    {
+        Half h;
+        for (int i = 0; i < 3; ++i)
+        {
+            h.c[i] = FloatToHalf(static_cast<float>(v[i]));
+        }
+        return h;
+    }
+
+    static core::color::RGBSpectrum DecodeHalf(const Half &h)
+    {
+        Float rgb[3] = {HalfToFloat(h.c[0]), HalfToFloat(h.c[1]), HalfToFloat(h.c[2])};
+        return core::color::RGBSpectrum::FromRGB(rgb);
+    }
+
+    static SRGB8 EncodeSRGB8(const core::color::RGBSpectrum &v)
+    {
+        SRGB8 s;
+        for (int i = 0; i < 3; ++i)
+        {
+            s.c[i] = LinearToSRGB8(v[i]);
+        }
+        return s;
+    }
+
+    static core::color::RGBSpectrum DecodeSRGB8(const SRGB8 &s)
+    {
+        Float rgb[3] = {SRGB8ToLinear[s.c[0]], SRGB8ToLinear[s.c[1]], SRGB8ToLinear[s.c[2]]};
+        return core::color::RGBSpectrum::FromRGB(rgb);
+    }
+};
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "TextureCache.h"
+#include "MultiThread.h"
+#include <algorithm>
+
+namespace common
+{
+namespace tool
+{
+
+
+static std::unique_ptr<TextureCache> textureCache;
+
+
+TextureCache::TextureCache(size_t maxBytes)
+    : maxBytes(maxBytes),
+    threadStates(MaxThreadIndex())
+{}
+
+TextureCache::~TextureCache()
+{}
+
+int TextureCache::AddTexture(const std::string &filename)
+{
+    std::unique_ptr<TiledTextureFile> file(new TiledTextureFile);
+    if (!file->Open(filename))
+    {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    textures.push_back(std::move(file));
+    return static_cast<int>(textures.size()) - 1;
+}
+
+const uint8_t *TextureCache::Texel(int textureId, int level, int s, int t)
+{
+    const TiledTextureFile &texture = *textures[textureId];
+    size_t offset = texture.TexelOffset(level, s, t);
+    size_t tileBytes = texture.TileBytes();
+    size_t tileIndex = offset / tileBytes;
+    uint64_t key = TileKey(textureId, level, tileIndex);
+
+    // Try the calling thread's micro-cache first
+    ThreadState &state = threadStates[ThreadIndex];
+    MicroCacheEntry &entry = state.entries[(key ^ (key >> 38)) & (MICRO_CACHE_SIZE - 1)];
+    if (entry.key == key)
+    {
+        ++state.microHits;
+    }
+    else
+    {
+        entry.tile = GetTile(textureId, level, tileIndex, key);
+        entry.key = key;
+    }
+    return entry.tile->data.get() + (offset - tileIndex * tileBytes);
+}
+
+std::shared_ptr<const TextureCache::Tile> TextureCache::GetTile(int textureId, int level, size_t tileIndex,
+    uint64_t key)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto iter = tiles.find(key);
+        if (iter != tiles.end())
+        {
+            // Move the tile to the front of the LRU list
+            ++hits;
+            lru.splice(lru.begin(), lru, iter->second);
+            return *iter->second;
+        }
+        ++misses;
+    }
+
+    // Read the tile without holding the lock so other threads can keep
+    // going; two threads missing on the same tile may both read it
+    std::shared_ptr<const Tile> tile = LoadTile(textureId, level, tileIndex, key);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bytesRead += tile->size;
+    auto iter = tiles.find(key);
+    if (iter != tiles.end())
+    {
+        return *iter->second;
+    }
+    lru.push_front(tile);
+    tiles[key] = lru.begin();
+    bytesInUse += tile->size;
+
+    // Evict least recently used tiles until we are back under budget
+    while (bytesInUse > maxBytes && lru.size() > 1)
+    {
+        const std::shared_ptr<const Tile> &victim = lru.back();
+        bytesInUse -= victim->size;
+        tiles.erase(victim->key);
+        lru.pop_back();
+        ++evictions;
+    }
+    return tile;
+}
+
+std::shared_ptr<const TextureCache::Tile> TextureCache::LoadTile(int textureId, int level, size_t tileIndex,
+    uint64_t key) const
+{
+    const TiledTextureFile &texture = *textures[textureId];
+    size_t tileBytes = texture.TileBytes();
+    size_t start = tileIndex * tileBytes;
+    size_t size = (std::min)(tileBytes, texture.LevelBytes(level) - start);
+
+    std::shared_ptr<Tile> tile = std::make_shared<Tile>();
+    tile->key = key;
+    tile->size = size;
+    tile->data.reset(new uint8_t[size]);
+    if (!texture.Read(texture.levels[level].offset + start, tile->data.get(), size))
+    {
+        /* TODO
+        Warning("%s: unable to read texture tile %d of level %d", texture.filename.c_str(),
+            static_cast<int>(tileIndex), level);
+        */
+        std::fill(tile->data.get(), tile->data.get() + size, static_cast<uint8_t>(0));
+    }
+    return tile;
+}
+
+TextureCache::Stats TextureCache::GetStats() const
+{
+    Stats stats;
+    for (const ThreadState &state : threadStates)
+    {
+        stats.microHits += state.microHits;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    stats.bytesRead = bytesRead;
+    stats.bytesInUse = bytesInUse;
+    return stats;
+}
+
+void TextureCache::PrintStats(FILE *dest) const
+{
+    Stats stats = GetStats();
+    int64_t lookups = stats.microHits + stats.hits + stats.misses;
+    fprintf(dest, "Texture cache\n");
+    fprintf(dest, "    Texel lookups                      %12lld\n", static_cast<long long>(lookups));
+    fprintf(dest, "    Thread-local hits                  %12lld (%.2f%%)\n", static_cast<long long>(stats.microHits),
+        lookups > 0 ? 100.0 * stats.microHits / lookups : 0.0);
+    fprintf(dest, "    Shared hits                        %12lld\n", static_cast<long long>(stats.hits));
+    fprintf(dest, "    Misses                             %12lld\n", static_cast<long long>(stats.misses));
+    fprintf(dest, "    Evictions                          %12lld\n", static_cast<long long>(stats.evictions));
+    fprintf(dest, "    MB read                            %12.2f\n", stats.bytesRead / (1024.0 * 1024.0));
+    fprintf(dest, "    MB resident / budget     %10.2f / %.2f\n", stats.bytesInUse / (1024.0 * 1024.0),
+        maxBytes / (1024.0 * 1024.0));
+}
+
+
+void InitTextureCache(size_t maxBytes)
+{
+    textureCache.reset(new TextureCache(maxBytes));
+}
+
+void CleanupTextureCache()
+{
+    textureCache.reset();
+}
+
+TextureCache *GetTextureCache()
+{
+    return textureCache.get();
+}
+
+
+}
+}
\ No newline at end of file
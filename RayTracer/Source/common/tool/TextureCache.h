@@ -0,0 +1,130 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "TiledTexture.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace common
+{
+namespace tool
+{
+
+
+// Thread-safe cache of texture tiles loaded on demand from tiled texture
+// files. Tiles are shared in a global LRU list bounded by a byte budget;
+// each thread also keeps a small direct-mapped table of the tiles it used
+// last, so repeated lookups into the same tile don't take the lock.
+//
+// A tile evicted from the global list stays alive while some thread's
+// micro-cache still references it, so the budget can be exceeded by at most
+// MICRO_CACHE_SIZE tiles per thread.
+class TextureCache
+{
+public:
+
+    static constexpr int MICRO_CACHE_SIZE = 64;
+
+    struct Stats
+    {
+        int64_t microHits = 0;
+        int64_t hits = 0;
+        int64_t misses = 0;
+        int64_t evictions = 0;
+        int64_t bytesRead = 0;
+        size_t bytesInUse = 0;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    explicit TextureCache(size_t maxBytes);
+
+    ~TextureCache();
+
+
+    // Opens a tiled texture file and returns its id, or -1 on failure.
+    // Textures have to be added before lookups start.
+    int AddTexture(const std::string &filename);
+
+    const TiledTextureFile &Texture(int textureId) const
+    {
+        return *textures[textureId];
+    }
+
+    // Returns a pointer to the texel bytes of $(s,t)$ in _level_. The
+    // coordinates must already be inside the level; the pointer stays valid
+    // until the calling thread's next Texel() call.
+    const uint8_t *Texel(int textureId, int level, int s, int t);
+
+    Stats GetStats() const;
+
+    void PrintStats(FILE *dest) const;
+
+private:
+
+    struct Tile
+    {
+        uint64_t key;
+        size_t size;
+        std::unique_ptr<uint8_t[]> data;
+    };
+
+    struct MicroCacheEntry
+    {
+        uint64_t key = ~0ULL;
+        std::shared_ptr<const Tile> tile;
+    };
+
+    // Padded so that threads don't share cache lines for their counters
+    struct alignas(64) ThreadState
+    {
+        MicroCacheEntry entries[MICRO_CACHE_SIZE];
+        int64_t microHits = 0;
+    };
+
+    typedef std::list<std::shared_ptr<const Tile>> TileList;
+
+    static uint64_t TileKey(int textureId, int level, size_t tileIndex)
+    {
+        return (static_cast<uint64_t>(textureId) << 44) | (static_cast<uint64_t>(level) << 38)
+            | static_cast<uint64_t>(tileIndex);
+    }
+
+    std::shared_ptr<const Tile> GetTile(int textureId, int level, size_t tileIndex, uint64_t key);
+
+    std::shared_ptr<const Tile> LoadTile(int textureId, int level, size_t tileIndex, uint64_t key) const;
+
+
+    const size_t maxBytes;
+    std::vector<std::unique_ptr<TiledTextureFile>> textures;
+    std::vector<ThreadState> threadStates;
+
+    // Guards the LRU list, the tile map and the global counters
+    mutable std::mutex mutex;
+    TileList lru;
+    std::unordered_map<uint64_t, TileList::iterator> tiles;
+    size_t bytesInUse = 0;
+    int64_t hits = 0, misses = 0, evictions = 0, bytesRead = 0;
+};
+
+
+// The cache shared by all image textures; it is only created when
+// InitTextureCache() is called, otherwise textures are loaded in memory
+void InitTextureCache(size_t maxBytes);
+
+void CleanupTextureCache();
+
+TextureCache *GetTextureCache();
+
+
+}
+}
\ No newline at end of file
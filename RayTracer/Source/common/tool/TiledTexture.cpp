@@ -0,0 +1,94 @@
+#include "TiledTexture.h"
+#include <cstring>
+
+namespace common
+{
+namespace tool
+{
+
+
+bool ReadTiledTextureHeader(const uint8_t *data, size_t size, TiledTextureHeader *header,
+    std::vector<TiledTextureLevel> *levels)
+{
+    if (size < sizeof(TiledTextureHeader))
+    {
+        return false;
+    }
+    std::memcpy(header, data, sizeof(TiledTextureHeader));
+    if (!header->IsValid()
+        || size < sizeof(TiledTextureHeader) + header->nLevels * sizeof(TiledTextureLevel))
+    {
+        return false;
+    }
+    levels->resize(header->nLevels);
+    std::memcpy(levels->data(), data + sizeof(TiledTextureHeader), header->nLevels * sizeof(TiledTextureLevel));
+
+    int blockSize = 1 << header->logBlockSize;
+    for (const TiledTextureLevel &level : *levels)
+    {
+        uint64_t uAlloc = (level.uRes + blockSize - 1) & ~(blockSize - 1);
+        uint64_t vAlloc = (level.vRes + blockSize - 1) & ~(blockSize - 1);
+        if (level.uRes <= 0 || level.vRes <= 0 || 0 != level.offset % TILED_TEXTURE_ALIGNMENT
+            || level.offset + uAlloc * vAlloc * header->texelSize > size)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+TiledTextureFile::~TiledTextureFile()
+{
+    if (file)
+    {
+        fclose(file);
+    }
+}
+
+bool TiledTextureFile::Open(const std::string &name)
+{
+    filename = name;
+    file = fopen(filename.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    if (1 != fread(&header, sizeof(TiledTextureHeader), 1, file) || !header.IsValid())
+    {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    levels.resize(header.nLevels);
+    if (header.nLevels != fread(levels.data(), sizeof(TiledTextureLevel), header.nLevels, file))
+    {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool TiledTextureFile::Read(uint64_t offset, void *dest, size_t size) const
+{
+    CHECK(nullptr != file);
+#ifdef _WIN32
+    // The CRT locks the stream around each call, but seek and read have to
+    // happen as one step
+    _lock_file(file);
+    bool ok = 0 == _fseeki64_nolock(file, static_cast<int64_t>(offset), SEEK_SET)
+        && size == _fread_nolock(dest, 1, size, file);
+    _unlock_file(file);
+#else
+    flockfile(file);
+    bool ok = 0 == fseeko(file, static_cast<off_t>(offset), SEEK_SET)
+        && size == fread(dest, 1, size, file);
+    funlockfile(file);
+#endif
+    return ok;
+}
+
+
+}
+}
\ No newline at end of file
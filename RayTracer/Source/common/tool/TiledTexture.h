@@ -0,0 +1,151 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace common
+{
+namespace tool
+{
+
+
+inline
+bool HasExtension(const std::string &value, const std::string &ending)
+{
+    if (ending.size() > value.size())
+    {
+        return false;
+    }
+    return std::equal(ending.rbegin(), ending.rend(), value.rbegin(),
+        [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+}
+
+
+// On-disk layout of a pre-tiled MIP pyramid:
+//
+//     TiledTextureHeader
+//     TiledTextureLevel[nLevels]
+//     level data, each level starting at its own _offset_
+//
+// Every level is stored exactly as the texels of a BlockedArray with the
+// same _logBlockSize_ (block after block, rows of blocks bottom up), so
+// blocks never straddle a cache tile and the data can be used in place.
+struct TiledTextureHeader
+{
+    static constexpr uint32_t MAGIC = 0x58545452; // "RTTX"
+    static constexpr uint32_t VERSION = 2;
+
+    uint32_t magic = MAGIC;
+    uint32_t version = VERSION;
+    // A TexelFormat and the size of one stored texel
+    uint32_t texelFormat = 0;
+    uint32_t texelSize = 0;
+    uint32_t logBlockSize = 2;
+    uint32_t nLevels = 0;
+    int32_t wrapMode = 0;
+
+
+    bool IsValid() const
+    {
+        return MAGIC == magic && VERSION == version && 0 != texelSize && 0 != nLevels;
+    }
+};
+
+struct TiledTextureLevel
+{
+    int32_t uRes = 0, vRes = 0;
+    uint64_t offset = 0;
+};
+
+
+// Tiles are a fixed number of consecutive blocks of one level
+static constexpr int TILED_TEXTURE_TILE_BLOCKS = 64;
+
+// Every level starts on a page boundary so it can be mapped in place
+static constexpr uint64_t TILED_TEXTURE_ALIGNMENT = 4096;
+
+
+// Parses the header and level table at the start of a mapped tiled
+// texture; fails unless every level lies inside the _size_ bytes
+bool ReadTiledTextureHeader(const uint8_t *data, size_t size, TiledTextureHeader *header,
+    std::vector<TiledTextureLevel> *levels);
+
+
+class TiledTextureFile
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    TiledTextureFile() = default;
+
+    ~TiledTextureFile();
+
+    TiledTextureFile(const TiledTextureFile &) = delete;
+    TiledTextureFile &operator=(const TiledTextureFile &) = delete;
+
+
+    // Reads the header and level table; returns false if _filename_ is not
+    // a tiled texture
+    bool Open(const std::string &filename);
+
+    // Reads _size_ bytes at _offset_ of the file; safe to call from several
+    // threads at once
+    bool Read(uint64_t offset, void *dest, size_t size) const;
+
+
+    int BlockSize() const
+    {
+        return 1 << header.logBlockSize;
+    }
+
+    int UBlocks(int level) const
+    {
+        return (levels[level].uRes + BlockSize() - 1) >> header.logBlockSize;
+    }
+
+    int VBlocks(int level) const
+    {
+        return (levels[level].vRes + BlockSize() - 1) >> header.logBlockSize;
+    }
+
+    size_t TileBytes() const
+    {
+        return static_cast<size_t>(TILED_TEXTURE_TILE_BLOCKS) * BlockSize() * BlockSize() * header.texelSize;
+    }
+
+    size_t LevelBytes(int level) const
+    {
+        return static_cast<size_t>(UBlocks(level)) * VBlocks(level) * BlockSize() * BlockSize() * header.texelSize;
+    }
+
+    // Byte offset of texel $(s,t)$ from the start of its level
+    size_t TexelOffset(int level, int s, int t) const
+    {
+        int bu = s >> header.logBlockSize, bv = t >> header.logBlockSize;
+        int ou = s & (BlockSize() - 1), ov = t & (BlockSize() - 1);
+        size_t index = static_cast<size_t>(BlockSize()) * BlockSize() * (static_cast<size_t>(UBlocks(level)) * bv + bu);
+        index += BlockSize() * ov + ou;
+        return index * header.texelSize;
+    }
+
+
+    std::string filename;
+    TiledTextureHeader header;
+    std::vector<TiledTextureLevel> levels;
+
+private:
+
+    FILE *file = nullptr;
+};
+
+
+}
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../../math/Ray.h"
 #include "../../math/Vec3.h"
 #include "../../../core/primitive/Primitive.h"
+#include "../Stats.h"
 
 namespace common
 {
@@ -107,13 +108,33 @@ static void RadixSort(std::vector<MortonPrimitive> *v)
 }
 
 
+// Accumulates the subtree under _nodeNum_ into _stats_
+static void AddNodeStats(const LinearBVHNode *nodes, int nodeNum, Float invRootArea,
+    common::tool::AcceleratorStructureStats *stats)
+{
+    const LinearBVHNode &node = nodes[nodeNum];
+    Float p = node.bounds.SurfaceArea() * invRootArea;
+    ++stats->nodes;
+    stats->sahCost += p;
+    if (node.nPrimitives > 0)
+    {
+        ++stats->leaves;
+        stats->primitiveReferences += node.nPrimitives;
+        stats->sahCost += p * node.nPrimitives;
+        return;
+    }
+    AddNodeStats(nodes, nodeNum + 1, invRootArea, stats);
+    AddNodeStats(nodes, node.secondChildOffset, invRootArea, stats);
+}
+
+
 BVHAccelerator::BVHAccelerator(std::vector<std::shared_ptr<core::primitive::Primitive>> p,
     int maxPrimsInNode, SplitMethod splitMethod)
     : maxPrimsInNode((std::min)(255, maxPrimsInNode)),
     splitMethod(splitMethod),
     primitives(std::move(p))
 {
-    //ProfilePhase _(Prof::AccelConstruction);
+    common::tool::ProfilePhase _(common::tool::Prof::AccelConstruction);
     if (primitives.empty())
     {
         return;
@@ -175,13 +196,27 @@ common::math::Bounds3f BVHAccelerator::WorldBound() const
     return nodes ? nodes[0].bounds : common::math::Bounds3f();
 }
 
-bool BVHAccelerator::Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect) const
+common::tool::AcceleratorStructureStats BVHAccelerator::StructureStats() const
+{
+    common::tool::AcceleratorStructureStats stats;
+    if (!nodes)
+    {
+        return stats;
+    }
+    AddNodeStats(nodes, 0, FLOAT_1 / nodes[0].bounds.SurfaceArea(), &stats);
+    stats.bytes = stats.nodes * sizeof(LinearBVHNode) + primitives.size() * sizeof(primitives[0]);
+    return stats;
+}
+
+template <typename Count>
+bool BVHAccelerator::Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+    Count &count) const
 {
     if (!nodes)
     {
         return false;
     }
-    //ProfilePhase p(Prof::AccelIntersect);
+    common::tool::ProfilePhase p(common::tool::Prof::AccelIntersect);
     bool hit = false;
     common::math::Vec3f invDir(FLOAT_1 / ray.dir.x, FLOAT_1 / ray.dir.y, FLOAT_1 / ray.dir.z);
     int dirIsNeg[3] = {invDir.x < FLOAT_0, invDir.y < FLOAT_0, invDir.z < FLOAT_0};
@@ -191,6 +226,7 @@ bool BVHAccelerator::Intersect(const common::math::Rayf &ray, core::interaction:
     while (true)
     {
         const LinearBVHNode *node = &nodes[currentNodeIndex];
+        count.NodeVisited();
         // Check ray against BVH node
         if (node->bounds.IntersectP(ray, invDir, dirIsNeg))
         {
@@ -199,6 +235,7 @@ bool BVHAccelerator::Intersect(const common::math::Rayf &ray, core::interaction:
                 // Intersect ray with primitives in leaf BVH node
                 for (int i = 0; i < node->nPrimitives; ++i)
                 {
+                    count.PrimitiveTested();
                     if (primitives[node->primitivesOffset + i]->Intersect(
                         ray, isect))
                     {
@@ -239,10 +276,17 @@ bool BVHAccelerator::Intersect(const common::math::Rayf &ray, core::interaction:
     return hit;
 }
 
-bool BVHAccelerator::IntersectP(const common::math::Rayf &ray) const
+bool BVHAccelerator::Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect) const
+{
+    common::tool::NoTraversalCount count;
+    return Intersect(ray, isect, count);
+}
+
+template <typename Count>
+bool BVHAccelerator::IntersectP(const common::math::Rayf &ray, Count &count) const
 {
     if (!nodes) return false;
-    //ProfilePhase p(Prof::AccelIntersectP);
+    common::tool::ProfilePhase p(common::tool::Prof::AccelIntersectP);
     common::math::Vec3f invDir(FLOAT_1 / ray.dir.x, FLOAT_1 / ray.dir.y, FLOAT_1 / ray.dir.z);
     int dirIsNeg[3] = {invDir.x < FLOAT_0, invDir.y < FLOAT_0, invDir.z < FLOAT_0};
     int nodesToVisit[64];
@@ -250,6 +294,7 @@ bool BVHAccelerator::IntersectP(const common::math::Rayf &ray) const
     while (true)
     {
         const LinearBVHNode *node = &nodes[currentNodeIndex];
+        count.NodeVisited();
         if (node->bounds.IntersectP(ray, invDir, dirIsNeg))
         {
             // Process BVH node _node_ for traversal
@@ -257,6 +302,7 @@ bool BVHAccelerator::IntersectP(const common::math::Rayf &ray) const
             {
                 for (int i = 0; i < node->nPrimitives; ++i)
                 {
+                    count.PrimitiveTested();
                     if (primitives[node->primitivesOffset + i]->IntersectP(
                         ray))
                     {
@@ -296,6 +342,83 @@ bool BVHAccelerator::IntersectP(const common::math::Rayf &ray) const
     return false;
 }
 
+bool BVHAccelerator::IntersectP(const common::math::Rayf &ray) const
+{
+    common::tool::NoTraversalCount count;
+    return IntersectP(ray, count);
+}
+
+template <typename Count>
+bool BVHAccelerator::IntersectAll(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect, const core::primitive::HitFilter &filter, Count &count) const
+{
+    if (!nodes)
+    {
+        return false;
+    }
+    common::tool::ProfilePhase p(common::tool::Prof::AccelIntersect);
+    bool hit = false;
+    common::math::Vec3f invDir(FLOAT_1 / ray.dir.x, FLOAT_1 / ray.dir.y, FLOAT_1 / ray.dir.z);
+    int dirIsNeg[3] = {invDir.x < FLOAT_0, invDir.y < FLOAT_0, invDir.z < FLOAT_0};
+    // Follow ray through BVH nodes; only accepted hits shorten the ray, so
+    // one traversal reports every hit in front of the nearest accepted one
+    int toVisitOffset = 0, currentNodeIndex = 0;
+    int nodesToVisit[64];
+    while (true)
+    {
+        const LinearBVHNode *node = &nodes[currentNodeIndex];
+        count.NodeVisited();
+        if (node->bounds.IntersectP(ray, invDir, dirIsNeg))
+        {
+            if (node->nPrimitives > 0)
+            {
+                for (int i = 0; i < node->nPrimitives; ++i)
+                {
+                    count.PrimitiveTested();
+                    if (primitives[node->primitivesOffset + i]->IntersectAll(ray, isect, filter))
+                    {
+                        hit = true;
+                    }
+                }
+                if (0 == toVisitOffset)
+                {
+                    break;
+                }
+                currentNodeIndex = nodesToVisit[--toVisitOffset];
+            }
+            else
+            {
+                if (dirIsNeg[node->axis])
+                {
+                    nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+                    currentNodeIndex = node->secondChildOffset;
+                }
+                else
+                {
+                    nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+                    currentNodeIndex = currentNodeIndex + 1;
+                }
+            }
+        }
+        else
+        {
+            if (0 == toVisitOffset)
+            {
+                break;
+            }
+            currentNodeIndex = nodesToVisit[--toVisitOffset];
+        }
+    }
+    return hit;
+}
+
+bool BVHAccelerator::IntersectAll(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect, const core::primitive::HitFilter &filter) const
+{
+    common::tool::NoTraversalCount count;
+    return IntersectAll(ray, isect, filter, count);
+}
+
 
 BVHBuildNode *BVHAccelerator::recursiveBuild(
     MemoryArena &arena, std::vector<BVHPrimitiveInfo> &primitiveInfo, int start,
@@ -806,6 +929,14 @@ int BVHAccelerator::flattenBVHTree(BVHBuildNode *node, int *offset)
 }
 
 
+// The counting traversals, for callers that measure the work per ray
+template bool BVHAccelerator::Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+    common::tool::CountTraversal &count) const;
+template bool BVHAccelerator::IntersectP(const common::math::Rayf &ray, common::tool::CountTraversal &count) const;
+template bool BVHAccelerator::IntersectAll(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect, const core::primitive::HitFilter &filter,
+    common::tool::CountTraversal &count) const;
+
 }
 }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../../core/primitive/Aggregate.h"
+#include "../AcceleratorStats.h"
 #include "BVHBuildNode.h"
 #include "BVHPrimitiveInfo.h"
 #include "MortonPrimitive.h"
@@ -42,6 +43,23 @@ public:
 
     bool IntersectP(const common::math::Rayf &ray) const;
 
+    bool IntersectAll(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+        const core::primitive::HitFilter &filter) const;
+
+    // The traversals behind the three above, adding their work to _count_;
+    // instantiated for NoTraversalCount and CountTraversal
+    template <typename Count>
+    bool Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect, Count &count) const;
+
+    template <typename Count>
+    bool IntersectP(const common::math::Rayf &ray, Count &count) const;
+
+    template <typename Count>
+    bool IntersectAll(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+        const core::primitive::HitFilter &filter, Count &count) const;
+
+    common::tool::AcceleratorStructureStats StructureStats() const;
+
 private:
 
     BVHBuildNode *recursiveBuild(
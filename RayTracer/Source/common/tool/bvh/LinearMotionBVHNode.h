@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../../../ForwardDeclaration.h"
+#include "../../math/Bounds3.h"
+
+namespace common
+{
+namespace tool
+{
+namespace bvh
+{
+
+
+struct LinearMotionBVHNode
+{
+    // axis of a node that splits its time range at the middle, the first
+    // child covering the earlier half
+    static constexpr uint8_t TIME_AXIS = 3;
+
+    // Bounds at the start and the end of the node's time range, which a
+    // ray interpolates at its time
+    common::math::Bounds3f bounds0, bounds1;
+    Float time0, invDuration;
+    union
+    {
+        int primitivesOffset;   // leaf
+        int secondChildOffset;  // interior
+    };
+    uint16_t nPrimitives;  // 0 -> interior node
+    uint8_t axis;          // interior node: xyz or TIME_AXIS
+    uint8_t pad[1];        // ensure 64 byte total size
+};
+
+
+}
+}
+}
\ No newline at end of file
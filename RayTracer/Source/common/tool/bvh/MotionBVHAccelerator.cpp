@@ -0,0 +1,555 @@
+#include "MotionBVHAccelerator.h"
+#include "../MemoryArena.h"
+#include "../../math/Ray.h"
+#include "../../math/Vec3.h"
+#include "../../../core/primitive/Primitive.h"
+
+namespace common
+{
+namespace tool
+{
+namespace bvh
+{
+
+
+struct MotionPrimitiveInfo
+{
+    size_t primitiveNumber;
+
+    // Linear bounds over the time range of the node being built
+    common::math::Bounds3f bounds0, bounds1;
+
+    common::math::Vec3f centroid;
+};
+
+struct MotionBucketInfo
+{
+    int count = 0;
+    common::math::Bounds3f bounds0, bounds1;
+};
+
+
+// A node splits in time when the halves of its range are bounded this much
+// tighter than the whole
+static constexpr Float TIME_SPLIT_RATIO = static_cast<Float>(0.7F);
+
+
+static common::math::Bounds3f LerpBounds(Float u, const common::math::Bounds3f &b0,
+    const common::math::Bounds3f &b1)
+{
+    common::math::Bounds3f ret;
+    ret.point_min = common::math::Lerp(u, b0.point_min, b1.point_min);
+    ret.point_max = common::math::Lerp(u, b0.point_max, b1.point_max);
+    return ret;
+}
+
+// Surface area of linear bounds halfway through their time range, which
+// stands in for the area a ray at a random time sees
+static Float MidArea(const common::math::Bounds3f &b0, const common::math::Bounds3f &b1)
+{
+    return LerpBounds(FLOAT_INV_2, b0, b1).SurfaceArea();
+}
+
+// Adds _count_ primitives with linear bounds _b0_, _b1_ to a bucket
+static void AddToBucket(MotionBucketInfo *bucket, int count, const common::math::Bounds3f &b0,
+    const common::math::Bounds3f &b1)
+{
+    if (0 == bucket->count)
+    {
+        bucket->bounds0 = b0;
+        bucket->bounds1 = b1;
+    }
+    else
+    {
+        bucket->bounds0 = Union(bucket->bounds0, b0);
+        bucket->bounds1 = Union(bucket->bounds1, b1);
+    }
+    bucket->count += count;
+}
+
+
+// Accumulates the subtree under _nodeNum_ into _stats_. The children of a
+// time split each see half the rays, so they count half.
+static void AddNodeStats(const LinearMotionBVHNode *nodes, int nodeNum, Float weight, Float invRootArea,
+    common::tool::AcceleratorStructureStats *stats)
+{
+    const LinearMotionBVHNode &node = nodes[nodeNum];
+    Float p = weight * MidArea(node.bounds0, node.bounds1) * invRootArea;
+    ++stats->nodes;
+    stats->sahCost += p;
+    if (node.nPrimitives > 0)
+    {
+        ++stats->leaves;
+        stats->primitiveReferences += node.nPrimitives;
+        stats->sahCost += p * node.nPrimitives;
+        return;
+    }
+    Float childWeight = LinearMotionBVHNode::TIME_AXIS == node.axis ? FLOAT_INV_2 * weight : weight;
+    AddNodeStats(nodes, nodeNum + 1, childWeight, invRootArea, stats);
+    AddNodeStats(nodes, node.secondChildOffset, childWeight, invRootArea, stats);
+}
+
+
+// Walks the nodes whose bounds at the ray's time the ray crosses and hands
+// each leaf to _visitLeaf_, which returns true to end the walk
+template <typename Count, typename VisitLeaf>
+static void Traverse(const LinearMotionBVHNode *nodes, Float time0, Float time1,
+    const common::math::Rayf &ray, Count &count, VisitLeaf visitLeaf)
+{
+    // The scene holds still outside the range it was built for
+    Float time = (std::min)((std::max)(ray.time, time0), time1);
+    common::math::Vec3f invDir(FLOAT_1 / ray.dir.x, FLOAT_1 / ray.dir.y, FLOAT_1 / ray.dir.z);
+    int dirIsNeg[3] = {invDir.x < FLOAT_0, invDir.y < FLOAT_0, invDir.z < FLOAT_0};
+    int toVisitOffset = 0, currentNodeIndex = 0;
+    int nodesToVisit[64];
+    while (true)
+    {
+        const LinearMotionBVHNode *node = &nodes[currentNodeIndex];
+        count.NodeVisited();
+        Float u = (time - node->time0) * node->invDuration;
+        if (LerpBounds(u, node->bounds0, node->bounds1).IntersectP(ray, invDir, dirIsNeg))
+        {
+            if (node->nPrimitives > 0)
+            {
+                if (visitLeaf(node->primitivesOffset, node->nPrimitives) || 0 == toVisitOffset)
+                {
+                    break;
+                }
+                currentNodeIndex = nodesToVisit[--toVisitOffset];
+            }
+            else if (LinearMotionBVHNode::TIME_AXIS == node->axis)
+            {
+                // Only the half holding the ray's time
+                currentNodeIndex = u < FLOAT_INV_2 ? currentNodeIndex + 1 : node->secondChildOffset;
+            }
+            else
+            {
+                // Put far BVH node on _nodesToVisit_ stack, advance to near
+                // node
+                if (dirIsNeg[node->axis])
+                {
+                    nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+                    currentNodeIndex = node->secondChildOffset;
+                }
+                else
+                {
+                    nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+                    currentNodeIndex = currentNodeIndex + 1;
+                }
+            }
+        }
+        else
+        {
+            if (0 == toVisitOffset)
+            {
+                break;
+            }
+            currentNodeIndex = nodesToVisit[--toVisitOffset];
+        }
+    }
+}
+
+
+MotionBVHAccelerator::MotionBVHAccelerator(std::vector<std::shared_ptr<core::primitive::Primitive>> p,
+    Float time0, Float time1, int maxPrimsInNode)
+    : maxPrimsInNode((std::min)(255, maxPrimsInNode)),
+    time0(time0),
+    time1(time1),
+    primitives(std::move(p))
+{
+    if (primitives.empty())
+    {
+        return;
+    }
+
+    // Sample the bounds of each primitive over every sub-slice of the time
+    // range, keeping one box for primitives that don't move
+    constexpr int sampleNumber = TIME_SEGMENTS * SEGMENT_SAMPLES;
+    Float sampleDuration = (time1 - time0) / sampleNumber;
+    common::math::Bounds3f samples[sampleNumber];
+    sampleOffsets.resize(primitives.size());
+    std::vector<MotionPrimitiveInfo> primitiveInfo(primitives.size());
+    for (size_t i = 0; i < primitives.size(); ++i)
+    {
+        bool moving = false;
+        for (int s = 0; s < sampleNumber; ++s)
+        {
+            samples[s] = primitives[i]->MotionBound(time0 + s * sampleDuration,
+                s + 1 == sampleNumber ? time1 : time0 + (s + 1) * sampleDuration);
+            moving = moving || !(samples[s].point_min == samples[0].point_min &&
+                samples[s].point_max == samples[0].point_max);
+        }
+        int offset = static_cast<int>(motionSamples.size());
+        sampleOffsets[i] = moving ? offset : ~offset;
+        motionSamples.insert(motionSamples.end(), samples, samples + (moving ? sampleNumber : 1));
+        primitiveInfo[i].primitiveNumber = i;
+    }
+
+    // Nodes are emitted in depth-first order as they are built
+    std::vector<LinearMotionBVHNode> buildNodes;
+    buildNodes.reserve(2 * primitives.size());
+    std::vector<std::shared_ptr<core::primitive::Primitive>> orderedPrims;
+    orderedPrims.reserve(primitives.size());
+    recursiveBuild(buildNodes, primitiveInfo, 0, static_cast<int>(primitives.size()), 0, TIME_SEGMENTS,
+        orderedPrims);
+    primitives.swap(orderedPrims);
+    motionSamples.clear();
+    motionSamples.shrink_to_fit();
+    sampleOffsets.clear();
+    sampleOffsets.shrink_to_fit();
+
+    nodeNumber = static_cast<int>(buildNodes.size());
+    nodes = common::tool::AllocAligned<LinearMotionBVHNode>(nodeNumber);
+    std::copy(buildNodes.begin(), buildNodes.end(), nodes);
+}
+
+MotionBVHAccelerator::~MotionBVHAccelerator()
+{
+    FreeAligned(nodes);
+}
+
+
+common::math::Bounds3f MotionBVHAccelerator::WorldBound() const
+{
+    return nodes ? Union(nodes[0].bounds0, nodes[0].bounds1) : common::math::Bounds3f();
+}
+
+common::tool::AcceleratorStructureStats MotionBVHAccelerator::StructureStats() const
+{
+    common::tool::AcceleratorStructureStats stats;
+    if (!nodes)
+    {
+        return stats;
+    }
+    AddNodeStats(nodes, 0, FLOAT_1, FLOAT_1 / MidArea(nodes[0].bounds0, nodes[0].bounds1), &stats);
+    stats.bytes = stats.nodes * sizeof(LinearMotionBVHNode) + primitives.size() * sizeof(primitives[0]);
+    return stats;
+}
+
+template <typename Count>
+bool MotionBVHAccelerator::Intersect(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect, Count &count) const
+{
+    if (!nodes)
+    {
+        return false;
+    }
+    bool hit = false;
+    Traverse(nodes, time0, time1, ray, count, [&](int offset, int n)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            count.PrimitiveTested();
+            if (primitives[offset + i]->Intersect(ray, isect))
+            {
+                hit = true;
+            }
+        }
+        return false;
+    });
+    return hit;
+}
+
+bool MotionBVHAccelerator::Intersect(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect) const
+{
+    common::tool::NoTraversalCount count;
+    return Intersect(ray, isect, count);
+}
+
+template <typename Count>
+bool MotionBVHAccelerator::IntersectP(const common::math::Rayf &ray, Count &count) const
+{
+    if (!nodes)
+    {
+        return false;
+    }
+    bool hit = false;
+    Traverse(nodes, time0, time1, ray, count, [&](int offset, int n)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            count.PrimitiveTested();
+            if (primitives[offset + i]->IntersectP(ray))
+            {
+                hit = true;
+                return true;
+            }
+        }
+        return false;
+    });
+    return hit;
+}
+
+bool MotionBVHAccelerator::IntersectP(const common::math::Rayf &ray) const
+{
+    common::tool::NoTraversalCount count;
+    return IntersectP(ray, count);
+}
+
+template <typename Count>
+bool MotionBVHAccelerator::IntersectAll(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect, const core::primitive::HitFilter &filter, Count &count) const
+{
+    if (!nodes)
+    {
+        return false;
+    }
+    bool hit = false;
+    Traverse(nodes, time0, time1, ray, count, [&](int offset, int n)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            count.PrimitiveTested();
+            if (primitives[offset + i]->IntersectAll(ray, isect, filter))
+            {
+                hit = true;
+            }
+        }
+        return false;
+    });
+    return hit;
+}
+
+bool MotionBVHAccelerator::IntersectAll(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect, const core::primitive::HitFilter &filter) const
+{
+    common::tool::NoTraversalCount count;
+    return IntersectAll(ray, isect, filter, count);
+}
+
+
+void MotionBVHAccelerator::LinearBounds(size_t primitiveNumber, int segment0, int segment1,
+    common::math::Bounds3f *bounds0, common::math::Bounds3f *bounds1) const
+{
+    int offset = sampleOffsets[primitiveNumber];
+    if (offset < 0)
+    {
+        *bounds0 = *bounds1 = motionSamples[~offset];
+        return;
+    }
+
+    // Interpolating the first and last sample must cover every sample in
+    // between over its whole duration; the interpolation being linear, its
+    // ends are the only times to check. Whatever falls outside pushes both
+    // boxes out.
+    const common::math::Bounds3f *samples = &motionSamples[offset];
+    int sample0 = segment0 * SEGMENT_SAMPLES, sample1 = segment1 * SEGMENT_SAMPLES;
+    *bounds0 = samples[sample0];
+    *bounds1 = samples[sample1 - 1];
+    Float n = static_cast<Float>(sample1 - sample0);
+    common::math::Vec3f grow_min(FLOAT_0, FLOAT_0, FLOAT_0), grow_max(FLOAT_0, FLOAT_0, FLOAT_0);
+    for (int s = sample0; s < sample1; ++s)
+    {
+        for (int end = 0; end < 2; ++end)
+        {
+            common::math::Bounds3f b = LerpBounds((s - sample0 + end) / n, *bounds0, *bounds1);
+            grow_min = Max(grow_min, b.point_min - samples[s].point_min);
+            grow_max = Max(grow_max, samples[s].point_max - b.point_max);
+        }
+    }
+    bounds0->point_min -= grow_min;
+    bounds1->point_min -= grow_min;
+    bounds0->point_max += grow_max;
+    bounds1->point_max += grow_max;
+}
+
+int MotionBVHAccelerator::emitLeaf(std::vector<LinearMotionBVHNode> &buildNodes, int nodeIndex,
+    const std::vector<MotionPrimitiveInfo> &primitiveInfo, int start, int end,
+    std::vector<std::shared_ptr<core::primitive::Primitive>> &orderedPrims) const
+{
+    CHECK_LT(end - start, 65536);
+    LinearMotionBVHNode &node = buildNodes[nodeIndex];
+    node.primitivesOffset = static_cast<int>(orderedPrims.size());
+    node.nPrimitives = static_cast<uint16_t>(end - start);
+    for (int i = start; i < end; ++i)
+    {
+        orderedPrims.push_back(primitives[primitiveInfo[i].primitiveNumber]);
+    }
+    return nodeIndex;
+}
+
+int MotionBVHAccelerator::recursiveBuild(std::vector<LinearMotionBVHNode> &buildNodes,
+    std::vector<MotionPrimitiveInfo> &primitiveInfo, int start, int end,
+    int segment0, int segment1,
+    std::vector<std::shared_ptr<core::primitive::Primitive>> &orderedPrims)
+{
+    CHECK_NE(start, end);
+    int nodeIndex = static_cast<int>(buildNodes.size());
+    buildNodes.emplace_back();
+
+    // Compute linear bounds of the primitives over this node's time range
+    common::math::Bounds3f bounds0, bounds1;
+    for (int i = start; i < end; ++i)
+    {
+        MotionPrimitiveInfo &pi = primitiveInfo[i];
+        LinearBounds(pi.primitiveNumber, segment0, segment1, &pi.bounds0, &pi.bounds1);
+        common::math::Bounds3f mid = LerpBounds(FLOAT_INV_2, pi.bounds0, pi.bounds1);
+        pi.centroid = FLOAT_INV_2 * mid.point_min + FLOAT_INV_2 * mid.point_max;
+        bounds0 = i == start ? pi.bounds0 : Union(bounds0, pi.bounds0);
+        bounds1 = i == start ? pi.bounds1 : Union(bounds1, pi.bounds1);
+    }
+    Float segmentDuration = (time1 - time0) / TIME_SEGMENTS;
+    Float duration = (segment1 - segment0) * segmentDuration;
+    {
+        LinearMotionBVHNode &node = buildNodes[nodeIndex];
+        node.bounds0 = bounds0;
+        node.bounds1 = bounds1;
+        node.time0 = time0 + segment0 * segmentDuration;
+        node.invDuration = duration > FLOAT_0 ? FLOAT_1 / duration : FLOAT_0;
+    }
+    int nPrimitives = end - start;
+    Float area = MidArea(bounds0, bounds1);
+
+    // Split the time range in half where the halves bound much tighter
+    if (segment1 - segment0 > 1)
+    {
+        int segmentMid = (segment0 + segment1) / 2;
+        common::math::Bounds3f half0[2], half1[2];
+        for (int i = start; i < end; ++i)
+        {
+            common::math::Bounds3f b0, b1;
+            LinearBounds(primitiveInfo[i].primitiveNumber, segment0, segmentMid, &b0, &b1);
+            half0[0] = i == start ? b0 : Union(half0[0], b0);
+            half1[0] = i == start ? b1 : Union(half1[0], b1);
+            LinearBounds(primitiveInfo[i].primitiveNumber, segmentMid, segment1, &b0, &b1);
+            half0[1] = i == start ? b0 : Union(half0[1], b0);
+            half1[1] = i == start ? b1 : Union(half1[1], b1);
+        }
+        Float timeSplitArea = FLOAT_INV_2 * (MidArea(half0[0], half1[0]) + MidArea(half0[1], half1[1]));
+        if (timeSplitArea < TIME_SPLIT_RATIO * area)
+        {
+            buildNodes[nodeIndex].axis = LinearMotionBVHNode::TIME_AXIS;
+            buildNodes[nodeIndex].nPrimitives = 0;
+            recursiveBuild(buildNodes, primitiveInfo, start, end, segment0, segmentMid, orderedPrims);
+            int second = recursiveBuild(buildNodes, primitiveInfo, start, end, segmentMid, segment1,
+                orderedPrims);
+            buildNodes[nodeIndex].secondChildOffset = second;
+            return nodeIndex;
+        }
+    }
+
+    if (1 == nPrimitives)
+    {
+        return emitLeaf(buildNodes, nodeIndex, primitiveInfo, start, end, orderedPrims);
+    }
+
+    // Compute bound of primitive centroids, choose split dimension _dim_
+    common::math::Bounds3f centroidBounds(primitiveInfo[start].centroid);
+    for (int i = start + 1; i < end; ++i)
+    {
+        centroidBounds = Union(centroidBounds, primitiveInfo[i].centroid);
+    }
+    int dim = centroidBounds.MaximumExtent();
+    if (centroidBounds.point_max[dim] == centroidBounds.point_min[dim])
+    {
+        return emitLeaf(buildNodes, nodeIndex, primitiveInfo, start, end, orderedPrims);
+    }
+
+    int mid = (start + end) / 2;
+    if (nPrimitives <= 2)
+    {
+        // Partition primitives into equally-sized subsets
+        std::nth_element(&primitiveInfo[start], &primitiveInfo[mid], &primitiveInfo[end - 1] + 1,
+            [dim](const MotionPrimitiveInfo &a, const MotionPrimitiveInfo &b)
+        {
+            return a.centroid[dim] < b.centroid[dim];
+        });
+    }
+    else
+    {
+        // Partition primitives using approximate SAH over the bounds at the
+        // middle of the time range
+        constexpr int nBuckets = 12;
+        MotionBucketInfo buckets[nBuckets];
+        for (int i = start; i < end; ++i)
+        {
+            int b = (std::min)(static_cast<int>(nBuckets * centroidBounds.Offset(primitiveInfo[i].centroid)[dim]),
+                nBuckets - 1);
+            CHECK_GE(b, 0);
+            AddToBucket(&buckets[b], 1, primitiveInfo[i].bounds0, primitiveInfo[i].bounds1);
+        }
+
+        // Compute costs for splitting after each bucket
+        Float cost[nBuckets - 1];
+        for (int i = 0; i < nBuckets - 1; ++i)
+        {
+            MotionBucketInfo b0, b1;
+            for (int j = 0; j <= i; ++j)
+            {
+                if (buckets[j].count > 0)
+                {
+                    AddToBucket(&b0, buckets[j].count, buckets[j].bounds0, buckets[j].bounds1);
+                }
+            }
+            for (int j = i + 1; j < nBuckets; ++j)
+            {
+                if (buckets[j].count > 0)
+                {
+                    AddToBucket(&b1, buckets[j].count, buckets[j].bounds0, buckets[j].bounds1);
+                }
+            }
+            cost[i] = FLOAT_1 +
+                ((b0.count > 0 ? b0.count * MidArea(b0.bounds0, b0.bounds1) : FLOAT_0) +
+                    (b1.count > 0 ? b1.count * MidArea(b1.bounds0, b1.bounds1) : FLOAT_0)) / area;
+        }
+
+        // Find bucket to split at that minimizes SAH metric
+        Float minCost = cost[0];
+        int minCostSplitBucket = 0;
+        for (int i = 1; i < nBuckets - 1; ++i)
+        {
+            if (cost[i] < minCost)
+            {
+                minCost = cost[i];
+                minCostSplitBucket = i;
+            }
+        }
+
+        // Either create leaf or split primitives at selected SAH bucket
+        Float leafCost = static_cast<Float>(nPrimitives);
+        if (nPrimitives <= maxPrimsInNode && minCost >= leafCost)
+        {
+            return emitLeaf(buildNodes, nodeIndex, primitiveInfo, start, end, orderedPrims);
+        }
+        MotionPrimitiveInfo *pmid = std::partition(&primitiveInfo[start], &primitiveInfo[end - 1] + 1,
+            [=](const MotionPrimitiveInfo &pi)
+        {
+            int b = (std::min)(static_cast<int>(nBuckets * centroidBounds.Offset(pi.centroid)[dim]),
+                nBuckets - 1);
+            return b <= minCostSplitBucket;
+        });
+        mid = static_cast<int>(pmid - &primitiveInfo[0]);
+        if (mid == start || mid == end)
+        {
+            mid = (start + end) / 2;
+            std::nth_element(&primitiveInfo[start], &primitiveInfo[mid], &primitiveInfo[end - 1] + 1,
+                [dim](const MotionPrimitiveInfo &a, const MotionPrimitiveInfo &b)
+            {
+                return a.centroid[dim] < b.centroid[dim];
+            });
+        }
+    }
+
+    buildNodes[nodeIndex].axis = static_cast<uint8_t>(dim);
+    buildNodes[nodeIndex].nPrimitives = 0;
+    recursiveBuild(buildNodes, primitiveInfo, start, mid, segment0, segment1, orderedPrims);
+    int second = recursiveBuild(buildNodes, primitiveInfo, mid, end, segment0, segment1, orderedPrims);
+    buildNodes[nodeIndex].secondChildOffset = second;
+    return nodeIndex;
+}
+
+
+// The counting traversals, for callers that measure the work per ray
+template bool MotionBVHAccelerator::Intersect(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect, common::tool::CountTraversal &count) const;
+template bool MotionBVHAccelerator::IntersectP(const common::math::Rayf &ray,
+    common::tool::CountTraversal &count) const;
+template bool MotionBVHAccelerator::IntersectAll(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect, const core::primitive::HitFilter &filter,
+    common::tool::CountTraversal &count) const;
+
+
+}
+}
+}
\ No newline at end of file
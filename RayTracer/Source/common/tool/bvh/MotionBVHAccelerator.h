@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../../../core/primitive/Aggregate.h"
+#include "../AcceleratorStats.h"
+#include "LinearMotionBVHNode.h"
+#include <vector>
+
+namespace common
+{
+namespace tool
+{
+namespace bvh
+{
+
+
+struct MotionPrimitiveInfo;
+
+
+// BVH over primitives that move while the shutter is open. Nodes store
+// linear bounds, one box for each end of their time range, and rays test
+// the box interpolated at their time, so a moving primitive costs about
+// what a static one does instead of being boxed over its whole path.
+// Where motion is too far from linear for that (rotation, a primitive
+// crossing the scene) a node splits its time range in half and builds a
+// subtree for each half.
+class MotionBVHAccelerator : public core::primitive::Aggregate
+{
+public:
+
+    // Time splits halve [time0, time1] down to TIME_SEGMENTS slices at most
+    static constexpr int TIME_SEGMENTS = 8;
+
+    // Bounds of a moving primitive are sampled over this many sub-slices of
+    // each slice; linear bounds fitted to them are loose by about the
+    // distance the primitive covers in one sub-slice
+    static constexpr int SEGMENT_SAMPLES = 4;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    MotionBVHAccelerator(std::vector<std::shared_ptr<core::primitive::Primitive>> p
+        , Float time0 = FLOAT_0, Float time1 = FLOAT_1, int maxPrimsInNode = 1);
+
+    ~MotionBVHAccelerator();
+
+
+    common::math::Bounds3f WorldBound() const;
+
+    bool Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect) const;
+
+    bool IntersectP(const common::math::Rayf &ray) const;
+
+    bool IntersectAll(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+        const core::primitive::HitFilter &filter) const;
+
+    // The traversals behind the three above, adding their work to _count_;
+    // instantiated for NoTraversalCount and CountTraversal
+    template <typename Count>
+    bool Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect, Count &count) const;
+
+    template <typename Count>
+    bool IntersectP(const common::math::Rayf &ray, Count &count) const;
+
+    template <typename Count>
+    bool IntersectAll(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+        const core::primitive::HitFilter &filter, Count &count) const;
+
+    // Node areas are taken halfway through their time range, and each time
+    // split halves the weight of the subtrees under it
+    common::tool::AcceleratorStructureStats StructureStats() const;
+
+    int NodeNumber() const
+    {
+        return nodeNumber;
+    }
+
+private:
+
+    int recursiveBuild(std::vector<LinearMotionBVHNode> &buildNodes,
+        std::vector<MotionPrimitiveInfo> &primitiveInfo, int start, int end,
+        int segment0, int segment1,
+        std::vector<std::shared_ptr<core::primitive::Primitive>> &orderedPrims);
+
+    // Linear bounds of primitive _primitiveNumber_ over the time segments
+    // [segment0, segment1)
+    void LinearBounds(size_t primitiveNumber, int segment0, int segment1,
+        common::math::Bounds3f *bounds0, common::math::Bounds3f *bounds1) const;
+
+    int emitLeaf(std::vector<LinearMotionBVHNode> &buildNodes, int nodeIndex,
+        const std::vector<MotionPrimitiveInfo> &primitiveInfo, int start, int end,
+        std::vector<std::shared_ptr<core::primitive::Primitive>> &orderedPrims) const;
+
+
+    const int maxPrimsInNode;
+    const Float time0, time1;
+    std::vector<std::shared_ptr<core::primitive::Primitive>> primitives;
+    // During the build only: TIME_SEGMENTS * SEGMENT_SAMPLES bounds per
+    // moving primitive from motionSamples[sampleOffsets[i]] on, and one at
+    // ~sampleOffsets[i] for each primitive that holds still
+    std::vector<common::math::Bounds3f> motionSamples;
+    std::vector<int> sampleOffsets;
+    LinearMotionBVHNode *nodes = nullptr;
+    int nodeNumber = 0;
+};
+
+
+}
+}
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../../math/Ray.h"
 #include "../../math/Vec3.h"
 #include "../../../core/primitive/Primitive.h"
+#include "../Stats.h"
 
 namespace common
 {
@@ -20,6 +21,57 @@ struct KDTreeToDo
 };
 
 
+struct KDBuildNode
+{
+    int axis;  // 3 for leaves
+    Float split;
+    KDBuildNode *children[2];
+    int nPrimitives;
+    int *primNums;
+};
+
+struct KDBuildTask
+{
+    KDBuildNode *node;
+    common::math::Bounds3f bounds;
+    std::vector<BoundEdge> edges[3];
+    int depth, badRefines;
+};
+
+
+// Sides of the split a primitive overlaps
+static constexpr uint8_t SIDE_BELOW = 1;
+static constexpr uint8_t SIDE_ABOVE = 2;
+
+static int CountNodes(const KDBuildNode *node)
+{
+    return 3 == node->axis ? 1 : 1 + CountNodes(node->children[0]) + CountNodes(node->children[1]);
+}
+
+
+// Accumulates the subtree under _nodeNum_, which covers _nodeBounds_, into
+// _stats_
+static void AddNodeStats(const KDTreeNode *nodes, int nodeNum, const common::math::Bounds3f &nodeBounds,
+    Float invRootArea, common::tool::AcceleratorStructureStats *stats)
+{
+    const KDTreeNode &node = nodes[nodeNum];
+    Float p = nodeBounds.SurfaceArea() * invRootArea;
+    ++stats->nodes;
+    stats->sahCost += p;
+    if (node.IsLeaf())
+    {
+        ++stats->leaves;
+        stats->primitiveReferences += node.nPrimitives();
+        stats->sahCost += p * node.nPrimitives();
+        return;
+    }
+    common::math::Bounds3f bounds0 = nodeBounds, bounds1 = nodeBounds;
+    bounds0.point_max[node.SplitAxis()] = bounds1.point_min[node.SplitAxis()] = node.SplitPos();
+    AddNodeStats(nodes, nodeNum + 1, bounds0, invRootArea, stats);
+    AddNodeStats(nodes, node.AboveChild(), bounds1, invRootArea, stats);
+}
+
+
 KDTreeAccelerator::KDTreeAccelerator(std::vector<std::shared_ptr<core::primitive::Primitive>> p,
     int isectCost, int traversalCost, Float emptyBonus,
     int maxPrims, int maxDepth)
@@ -27,10 +79,11 @@ KDTreeAccelerator::KDTreeAccelerator(std::vector<std::shared_ptr<core::primitive
     traversalCost(traversalCost),
     maxPrims(maxPrims),
     emptyBonus(emptyBonus),
-    primitives(std::move(p))
+    primitives(std::move(p)),
+    nodes(nullptr)
 {
     // Build kd-tree for accelerator
-    //ProfilePhase _(Prof::AccelConstruction);
+    common::tool::ProfilePhase _(common::tool::Prof::AccelConstruction);
     nextFreeNode = nAllocedNodes = 0;
     if (maxDepth <= 0)
     {
@@ -38,35 +91,65 @@ KDTreeAccelerator::KDTreeAccelerator(std::vector<std::shared_ptr<core::primitive
             + static_cast<Float>(1.3F) * common::math::Log2Int(int64_t(primitives.size()))));
     }
 
-    // Compute bounds for kd-tree construction
-    std::vector<common::math::Bounds3f> primBounds;
-    primBounds.reserve(primitives.size());
-    for (const std::shared_ptr<core::primitive::Primitive> &prim : primitives)
-    {
-        common::math::Bounds3f b = prim->WorldBound();
-        bounds = Union(bounds, b);
-        primBounds.push_back(b);
-    }
-
-    // Allocate working memory for kd-tree construction
-    std::unique_ptr<BoundEdge[]> edges[3];
-    for (int i = 0; i < 3; ++i)
+    // Compute bounds and sorted edges of every axis for kd-tree construction;
+    // each node then splits the sorted lists between its children in linear
+    // time, which makes the build O(n log n)
+    std::vector<BoundEdge> edges[3];
+    for (int axis = 0; axis < 3; ++axis)
     {
-        edges[i].reset(new BoundEdge[2 * primitives.size()]);
+        edges[axis].reserve(2 * primitives.size());
     }
-    std::unique_ptr<int[]> prims0(new int[primitives.size()]);
-    std::unique_ptr<int[]> prims1(new int[(maxDepth + 1) * primitives.size()]);
-
-    // Initialize _primNums_ for kd-tree construction
-    std::unique_ptr<int[]> primNums(new int[primitives.size()]);
     for (size_t i = 0; i < primitives.size(); ++i)
     {
-        primNums[i] = i;
+        common::math::Bounds3f b = primitives[i]->WorldBound();
+        bounds = Union(bounds, b);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            edges[axis].push_back(BoundEdge(b.point_min[axis], static_cast<int>(i), true));
+            edges[axis].push_back(BoundEdge(b.point_max[axis], static_cast<int>(i), false));
+        }
     }
+    ParallelFor([&](int64_t axis)
+    {
+        std::sort(edges[axis].begin(), edges[axis].end(),
+            [](const BoundEdge &e0, const BoundEdge &e1) -> bool
+        {
+            if (e0.t == e1.t)
+            {
+                return (int)e0.type < (int)e1.type;
+            }
+            else
+            {
+                return e0.t < e1.t;
+            }
+        });
+    }, 3);
 
-    // Start recursive construction of kd-tree
-    buildTree(0, bounds, primBounds, primNums.get(), primitives.size(),
-        maxDepth, edges, prims0.get(), prims1.get());
+    primSides.resize(MaxThreadIndex());
+
+    // The upper levels are built here until there are a few subtrees per
+    // core, which are then built in parallel
+    common::tool::MemoryArena arena;
+    KDBuildNode *root = arena.Alloc<KDBuildNode>();
+    std::vector<KDBuildTask> tasks;
+    int taskDepth = maxDepth - common::math::Log2Int(4 * NumSystemCores());
+    buildTree(root, bounds, edges, maxDepth, 0, arena, &tasks, taskDepth);
+
+    std::vector<std::unique_ptr<common::tool::MemoryArena>> taskArenas(tasks.size());
+    ParallelFor([&](int64_t i)
+    {
+        KDBuildTask &task = tasks[i];
+        taskArenas[i].reset(new common::tool::MemoryArena());
+        buildTree(task.node, task.bounds, task.edges, task.depth, task.badRefines, *taskArenas[i], nullptr, 0);
+    }, tasks.size());
+    tasks.clear();
+    primSides.clear();
+
+    // Lay the nodes out in depth-first order, below children first
+    nAllocedNodes = CountNodes(root);
+    nodes = AllocAligned<KDTreeNode>(nAllocedNodes);
+    flattenTree(root);
+    CHECK_EQ(nAllocedNodes, nextFreeNode);
 }
 
 KDTreeAccelerator::~KDTreeAccelerator()
@@ -75,32 +158,44 @@ KDTreeAccelerator::~KDTreeAccelerator()
 }
 
 
-void KDTreeAccelerator::buildTree(int nodeNum, const common::math::Bounds3f &nodeBounds,
-    const std::vector<common::math::Bounds3f> &allPrimBounds,
-    int *primNums, int nPrimitives, int depth,
-    const std::unique_ptr<BoundEdge[]> edges[3],
-    int *prims0, int *prims1, int badRefines)
+void KDTreeAccelerator::buildTree(KDBuildNode *node, const common::math::Bounds3f &nodeBounds,
+    std::vector<BoundEdge> edges[3], int depth, int badRefines,
+    common::tool::MemoryArena &arena, std::vector<KDBuildTask> *tasks, int taskDepth)
 {
-    CHECK_EQ(nodeNum, nextFreeNode);
-    // Get next free node from _nodes_ array
-    if (nextFreeNode == nAllocedNodes)
+    if (nullptr != tasks && depth == taskDepth)
     {
-        int nNewAllocNodes = (std::max)(2 * nAllocedNodes, 512);
-        KDTreeNode *n = AllocAligned<KDTreeNode>(nNewAllocNodes);
-        if (nAllocedNodes > 0)
+        tasks->emplace_back();
+        KDBuildTask &task = tasks->back();
+        task.node = node;
+        task.bounds = nodeBounds;
+        for (int axis = 0; axis < 3; ++axis)
         {
-            memcpy(n, nodes, nAllocedNodes * sizeof(KDTreeNode));
-            FreeAligned(nodes);
+            task.edges[axis].swap(edges[axis]);
         }
-        nodes = n;
-        nAllocedNodes = nNewAllocNodes;
+        task.depth = depth;
+        task.badRefines = badRefines;
+        return;
     }
-    ++nextFreeNode;
 
     // Initialize leaf node if termination criteria met
+    int nPrimitives = static_cast<int>(edges[0].size() / 2);
+    auto initLeaf = [&]()
+    {
+        node->axis = 3;
+        node->nPrimitives = nPrimitives;
+        node->primNums = arena.Alloc<int>(nPrimitives);
+        int n = 0;
+        for (const BoundEdge &edge : edges[0])
+        {
+            if (EdgeType::Start == edge.type)
+            {
+                node->primNums[n++] = edge.primNum;
+            }
+        }
+    };
     if (nPrimitives <= maxPrims || 0 == depth)
     {
-        nodes[nodeNum].InitLeaf(primNums, nPrimitives, &primitiveIndices);
+        initLeaf();
         return;
     }
 
@@ -114,83 +209,54 @@ void KDTreeAccelerator::buildTree(int nodeNum, const common::math::Bounds3f &nod
     Float invTotalSA = FLOAT_1 / totalSA;
     common::math::Vec3f d = nodeBounds.point_max - nodeBounds.point_min;
 
-    // Choose which axis to split along
-    int axis = nodeBounds.MaximumExtent();
-    int retries = 0;
-retrySplit:
-
-    // Initialize edges for _axis_
-    for (int i = 0; i < nPrimitives; ++i)
-    {
-        int pn = primNums[i];
-        const common::math::Bounds3f &bounds = allPrimBounds[pn];
-        edges[axis][2 * i] = BoundEdge(bounds.point_min[axis], pn, true);
-        edges[axis][2 * i + 1] = BoundEdge(bounds.point_max[axis], pn, false);
-    }
-
-    // Sort _edges_ for _axis_
-    std::sort(&edges[axis][0], &edges[axis][2 * nPrimitives],
-        [](const BoundEdge &e0, const BoundEdge &e1) -> bool
-    {
-        if (e0.t == e1.t)
-        {
-            return (int)e0.type < (int)e1.type;
-        }
-        else
-        {
-            return e0.t < e1.t;
-        }
-    });
-
-    // Compute cost of all splits for _axis_ to find best
-    int nBelow = 0, nAbove = nPrimitives;
-    for (int i = 0; i < 2 * nPrimitives; ++i)
+    // The edges being sorted already, every axis is swept
+    for (int axis = 0; axis < 3; ++axis)
     {
-        if (EdgeType::End == edges[axis][i].type)
+        // Compute cost of all splits for _axis_ to find best
+        const std::vector<BoundEdge> &axisEdges = edges[axis];
+        int nBelow = 0, nAbove = nPrimitives;
+        for (int i = 0; i < 2 * nPrimitives; ++i)
         {
-            --nAbove;
-        }
-        Float edgeT = edges[axis][i].t;
-        if (edgeT > nodeBounds.point_min[axis] && edgeT < nodeBounds.point_max[axis])
-        {
-            // Compute cost for split at _i_th edge
-
-            // Compute child surface areas for split at _edgeT_
-            int otherAxis0 = (axis + 1) % 3, otherAxis1 = (axis + 2) % 3;
-            Float belowSA = FLOAT_2 * (d[otherAxis0] * d[otherAxis1] +
-                (edgeT - nodeBounds.point_min[axis]) *
-                (d[otherAxis0] + d[otherAxis1]));
-            Float aboveSA = FLOAT_2 * (d[otherAxis0] * d[otherAxis1] +
-                (nodeBounds.point_max[axis] - edgeT) *
-                (d[otherAxis0] + d[otherAxis1]));
-            Float pBelow = belowSA * invTotalSA;
-            Float pAbove = aboveSA * invTotalSA;
-            Float eb = (0 == nAbove || 0 == nBelow) ? emptyBonus : 0;
-            Float cost = traversalCost +
-                isectCost * (FLOAT_1 - eb) * (pBelow * nBelow + pAbove * nAbove);
-
-            // Update best split if this is lowest cost so far
-            if (cost < bestCost)
+            if (EdgeType::End == axisEdges[i].type)
             {
-                bestCost = cost;
-                bestAxis = axis;
-                bestOffset = i;
+                --nAbove;
+            }
+            Float edgeT = axisEdges[i].t;
+            if (edgeT > nodeBounds.point_min[axis] && edgeT < nodeBounds.point_max[axis])
+            {
+                // Compute cost for split at _i_th edge
+
+                // Compute child surface areas for split at _edgeT_
+                int otherAxis0 = (axis + 1) % 3, otherAxis1 = (axis + 2) % 3;
+                Float belowSA = FLOAT_2 * (d[otherAxis0] * d[otherAxis1] +
+                    (edgeT - nodeBounds.point_min[axis]) *
+                    (d[otherAxis0] + d[otherAxis1]));
+                Float aboveSA = FLOAT_2 * (d[otherAxis0] * d[otherAxis1] +
+                    (nodeBounds.point_max[axis] - edgeT) *
+                    (d[otherAxis0] + d[otherAxis1]));
+                Float pBelow = belowSA * invTotalSA;
+                Float pAbove = aboveSA * invTotalSA;
+                Float eb = (0 == nAbove || 0 == nBelow) ? emptyBonus : 0;
+                Float cost = traversalCost +
+                    isectCost * (FLOAT_1 - eb) * (pBelow * nBelow + pAbove * nAbove);
+
+                // Update best split if this is lowest cost so far
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestOffset = i;
+                }
+            }
+            if (EdgeType::Start == axisEdges[i].type)
+            {
+                ++nBelow;
             }
         }
-        if (EdgeType::Start == edges[axis][i].type)
-        {
-            ++nBelow;
-        }
+        CHECK(nBelow == nPrimitives && 0 == nAbove);
     }
-    CHECK(nBelow == nPrimitives && 0 == nAbove);
 
     // Create leaf if no good splits were found
-    if (-1 == bestAxis && retries < 2)
-    {
-        ++retries;
-        axis = (axis + 1) % 3;
-        goto retrySplit;
-    }
     if (bestCost > oldCost)
     {
         ++badRefines;
@@ -198,42 +264,99 @@ retrySplit:
     if ((bestCost > static_cast<Float>(4.0F) * oldCost && nPrimitives < 16) || -1 == bestAxis ||
         3 == badRefines)
     {
-        nodes[nodeNum].InitLeaf(primNums, nPrimitives, &primitiveIndices);
+        initLeaf();
         return;
     }
 
-    // Classify primitives with respect to split
+    // Classify primitives with respect to split: those starting before the
+    // split edge overlap the space below, those ending after it the space
+    // above
+    std::unique_ptr<uint8_t[]> &sides = primSides[ThreadIndex];
+    if (!sides)
+    {
+        sides.reset(new uint8_t[primitives.size()]);
+    }
+    const std::vector<BoundEdge> &splitEdges = edges[bestAxis];
     int n0 = 0, n1 = 0;
-    for (int i = 0; i < bestOffset; ++i)
+    for (int i = 0; i < 2 * nPrimitives; ++i)
     {
-        if (EdgeType::Start == edges[bestAxis][i].type)
+        const BoundEdge &edge = splitEdges[i];
+        if (EdgeType::Start == edge.type)
+        {
+            sides[edge.primNum] = i < bestOffset ? SIDE_BELOW : 0;
+            n0 += i < bestOffset ? 1 : 0;
+        }
+        else if (i > bestOffset)
         {
-            prims0[n0++] = edges[bestAxis][i].primNum;
+            sides[edge.primNum] |= SIDE_ABOVE;
+            ++n1;
         }
     }
-    for (int i = bestOffset + 1; i < 2 * nPrimitives; ++i)
+
+    // Split the sorted edges of every axis between the children, keeping
+    // them sorted
+    Float tSplit = splitEdges[bestOffset].t;
+    std::vector<BoundEdge> edges0[3], edges1[3];
+    for (int axis = 0; axis < 3; ++axis)
     {
-        if (EdgeType::End == edges[bestAxis][i].type)
+        edges0[axis].reserve(2 * n0);
+        edges1[axis].reserve(2 * n1);
+        for (const BoundEdge &edge : edges[axis])
         {
-            prims1[n1++] = edges[bestAxis][i].primNum;
+            if (sides[edge.primNum] & SIDE_BELOW)
+            {
+                edges0[axis].push_back(edge);
+            }
+            if (sides[edge.primNum] & SIDE_ABOVE)
+            {
+                edges1[axis].push_back(edge);
+            }
         }
+        std::vector<BoundEdge>().swap(edges[axis]);
     }
 
     // Recursively initialize children nodes
-    Float tSplit = edges[bestAxis][bestOffset].t;
     common::math::Bounds3f bounds0 = nodeBounds, bounds1 = nodeBounds;
     bounds0.point_max[bestAxis] = bounds1.point_min[bestAxis] = tSplit;
-    buildTree(nodeNum + 1, bounds0, allPrimBounds, prims0, n0, depth - 1, edges,
-        prims0, prims1 + nPrimitives, badRefines);
-    int aboveChild = nextFreeNode;
-    nodes[nodeNum].InitInterior(bestAxis, aboveChild, tSplit);
-    buildTree(aboveChild, bounds1, allPrimBounds, prims1, n1, depth - 1, edges,
-        prims0, prims1 + nPrimitives, badRefines);
+    node->axis = bestAxis;
+    node->split = tSplit;
+    node->children[0] = arena.Alloc<KDBuildNode>();
+    node->children[1] = arena.Alloc<KDBuildNode>();
+    buildTree(node->children[0], bounds0, edges0, depth - 1, badRefines, arena, tasks, taskDepth);
+    buildTree(node->children[1], bounds1, edges1, depth - 1, badRefines, arena, tasks, taskDepth);
 }
 
-bool KDTreeAccelerator::Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect) const
+void KDTreeAccelerator::flattenTree(const KDBuildNode *node)
 {
-    //ProfilePhase p(Prof::AccelIntersect);
+    int nodeNum = nextFreeNode++;
+    if (3 == node->axis)
+    {
+        nodes[nodeNum].InitLeaf(node->primNums, node->nPrimitives, &primitiveIndices);
+        return;
+    }
+    flattenTree(node->children[0]);
+    nodes[nodeNum].InitInterior(node->axis, nextFreeNode, node->split);
+    flattenTree(node->children[1]);
+}
+
+common::tool::AcceleratorStructureStats KDTreeAccelerator::StructureStats() const
+{
+    common::tool::AcceleratorStructureStats stats;
+    if (primitives.empty())
+    {
+        return stats;
+    }
+    AddNodeStats(nodes, 0, bounds, FLOAT_1 / bounds.SurfaceArea(), &stats);
+    stats.bytes = nAllocedNodes * sizeof(KDTreeNode) + primitiveIndices.size() * sizeof(int) +
+        primitives.size() * sizeof(primitives[0]);
+    return stats;
+}
+
+template <typename Count>
+bool KDTreeAccelerator::Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+    Count &count) const
+{
+    common::tool::ProfilePhase p(common::tool::Prof::AccelIntersect);
     // Compute initial parametric range of ray inside kd-tree extent
     Float t_min, t_max;
     if (!bounds.IntersectP(ray, &t_min, &t_max))
@@ -257,6 +380,7 @@ bool KDTreeAccelerator::Intersect(const common::math::Rayf &ray, core::interacti
         {
             break;
         }
+        count.NodeVisited();
         if (!node->IsLeaf())
         {
             // Process kd-tree interior node
@@ -310,6 +434,7 @@ bool KDTreeAccelerator::Intersect(const common::math::Rayf &ray, core::interacti
                 const std::shared_ptr<core::primitive::Primitive> &p =
                     primitives[node->onePrimitive];
                 // Check one primitive inside leaf node
+                count.PrimitiveTested();
                 if (p->Intersect(ray, isect))
                 {
                     hit = true;
@@ -322,6 +447,7 @@ bool KDTreeAccelerator::Intersect(const common::math::Rayf &ray, core::interacti
                     int index = primitiveIndices[node->primitiveIndicesOffset + i];
                     const std::shared_ptr<core::primitive::Primitive> &p = primitives[index];
                     // Check one primitive inside leaf node
+                    count.PrimitiveTested();
                     if (p->Intersect(ray, isect))
                     {
                         hit = true;
@@ -346,9 +472,16 @@ bool KDTreeAccelerator::Intersect(const common::math::Rayf &ray, core::interacti
     return hit;
 }
 
-bool KDTreeAccelerator::IntersectP(const common::math::Rayf &ray) const
+bool KDTreeAccelerator::Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect) const
+{
+    common::tool::NoTraversalCount count;
+    return Intersect(ray, isect, count);
+}
+
+template <typename Count>
+bool KDTreeAccelerator::IntersectP(const common::math::Rayf &ray, Count &count) const
 {
-    //ProfilePhase p(Prof::AccelIntersectP);
+    common::tool::ProfilePhase p(common::tool::Prof::AccelIntersectP);
     // Compute initial parametric range of ray inside kd-tree extent
     Float t_min, t_max;
     if (!bounds.IntersectP(ray, &t_min, &t_max))
@@ -364,6 +497,7 @@ bool KDTreeAccelerator::IntersectP(const common::math::Rayf &ray) const
     const KDTreeNode *node = &nodes[0];
     while (node != nullptr)
     {
+        count.NodeVisited();
         if (node->IsLeaf())
         {
             // Check for shadow ray intersections inside leaf node
@@ -372,6 +506,7 @@ bool KDTreeAccelerator::IntersectP(const common::math::Rayf &ray) const
             {
                 const std::shared_ptr<core::primitive::Primitive> &p =
                     primitives[node->onePrimitive];
+                count.PrimitiveTested();
                 if (p->IntersectP(ray))
                 {
                     return true;
@@ -384,6 +519,7 @@ bool KDTreeAccelerator::IntersectP(const common::math::Rayf &ray) const
                     int primitiveIndex = primitiveIndices[node->primitiveIndicesOffset + i];
                     const std::shared_ptr<core::primitive::Primitive> &prim =
                         primitives[primitiveIndex];
+                    count.PrimitiveTested();
                     if (prim->IntersectP(ray))
                     {
                         return true;
@@ -452,6 +588,17 @@ bool KDTreeAccelerator::IntersectP(const common::math::Rayf &ray) const
     return false;
 }
 
+bool KDTreeAccelerator::IntersectP(const common::math::Rayf &ray) const
+{
+    common::tool::NoTraversalCount count;
+    return IntersectP(ray, count);
+}
+
+
+// The counting traversals, for callers that measure the work per ray
+template bool KDTreeAccelerator::Intersect(const common::math::Rayf &ray,
+    core::interaction::SurfaceInteraction *isect, common::tool::CountTraversal &count) const;
+template bool KDTreeAccelerator::IntersectP(const common::math::Rayf &ray, common::tool::CountTraversal &count) const;
 
 }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../../core/primitive/Aggregate.h"
+#include "../AcceleratorStats.h"
 #include "BoundEdge.h"
 #include "KDTreeNode.h"
 #include "../../math/Bounds3.h"
@@ -14,6 +15,10 @@ namespace kdtree
 {
 
 
+struct KDBuildNode;
+struct KDBuildTask;
+
+
 class KDTreeAccelerator : public core::primitive::Aggregate
 {
 public:
@@ -38,13 +43,26 @@ public:
 
     bool IntersectP(const common::math::Rayf &ray) const;
 
+    // The traversals behind the two above, adding their work to _count_;
+    // instantiated for NoTraversalCount and CountTraversal
+    template <typename Count>
+    bool Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect, Count &count) const;
+
+    template <typename Count>
+    bool IntersectP(const common::math::Rayf &ray, Count &count) const;
+
+    common::tool::AcceleratorStructureStats StructureStats() const;
+
 private:
 
-    void buildTree(int nodeNum, const common::math::Bounds3f &bounds,
-        const std::vector<common::math::Bounds3f> &primBounds, int *primNums,
-        int nprims, int depth,
-        const std::unique_ptr<BoundEdge[]> edges[3], int *prims0,
-        int *prims1, int badRefines = 0);
+    // Builds the subtree under _node_ from the edges of its primitives,
+    // presorted on every axis. With _tasks_ given, subtrees at _taskDepth_
+    // are queued there instead of being built.
+    void buildTree(KDBuildNode *node, const common::math::Bounds3f &nodeBounds,
+        std::vector<BoundEdge> edges[3], int depth, int badRefines,
+        common::tool::MemoryArena &arena, std::vector<KDBuildTask> *tasks, int taskDepth);
+
+    void flattenTree(const KDBuildNode *node);
 
 
     const int isectCost, traversalCost, maxPrims;
@@ -59,6 +77,9 @@ private:
 
     int nAllocedNodes, nextFreeNode;
 
+    // Per thread primitive classification scratch, during the build only
+    std::vector<std::unique_ptr<uint8_t[]>> primSides;
+
     common::math::Bounds3f bounds;
 };
 
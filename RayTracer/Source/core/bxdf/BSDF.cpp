@@ -1,4 +1,15 @@
 #include "BSDF.h"
+#include "FourierBSDF.h"
+#include "FresnelBlend.h"
+#include "FresnelSpecular.h"
+#include "LambertianReflection.h"
+#include "LambertianTransmission.h"
+#include "MicrofacetReflection.h"
+#include "MicrofacetTransmission.h"
+#include "OrenNayar.h"
+#include "SpecularReflection.h"
+#include "SpecularTransmission.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -6,10 +17,217 @@ namespace bxdf
 {
 
 
+// The concrete classes are final, so each case is a direct call and the
+// ones defined in their headers inline
+template <typename F>
+inline
+auto BSDF::Dispatch(const Component &c, F &&fn) -> decltype(fn(c.bxdf))
+{
+    switch (c.kind)
+    {
+    case BxDFKind::LambertianReflection:
+        return fn(static_cast<const LambertianReflection *>(c.bxdf));
+    case BxDFKind::LambertianTransmission:
+        return fn(static_cast<const LambertianTransmission *>(c.bxdf));
+    case BxDFKind::OrenNayar:
+        return fn(static_cast<const OrenNayar *>(c.bxdf));
+    case BxDFKind::MicrofacetReflection:
+        return fn(static_cast<const MicrofacetReflection *>(c.bxdf));
+    case BxDFKind::MicrofacetTransmission:
+        return fn(static_cast<const MicrofacetTransmission *>(c.bxdf));
+    case BxDFKind::SpecularReflection:
+        return fn(static_cast<const SpecularReflection *>(c.bxdf));
+    case BxDFKind::SpecularTransmission:
+        return fn(static_cast<const SpecularTransmission *>(c.bxdf));
+    case BxDFKind::FresnelSpecular:
+        return fn(static_cast<const FresnelSpecular *>(c.bxdf));
+    case BxDFKind::FresnelBlend:
+        return fn(static_cast<const FresnelBlend *>(c.bxdf));
+    case BxDFKind::Fourier:
+        return fn(static_cast<const FourierBSDF *>(c.bxdf));
+    default:
+        return fn(c.bxdf);
+    }
+}
+
+
+// Lobes without a batched form take the directions one at a time
+template <typename T>
+static void AccumulateF(const T *bxdf, const common::math::Vec3f &wo, const DirectionBatch &wi,
+    const bool *active, color::Spectrum *f)
+{
+    for (int i = 0; i < wi.n; ++i)
+    {
+        if (active[i])
+        {
+            f[i] += bxdf->f(wo, wi[i]);
+        }
+    }
+}
+
+static void AccumulateF(const LambertianReflection *bxdf, const common::math::Vec3f &wo,
+    const DirectionBatch &wi, const bool *active, color::Spectrum *f)
+{
+    bxdf->f(wo, wi, active, f);
+}
+
+static void AccumulateF(const MicrofacetReflection *bxdf, const common::math::Vec3f &wo,
+    const DirectionBatch &wi, const bool *active, color::Spectrum *f)
+{
+    bxdf->f(wo, wi, active, f);
+}
+
+// Lobes that cannot estimate their albedo make lobe selection uniform
+template <typename T>
+static Float AlbedoEstimate(const T *, const common::math::Vec3f &)
+{
+    return -FLOAT_1;
+}
+
+static Float AlbedoEstimate(const LambertianReflection *bxdf, const common::math::Vec3f &wo)
+{
+    return bxdf->AlbedoEstimate(wo);
+}
+
+static Float AlbedoEstimate(const LambertianTransmission *bxdf, const common::math::Vec3f &wo)
+{
+    return bxdf->AlbedoEstimate(wo);
+}
+
+static Float AlbedoEstimate(const OrenNayar *bxdf, const common::math::Vec3f &wo)
+{
+    return bxdf->AlbedoEstimate(wo);
+}
+
+static Float AlbedoEstimate(const MicrofacetReflection *bxdf, const common::math::Vec3f &wo)
+{
+    return bxdf->AlbedoEstimate(wo);
+}
+
+static Float AlbedoEstimate(const MicrofacetTransmission *bxdf, const common::math::Vec3f &wo)
+{
+    return bxdf->AlbedoEstimate(wo);
+}
+
+// Every lobe keeps some chance of being sampled, so sampling stays
+// unbiased wherever an estimate is off
+static const Float MIN_SELECTION_ALBEDO = static_cast<Float>(0.02F);
+
+template <typename T>
+static void AccumulatePdf(const T *bxdf, const common::math::Vec3f &wo, const DirectionBatch &wi, Float *pdf)
+{
+    for (int i = 0; i < wi.n; ++i)
+    {
+        pdf[i] += bxdf->Pdf(wo, wi[i]);
+    }
+}
+
+static void AccumulatePdf(const LambertianReflection *bxdf, const common::math::Vec3f &wo,
+    const DirectionBatch &wi, Float *pdf)
+{
+    bxdf->Pdf(wo, wi, pdf);
+}
+
+static void AccumulatePdf(const MicrofacetReflection *bxdf, const common::math::Vec3f &wo,
+    const DirectionBatch &wi, Float *pdf)
+{
+    bxdf->Pdf(wo, wi, pdf);
+}
+
+
+// Lobes without values at given wavelengths read the bins of their dense
+// ones
+template <typename T>
+static color::HeroSpectrum HeroF(const T *bxdf, const common::math::Vec3f &wo, const common::math::Vec3f &wi,
+    const color::SampledWavelengths &lambda)
+{
+    return color::HeroSpectrum::FromSpectrum(bxdf->f(wo, wi), lambda);
+}
+
+static color::HeroSpectrum HeroF(const LambertianReflection *bxdf, const common::math::Vec3f &wo,
+    const common::math::Vec3f &wi, const color::SampledWavelengths &lambda)
+{
+    return bxdf->f(wo, wi, lambda);
+}
+
+static color::HeroSpectrum HeroF(const MicrofacetReflection *bxdf, const common::math::Vec3f &wo,
+    const common::math::Vec3f &wi, const color::SampledWavelengths &lambda)
+{
+    return bxdf->f(wo, wi, lambda);
+}
+
+template <typename T>
+static color::HeroSpectrum HeroSample_f(const T *bxdf, const common::math::Vec3f &wo, common::math::Vec3f *wi,
+    const common::math::Vec2f &u, Float *pdf, color::SampledWavelengths &lambda, BxDFType *sampledType)
+{
+    return color::HeroSpectrum::FromSpectrum(bxdf->Sample_f(wo, wi, u, pdf, sampledType), lambda);
+}
+
+static color::HeroSpectrum HeroSample_f(const LambertianReflection *bxdf, const common::math::Vec3f &wo,
+    common::math::Vec3f *wi, const common::math::Vec2f &u, Float *pdf, color::SampledWavelengths &lambda,
+    BxDFType *sampledType)
+{
+    return bxdf->Sample_f(wo, wi, u, pdf, lambda, sampledType);
+}
+
+static color::HeroSpectrum HeroSample_f(const MicrofacetReflection *bxdf, const common::math::Vec3f &wo,
+    common::math::Vec3f *wi, const common::math::Vec2f &u, Float *pdf, color::SampledWavelengths &lambda,
+    BxDFType *sampledType)
+{
+    return bxdf->Sample_f(wo, wi, u, pdf, lambda, sampledType);
+}
+
+static color::HeroSpectrum HeroSample_f(const SpecularTransmission *bxdf, const common::math::Vec3f &wo,
+    common::math::Vec3f *wi, const common::math::Vec2f &u, Float *pdf, color::SampledWavelengths &lambda,
+    BxDFType *sampledType)
+{
+    return bxdf->Sample_f(wo, wi, u, pdf, lambda, sampledType);
+}
+
+// The lobe calls of BSDF::SampleLobes() for the spectrum it returns
+template <typename S>
+struct LobeCalls;
+
+template <>
+struct LobeCalls<color::Spectrum>
+{
+    template <typename T>
+    static color::Spectrum f(const T *bxdf, const common::math::Vec3f &wo, const common::math::Vec3f &wi,
+        color::SampledWavelengths *)
+    {
+        return bxdf->f(wo, wi);
+    }
+
+    template <typename T>
+    static color::Spectrum Sample_f(const T *bxdf, const common::math::Vec3f &wo, common::math::Vec3f *wi,
+        const common::math::Vec2f &u, Float *pdf, color::SampledWavelengths *, BxDFType *sampledType)
+    {
+        return bxdf->Sample_f(wo, wi, u, pdf, sampledType);
+    }
+};
+
+template <>
+struct LobeCalls<color::HeroSpectrum>
+{
+    template <typename T>
+    static color::HeroSpectrum f(const T *bxdf, const common::math::Vec3f &wo, const common::math::Vec3f &wi,
+        color::SampledWavelengths *lambda)
+    {
+        return HeroF(bxdf, wo, wi, *lambda);
+    }
+
+    template <typename T>
+    static color::HeroSpectrum Sample_f(const T *bxdf, const common::math::Vec3f &wo, common::math::Vec3f *wi,
+        const common::math::Vec2f &u, Float *pdf, color::SampledWavelengths *lambda, BxDFType *sampledType)
+    {
+        return HeroSample_f(bxdf, wo, wi, u, pdf, *lambda, sampledType);
+    }
+};
+
 color::Spectrum BSDF::f(const common::math::Vec3f &woW, const common::math::Vec3f &wiW,
     BxDFType flags) const
 {
-    //ProfilePhase pp(Prof::BSDFEvaluation);
+    common::tool::ProfilePhase pp(common::tool::Prof::BSDFEvaluation);
     common::math::Vec3f wi = WorldToLocal(wiW), wo = WorldToLocal(woW);
     if (FLOAT_0 == wo.z)
     {
@@ -19,25 +237,100 @@ color::Spectrum BSDF::f(const common::math::Vec3f &woW, const common::math::Vec3
     color::Spectrum f(FLOAT_0);
     for (int i = 0; i < nBxDFs; ++i)
     {
-        if (bxdfs[i]->MatchesFlags(flags) &&
-            ((reflect && (bxdfs[i]->type & BSDF_REFLECTION)) ||
-            (!reflect && (bxdfs[i]->type & BSDF_TRANSMISSION))))
+        const Component &c = components[i];
+        if (c.MatchesFlags(flags) &&
+            ((reflect && (c.type & BSDF_REFLECTION)) ||
+            (!reflect && (c.type & BSDF_TRANSMISSION))))
+        {
+            f += Dispatch(c, [&](auto bxdf)
+            {
+                return bxdf->f(wo, wi);
+            });
+        }
+    }
+    return f;
+}
+
+color::HeroSpectrum BSDF::f(const common::math::Vec3f &woW, const common::math::Vec3f &wiW,
+    const color::SampledWavelengths &lambda, BxDFType flags) const
+{
+    common::tool::ProfilePhase pp(common::tool::Prof::BSDFEvaluation);
+    common::math::Vec3f wi = WorldToLocal(wiW), wo = WorldToLocal(woW);
+    if (FLOAT_0 == wo.z)
+    {
+        return FLOAT_0;
+    }
+    bool reflect = Dot(wiW, ng) * Dot(woW, ng) > FLOAT_0;
+    color::HeroSpectrum f(FLOAT_0);
+    for (int i = 0; i < nBxDFs; ++i)
+    {
+        const Component &c = components[i];
+        if (c.MatchesFlags(flags) &&
+            ((reflect && (c.type & BSDF_REFLECTION)) ||
+            (!reflect && (c.type & BSDF_TRANSMISSION))))
         {
-            f += bxdfs[i]->f(wo, wi);
+            f += Dispatch(c, [&](auto bxdf)
+            {
+                return HeroF(bxdf, wo, wi, lambda);
+            });
         }
     }
     return f;
 }
 
+void BSDF::f(const common::math::Vec3f &woW, int n, const common::math::Vec3f *wiW,
+    color::Spectrum *f, BxDFType flags) const
+{
+    common::tool::ProfilePhase pp(common::tool::Prof::BSDFEvaluation);
+    common::math::Vec3f wo = WorldToLocal(woW);
+    Float woDotNg = Dot(woW, ng);
+    DirectionBatch wi;
+    bool all[DirectionBatch::MAX_SIZE], reflect[DirectionBatch::MAX_SIZE], transmit[DirectionBatch::MAX_SIZE];
+    for (int start = 0; start < n; start += DirectionBatch::MAX_SIZE)
+    {
+        wi.n = (std::min)(DirectionBatch::MAX_SIZE, n - start);
+        for (int i = 0; i < wi.n; ++i)
+        {
+            f[start + i] = color::Spectrum(FLOAT_0);
+            wi.Set(i, WorldToLocal(wiW[start + i]));
+            all[i] = true;
+            reflect[i] = Dot(wiW[start + i], ng) * woDotNg > FLOAT_0;
+            transmit[i] = !reflect[i];
+        }
+        if (FLOAT_0 == wo.z)
+        {
+            continue;
+        }
+        for (int j = 0; j < nBxDFs; ++j)
+        {
+            const Component &c = components[j];
+            if (!c.MatchesFlags(flags))
+            {
+                continue;
+            }
+            // A lobe contributes on the side(s) of the geometric normal it scatters to
+            const bool *active = (c.type & BSDF_REFLECTION) ?
+                ((c.type & BSDF_TRANSMISSION) ? all : reflect) : transmit;
+            Dispatch(c, [&](auto bxdf)
+            {
+                AccumulateF(bxdf, wo, wi, active, f + start);
+            });
+        }
+    }
+}
+
 color::Spectrum BSDF::rho(int nSamples, const common::math::Vec2f *samples1,
     const common::math::Vec2f *samples2, BxDFType flags) const
 {
     color::Spectrum ret(0.f);
     for (int i = 0; i < nBxDFs; ++i)
     {
-        if (bxdfs[i]->MatchesFlags(flags))
+        if (components[i].MatchesFlags(flags))
         {
-            ret += bxdfs[i]->rho(nSamples, samples1, samples2);
+            ret += Dispatch(components[i], [&](auto bxdf)
+            {
+                return bxdf->rho(nSamples, samples1, samples2);
+            });
         }
     }
 
@@ -50,62 +343,114 @@ color::Spectrum BSDF::rho(const common::math::Vec3f &wo, int nSamples, const com
     color::Spectrum ret(FLOAT_0);
     for (int i = 0; i < nBxDFs; ++i)
     {
-        if (bxdfs[i]->MatchesFlags(flags))
+        if (components[i].MatchesFlags(flags))
         {
-            ret += bxdfs[i]->rho(wo, nSamples, samples);
+            ret += Dispatch(components[i], [&](auto bxdf)
+            {
+                return bxdf->rho(wo, nSamples, samples);
+            });
         }
     }
 
     return ret;
 }
 
-color::Spectrum BSDF::Sample_f(const common::math::Vec3f &woWorld, common::math::Vec3f *wiWorld,
-    const common::math::Vec2f &u, Float *pdf, BxDFType type,
-    BxDFType *sampledType) const
+int BSDF::MatchingComponents(BxDFType flags, int *matching) const
 {
-    //ProfilePhase pp(Prof::BSDFSampling);
-    // Choose which _BxDF_ to sample
-    int matchingComps = NumComponents(type);
-    if (0 == matchingComps)
+    int nMatching = 0;
+    for (int i = 0; i < nBxDFs; ++i)
     {
-        *pdf = FLOAT_0;
-        if (sampledType) *sampledType = BxDFType(0);
-        return color::Spectrum(FLOAT_0);
+        if (components[i].MatchesFlags(flags))
+        {
+            matching[nMatching++] = i;
+        }
     }
-    int comp = (std::min)((int)std::floor(u[0] * matchingComps), matchingComps - 1);
+    return nMatching;
+}
 
-    // Get _BxDF_ pointer for chosen component
-    BxDF *_bxdf = nullptr;
-    int count = comp;
-    for (int i = 0; i < nBxDFs; ++i)
+void BSDF::SelectionProbabilities(const common::math::Vec3f &wo, const int *matching, int nMatching,
+    Float *probabilities) const
+{
+    Float sum = FLOAT_0;
+    for (int j = 0; j < nMatching; ++j)
     {
-        if (bxdfs[i]->MatchesFlags(type) && 0 == count--)
+        Float albedo = Dispatch(components[matching[j]], [&](auto bxdf)
+        {
+            return AlbedoEstimate(bxdf, wo);
+        });
+        if (albedo < FLOAT_0)
         {
-            _bxdf = bxdfs[i];
+            sum = FLOAT_0;
             break;
         }
+        probabilities[j] = (std::max)(albedo, MIN_SELECTION_ALBEDO);
+        sum += probabilities[j];
+    }
+
+    if (FLOAT_0 == sum)
+    {
+        for (int j = 0; j < nMatching; ++j)
+        {
+            probabilities[j] = FLOAT_1 / nMatching;
+        }
+        return;
+    }
+    for (int j = 0; j < nMatching; ++j)
+    {
+        probabilities[j] /= sum;
+    }
+}
+
+template <typename S>
+S BSDF::SampleLobes(const common::math::Vec3f &woWorld, common::math::Vec3f *wiWorld,
+    const common::math::Vec2f &u, Float *pdf, BxDFType type,
+    BxDFType *sampledType, color::SampledWavelengths *lambda) const
+{
+    common::tool::ProfilePhase pp(common::tool::Prof::BSDFSampling);
+    // Choose which _BxDF_ to sample, collecting the matching ones in a
+    // single pass
+    int matching[MaxBxDFs];
+    int matchingComps = MatchingComponents(type, matching);
+    if (0 == matchingComps)
+    {
+        *pdf = FLOAT_0;
+        if (sampledType) *sampledType = BxDFType(0);
+        return S(FLOAT_0);
+    }
+    common::math::Vec3f wi, wo = WorldToLocal(woWorld);
+    if (FLOAT_0 == wo.z)
+    {
+        return S(FLOAT_0);
+    }
+    Float probabilities[MaxBxDFs];
+    SelectionProbabilities(wo, matching, matchingComps, probabilities);
+    int comp = 0;
+    Float cdf = FLOAT_0;
+    while (comp < matchingComps - 1 && u[0] >= cdf + probabilities[comp])
+    {
+        cdf += probabilities[comp++];
     }
-    CHECK(nullptr != _bxdf);
+
+    const Component &chosen = components[matching[comp]];
     /*
     VLOG(2) << "BSDF::Sample_f chose comp = " << comp << " / matching = " <<
-        matchingComps << ", _bxdf: " << _bxdf->ToString();
+        matchingComps << ", _bxdf: " << chosen.bxdf->ToString();
     */
 
     // Remap _BxDF_ sample _u_ to $[0,1)^2$
-    common::math::Vec2f uRemapped((std::min)(u[0] * matchingComps - comp, common::math::ONE_MINUS_MACHINE_EPSILON), u[1]);
+    common::math::Vec2f uRemapped(common::math::Clamp((u[0] - cdf) / probabilities[comp], FLOAT_0,
+        common::math::ONE_MINUS_MACHINE_EPSILON), u[1]);
 
     // Sample chosen _BxDF_
-    common::math::Vec3f wi, wo = WorldToLocal(woWorld);
-    if (FLOAT_0 == wo.z)
-    {
-        return color::Spectrum(FLOAT_0);;
-    }
     *pdf = FLOAT_0;
     if (sampledType)
     {
-        *sampledType = _bxdf->type;
+        *sampledType = chosen.type;
     }
-    color::Spectrum f = _bxdf->Sample_f(wo, &wi, uRemapped, pdf, sampledType);
+    S f = Dispatch(chosen, [&](auto bxdf)
+    {
+        return LobeCalls<S>::Sample_f(bxdf, wo, &wi, uRemapped, pdf, lambda, sampledType);
+    });
     /*
     VLOG(2) << "For wo = " << wo << ", sampled f = " << f << ", pdf = "
         << *pdf << ", ratio = " << ((*pdf > 0) ? (f / *pdf) : color::Spectrum(0.))
@@ -117,38 +462,41 @@ color::Spectrum BSDF::Sample_f(const common::math::Vec3f &woWorld, common::math:
         {
             *sampledType = BxDFType(0);
         }
-        return color::Spectrum(FLOAT_0);;
+        return S(FLOAT_0);
     }
     *wiWorld = LocalToWorld(wi);
 
     // Compute overall PDF with all matching _BxDF_s
-    if (!(_bxdf->type & BSDF_SPECULAR) && matchingComps > 1)
+    *pdf *= probabilities[comp];
+    if (!(chosen.type & BSDF_SPECULAR) && matchingComps > 1)
     {
-        for (int i = 0; i < nBxDFs; ++i)
+        for (int j = 0; j < matchingComps; ++j)
         {
-            if (bxdfs[i] != _bxdf && bxdfs[i]->MatchesFlags(type))
+            if (j != comp)
             {
-                *pdf += bxdfs[i]->Pdf(wo, wi);
+                *pdf += probabilities[j] * Dispatch(components[matching[j]], [&](auto bxdf)
+                {
+                    return bxdf->Pdf(wo, wi);
+                });
             }
         }
     }
-    if (matchingComps > 1)
-    {
-        *pdf /= matchingComps;
-    }
 
     // Compute value of BSDF for sampled direction
-    if (!(_bxdf->type & BSDF_SPECULAR))
+    if (!(chosen.type & BSDF_SPECULAR))
     {
         bool reflect = Dot(*wiWorld, ng) * Dot(woWorld, ng) > 0;
         f = FLOAT_0;
-        for (int i = 0; i < nBxDFs; ++i)
+        for (int j = 0; j < matchingComps; ++j)
         {
-            if (bxdfs[i]->MatchesFlags(type) &&
-                ((reflect && (bxdfs[i]->type & BSDF_REFLECTION)) ||
-                (!reflect && (bxdfs[i]->type & BSDF_TRANSMISSION))))
+            const Component &c = components[matching[j]];
+            if ((reflect && (c.type & BSDF_REFLECTION)) ||
+                (!reflect && (c.type & BSDF_TRANSMISSION)))
             {
-                f += bxdfs[i]->f(wo, wi);
+                f += Dispatch(c, [&](auto bxdf)
+                {
+                    return LobeCalls<S>::f(bxdf, wo, wi, lambda);
+                });
             }
         }
     }
@@ -159,11 +507,25 @@ color::Spectrum BSDF::Sample_f(const common::math::Vec3f &woWorld, common::math:
     return f;
 }
 
+color::Spectrum BSDF::Sample_f(const common::math::Vec3f &woWorld, common::math::Vec3f *wiWorld,
+    const common::math::Vec2f &u, Float *pdf, BxDFType type,
+    BxDFType *sampledType) const
+{
+    return SampleLobes<color::Spectrum>(woWorld, wiWorld, u, pdf, type, sampledType, nullptr);
+}
+
+color::HeroSpectrum BSDF::Sample_f(const common::math::Vec3f &woWorld, common::math::Vec3f *wiWorld,
+    const common::math::Vec2f &u, Float *pdf, color::SampledWavelengths &lambda, BxDFType type,
+    BxDFType *sampledType) const
+{
+    return SampleLobes<color::HeroSpectrum>(woWorld, wiWorld, u, pdf, type, sampledType, &lambda);
+}
+
 Float BSDF::Pdf(const common::math::Vec3f &woWorld, const common::math::Vec3f &wiWorld,
     BxDFType flags) const
 {
-    //ProfilePhase pp(Prof::BSDFPdf);
-    if (FLOAT_0 == nBxDFs)
+    common::tool::ProfilePhase pp(common::tool::Prof::BSDFPdf);
+    if (0 == nBxDFs)
     {
         return FLOAT_0;
     }
@@ -172,18 +534,60 @@ Float BSDF::Pdf(const common::math::Vec3f &woWorld, const common::math::Vec3f &w
     {
         return FLOAT_0;
     }
+    int matching[MaxBxDFs];
+    Float probabilities[MaxBxDFs];
+    int matchingComps = MatchingComponents(flags, matching);
+    SelectionProbabilities(wo, matching, matchingComps, probabilities);
     Float pdf = FLOAT_0;
-    int matchingComps = 0;
-    for (int i = 0; i < nBxDFs; ++i)
+    for (int j = 0; j < matchingComps; ++j)
     {
-        if (bxdfs[i]->MatchesFlags(flags))
+        pdf += probabilities[j] * Dispatch(components[matching[j]], [&](auto bxdf)
         {
-            ++matchingComps;
-            pdf += bxdfs[i]->Pdf(wo, wi);
+            return bxdf->Pdf(wo, wi);
+        });
+    }
+    return pdf;
+}
+
+void BSDF::Pdf(const common::math::Vec3f &woW, int n, const common::math::Vec3f *wiW,
+    Float *pdf, BxDFType flags) const
+{
+    common::tool::ProfilePhase pp(common::tool::Prof::BSDFPdf);
+    common::math::Vec3f wo = WorldToLocal(woW);
+    int matching[MaxBxDFs];
+    Float probabilities[MaxBxDFs];
+    int matchingComps = MatchingComponents(flags, matching);
+    SelectionProbabilities(wo, matching, matchingComps, probabilities);
+    DirectionBatch wi;
+    Float componentPdf[DirectionBatch::MAX_SIZE];
+    for (int start = 0; start < n; start += DirectionBatch::MAX_SIZE)
+    {
+        wi.n = (std::min)(DirectionBatch::MAX_SIZE, n - start);
+        for (int i = 0; i < wi.n; ++i)
+        {
+            pdf[start + i] = FLOAT_0;
+            wi.Set(i, WorldToLocal(wiW[start + i]));
+        }
+        if (FLOAT_0 == wo.z || 0 == matchingComps)
+        {
+            continue;
+        }
+        for (int j = 0; j < matchingComps; ++j)
+        {
+            for (int i = 0; i < wi.n; ++i)
+            {
+                componentPdf[i] = FLOAT_0;
+            }
+            Dispatch(components[matching[j]], [&](auto bxdf)
+            {
+                AccumulatePdf(bxdf, wo, wi, componentPdf);
+            });
+            for (int i = 0; i < wi.n; ++i)
+            {
+                pdf[start + i] += probabilities[j] * componentPdf[i];
+            }
         }
     }
-    Float v = matchingComps > 0 ? pdf / matchingComps : FLOAT_0;
-    return v;
 }
 
 
@@ -1,7 +1,14 @@
 #pragma once
 
 #include "BxDF.h"
+#include "../color/HeroSpectrum.h"
 #include "../interaction/SurfaceInteraction.h"
+#include "../../common/tool/MemoryArena.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
 
 namespace core
 {
@@ -28,10 +35,26 @@ public:
     {}
 
 
-    void Add(BxDF *b)
+    // Constructs one of the closed set of BxDFs (those with a KIND other
+    // than Generic) inside the BSDF itself, falling back to _arena_ once
+    // that storage is full. The BSDF then calls it without the vtable.
+    template <typename T, typename... Args>
+    T *Add(common::tool::MemoryArena &arena, Args &&... args)
     {
-        CHECK_LT(nBxDFs, MaxBxDFs);
-        bxdfs[nBxDFs++] = b;
+        void *mem = InlineAlloc(sizeof(T), alignof(T));
+        if (nullptr == mem)
+        {
+            mem = arena.Alloc(sizeof(T));
+        }
+        T *b = new (mem) T(std::forward<Args>(args)...);
+        AddComponent(b, T::KIND);
+        return b;
+    }
+
+    // Any other BxDF, called through the vtable
+    void Add(const BxDF *b)
+    {
+        AddComponent(b, BxDFKind::Generic);
     }
 
     int NumComponents(BxDFType flags = BSDF_ALL) const;
@@ -65,17 +88,94 @@ public:
     Float Pdf(const common::math::Vec3f &wo, const common::math::Vec3f &wi,
         BxDFType flags = BSDF_ALL) const;
 
+    // f() and Sample_f() at the wavelengths of _lambda_ for hero-wavelength
+    // rendering; a lobe whose sampled direction depends on the wavelength
+    // may terminate the secondary ones
+    color::HeroSpectrum f(const common::math::Vec3f &woW, const common::math::Vec3f &wiW,
+        const color::SampledWavelengths &lambda, BxDFType flags = BSDF_ALL) const;
+
+    color::HeroSpectrum Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi, const common::math::Vec2f &u,
+        Float *pdf, color::SampledWavelengths &lambda, BxDFType type = BSDF_ALL,
+        BxDFType *sampledType = nullptr) const;
+
+    // f() and Pdf() for _n_ incident directions sharing _woW_, such as the
+    // samples of one light: the frame change and flag tests run once, and
+    // each lobe evaluates DirectionBatch::MAX_SIZE directions per call
+    void f(const common::math::Vec3f &woW, int n, const common::math::Vec3f *wiW,
+        color::Spectrum *f, BxDFType flags = BSDF_ALL) const;
+
+    void Pdf(const common::math::Vec3f &woW, int n, const common::math::Vec3f *wiW,
+        Float *pdf, BxDFType flags = BSDF_ALL) const;
+
 private:
 
+    // The type is cached next to the pointer so flag tests do not touch
+    // the BxDF itself
+    struct Component
+    {
+        const BxDF *bxdf;
+        BxDFType type;
+        BxDFKind kind;
+
+        bool MatchesFlags(BxDFType t) const
+        {
+            return (type & t) == type;
+        }
+    };
+
+
     ~BSDF()
     {}
 
+    void AddComponent(const BxDF *b, BxDFKind kind)
+    {
+        CHECK_LT(nBxDFs, MaxBxDFs);
+        components[nBxDFs++] = { b, b->type, kind };
+    }
+
+    void *InlineAlloc(size_t size, size_t alignment)
+    {
+        void *mem = inlineStorage + inlineUsed;
+        size_t space = INLINE_BYTES - inlineUsed;
+        if (nullptr == std::align(alignment, size, mem, space))
+        {
+            return nullptr;
+        }
+        inlineUsed = INLINE_BYTES - space + size;
+        return mem;
+    }
+
+    // Indices of the components matching _flags_, returning their number
+    int MatchingComponents(BxDFType flags, int *matching) const;
+
+    // Probability of sampling each of the _nMatching_ components in
+    // _matching_ from _wo_: proportional to their albedo estimates when all
+    // of them have one, uniform otherwise
+    void SelectionProbabilities(const common::math::Vec3f &wo, const int *matching, int nMatching,
+        Float *probabilities) const;
+
+    // Sample_f() returning dense spectra, or values at the wavelengths of
+    // _lambda_ for _HeroSpectrum_
+    template <typename S>
+    S SampleLobes(const common::math::Vec3f &woWorld, common::math::Vec3f *wiWorld, const common::math::Vec2f &u,
+        Float *pdf, BxDFType type, BxDFType *sampledType, color::SampledWavelengths *lambda) const;
+
+    // Calls _fn_ with the component's BxDF cast to its concrete type
+    template <typename F>
+    static auto Dispatch(const Component &c, F &&fn) -> decltype(fn(c.bxdf));
+
 
     const common::math::Vec3f ns, ng;
     const common::math::Vec3f ss, ts;
     int nBxDFs = 0;
     static constexpr int MaxBxDFs = 8;
-    BxDF *bxdfs[MaxBxDFs];
+    Component components[MaxBxDFs];
+    // Room for one lobe holding a Spectrum and a few pointers: all of a
+    // matte surface, the first lobe of the others. Further lobes come from
+    // the arena, which places them right after the BSDF anyway.
+    static constexpr size_t INLINE_BYTES = sizeof(color::Spectrum) + 8 * sizeof(void *);
+    size_t inlineUsed = 0;
+    alignas(std::max_align_t) uint8_t inlineStorage[INLINE_BYTES];
     friend class core::material::MixMaterial;
 };
 
@@ -86,7 +186,7 @@ int BSDF::NumComponents(BxDFType flags) const
     int num = 0;
     for (int i = 0; i < nBxDFs; ++i)
     {
-        if (bxdfs[i]->MatchesFlags(flags))
+        if (components[i].MatchesFlags(flags))
         {
             ++num;
         }
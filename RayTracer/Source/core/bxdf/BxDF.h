@@ -5,6 +5,7 @@
 #include "../../common/math/Vec3.h"
 #include "../../common/math/Constants.h"
 #include "../color/Spectrum.h"
+#include <cstdint>
 
 namespace core
 {
@@ -22,12 +23,57 @@ enum BxDFType
     BSDF_ALL = BSDF_DIFFUSE | BSDF_GLOSSY | BSDF_SPECULAR | BSDF_REFLECTION | BSDF_TRANSMISSION,
 };
 
+// The BxDFs materials build, which BSDF calls without going through the
+// vtable. Every other BxDF is Generic and stays a virtual call.
+enum class BxDFKind : uint8_t
+{
+    Generic,
+    LambertianReflection,
+    LambertianTransmission,
+    OrenNayar,
+    MicrofacetReflection,
+    MicrofacetTransmission,
+    SpecularReflection,
+    SpecularTransmission,
+    FresnelSpecular,
+    FresnelBlend,
+    Fourier
+};
+
+// Directions in the shading frame stored one component per array, so the
+// loops that evaluate a lobe for many of them at once vectorize
+struct DirectionBatch
+{
+    static constexpr int MAX_SIZE = 32;
+
+    int n = 0;
+    alignas(32) Float x[MAX_SIZE];
+    alignas(32) Float y[MAX_SIZE];
+    alignas(32) Float z[MAX_SIZE];
+
+
+    common::math::Vec3f operator[](int i) const
+    {
+        return common::math::Vec3f(x[i], y[i], z[i]);
+    }
+
+    void Set(int i, const common::math::Vec3f &w)
+    {
+        x[i] = w.x;
+        y[i] = w.y;
+        z[i] = w.z;
+    }
+};
+
+
 class BxDF
 {
 public:
 
     const BxDFType type;
 
+    static constexpr BxDFKind KIND = BxDFKind::Generic;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
@@ -1,5 +1,6 @@
 #include "FourierBSDF.h"
 #include "Interpolation.h"
+#include "../color/SpectrumLane.h"
 
 namespace core
 {
@@ -7,11 +8,164 @@ namespace bxdf
 {
 
 
+std::map<std::string, std::unique_ptr<FourierBSDFTable>> FourierBSDFTable::tables;
+std::mutex FourierBSDFTable::tablesMutex;
+
+
+// _count_ floats of the file as Floats: in place, or copied to the end of
+// _storage_ (reserved by the caller) when Float is double
+static const Float *FileFloats(const uint8_t *data, size_t count, std::vector<Float> *storage)
+{
+#ifdef FLOAT_AS_DOUBLE
+    const float *values = reinterpret_cast<const float *>(data);
+    size_t start = storage->size();
+    storage->insert(storage->end(), values, values + count);
+    return storage->data() + start;
+#else
+    return reinterpret_cast<const Float *>(data);
+#endif
+}
+
+std::unique_ptr<FourierBSDFTable> FourierBSDFTable::Read(const std::string &filename)
+{
+    std::shared_ptr<const common::tool::MappedFile> file = common::tool::MappedFile::Open(filename);
+    if (!file || file->Size() < sizeof(FourierBSDFFileHeader))
+    {
+        return nullptr;
+    }
+    FourierBSDFFileHeader header;
+    memcpy(&header, file->Data(), sizeof(FourierBSDFFileHeader));
+    if (!header.IsValid())
+    {
+        return nullptr;
+    }
+
+    // Every array is 32 bit and follows the header back to back
+    const size_t nMu2 = static_cast<size_t>(header.nMu) * header.nMu;
+    const size_t muOffset = sizeof(FourierBSDFFileHeader);
+    const size_t cdfOffset = muOffset + header.nMu * sizeof(float);
+    const size_t pairsOffset = cdfOffset + nMu2 * sizeof(float);
+    const size_t coefficientsOffset = pairsOffset + 2 * nMu2 * sizeof(int32_t);
+    if (file->Size() < coefficientsOffset + header.nCoeffs * sizeof(float))
+    {
+        return nullptr;
+    }
+    const uint8_t *data = file->Data();
+    const int32_t *pairs = reinterpret_cast<const int32_t *>(data + pairsOffset);
+
+    // Check every series once here so that lookups never leave the mapping
+    for (size_t i = 0; i < nMu2; ++i)
+    {
+        int32_t offset = pairs[2 * i], length = pairs[2 * i + 1];
+        if (offset < 0 || length < 0 || length > header.mMax
+            || static_cast<int64_t>(offset) + static_cast<int64_t>(length) * header.nChannels > header.nCoeffs)
+        {
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<FourierBSDFTable> table(new FourierBSDFTable);
+    table->eta = header.eta;
+    table->mMax = header.mMax;
+    table->nChannels = header.nChannels;
+    table->nMu = header.nMu;
+    table->offsetAndLength = pairs;
+
+    size_t storageSize = nMu2 + header.mMax;
+#ifdef FLOAT_AS_DOUBLE
+    storageSize += header.nMu + nMu2 + header.nCoeffs;
+#endif
+    table->storage.reserve(storageSize);
+    table->mu = FileFloats(data + muOffset, header.nMu, &table->storage);
+    table->cdf = FileFloats(data + cdfOffset, nMu2, &table->storage);
+    table->a = FileFloats(data + coefficientsOffset, header.nCoeffs, &table->storage);
+
+    size_t a0Start = table->storage.size();
+    for (size_t i = 0; i < nMu2; ++i)
+    {
+        table->storage.push_back(pairs[2 * i + 1] > 0 ? table->a[pairs[2 * i]] : FLOAT_0);
+    }
+    size_t recipStart = table->storage.size();
+    for (int i = 0; i < header.mMax; ++i)
+    {
+        table->storage.push_back(FLOAT_1 / static_cast<Float>(i));
+    }
+    table->a0 = table->storage.data() + a0Start;
+    table->recip = table->storage.data() + recipStart;
+
+    table->file = std::move(file);
+    return table;
+}
+
+const FourierBSDFTable *FourierBSDFTable::Get(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    auto found = tables.find(filename);
+    if (tables.end() == found)
+    {
+        found = tables.emplace(filename, Read(filename)).first;
+        /* TODO
+        if (!found->second)
+        {
+            Error("Unable to read tabulated BSDF file \"%s\"", filename.c_str());
+        }
+        */
+    }
+    return found->second.get();
+}
+
+void FourierBSDFTable::ClearCache()
+{
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    tables.clear();
+}
+
+
 bool FourierBSDFTable::GetWeightsAndOffset(Float cosTheta, int *offset, Float weights[4]) const
 {
     return CatmullRomWeights(nMu, mu, cosTheta, offset, weights);
 }
 
+int FourierBSDFTable::AccumulateAk(int offsetI, int offsetO, const Float weightsI[4], const Float weightsO[4],
+    int channels, Float *ak) const
+{
+    typedef core::color::SpectrumLaneFor<8>::Type Lane;
+
+    int maxOrder = 0;
+    for (int b = 0; b < 4; ++b)
+    {
+        for (int a = 0; a < 4; ++a)
+        {
+            // Add contribution of _(a, b)_ to $a_k$ values
+            Float weight = weightsI[a] * weightsO[b];
+            if (FLOAT_0 == weight)
+            {
+                continue;
+            }
+            int m;
+            const Float *ap = GetAk(offsetI + a, offsetO + b, &m);
+            maxOrder = (std::max)(maxOrder, m);
+
+            Lane laneWeight = Lane::Set(weight);
+            for (int c = 0; c < channels; ++c)
+            {
+                Float *dst = ak + c * mMax;
+                const Float *src = ap + c * m;
+                int k = 0;
+                for (; k + Lane::WIDTH <= m; k += Lane::WIDTH)
+                {
+                    (Lane::Load(dst + k) + laneWeight * Lane::Load(src + k)).Store(dst + k);
+                }
+                for (; k < m; ++k)
+                {
+                    dst[k] += weight * src[k];
+                }
+            }
+        }
+    }
+    return maxOrder;
+}
+
 
 core::color::Spectrum FourierBSDF::f(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const
 {
@@ -35,31 +189,12 @@ core::color::Spectrum FourierBSDF::f(const common::math::Vec3f &wo, const common
     memset(ak, 0, bsdfTable.mMax * bsdfTable.nChannels * sizeof(Float));
 
     // Accumulate weighted sums of nearby $a_k$ coefficients
-    int mMax = 0;
-    for (int b = 0; b < 4; ++b)
-    {
-        for (int a = 0; a < 4; ++a)
-        {
-            // Add contribution of _(a, b)_ to $a_k$ values
-            Float weight = weightsI[a] * weightsO[b];
-            if (weight != FLOAT_0)
-            {
-                int m;
-                const Float *ap = bsdfTable.GetAk(offsetI + a, offsetO + b, &m);
-                mMax = (std::max)(mMax, m);
-                for (int c = 0; c < bsdfTable.nChannels; ++c)
-                {
-                    for (int k = 0; k < m; ++k)
-                    {
-                        ak[c * bsdfTable.mMax + k] += weight * ap[c * m + k];
-                    }
-                }
-            }
-        }
-    }
+    int mMax = bsdfTable.AccumulateAk(offsetI, offsetO, weightsI, weightsO, bsdfTable.nChannels, ak);
 
-    // Evaluate Fourier expansion for angle $\phi$
-    Float Y = (std::max)(FLOAT_0, Fourier(ak, mMax, cosPhi));
+    // Evaluate the Fourier expansions of every channel for angle $\phi$
+    Float values[3];
+    FourierChannels(ak, bsdfTable.mMax, mMax, bsdfTable.nChannels, cosPhi, values);
+    Float Y = (std::max)(FLOAT_0, values[0]);
     Float scale = muI != FLOAT_0 ? (FLOAT_1 / std::abs(muI)) : FLOAT_0;
 
     // Update _scale_ to account for adjoint light transport
@@ -75,8 +210,8 @@ core::color::Spectrum FourierBSDF::f(const common::math::Vec3f &wo, const common
     else
     {
         // Compute and return RGB colors for tabulated BSDF
-        Float R = Fourier(ak + 1 * bsdfTable.mMax, mMax, cosPhi);
-        Float B = Fourier(ak + 2 * bsdfTable.mMax, mMax, cosPhi);
+        Float R = values[1];
+        Float B = values[2];
         Float G = static_cast<Float>(1.39829F) * Y - static_cast<Float>(0.100913F) * B
             - static_cast<Float>(0.297375F) * R;
         Float rgb[3] = {R * scale, G * scale, B * scale};
@@ -111,28 +246,7 @@ core::color::Spectrum FourierBSDF::Sample_f(const common::math::Vec3f &wo, commo
     memset(ak, 0, bsdfTable.mMax * bsdfTable.nChannels * sizeof(Float));
 
     // Accumulate weighted sums of nearby $a_k$ coefficients
-    int mMax = 0;
-    for (int b = 0; b < 4; ++b)
-    {
-        for (int a = 0; a < 4; ++a)
-        {
-            // Add contribution of _(a, b)_ to $a_k$ values
-            Float weight = weightsI[a] * weightsO[b];
-            if (weight != FLOAT_0)
-            {
-                int m;
-                const Float *ap = bsdfTable.GetAk(offsetI + a, offsetO + b, &m);
-                mMax = (std::max)(mMax, m);
-                for (int c = 0; c < bsdfTable.nChannels; ++c)
-                {
-                    for (int k = 0; k < m; ++k)
-                    {
-                        ak[c * bsdfTable.mMax + k] += weight * ap[c * m + k];
-                    }
-                }
-            }
-        }
-    }
+    int mMax = bsdfTable.AccumulateAk(offsetI, offsetO, weightsI, weightsO, bsdfTable.nChannels, ak);
 
     // Importance sample the luminance Fourier expansion
     Float phi, pdfPhi;
@@ -173,8 +287,10 @@ core::color::Spectrum FourierBSDF::Sample_f(const common::math::Vec3f &wo, commo
     {
         return core::color::Spectrum(Y * scale);
     }
-    Float R = Fourier(ak + 1 * bsdfTable.mMax, mMax, cosPhi);
-    Float B = Fourier(ak + 2 * bsdfTable.mMax, mMax, cosPhi);
+    Float values[2];
+    FourierChannels(ak + bsdfTable.mMax, bsdfTable.mMax, mMax, 2, cosPhi, values);
+    Float R = values[0];
+    Float B = values[1];
     Float G = static_cast<Float>(1.39829F) * Y - static_cast<Float>(0.100913F) * B
         - static_cast<Float>(0.297375F) * R;
     Float rgb[3] = {R * scale, G * scale, B * scale};
@@ -197,27 +313,7 @@ Float FourierBSDF::Pdf(const common::math::Vec3f &wo, const common::math::Vec3f
     }
     Float *ak = ALLOCA(Float, bsdfTable.mMax);
     memset(ak, 0, bsdfTable.mMax * sizeof(Float));
-    int mMax = 0;
-    for (int o = 0; o < 4; ++o)
-    {
-        for (int i = 0; i < 4; ++i)
-        {
-            Float weight = weightsI[i] * weightsO[o];
-            if (FLOAT_0 == weight)
-            {
-                continue;
-            }
-
-            int order;
-            const Float *coeffs = bsdfTable.GetAk(offsetI + i, offsetO + o, &order);
-            mMax = (std::max)(mMax, order);
-
-            for (int k = 0; k < order; ++k)
-            {
-                ak[k] += *coeffs++ * weight;
-            }
-        }
-    }
+    int mMax = bsdfTable.AccumulateAk(offsetI, offsetO, weightsI, weightsO, 1, ak);
 
     // Evaluate probability of sampling _wi_
     Float rho = FLOAT_0;
@@ -2,6 +2,14 @@
 
 #include "BxDF.h"
 #include "../material/Material.h"
+#include "../../common/tool/MappedFile.h"
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace core
 {
@@ -9,38 +17,96 @@ namespace bxdf
 {
 
 
+// Layout of the header of pbrt's tabulated .bsdf files, which is followed by
+// mu[nMu], cdf[nMu * nMu], (offset, length) pairs[nMu * nMu] and
+// coefficients[nCoeffs], all 32 bit
+struct FourierBSDFFileHeader
+{
+    char identifier[8];
+    int32_t flags;
+    int32_t nMu;
+    int32_t nCoeffs;
+    int32_t mMax;
+    int32_t nChannels;
+    int32_t nBases;
+    int32_t unused0[3];
+    float eta;
+    int32_t unused1[4];
+
+
+    // Only monochromatic and RGB files with a single basis are supported
+    bool IsValid() const
+    {
+        return 0 == memcmp(identifier, "SCATFUN\x01", 8) && 1 == flags && nMu >= 2 && nCoeffs > 0
+            && mMax > 0 && (1 == nChannels || 3 == nChannels) && 1 == nBases;
+    }
+};
+
+
+// The table points straight into the memory mapped file, so loading only
+// validates it and every FourierMaterial using the same file, in any scene,
+// shares the same pages.
 struct FourierBSDFTable
 {
     Float eta;
     int mMax;
     int nChannels;
     int nMu;
-    Float *mu;
-    int *m;
-    int *aOffset;
-    Float *a;
-    Float *a0;
-    Float *cdf;
-    Float *recip;
-
-    /* TODO
-    static bool Read(const std::string &filename, FourierBSDFTable *table);
-    */
+    const Float *mu;
+    // (offset into _a_, order) for each (muO, muI) pair
+    const int32_t *offsetAndLength;
+    const Float *a;
+    const Float *a0;
+    const Float *cdf;
+    const Float *recip;
+
+    FourierBSDFTable() = default;
+    FourierBSDFTable(const FourierBSDFTable &) = delete;
+    FourierBSDFTable &operator=(const FourierBSDFTable &) = delete;
+
+    // Returns nullptr if _filename_ can't be mapped or isn't a supported
+    // .bsdf file
+    static std::unique_ptr<FourierBSDFTable> Read(const std::string &filename);
+
+    // Tables are loaded once per filename and kept until ClearCache();
+    // returns nullptr for files Read() rejects
+    static const FourierBSDFTable *Get(const std::string &filename);
+
+    static void ClearCache();
+
 
     const Float *GetAk(int offsetI, int offsetO, int *mptr) const
     {
-        *mptr = m[offsetO * nMu + offsetI];
-        return a + aOffset[offsetO * nMu + offsetI];
+        const int32_t *entry = offsetAndLength + 2 * (offsetO * nMu + offsetI);
+        *mptr = entry[1];
+        return a + entry[0];
     }
 
     bool GetWeightsAndOffset(Float cosTheta, int *offset, Float weights[4]) const;
+
+    // Sums the first _channels_ coefficient series of the 4x4 (muI, muO)
+    // neighbourhood into _ak_, which holds them _mMax_ apart and starts
+    // zeroed; returns the largest order among them
+    int AccumulateAk(int offsetI, int offsetO, const Float weightsI[4], const Float weightsO[4],
+        int channels, Float *ak) const;
+
+private:
+
+    std::shared_ptr<const common::tool::MappedFile> file;
+    // a0 and recip, plus copies of the file's floats when Float is double
+    std::vector<Float> storage;
+
+    static std::map<std::string, std::unique_ptr<FourierBSDFTable>> tables;
+    static std::mutex tablesMutex;
 };
 
 
-class FourierBSDF : public BxDF
+class FourierBSDF final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::Fourier;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
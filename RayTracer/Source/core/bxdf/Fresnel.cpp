@@ -1,4 +1,5 @@
 #include "Fresnel.h"
+#include "BxDF.h"
 #include "../../common/math/Constants.h"
 
 namespace core
@@ -7,6 +8,24 @@ namespace bxdf
 {
 
 
+void Fresnel::Accumulate(const color::Spectrum &R, int n, const Float *cosThetaI,
+    const Float *weight, color::Spectrum *f) const
+{
+    for (int i = 0; i < n; ++i)
+    {
+        if (FLOAT_0 != weight[i])
+        {
+            f[i] += R * Evaluate(cosThetaI[i]) * weight[i];
+        }
+    }
+}
+
+color::HeroSpectrum Fresnel::Evaluate(Float cosI, const color::SampledWavelengths &lambda) const
+{
+    return color::HeroSpectrum::FromSpectrum(Evaluate(cosI), lambda);
+}
+
+
 color::Spectrum FresnelConductor::Evaluate(Float cosThetaI) const
 {
     return FrConductor(std::abs(cosThetaI), etaI, etaT, k);
@@ -17,11 +36,63 @@ color::Spectrum FresnelDielectric::Evaluate(Float cosThetaI) const
     return FrDielectric(cosThetaI, etaI, etaT);
 }
 
+// The same at every wavelength
+color::HeroSpectrum FresnelDielectric::Evaluate(Float cosThetaI, const color::SampledWavelengths &) const
+{
+    return color::HeroSpectrum(FrDielectric(cosThetaI, etaI, etaT));
+}
+
+void FresnelDielectric::Accumulate(const color::Spectrum &R, int n, const Float *cosThetaI,
+    const Float *weight, color::Spectrum *f) const
+{
+    CHECK_LE(n, DirectionBatch::MAX_SIZE);
+    Float Fr[DirectionBatch::MAX_SIZE];
+    FrDielectric(n, cosThetaI, etaI, etaT, Fr);
+    for (int i = 0; i < n; ++i)
+    {
+        if (FLOAT_0 != weight[i])
+        {
+            f[i] += R * (Fr[i] * weight[i]);
+        }
+    }
+}
+
+// Kulla and Conty's fits, "Revisiting Physically Based Shading at
+// Imageworks", for the two sides of the interface
+Float FresnelDielectric::Average() const
+{
+    Float eta = etaT / etaI;
+    if (eta >= FLOAT_1)
+    {
+        return (eta - FLOAT_1) / (static_cast<Float>(4.08567F) + static_cast<Float>(1.00071F) * eta);
+    }
+    return static_cast<Float>(0.997118F) + static_cast<Float>(0.1014F) * eta
+        - static_cast<Float>(0.965241F) * eta * eta
+        - static_cast<Float>(0.130607F) * eta * eta * eta;
+}
+
 color::Spectrum FresnelNoOp::Evaluate(Float cosThetaI) const
 {
     return color::Spectrum(FLOAT_1);
 }
 
+color::HeroSpectrum FresnelNoOp::Evaluate(Float, const color::SampledWavelengths &) const
+{
+    return color::HeroSpectrum(FLOAT_1);
+}
+
+void FresnelNoOp::Accumulate(const color::Spectrum &R, int n, const Float *cosThetaI,
+    const Float *weight, color::Spectrum *f) const
+{
+    for (int i = 0; i < n; ++i)
+    {
+        if (FLOAT_0 != weight[i])
+        {
+            f[i] += R * weight[i];
+        }
+    }
+}
+
 
 Float FrDielectric(Float cosThetaI, Float etaI, Float etaT)
 {
@@ -50,6 +121,26 @@ Float FrDielectric(Float cosThetaI, Float etaI, Float etaT)
     return (Rparl * Rparl + Rperp * Rperp) / FLOAT_2;
 }
 
+void FrDielectric(int n, const Float *cosThetaI, Float etaI, Float etaT, Float *Fr)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        Float cosI = common::math::Clamp(cosThetaI[i], -FLOAT_1, FLOAT_1);
+        // Swap the indices of refraction by selection rather than a branch
+        bool entering = cosI > FLOAT_0;
+        Float ei = entering ? etaI : etaT;
+        Float et = entering ? etaT : etaI;
+        cosI = std::abs(cosI);
+
+        Float sinThetaT = ei / et * std::sqrt((std::max)(FLOAT_0, FLOAT_1 - cosI * cosI));
+        Float cosThetaT = std::sqrt((std::max)(FLOAT_0, FLOAT_1 - sinThetaT * sinThetaT));
+        Float Rparl = ((et * cosI) - (ei * cosThetaT)) / ((et * cosI) + (ei * cosThetaT));
+        Float Rperp = ((ei * cosI) - (et * cosThetaT)) / ((ei * cosI) + (et * cosThetaT));
+        // Total internal reflection
+        Fr[i] = sinThetaT >= FLOAT_1 ? FLOAT_1 : (Rparl * Rparl + Rperp * Rperp) * FLOAT_INV_2;
+    }
+}
+
 // https://seblagarde.wordpress.com/2013/04/29/memo-on-fresnel-equations/
 color::Spectrum FrConductor(Float cosThetaI, const color::Spectrum &etai,
     const color::Spectrum &etat, const color::Spectrum &k)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../ForwardDeclaration.h"
+#include "../color/HeroSpectrum.h"
 #include "../color/Spectrum.h"
 
 namespace core
@@ -17,6 +18,27 @@ public:
     {}
 
     virtual color::Spectrum Evaluate(Float cosI) const = 0;
+
+    // Evaluate() at the wavelengths of _lambda_
+    virtual color::HeroSpectrum Evaluate(Float cosI, const color::SampledWavelengths &lambda) const;
+
+    // f[i] += R * weight[i] * Evaluate(cosThetaI[i]) for the _n_ entries
+    // whose weight is not zero
+    virtual void Accumulate(const color::Spectrum &R, int n, const Float *cosThetaI,
+        const Float *weight, color::Spectrum *f) const;
+
+    // Cosine-weighted hemispherical average of Evaluate() when it is the
+    // same at every wavelength, otherwise negative
+    virtual Float Average() const
+    {
+        return -FLOAT_1;
+    }
+
+    // etaT / etaI of a dielectric interface, otherwise 0
+    virtual Float DielectricEta() const
+    {
+        return FLOAT_0;
+    }
 };
 
 
@@ -55,6 +77,18 @@ public:
 
     color::Spectrum Evaluate(Float cosThetaI) const;
 
+    color::HeroSpectrum Evaluate(Float cosThetaI, const color::SampledWavelengths &lambda) const;
+
+    void Accumulate(const color::Spectrum &R, int n, const Float *cosThetaI,
+        const Float *weight, color::Spectrum *f) const;
+
+    Float Average() const;
+
+    Float DielectricEta() const
+    {
+        return etaT / etaI;
+    }
+
 private:
     Float etaI, etaT;
 };
@@ -66,6 +100,15 @@ public:
 
     color::Spectrum Evaluate(Float) const;
 
+    color::HeroSpectrum Evaluate(Float, const color::SampledWavelengths &lambda) const;
+
+    void Accumulate(const color::Spectrum &R, int n, const Float *cosThetaI,
+        const Float *weight, color::Spectrum *f) const;
+
+    Float Average() const
+    {
+        return FLOAT_1;
+    }
 };
 
 
@@ -75,6 +118,9 @@ public:
 
 Float FrDielectric(Float cosThetaI, Float etaI, Float etaT);
 
+// FrDielectric() for _n_ angles, written without branches so it vectorizes
+void FrDielectric(int n, const Float *cosThetaI, Float etaI, Float etaT, Float *Fr);
+
 color::Spectrum FrConductor(Float cosThetaI, const color::Spectrum &etaI,
     const color::Spectrum &etaT, const color::Spectrum &k);
 
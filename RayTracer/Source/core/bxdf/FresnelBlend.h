@@ -9,10 +9,12 @@ namespace bxdf
 {
 
 
-class FresnelBlend : public BxDF
+class FresnelBlend final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::FresnelBlend;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
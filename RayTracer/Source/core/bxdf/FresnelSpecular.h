@@ -9,10 +9,12 @@ namespace bxdf
 {
 
 
-class FresnelSpecular : public BxDF
+class FresnelSpecular final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::FresnelSpecular;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
@@ -1,5 +1,6 @@
 #include "Interpolation.h"
 #include "../../common/math/Constants.h"
+#include "../color/SpectrumLane.h"
 
 namespace core
 {
@@ -467,6 +468,44 @@ Float Fourier(const Float *a, int m, double cosPhi)
     return value;
 }
 
+void FourierChannels(const Float *a, int stride, int m, int nChannels, double cosPhi, Float *values)
+{
+    typedef core::color::SpectrumLaneFor<8>::Type Lane;
+    CHECK(nChannels >= 1 && nChannels <= 3);
+
+    // Tabulate the cosine iterates once for every channel
+    Float *cosKPhi = ALLOCA(Float, m);
+    double cosKMinusOnePhi = cosPhi;
+    double cosK = 1.0;
+    for (int k = 0; k < m; ++k)
+    {
+        cosKPhi[k] = static_cast<Float>(cosK);
+        double cosKPlusOnePhi = 2.0 * cosPhi * cosK - cosKMinusOnePhi;
+        cosKMinusOnePhi = cosK;
+        cosK = cosKPlusOnePhi;
+    }
+
+    // Sum whole lanes of terms for all channels together, then the rest
+    Lane sum[3] = {Lane::Set(FLOAT_0), Lane::Set(FLOAT_0), Lane::Set(FLOAT_0)};
+    int k = 0;
+    for (; k + Lane::WIDTH <= m; k += Lane::WIDTH)
+    {
+        Lane cosines = Lane::Load(cosKPhi + k);
+        for (int c = 0; c < nChannels; ++c)
+        {
+            sum[c] = sum[c] + Lane::Load(a + c * stride + k) * cosines;
+        }
+    }
+    for (int c = 0; c < nChannels; ++c)
+    {
+        values[c] = sum[c].SumLane();
+        for (int j = k; j < m; ++j)
+        {
+            values[c] += a[c * stride + j] * cosKPhi[j];
+        }
+    }
+}
+
 Float SampleFourier(const Float *ak, const Float *recip, int m, Float u, Float *pdf, Float *phiPtr)
 {
     // Pick a side and declare bisection variables
@@ -29,6 +29,10 @@ Float InvertCatmullRom(int n, const Float *x, const Float *values, Float u);
 
 Float Fourier(const Float *a, int m, double cosPhi);
 
+// Fourier() for _nChannels_ (at most 3) series stored _stride_ apart in _a_,
+// sharing the cosine iterates and summing the terms a SIMD lane at a time
+void FourierChannels(const Float *a, int stride, int m, int nChannels, double cosPhi, Float *values);
+
 Float SampleFourier(const Float *ak, const Float *recip, int m, Float u,
     Float *pdf, Float *phiPtr);
 
@@ -2,6 +2,8 @@
 
 #include "BxDF.h"
 #include "Fresnel.h"
+#include "../color/HeroSpectrum.h"
+#include "../sampler/Sampling.h"
 
 namespace core
 {
@@ -9,10 +11,12 @@ namespace bxdf
 {
 
 
-class LambertianReflection : public BxDF
+class LambertianReflection final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::LambertianReflection;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
@@ -22,7 +26,78 @@ public:
     {}
 
 
-    color::Spectrum f(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const;
+    // Defined here so BSDF's dispatch inlines the most common lobe
+    color::Spectrum f(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const
+    {
+        return R * common::math::INV_PI;
+    }
+
+    color::Spectrum Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+        const common::math::Vec2f &u, Float *pdf,
+        BxDFType *sampledType = nullptr) const
+    {
+        *wi = sampler::CosineSampleHemisphere(u);
+        if (wo.z < FLOAT_0)
+        {
+            wi->z *= -FLOAT_1;
+        }
+        *pdf = Pdf(wo, *wi);
+        return f(wo, *wi);
+    }
+
+    // f() and Sample_f() at the wavelengths of _lambda_
+    color::HeroSpectrum f(const common::math::Vec3f &wo, const common::math::Vec3f &wi,
+        const color::SampledWavelengths &lambda) const
+    {
+        return color::HeroSpectrum::FromSpectrum(R, lambda) * common::math::INV_PI;
+    }
+
+    color::HeroSpectrum Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+        const common::math::Vec2f &u, Float *pdf, const color::SampledWavelengths &lambda,
+        BxDFType *sampledType = nullptr) const
+    {
+        *wi = sampler::CosineSampleHemisphere(u);
+        if (wo.z < FLOAT_0)
+        {
+            wi->z *= -FLOAT_1;
+        }
+        *pdf = Pdf(wo, *wi);
+        return f(wo, *wi, lambda);
+    }
+
+    Float Pdf(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const
+    {
+        return SameHemisphere(wo, wi) ? AbsCosTheta(wi) * common::math::INV_PI : FLOAT_0;
+    }
+
+    // Reflectance used to pick lobes in BSDF::Sample_f()
+    Float AlbedoEstimate(const common::math::Vec3f &) const
+    {
+        return R.MaxComponentValue();
+    }
+
+    // Adds f() to _f_ where _active_ is set, for every direction of _wi_
+    void f(const common::math::Vec3f &wo, const DirectionBatch &wi, const bool *active,
+        color::Spectrum *f) const
+    {
+        color::Spectrum r = R * common::math::INV_PI;
+        for (int i = 0; i < wi.n; ++i)
+        {
+            if (active[i])
+            {
+                f[i] += r;
+            }
+        }
+    }
+
+    // Adds Pdf() to _pdf_ for every direction of _wi_
+    void Pdf(const common::math::Vec3f &wo, const DirectionBatch &wi, Float *pdf) const
+    {
+        for (int i = 0; i < wi.n; ++i)
+        {
+            pdf[i] += wo.z * wi.z[i] > FLOAT_0 ? std::abs(wi.z[i]) * common::math::INV_PI : FLOAT_0;
+        }
+    }
 
     color::Spectrum rho(const common::math::Vec3f &, int, const common::math::Vec2f *) const
     {
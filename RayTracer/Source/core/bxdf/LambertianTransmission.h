@@ -9,10 +9,12 @@ namespace bxdf
 {
 
 
-class LambertianTransmission : public BxDF
+class LambertianTransmission final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::LambertianTransmission;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
@@ -39,6 +41,11 @@ public:
 
     Float Pdf(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const;
 
+    Float AlbedoEstimate(const common::math::Vec3f &) const
+    {
+        return T.MaxComponentValue();
+    }
+
 private:
 
     color::Spectrum T;
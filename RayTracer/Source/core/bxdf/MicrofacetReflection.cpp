@@ -1,4 +1,5 @@
 #include "MicrofacetReflection.h"
+#include "./distribution/MicrofacetAlbedo.h"
 
 
 namespace core
@@ -7,46 +8,121 @@ namespace bxdf
 {
 
 
-core::color::Spectrum MicrofacetReflection::f(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const
+// Normalized wo + wi, left at zero where the sum vanishes
+static void HalfVectors(const common::math::Vec3f &wo, const DirectionBatch &wi, DirectionBatch *wh)
+{
+    wh->n = wi.n;
+    for (int i = 0; i < wi.n; ++i)
+    {
+        Float x = wi.x[i] + wo.x, y = wi.y[i] + wo.y, z = wi.z[i] + wo.z;
+        Float length2 = x * x + y * y + z * z;
+        Float invLength = length2 > FLOAT_0 ? FLOAT_1 / std::sqrt(length2) : FLOAT_0;
+        wh->x[i] = x * invLength;
+        wh->y[i] = y * invLength;
+        wh->z[i] = z * invLength;
+    }
+}
+
+
+bool MicrofacetReflection::Factors(const common::math::Vec3f &wo, const common::math::Vec3f &wi,
+    Float *single, Float *cosThetaIH, Float *multiple) const
 {
     Float cosThetaO = AbsCosTheta(wo), cosThetaI = AbsCosTheta(wi);
     common::math::Vec3f wh = wi + wo;
     // Handle degenerate cases for microfacet reflection
     if (FLOAT_0 == cosThetaI || FLOAT_0 == cosThetaO)
     {
-        return core::color::Spectrum(FLOAT_0);
+        return false;
     }
     if (FLOAT_0 == wh.x && FLOAT_0 == wh.y && FLOAT_0 == wh.z)
     {
-        return core::color::Spectrum(FLOAT_0);
+        return false;
     }
     wh = Normalize(wh);
-    core::color::Spectrum F = fresnel->Evaluate(Dot(wi, wh));
-    return R * distribution->D(wh) * distribution->G(wo, wi) * F /
-        (FLOAT_2 * FLOAT_2 * cosThetaI * cosThetaO);
+    // On an interface the Fresnel term tells the sides apart by the sign
+    // of the cosine, measured against the normal's side
+    if (interfaceScattering && wh.z < FLOAT_0)
+    {
+        wh = -wh;
+    }
+    *cosThetaIH = Dot(wi, wh);
+    *single = distribution->D(wh) * distribution->G(wo, wi) / (FLOAT_2 * FLOAT_2 * cosThetaI * cosThetaO);
+    *multiple = FLOAT_0;
+    if (interfaceScattering && SameHemisphere(wo, wi))
+    {
+        *multiple = albedo->DielectricMultipleScattering(alpha, EtaO(wo), cosThetaO, cosThetaI, true);
+    }
+    else if (msScale > FLOAT_0 && SameHemisphere(wo, wi))
+    {
+        *multiple = msScale * (FLOAT_1 - albedo->E(alpha, cosThetaO)) * (FLOAT_1 - albedo->E(alpha, cosThetaI));
+    }
+    return true;
 }
 
-core::color::Spectrum MicrofacetReflection::Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
-    const common::math::Vec2f &u, Float *pdf,
-    BxDFType *sampledType) const
+core::color::Spectrum MicrofacetReflection::f(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const
+{
+    Float single, cosThetaIH, multiple;
+    if (!Factors(wo, wi, &single, &cosThetaIH, &multiple))
+    {
+        return core::color::Spectrum(FLOAT_0);
+    }
+    return R * (fresnel->Evaluate(cosThetaIH) * single + core::color::Spectrum(multiple));
+}
+
+core::color::HeroSpectrum MicrofacetReflection::f(const common::math::Vec3f &wo, const common::math::Vec3f &wi,
+    const core::color::SampledWavelengths &lambda) const
+{
+    Float single, cosThetaIH, multiple;
+    if (!Factors(wo, wi, &single, &cosThetaIH, &multiple))
+    {
+        return core::color::HeroSpectrum(FLOAT_0);
+    }
+    return core::color::HeroSpectrum::FromSpectrum(R, lambda) *
+        (fresnel->Evaluate(cosThetaIH, lambda) * single + core::color::HeroSpectrum(multiple));
+}
+
+bool MicrofacetReflection::SampleDirection(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+    const common::math::Vec2f &u, Float *pdf) const
 {
     // Sample microfacet orientation $\wh$ and reflected direction $\wi$
     if (FLOAT_0 == wo.z)
     {
-        return FLOAT_0;
+        return false;
     }
     common::math::Vec3f wh = distribution->Sample_wh(wo, u);
     *wi = Reflect(wo, wh);
     if (!SameHemisphere(wo, *wi))
     {
-        return core::color::Spectrum(FLOAT_0);
+        return false;
     }
 
     // Compute PDF of _wi_ for microfacet reflection
     *pdf = distribution->Pdf(wo, wh) / (FLOAT_2 * FLOAT_2 * Dot(wo, wh));
+    return true;
+}
+
+core::color::Spectrum MicrofacetReflection::Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+    const common::math::Vec2f &u, Float *pdf,
+    BxDFType *sampledType) const
+{
+    if (!SampleDirection(wo, wi, u, pdf))
+    {
+        return core::color::Spectrum(FLOAT_0);
+    }
     return f(wo, *wi);
 }
 
+core::color::HeroSpectrum MicrofacetReflection::Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+    const common::math::Vec2f &u, Float *pdf, const core::color::SampledWavelengths &lambda,
+    BxDFType *sampledType) const
+{
+    if (!SampleDirection(wo, wi, u, pdf))
+    {
+        return core::color::HeroSpectrum(FLOAT_0);
+    }
+    return f(wo, *wi, lambda);
+}
+
 Float MicrofacetReflection::Pdf(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const
 {
     if (!SameHemisphere(wo, wi))
@@ -57,6 +133,116 @@ Float MicrofacetReflection::Pdf(const common::math::Vec3f &wo, const common::mat
     return distribution->Pdf(wo, wh) / (FLOAT_2 * FLOAT_2 * Dot(wo, wh));
 }
 
+void MicrofacetReflection::f(const common::math::Vec3f &wo, const DirectionBatch &wi, const bool *active,
+    core::color::Spectrum *f) const
+{
+    Float cosThetaO = AbsCosTheta(wo);
+    if (FLOAT_0 == cosThetaO)
+    {
+        return;
+    }
+    DirectionBatch wh;
+    HalfVectors(wo, wi, &wh);
+    Float cosThetaIH[DirectionBatch::MAX_SIZE], weight[DirectionBatch::MAX_SIZE];
+    Float d[DirectionBatch::MAX_SIZE], g[DirectionBatch::MAX_SIZE];
+    distribution->D(wh, d);
+    distribution->G(wo, wi, g);
+    for (int i = 0; i < wi.n; ++i)
+    {
+        // Zero for inactive and degenerate directions, as in f() above
+        Float cosThetaI = std::abs(wi.z[i]);
+        bool valid = active[i] && FLOAT_0 != cosThetaI &&
+            (FLOAT_0 != wh.x[i] || FLOAT_0 != wh.y[i] || FLOAT_0 != wh.z[i]);
+        cosThetaIH[i] = wi.x[i] * wh.x[i] + wi.y[i] * wh.y[i] + wi.z[i] * wh.z[i];
+        if (interfaceScattering && wh.z[i] < FLOAT_0)
+        {
+            cosThetaIH[i] = -cosThetaIH[i];
+        }
+        weight[i] = valid ? d[i] * g[i] / (FLOAT_2 * FLOAT_2 * cosThetaI * cosThetaO) : FLOAT_0;
+    }
+    fresnel->Accumulate(R, wi.n, cosThetaIH, weight, f);
+
+    if (interfaceScattering)
+    {
+        Float etaO = EtaO(wo);
+        for (int i = 0; i < wi.n; ++i)
+        {
+            if (active[i] && wo.z * wi.z[i] > FLOAT_0)
+            {
+                f[i] += R * albedo->DielectricMultipleScattering(alpha, etaO, cosThetaO, wi.z[i], true);
+            }
+        }
+    }
+    else if (msScale > FLOAT_0)
+    {
+        Float scaleO = msScale * (FLOAT_1 - albedo->E(alpha, cosThetaO));
+        for (int i = 0; i < wi.n; ++i)
+        {
+            if (active[i] && wo.z * wi.z[i] > FLOAT_0)
+            {
+                f[i] += R * (scaleO * (FLOAT_1 - albedo->E(alpha, wi.z[i])));
+            }
+        }
+    }
+}
+
+Float MicrofacetReflection::AlbedoEstimate(const common::math::Vec3f &wo) const
+{
+    if (nullptr == albedo)
+    {
+        return -FLOAT_1;
+    }
+    // Conductors fall back to the F = 1 table, an upper bound
+    Float cosThetaO = AbsCosTheta(wo);
+    if (interfaceScattering)
+    {
+        Float etaO = EtaO(wo);
+        return R.MaxComponentValue() * (albedo->E(alpha, cosThetaO, etaO)
+            + albedo->DielectricMultipleScatteringAlbedo(alpha, etaO, cosThetaO, true));
+    }
+    Float e = albedo->E(alpha, cosThetaO);
+    Float single = eta > FLOAT_0 ? albedo->E(alpha, cosThetaO, eta) : e;
+    return R.MaxComponentValue() * (single + msAlbedo * (FLOAT_1 - e));
+}
+
+void MicrofacetReflection::InitEnergyCompensation(bool transmissive)
+{
+    albedo = distribution->AlbedoTable(&alpha);
+    if (nullptr == albedo)
+    {
+        return;
+    }
+    eta = fresnel->DielectricEta();
+    if (transmissive)
+    {
+        interfaceScattering = eta > FLOAT_0;
+        return;
+    }
+    Float fAvg = fresnel->Average();
+    Float eAvg = albedo->EAvg(alpha);
+    if (fAvg < FLOAT_0 || eAvg >= FLOAT_1)
+    {
+        return;
+    }
+    // The missing energy 1 - E(mu_o), tinted by the Fresnel average over
+    // the repeated bounces as in Kulla and Conty
+    msAlbedo = fAvg * fAvg * eAvg / (FLOAT_1 - fAvg * (FLOAT_1 - eAvg));
+    msScale = msAlbedo / (common::math::PI * (FLOAT_1 - eAvg));
+}
+
+void MicrofacetReflection::Pdf(const common::math::Vec3f &wo, const DirectionBatch &wi, Float *pdf) const
+{
+    DirectionBatch wh;
+    HalfVectors(wo, wi, &wh);
+    Float p[DirectionBatch::MAX_SIZE];
+    distribution->Pdf(wo, wh, p);
+    for (int i = 0; i < wi.n; ++i)
+    {
+        Float cosThetaOH = wo.x * wh.x[i] + wo.y * wh.y[i] + wo.z * wh.z[i];
+        pdf[i] += wo.z * wi.z[i] > FLOAT_0 ? p[i] / (FLOAT_2 * FLOAT_2 * cosThetaOH) : FLOAT_0;
+    }
+}
+
 
 }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "BxDF.h"
 #include "Fresnel.h"
+#include "../color/HeroSpectrum.h"
 #include "./distribution/MicrofacetDistribution.h"
 
 namespace core
@@ -10,21 +11,29 @@ namespace bxdf
 {
 
 
-class MicrofacetReflection : public BxDF
+class MicrofacetReflection final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::MicrofacetReflection;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
 
+    // _transmissive_ marks the reflection of a rough dielectric interface
+    // that a MicrofacetTransmission of the same distribution refracts
+    // through, whose lost energy goes to both sides
     MicrofacetReflection(const core::color::Spectrum &R,
-        core::bxdf::distribution::MicrofacetDistribution *distribution, Fresnel *fresnel)
+        core::bxdf::distribution::MicrofacetDistribution *distribution, Fresnel *fresnel,
+        bool transmissive = false)
         : BxDF(BxDFType(BSDF_REFLECTION | BSDF_GLOSSY)),
         R(R),
         distribution(distribution),
         fresnel(fresnel)
-    {}
+    {
+        InitEnergyCompensation(transmissive);
+    }
 
 
     core::color::Spectrum f(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const;
@@ -34,13 +43,69 @@ public:
 
     Float Pdf(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const;
 
+    // f() and Sample_f() at the wavelengths of _lambda_: D, G and a
+    // dielectric Fresnel term are scalars, only R and a conductor's
+    // Fresnel term vary with the wavelength
+    core::color::HeroSpectrum f(const common::math::Vec3f &wo, const common::math::Vec3f &wi,
+        const core::color::SampledWavelengths &lambda) const;
+
+    core::color::HeroSpectrum Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+        const common::math::Vec2f &u, Float *pdf, const core::color::SampledWavelengths &lambda,
+        BxDFType *sampledType) const;
+
+    // Adds f() to _f_ where _active_ is set, for every direction of _wi_;
+    // D, G and the Fresnel term are each evaluated over the whole batch
+    void f(const common::math::Vec3f &wo, const DirectionBatch &wi, const bool *active,
+        core::color::Spectrum *f) const;
+
+    // Adds Pdf() to _pdf_ for every direction of _wi_
+    void Pdf(const common::math::Vec3f &wo, const DirectionBatch &wi, Float *pdf) const;
+
+    // Tabulated reflectance from _wo_ for picking lobes, or negative
+    // before MicrofacetAlbedo::Init()
+    Float AlbedoEstimate(const common::math::Vec3f &wo) const;
+
 private:
 
+    // Sets up Kulla and Conty's multiple scattering lobe, which returns the
+    // energy single scattering loses to masking at high roughness, when
+    // the distribution has a baked albedo table and the Fresnel term a
+    // scalar average, or is dielectric for a transmissive interface
+    void InitEnergyCompensation(bool transmissive);
+
+    // The factors of f() that do not depend on the wavelength: D G over
+    // the cosines in _single_, the cosine the Fresnel term takes and the
+    // multiple scattering lobe in _multiple_; false where f() is zero
+    bool Factors(const common::math::Vec3f &wo, const common::math::Vec3f &wi,
+        Float *single, Float *cosThetaIH, Float *multiple) const;
+
+    // Samples _wi_ and its pdf for Sample_f(), false where it fails
+    bool SampleDirection(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+        const common::math::Vec2f &u, Float *pdf) const;
+
+    // Relative index of refraction on the side of _wo_
+    Float EtaO(const common::math::Vec3f &wo) const
+    {
+        return CosTheta(wo) > FLOAT_0 ? eta : FLOAT_1 / eta;
+    }
+
+
     const core::color::Spectrum R;
 
     const core::bxdf::distribution::MicrofacetDistribution *distribution;
 
     const Fresnel *fresnel;
+
+    const core::bxdf::distribution::MicrofacetAlbedo *albedo = nullptr;
+    Float alpha = FLOAT_0;
+    Float eta = FLOAT_0;
+    // The lobe is msScale (1 - E(mu_o)) (1 - E(mu_i)) and reflects
+    // msAlbedo (1 - E(mu_o)) in total
+    Float msScale = FLOAT_0;
+    Float msAlbedo = FLOAT_0;
+    // The lobe is the reflected share of
+    // MicrofacetAlbedo::DielectricMultipleScattering() instead
+    bool interfaceScattering = false;
 };
 
 
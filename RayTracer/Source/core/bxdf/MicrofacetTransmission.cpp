@@ -1,4 +1,5 @@
 #include "MicrofacetTransmission.h"
+#include "./distribution/MicrofacetAlbedo.h"
 
 namespace core
 {
@@ -34,10 +35,15 @@ core::color::Spectrum MicrofacetTransmission::f(const common::math::Vec3f &wo,
     Float sqrtDenom = Dot(wo, wh) + eta * Dot(wi, wh);
     Float factor = (core::material::TransportMode::Radiance == mode) ? (FLOAT_1 / eta) : FLOAT_1;
 
-    return (core::color::Spectrum(FLOAT_1) - F) * T *
+    core::color::Spectrum f = (core::color::Spectrum(FLOAT_1) - F) * T *
         std::abs(distribution->D(wh) * distribution->G(wo, wi) * eta * eta *
             AbsDot(wi, wh) * AbsDot(wo, wh) * factor * factor /
             (cosThetaI * cosThetaO * sqrtDenom * sqrtDenom));
+    if (nullptr != albedo)
+    {
+        f += T * (factor * factor * albedo->DielectricMultipleScattering(alpha, eta, cosThetaO, cosThetaI, false));
+    }
+    return f;
 }
 
 core::color::Spectrum MicrofacetTransmission::Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
@@ -58,6 +64,18 @@ core::color::Spectrum MicrofacetTransmission::Sample_f(const common::math::Vec3f
     return f(wo, *wi);
 }
 
+Float MicrofacetTransmission::AlbedoEstimate(const common::math::Vec3f &wo) const
+{
+    if (nullptr == albedo)
+    {
+        return -FLOAT_1;
+    }
+    Float eta = CosTheta(wo) > FLOAT_0 ? (etaB / etaA) : (etaA / etaB);
+    Float cosThetaO = AbsCosTheta(wo);
+    return T.MaxComponentValue() * (albedo->ETransmission(alpha, cosThetaO, eta)
+        + albedo->DielectricMultipleScatteringAlbedo(alpha, eta, cosThetaO, false));
+}
+
 Float MicrofacetTransmission::Pdf(const common::math::Vec3f &wo,
     const common::math::Vec3f &wi) const
 {
@@ -11,10 +11,12 @@ namespace bxdf
 {
 
 
-class MicrofacetTransmission : public BxDF
+class MicrofacetTransmission final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::MicrofacetTransmission;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
@@ -29,7 +31,9 @@ public:
         etaB(etaB),
         fresnel(etaA, etaB),
         mode(mode)
-    {}
+    {
+        albedo = distribution->AlbedoTable(&alpha);
+    }
 
 
     core::color::Spectrum f(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const;
@@ -39,6 +43,10 @@ public:
 
     Float Pdf(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const;
 
+    // Tabulated transmittance from _wo_ for picking lobes, or negative
+    // before MicrofacetAlbedo::Init()
+    Float AlbedoEstimate(const common::math::Vec3f &wo) const;
+
 private:
 
     const core::color::Spectrum T;
@@ -50,6 +58,11 @@ private:
     const FresnelDielectric fresnel;
 
     const core::material::TransportMode mode;
+
+    // When set, f() adds the refracted share of the multiple scattering
+    // lobe of the interface (MicrofacetAlbedo::DielectricMultipleScattering())
+    const core::bxdf::distribution::MicrofacetAlbedo *albedo = nullptr;
+    Float alpha = FLOAT_0;
 };
 
 
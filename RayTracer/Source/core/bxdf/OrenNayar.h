@@ -10,10 +10,12 @@ namespace bxdf
 {
 
 
-class OrenNayar : public BxDF
+class OrenNayar final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::OrenNayar;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +32,11 @@ public:
 
     core::color::Spectrum f(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const;
 
+    Float AlbedoEstimate(const common::math::Vec3f &) const
+    {
+        return R.MaxComponentValue();
+    }
+
 private:
 
     const core::color::Spectrum R;
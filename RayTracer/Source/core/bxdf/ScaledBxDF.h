@@ -17,7 +17,7 @@ public:
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
 
-    ScaledBxDF(BxDF *bxdf, const core::color::Spectrum &scale)
+    ScaledBxDF(const BxDF *bxdf, const core::color::Spectrum &scale)
         : BxDF(BxDFType(bxdf->type)), bxdf(bxdf), scale(scale)
     {}
 
@@ -44,7 +44,7 @@ public:
 
 private:
 
-    BxDF *bxdf;
+    const BxDF *bxdf;
 
     core::color::Spectrum scale;
 };
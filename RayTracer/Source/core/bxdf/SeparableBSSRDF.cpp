@@ -2,8 +2,10 @@
 #include "BSDF.h"
 #include "SeparableBSSRDFAdapter.h"
 #include "../primitive/Primitive.h"
+#include "../interaction/SurfaceInteraction.h"
 #include "../scene/Scene.h"
 #include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -15,7 +17,7 @@ core::color::Spectrum SeparableBSSRDF::Sample_S(const core::scene::Scene &scene,
     const common::math::Vec2f &u2, common::tool::MemoryArena &arena,
     core::interaction::SurfaceInteraction *si, Float *pdf) const
 {
-    //ProfilePhase pp(Prof::BSSRDFSampling);
+    common::tool::ProfilePhase pp(common::tool::Prof::BSSRDFSampling);
     core::color::Spectrum Sp = Sample_Sp(scene, u1, u2, arena, si, pdf);
     if (!Sp.IsBlack())
     {
@@ -31,7 +33,7 @@ core::color::Spectrum SeparableBSSRDF::Sample_Sp(const core::scene::Scene &scene
     const common::math::Vec2f &u2, common::tool::MemoryArena &arena,
     core::interaction::SurfaceInteraction *pi, Float *pdf) const
 {
-    //ProfilePhase pp(Prof::BSSRDFEvaluation);
+    common::tool::ProfilePhase pp(common::tool::Prof::BSSRDFEvaluation);
     // Choose projection axis for BSSRDF sampling
     common::math::Vec3f vx, vy, vz;
     if (u1 < FLOAT_INV_2)
@@ -95,27 +97,28 @@ core::color::Spectrum SeparableBSSRDF::Sample_Sp(const core::scene::Scene &scene
     };
     IntersectionChain *chain = ARENA_ALLOC(arena, IntersectionChain)();
 
-    // Accumulate chain of intersections along ray
+    // Accumulate chain of intersections along ray in a single traversal
     IntersectionChain *ptr = chain;
     int nFound = 0;
-    while (true)
+    common::math::Rayf ray = base.SpawnRayTo(pTarget);
+    if (common::math::Vec3f(FLOAT_0, FLOAT_0, FLOAT_0) == ray.dir)
+    {
+        return core::color::Spectrum(FLOAT_0);
+    }
+    core::interaction::SurfaceInteraction unused;
+    scene.IntersectAll(ray, &unused, [&](const core::interaction::SurfaceInteraction &si, Float tHit)
     {
-        common::math::Rayf r = base.SpawnRayTo(pTarget);
-        if (common::math::Vec3f(FLOAT_0, FLOAT_0, FLOAT_0) == r.dir || !scene.Intersect(r, &ptr->si))
-        {
-            break;
-        }
-
-        base = ptr->si;
         // Append admissible intersection to _IntersectionChain_
-        if (ptr->si.primitive->GetMaterial() == this->material)
+        if (si.primitive->GetMaterial() == this->material)
         {
+            ptr->si = si;
             IntersectionChain *next = ARENA_ALLOC(arena, IntersectionChain)();
             ptr->next = next;
             ptr = next;
             nFound++;
         }
-    }
+        return false;
+    });
 
     // Randomly choose one of several intersections during BSSRDF sampling
     if (0 == nFound)
@@ -5,6 +5,7 @@
 #include "Fresnel.h"
 #include "../material/Material.h"
 #include "../color/Spectrum.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -33,7 +34,7 @@ public:
 
     core::color::Spectrum S(const core::interaction::SurfaceInteraction &pi, const common::math::Vec3f &wi)
     {
-        //ProfilePhase pp(Prof::BSSRDFEvaluation);
+        common::tool::ProfilePhase pp(common::tool::Prof::BSSRDFEvaluation);
         Float Ft = FrDielectric(CosTheta(po.wo), FLOAT_1, eta);
         return (FLOAT_1 - Ft) * Sp(pi) * Sw(wi);
     }
@@ -9,10 +9,12 @@ namespace bxdf
 {
 
 
-class SpecularReflection : public BxDF
+class SpecularReflection final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::SpecularReflection;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
@@ -6,22 +6,21 @@ namespace bxdf
 {
 
 
-color::Spectrum SpecularTransmission::Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
-    const common::math::Vec2f &sample, Float *pdf,
-    BxDFType *sampledType) const
+Float SpecularTransmission::Transmit(const common::math::Vec3f &wo, common::math::Vec3f *wi, Float *pdf,
+    Float etaInside) const
 {
     // Figure out which $\eta$ is incident and which is transmitted
     bool entering = CosTheta(wo) > FLOAT_0;
-    Float etaI = entering ? etaA : etaB;
-    Float etaT = entering ? etaB : etaA;
+    Float etaI = entering ? etaA : etaInside;
+    Float etaT = entering ? etaInside : etaA;
 
     // Compute ray direction for specular transmission
     if (!Refract(wo, Faceforward(common::math::Vec3f(FLOAT_0, FLOAT_0, FLOAT_1), wo), etaI / etaT, wi))
     {
-        return color::Spectrum(FLOAT_0);
+        return FLOAT_0;
     }
     *pdf = FLOAT_1;
-    color::Spectrum ft = T * (color::Spectrum(FLOAT_1) - fresnel.Evaluate(CosTheta(*wi)));
+    Float ft = FLOAT_1 - FrDielectric(CosTheta(*wi), etaA, etaInside);
     // Account for non-symmetry with transmission to different medium
     if (material::TransportMode::Radiance == mode)
     {
@@ -31,6 +30,28 @@ color::Spectrum SpecularTransmission::Sample_f(const common::math::Vec3f &wo, co
     return ft / AbsCosTheta(*wi);
 }
 
+color::Spectrum SpecularTransmission::Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+    const common::math::Vec2f &sample, Float *pdf,
+    BxDFType *sampledType) const
+{
+    return T * Transmit(wo, wi, pdf, etaB);
+}
+
+color::HeroSpectrum SpecularTransmission::Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+    const common::math::Vec2f &sample, Float *pdf, color::SampledWavelengths &lambda,
+    BxDFType *sampledType) const
+{
+    Float etaInside = etaB;
+    if (FLOAT_0 != dispersion)
+    {
+        lambda.TerminateSecondary();
+        const Float lambdaD = static_cast<Float>(0.5893F);
+        Float lambdaHero = lambda[0] * static_cast<Float>(0.001F);
+        etaInside += dispersion * (FLOAT_1 / (lambdaHero * lambdaHero) - FLOAT_1 / (lambdaD * lambdaD));
+    }
+    return color::HeroSpectrum::FromSpectrum(T, lambda) * Transmit(wo, wi, pdf, etaInside);
+}
+
 
 }
 }
\ No newline at end of file
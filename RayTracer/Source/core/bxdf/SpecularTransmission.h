@@ -2,6 +2,7 @@
 
 #include "BxDF.h"
 #include "Fresnel.h"
+#include "../color/HeroSpectrum.h"
 #include "../material/Material.h"
 
 namespace core
@@ -10,22 +11,26 @@ namespace bxdf
 {
 
 
-class SpecularTransmission : public BxDF
+class SpecularTransmission final : public BxDF
 {
 public:
 
+    static constexpr BxDFKind KIND = BxDFKind::SpecularTransmission;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
 
+    // _dispersion_ is the Cauchy coefficient B of the medium behind the
+    // surface in um^2; _etaB_ is its index at the sodium D line (589.3nm)
     SpecularTransmission(const color::Spectrum &T, Float etaA, Float etaB,
-        material::TransportMode mode)
+        material::TransportMode mode, Float dispersion = FLOAT_0)
         : BxDF(BxDFType(BSDF_TRANSMISSION | BSDF_SPECULAR)),
         T(T),
         etaA(etaA),
         etaB(etaB),
-        fresnel(etaA, etaB),
-        mode(mode)
+        mode(mode),
+        dispersion(dispersion)
     {}
 
 
@@ -37,6 +42,12 @@ public:
     color::Spectrum Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi, const common::math::Vec2f &sample,
         Float *pdf, BxDFType *sampledType) const;
 
+    // Sample_f() at the wavelengths of _lambda_: a dispersive medium
+    // refracts at the index of the hero wavelength and terminates the
+    // others
+    color::HeroSpectrum Sample_f(const common::math::Vec3f &wo, common::math::Vec3f *wi, const common::math::Vec2f &sample,
+        Float *pdf, color::SampledWavelengths &lambda, BxDFType *sampledType) const;
+
     Float Pdf(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const
     {
         return FLOAT_0;
@@ -44,13 +55,19 @@ public:
 
 private:
 
+    // Refracts _wo_ into the medium of index _etaInside_, returning the
+    // transmitted fraction over the cosine, or 0 on total internal
+    // reflection
+    Float Transmit(const common::math::Vec3f &wo, common::math::Vec3f *wi, Float *pdf, Float etaInside) const;
+
+
     const color::Spectrum T;
 
     const Float etaA, etaB;
 
-    const FresnelDielectric fresnel;
-
     const material::TransportMode mode;
+
+    const Float dispersion;
 };
 
 
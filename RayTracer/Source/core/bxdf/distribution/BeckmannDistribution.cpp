@@ -89,7 +89,7 @@ static void BeckmannSample11(Float cosThetaI, Float U1, Float U2,
     *slope_x = common::math::ErfInv(b);
 
     /* Simulate Y component */
-    *slope_y = common::math::ErfInv(FLOAT_2 * (std::max)(U2, static_cast<Float>(1e-6f) - FLOAT_1));
+    *slope_y = common::math::ErfInv(FLOAT_2 * (std::max)(U2, static_cast<Float>(1e-6f)) - FLOAT_1);
 
     CHECK(!std::isinf(*slope_x));
     CHECK(!std::isnan(*slope_x));
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MicrofacetDistribution.h"
+#include "MicrofacetAlbedo.h"
 #include "../BxDF.h"
 
 namespace core
@@ -39,6 +40,12 @@ public:
 
     common::math::Vec3f Sample_wh(const common::math::Vec3f &wo, const common::math::Vec2f &u) const;
 
+    const MicrofacetAlbedo *AlbedoTable(Float *alpha) const
+    {
+        *alpha = std::sqrt(alphax * alphay);
+        return MicrofacetAlbedo::Beckmann();
+    }
+
 private:
 
     Float Lambda(const common::math::Vec3f &w) const;
@@ -0,0 +1,268 @@
+#include "MicrofacetAlbedo.h"
+#include "BeckmannDistribution.h"
+#include "TrowbridgeReitzDistribution.h"
+#include "../BxDF.h"
+#include "../Fresnel.h"
+#include "../../../common/tool/MultiThread.h"
+
+namespace core
+{
+namespace bxdf
+{
+namespace distribution
+{
+
+
+std::unique_ptr<MicrofacetAlbedo> MicrofacetAlbedo::trowbridgeReitz;
+std::unique_ptr<MicrofacetAlbedo> MicrofacetAlbedo::beckmann;
+
+// The F = 1 table drives energy compensation and needs 4096 samples per
+// entry to stay within 1e-2: a stratified grid reaches the far slopes that
+// carry the shadowing loss of smooth lobes slowly. The dielectric tables
+// compensate rough interfaces too, but there are ETA_SIZE of them and the
+// Fresnel term weighs the grazing slopes less.
+static const int SQRT_SAMPLE_NUMBER = 64;
+static const int SQRT_DIELECTRIC_SAMPLE_NUMBER = 32;
+
+
+// Entries sit at sqrt(alpha) = i / (ROUGHNESS_SIZE - 1); alpha stays away
+// from zero, where the lobe is a mirror and E is one anyway
+static Float AlphaAt(int i)
+{
+    Float r = static_cast<Float>(i) / (MicrofacetAlbedo::ROUGHNESS_SIZE - 1);
+    return (std::max)(r * r, static_cast<Float>(1e-3F));
+}
+
+static Float CosThetaAt(int j)
+{
+    return (std::max)(static_cast<Float>(j) / (MicrofacetAlbedo::COS_THETA_SIZE - 1), static_cast<Float>(1e-3F));
+}
+
+// Spaced evenly in log(eta), so eta and 1 / eta sit on mirrored entries
+static Float EtaAt(int k)
+{
+    return MicrofacetAlbedo::ETA_MIN *
+        std::pow(MicrofacetAlbedo::ETA_MAX / MicrofacetAlbedo::ETA_MIN,
+            static_cast<Float>(k) / (MicrofacetAlbedo::ETA_SIZE - 1));
+}
+
+// Index of the table interval holding _x_, clamped to [lo, hi], and the
+// offset _*t_ within it
+static int Locate(Float x, Float lo, Float hi, int size, Float *t)
+{
+    Float f = common::math::Clamp((x - lo) / (hi - lo), FLOAT_0, FLOAT_1) * (size - 1);
+    int i = (std::min)(static_cast<int>(f), size - 2);
+    *t = f - i;
+    return i;
+}
+
+// 2 * integral of E(mu) mu over [0, 1] of one table row, by the trapezoid
+// rule
+static Float Average(const Float *row)
+{
+    Float avg = FLOAT_0;
+    for (int j = 0; j + 1 < MicrofacetAlbedo::COS_THETA_SIZE; ++j)
+    {
+        Float mu0 = static_cast<Float>(j) / (MicrofacetAlbedo::COS_THETA_SIZE - 1);
+        Float mu1 = static_cast<Float>(j + 1) / (MicrofacetAlbedo::COS_THETA_SIZE - 1);
+        avg += (row[j] * mu0 + row[j + 1] * mu1) * (mu1 - mu0);
+    }
+    return avg;
+}
+
+static Float Bilerp(const Float *table, int i, int j, Float ta, Float tc)
+{
+    const Float *r0 = table + i * MicrofacetAlbedo::COS_THETA_SIZE + j;
+    const Float *r1 = r0 + MicrofacetAlbedo::COS_THETA_SIZE;
+    return (FLOAT_1 - ta) * ((FLOAT_1 - tc) * r0[0] + tc * r0[1]) +
+        ta * ((FLOAT_1 - tc) * r1[0] + tc * r1[1]);
+}
+
+
+MicrofacetAlbedo::MicrofacetAlbedo()
+    : e(ROUGHNESS_SIZE * COS_THETA_SIZE),
+    eAvg(ROUGHNESS_SIZE),
+    eDielectric(ETA_SIZE * ROUGHNESS_SIZE * COS_THETA_SIZE),
+    eTransmission(ETA_SIZE * ROUGHNESS_SIZE * COS_THETA_SIZE),
+    eDielectricAvg(ETA_SIZE * ROUGHNESS_SIZE),
+    eTransmissionAvg(ETA_SIZE * ROUGHNESS_SIZE)
+{}
+
+void MicrofacetAlbedo::Init()
+{
+    std::unique_ptr<MicrofacetAlbedo> tr(new MicrofacetAlbedo());
+    tr->Bake<TrowbridgeReitzDistribution>(SQRT_SAMPLE_NUMBER, SQRT_DIELECTRIC_SAMPLE_NUMBER);
+    std::unique_ptr<MicrofacetAlbedo> b(new MicrofacetAlbedo());
+    b->Bake<BeckmannDistribution>(SQRT_SAMPLE_NUMBER, SQRT_DIELECTRIC_SAMPLE_NUMBER);
+
+    trowbridgeReitz = std::move(tr);
+    beckmann = std::move(b);
+}
+
+const MicrofacetAlbedo *MicrofacetAlbedo::TrowbridgeReitz()
+{
+    return trowbridgeReitz.get();
+}
+
+const MicrofacetAlbedo *MicrofacetAlbedo::Beckmann()
+{
+    return beckmann.get();
+}
+
+template <typename Distribution>
+void MicrofacetAlbedo::Bake(int sqrtSamples, int sqrtDielectricSamples)
+{
+    // One task per roughness row and Fresnel term: F = 1 first, then each
+    // eta of the dielectric table
+    common::tool::ParallelFor([&](int64_t task)
+    {
+        int i = static_cast<int>(task % ROUGHNESS_SIZE);
+        int k = static_cast<int>(task / ROUGHNESS_SIZE) - 1;
+        Float alpha = AlphaAt(i);
+        Distribution distribution(alpha, alpha);
+        size_t offset = (k * ROUGHNESS_SIZE + i) * COS_THETA_SIZE;
+        Float *row = k < 0 ? &e[i * COS_THETA_SIZE] : &eDielectric[offset];
+        Float *transmissionRow = k < 0 ? nullptr : &eTransmission[offset];
+        int n = k < 0 ? sqrtSamples : sqrtDielectricSamples;
+        for (int j = 0; j < COS_THETA_SIZE; ++j)
+        {
+            Float cosTheta = CosThetaAt(j);
+            common::math::Vec3f wo(std::sqrt(FLOAT_1 - cosTheta * cosTheta), FLOAT_0, cosTheta);
+            Float g1 = distribution.G1(wo);
+            Float sum = FLOAT_0, transmissionSum = FLOAT_0;
+            for (int a = 0; a < n; ++a)
+            {
+                for (int b = 0; b < n; ++b)
+                {
+                    common::math::Vec2f u((a + FLOAT_INV_2) / n, (b + FLOAT_INV_2) / n);
+                    common::math::Vec3f wh = distribution.Sample_wh(wo, u);
+                    // f cos(theta_i) / pdf reduces to F G / G1 for visible
+                    // normals, and to (1 - F) G / G1 for the refracted
+                    // direction without the radiance scaling
+                    Float F = k < 0 ? FLOAT_1 : FrDielectric(Dot(wo, wh), FLOAT_1, EtaAt(k));
+                    common::math::Vec3f wi = Reflect(wo, wh);
+                    if (wi.z > FLOAT_0)
+                    {
+                        sum += F * distribution.G(wo, wi) / g1;
+                    }
+                    if (k >= 0 && F < FLOAT_1 && Refract(wo, wh, FLOAT_1 / EtaAt(k), &wi) && wi.z < FLOAT_0)
+                    {
+                        transmissionSum += (FLOAT_1 - F) * distribution.G(wo, wi) / g1;
+                    }
+                }
+            }
+            // Sampling noise must not push 1 - E below zero
+            row[j] = (std::min)(sum / (n * n), FLOAT_1);
+            if (k >= 0)
+            {
+                transmissionRow[j] = (std::min)(transmissionSum / (n * n), FLOAT_1 - row[j]);
+            }
+        }
+
+        if (k < 0)
+        {
+            eAvg[i] = Average(row);
+        }
+        else
+        {
+            eDielectricAvg[k * ROUGHNESS_SIZE + i] = Average(row);
+            eTransmissionAvg[k * ROUGHNESS_SIZE + i] = Average(transmissionRow);
+        }
+    }, ROUGHNESS_SIZE * (ETA_SIZE + 1));
+}
+
+Float MicrofacetAlbedo::E(Float alpha, Float cosTheta) const
+{
+    Float ta, tc;
+    int i = Locate(std::sqrt(alpha), FLOAT_0, FLOAT_1, ROUGHNESS_SIZE, &ta);
+    int j = Locate(std::abs(cosTheta), FLOAT_0, FLOAT_1, COS_THETA_SIZE, &tc);
+    return Bilerp(&e[0], i, j, ta, tc);
+}
+
+Float MicrofacetAlbedo::EAvg(Float alpha) const
+{
+    Float ta;
+    int i = Locate(std::sqrt(alpha), FLOAT_0, FLOAT_1, ROUGHNESS_SIZE, &ta);
+    return (FLOAT_1 - ta) * eAvg[i] + ta * eAvg[i + 1];
+}
+
+// Looks _eta_ up in _tables_, ETA_SIZE consecutive roughness by cos(theta)
+// tables
+static Float DielectricLookup(const std::vector<Float> &tables, Float alpha, Float cosTheta, Float eta)
+{
+    const int size = MicrofacetAlbedo::ROUGHNESS_SIZE * MicrofacetAlbedo::COS_THETA_SIZE;
+    Float ta, tc, te;
+    int i = Locate(std::sqrt(alpha), FLOAT_0, FLOAT_1, MicrofacetAlbedo::ROUGHNESS_SIZE, &ta);
+    int j = Locate(std::abs(cosTheta), FLOAT_0, FLOAT_1, MicrofacetAlbedo::COS_THETA_SIZE, &tc);
+    int k = Locate(std::log(eta), std::log(MicrofacetAlbedo::ETA_MIN), std::log(MicrofacetAlbedo::ETA_MAX),
+        MicrofacetAlbedo::ETA_SIZE, &te);
+    const Float *table = &tables[k * size];
+    return (FLOAT_1 - te) * Bilerp(table, i, j, ta, tc) + te * Bilerp(table + size, i, j, ta, tc);
+}
+
+// The same for ETA_SIZE consecutive rows of averages over roughness
+static Float DielectricAvgLookup(const std::vector<Float> &rows, Float alpha, Float eta)
+{
+    Float ta, te;
+    int i = Locate(std::sqrt(alpha), FLOAT_0, FLOAT_1, MicrofacetAlbedo::ROUGHNESS_SIZE, &ta);
+    int k = Locate(std::log(eta), std::log(MicrofacetAlbedo::ETA_MIN), std::log(MicrofacetAlbedo::ETA_MAX),
+        MicrofacetAlbedo::ETA_SIZE, &te);
+    const Float *r0 = &rows[k * MicrofacetAlbedo::ROUGHNESS_SIZE + i];
+    const Float *r1 = r0 + MicrofacetAlbedo::ROUGHNESS_SIZE;
+    return (FLOAT_1 - te) * ((FLOAT_1 - ta) * r0[0] + ta * r0[1]) + te * ((FLOAT_1 - ta) * r1[0] + ta * r1[1]);
+}
+
+Float MicrofacetAlbedo::E(Float alpha, Float cosTheta, Float eta) const
+{
+    return DielectricLookup(eDielectric, alpha, cosTheta, eta);
+}
+
+Float MicrofacetAlbedo::ETransmission(Float alpha, Float cosTheta, Float eta) const
+{
+    return DielectricLookup(eTransmission, alpha, cosTheta, eta);
+}
+
+Float MicrofacetAlbedo::EDielectricTotal(Float alpha, Float cosTheta, Float eta) const
+{
+    return E(alpha, cosTheta, eta) + ETransmission(alpha, cosTheta, eta);
+}
+
+Float MicrofacetAlbedo::EDielectricTotalAvg(Float alpha, Float eta) const
+{
+    return DielectricAvgLookup(eDielectricAvg, alpha, eta) + DielectricAvgLookup(eTransmissionAvg, alpha, eta);
+}
+
+Float MicrofacetAlbedo::DielectricMultipleScatteringAlbedo(Float alpha, Float eta, Float cosThetaO,
+    bool reflect) const
+{
+    Float avg = EDielectricTotalAvg(alpha, eta);
+    Float missing = FLOAT_1 - EDielectricTotal(alpha, cosThetaO, eta);
+    if (missing <= FLOAT_0 || avg <= FLOAT_0)
+    {
+        return FLOAT_0;
+    }
+    // Split as single scattering splits on average
+    Float share = DielectricAvgLookup(eDielectricAvg, alpha, eta) / avg;
+    return (reflect ? share : FLOAT_1 - share) * missing;
+}
+
+Float MicrofacetAlbedo::DielectricMultipleScattering(Float alpha, Float eta, Float cosThetaO, Float cosThetaI,
+    bool reflect) const
+{
+    // Spread over the side _wi_ lies on, where the relative index is
+    // 1 / _eta_ for the refracted share
+    Float etaI = reflect ? eta : FLOAT_1 / eta;
+    Float avgI = EDielectricTotalAvg(alpha, etaI);
+    if (avgI >= FLOAT_1)
+    {
+        return FLOAT_0;
+    }
+    return DielectricMultipleScatteringAlbedo(alpha, eta, cosThetaO, reflect)
+        * (std::max)(FLOAT_0, FLOAT_1 - EDielectricTotal(alpha, cosThetaI, etaI))
+        / (common::math::PI * (FLOAT_1 - avgI));
+}
+
+
+}
+}
+}
\ No newline at end of file
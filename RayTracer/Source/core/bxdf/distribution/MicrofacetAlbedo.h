@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../../../ForwardDeclaration.h"
+#include "../../../common/math/Constants.h"
+#include <memory>
+#include <vector>
+
+namespace core
+{
+namespace bxdf
+{
+namespace distribution
+{
+
+
+// Directional albedo E(mu) of a single scattering microfacet reflection
+// lobe, tabulated over sqrt(alpha) and cos(theta_o), once with a perfect
+// reflector (F = 1) and once per relative index of refraction with a
+// dielectric Fresnel term, along with the albedo of the matching
+// transmission lobe. The F = 1 table and its average drive Kulla and
+// Conty's multiple scattering compensation of opaque lobes, the dielectric
+// ones that of rough dielectric interfaces and the estimate of how much a
+// coating reflects, which BSDF::Sample_f() uses to pick lobes.
+class MicrofacetAlbedo
+{
+public:
+
+    static constexpr int ROUGHNESS_SIZE = 32;
+    static constexpr int COS_THETA_SIZE = 32;
+    static constexpr int ETA_SIZE = 24;
+
+    // Relative indices of refraction etaT / etaI covered by the dielectric
+    // tables; down to 1 / ETA_MAX, so that the inside of an interface
+    // (1 / eta) is covered as well as its outside
+    static constexpr Float ETA_MAX = static_cast<Float>(3.0F);
+    static constexpr Float ETA_MIN = FLOAT_1 / ETA_MAX;
+
+
+    // Bakes the TrowbridgeReitzDistribution and BeckmannDistribution
+    // tables with ParallelFor(); until then materials render without
+    // compensation and BSDFs pick lobes uniformly
+    static void Init();
+
+    static const MicrofacetAlbedo *TrowbridgeReitz();
+
+    static const MicrofacetAlbedo *Beckmann();
+
+
+    Float E(Float alpha, Float cosTheta) const;
+
+    // Cosine-weighted hemispherical average of E(alpha, mu)
+    Float EAvg(Float alpha) const;
+
+    // With FrDielectric(cosThetaI, 1, eta) in the lobe
+    Float E(Float alpha, Float cosTheta, Float eta) const;
+
+    // Albedo of the refraction lobe, 1 - FrDielectric(cosThetaI, 1, eta)
+    // in, without the 1 / eta^2 radiance scaling
+    Float ETransmission(Float alpha, Float cosTheta, Float eta) const;
+
+    // Kulla and Conty's multiple scattering lobe of a rough dielectric
+    // interface seen from the side of _wo_, where the relative index is
+    // _eta_: the energy both single scattering lobes lose at
+    // _cosThetaO_, the share the reflection lobe leaves reflected and the
+    // rest refracted, each spread over _cosThetaI_ like 1 - E of its side
+    Float DielectricMultipleScattering(Float alpha, Float eta, Float cosThetaO, Float cosThetaI,
+        bool reflect) const;
+
+    // What that lobe reflects or refracts in total from _cosThetaO_
+    Float DielectricMultipleScatteringAlbedo(Float alpha, Float eta, Float cosThetaO, bool reflect) const;
+
+private:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    MicrofacetAlbedo();
+
+
+    // Integrates each entry with stratified visible normal samples of
+    // _Distribution_, _sqrtSamples_^2 of them for the F = 1 table and
+    // _sqrtDielectricSamples_^2 for the dielectric ones
+    template <typename Distribution>
+    void Bake(int sqrtSamples, int sqrtDielectricSamples);
+
+    // Reflection plus transmission albedo of a dielectric interface and its
+    // cosine-weighted average
+    Float EDielectricTotal(Float alpha, Float cosTheta, Float eta) const;
+
+    Float EDielectricTotalAvg(Float alpha, Float eta) const;
+
+
+    // F = 1 table and its average, then ETA_SIZE dielectric reflection and
+    // transmission tables and their averages
+    std::vector<Float> e;
+    std::vector<Float> eAvg;
+    std::vector<Float> eDielectric;
+    std::vector<Float> eTransmission;
+    std::vector<Float> eDielectricAvg;
+    std::vector<Float> eTransmissionAvg;
+
+    static std::unique_ptr<MicrofacetAlbedo> trowbridgeReitz;
+    static std::unique_ptr<MicrofacetAlbedo> beckmann;
+};
+
+
+}
+}
+}
\ No newline at end of file
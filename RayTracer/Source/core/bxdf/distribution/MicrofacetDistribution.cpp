@@ -25,6 +25,43 @@ Float MicrofacetDistribution::Pdf(const common::math::Vec3f &wo,
     }
 }
 
+void MicrofacetDistribution::D(const DirectionBatch &wh, Float *d) const
+{
+    for (int i = 0; i < wh.n; ++i)
+    {
+        d[i] = D(wh[i]);
+    }
+}
+
+void MicrofacetDistribution::G(const common::math::Vec3f &wo, const DirectionBatch &wi, Float *g) const
+{
+    for (int i = 0; i < wi.n; ++i)
+    {
+        g[i] = G(wo, wi[i]);
+    }
+}
+
+void MicrofacetDistribution::Pdf(const common::math::Vec3f &wo, const DirectionBatch &wh,
+    Float *pdf) const
+{
+    D(wh, pdf);
+    if (sampleVisibleArea)
+    {
+        Float g1 = G1(wo) / AbsCosTheta(wo);
+        for (int i = 0; i < wh.n; ++i)
+        {
+            pdf[i] *= g1 * std::abs(wo.x * wh.x[i] + wo.y * wh.y[i] + wo.z * wh.z[i]);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < wh.n; ++i)
+        {
+            pdf[i] *= std::abs(wh.z[i]);
+        }
+    }
+}
+
 
 }
 }
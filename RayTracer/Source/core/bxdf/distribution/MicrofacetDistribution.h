@@ -43,6 +43,21 @@ public:
 
     Float Pdf(const common::math::Vec3f &wo, const common::math::Vec3f &wh) const;
 
+    // D(), G() and Pdf() for every direction of a batch; the base versions
+    // call the single direction forms in turn
+    virtual void D(const DirectionBatch &wh, Float *d) const;
+
+    virtual void G(const common::math::Vec3f &wo, const DirectionBatch &wi, Float *g) const;
+
+    void Pdf(const common::math::Vec3f &wo, const DirectionBatch &wh, Float *pdf) const;
+
+    // The baked albedo table for this kind of distribution and the
+    // isotropic alpha to look it up with; nullptr when there is none
+    virtual const MicrofacetAlbedo *AlbedoTable(Float *alpha) const
+    {
+        return nullptr;
+    }
+
 protected:
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -52,7 +52,7 @@ static void TrowbridgeReitzSample11(Float cosTheta, Float U1, Float U2,
     Float z = (U2 * (U2 * (U2 * static_cast<Float>(0.27385F) - static_cast<Float>(0.73369F))
             + static_cast<Float>(0.46341F))) /
         (U2 * (U2 * (U2 * static_cast<Float>(0.093073F) + static_cast<Float>(0.309420F))
-            - FLOAT_1 + static_cast<Float>(0.597999F)));
+            - FLOAT_1) + static_cast<Float>(0.597999F));
     *slope_y = S * z * std::sqrt(FLOAT_1 + *slope_x * *slope_x);
 
     CHECK(!std::isinf(*slope_y));
@@ -95,6 +95,34 @@ Float TrowbridgeReitzDistribution::D(const common::math::Vec3f &wh) const
     return FLOAT_1 / (common::math::PI * alphax * alphay * cos4Theta * (FLOAT_1 + e) * (FLOAT_1 + e));
 }
 
+void TrowbridgeReitzDistribution::D(const DirectionBatch &wh, Float *d) const
+{
+    const Float invAlphax2 = FLOAT_1 / (alphax * alphax), invAlphay2 = FLOAT_1 / (alphay * alphay);
+    const Float scale = FLOAT_1 / (common::math::PI * alphax * alphay);
+    for (int i = 0; i < wh.n; ++i)
+    {
+        Float cos2Theta = wh.z[i] * wh.z[i];
+        Float e = (wh.x[i] * wh.x[i] * invAlphax2 + wh.y[i] * wh.y[i] * invAlphay2) / cos2Theta;
+        Float denom = cos2Theta * cos2Theta * (FLOAT_1 + e) * (FLOAT_1 + e);
+        // Grazing _wh_ (tan2Theta infinite) has no microfacets
+        d[i] = cos2Theta > FLOAT_0 ? scale / denom : FLOAT_0;
+    }
+}
+
+void TrowbridgeReitzDistribution::G(const common::math::Vec3f &wo, const DirectionBatch &wi, Float *g) const
+{
+    const Float alphax2 = alphax * alphax, alphay2 = alphay * alphay;
+    const Float lambdaO = Lambda(wo);
+    for (int i = 0; i < wi.n; ++i)
+    {
+        Float cos2Theta = wi.z[i] * wi.z[i];
+        Float alpha2Tan2Theta = (wi.x[i] * wi.x[i] * alphax2 + wi.y[i] * wi.y[i] * alphay2) / cos2Theta;
+        Float lambdaI = cos2Theta > FLOAT_0 ?
+            (-FLOAT_1 + std::sqrt(FLOAT_1 + alpha2Tan2Theta)) * FLOAT_INV_2 : FLOAT_0;
+        g[i] = FLOAT_1 / (FLOAT_1 + lambdaO + lambdaI);
+    }
+}
+
 Float TrowbridgeReitzDistribution::Lambda(const common::math::Vec3f &w) const
 {
     Float absTanTheta = std::abs(TanTheta(w));
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MicrofacetDistribution.h"
+#include "MicrofacetAlbedo.h"
 
 namespace core
 {
@@ -37,8 +38,22 @@ public:
 
     Float D(const common::math::Vec3f &wh) const;
 
+    // Cos2Phi() tan^2 is x^2 / z^2 for a unit vector, which leaves these
+    // without trigonometry or branches
+    void D(const DirectionBatch &wh, Float *d) const;
+
+    using MicrofacetDistribution::G;
+
+    void G(const common::math::Vec3f &wo, const DirectionBatch &wi, Float *g) const;
+
     common::math::Vec3f Sample_wh(const common::math::Vec3f &wo, const common::math::Vec2f &u) const;
 
+    const MicrofacetAlbedo *AlbedoTable(Float *alpha) const
+    {
+        *alpha = std::sqrt(alphax * alphay);
+        return MicrofacetAlbedo::TrowbridgeReitz();
+    }
+
 private:
 
     Float Lambda(const common::math::Vec3f &w) const;
@@ -6,6 +6,7 @@
 #include "../../common/math/Constants.h"
 #include "../../common/math/Ray.h"
 #include "../../common/math/RayDifferential.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -16,7 +17,7 @@ namespace camera
 Float EnvironmentCamera::GenerateRay(const CameraSample &sample,
     common::math::Rayf *ray) const
 {
-    //ProfilePhase prof(Prof::GenerateCameraRay);
+    common::tool::ProfilePhase prof(common::tool::Prof::GenerateCameraRay);
     // Compute environment camera ray direction
     Float theta = common::math::PI * sample.pFilm.y / film->fullResolution.y;
     Float phi = FLOAT_2 * common::math::PI * sample.pFilm.x / film->fullResolution.x;
@@ -6,6 +6,7 @@
 #include "../../common/math/Constants.h"
 #include "../../common/math/Ray.h"
 #include "../../common/math/RayDifferential.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -16,7 +17,7 @@ namespace camera
 Float OrthographicCamera::GenerateRay(const CameraSample &sample,
     common::math::Rayf *ray) const
 {
-    //ProfilePhase prof(Prof::GenerateCameraRay);
+    common::tool::ProfilePhase prof(common::tool::Prof::GenerateCameraRay);
     // Compute raster and camera sample positions
     common::math::Vec3f pFilm = common::math::Vec3f(sample.pFilm.x, sample.pFilm.y, FLOAT_0);
     common::math::Vec3f pCamera = RasterToCamera(pFilm);
@@ -45,7 +46,7 @@ Float OrthographicCamera::GenerateRay(const CameraSample &sample,
 Float OrthographicCamera::GenerateRayDifferential(const CameraSample &sample,
     common::math::RayDifferentialf *ray) const
 {
-    //ProfilePhase prof(Prof::GenerateCameraRay);
+    common::tool::ProfilePhase prof(common::tool::Prof::GenerateCameraRay);
     // Compute main orthographic viewing ray
 
     // Compute raster and camera sample positions
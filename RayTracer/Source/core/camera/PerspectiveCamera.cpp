@@ -8,6 +8,7 @@
 #include "../../common/math/Ray.h"
 #include "../../common/math/RayDifferential.h"
 #include "../../common/math/Vec3.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -44,7 +45,7 @@ PerspectiveCamera::PerspectiveCamera(const common::math::AnimatedTransformf &Cam
 Float PerspectiveCamera::GenerateRay(const CameraSample &sample,
     common::math::Rayf *ray) const
 {
-    //ProfilePhase prof(Prof::GenerateCameraRay);
+    common::tool::ProfilePhase prof(common::tool::Prof::GenerateCameraRay);
     // Compute raster and camera sample positions
     common::math::Vec3f pFilm = common::math::Vec3f(sample.pFilm.x, sample.pFilm.y, FLOAT_0);
     common::math::Vec3f pCamera = RasterToCamera(pFilm);
@@ -73,7 +74,7 @@ Float PerspectiveCamera::GenerateRay(const CameraSample &sample,
 Float PerspectiveCamera::GenerateRayDifferential(const CameraSample &sample,
     common::math::RayDifferentialf *ray) const
 {
-    //ProfilePhase prof(Prof::GenerateCameraRay);
+    common::tool::ProfilePhase prof(common::tool::Prof::GenerateCameraRay);
     // Compute raster and camera sample positions
     common::math::Vec3f pFilm = common::math::Vec3f(sample.pFilm.x, sample.pFilm.y, FLOAT_0);
     common::math::Vec3f pCamera = RasterToCamera(pFilm);
@@ -202,7 +203,7 @@ core::color::Spectrum PerspectiveCamera::Sample_Wi(const core::interaction::Inte
 {
     // Uniformly sample a lens interaction _lensIntr_
     common::math::Vec2f pLens = lensRadius * sampler::ConcentricSampleDisk(u);
-    common::math::Vec3f pLensWorld = CameraToWorld(ref.time, common::math::Vec3f(pLens.x, pLens.y, FLOAT_0));
+    common::math::Vec3f pLensWorld = CameraToWorld.ApplyPoint(ref.time, common::math::Vec3f(pLens.x, pLens.y, FLOAT_0));
     core::interaction::Interaction lensIntr(pLensWorld, ref.time, medium);
     lensIntr.n = common::math::Vec3f(CameraToWorld(ref.time, common::math::Vec3f(FLOAT_0, FLOAT_0, FLOAT_1)));
 
@@ -9,6 +9,7 @@
 #include "../../common/math/RayDifferential.h"
 #include "../../common/math/Transform.h"
 #include "../../common/tool/MultiThread.h"
+#include "../../common/tool/Stats.h"
 #include <array>
 
 namespace core
@@ -793,7 +794,7 @@ void RealisticCamera::TestExitPupilBounds() const
 
 Float RealisticCamera::GenerateRay(const CameraSample &sample, common::math::Rayf *ray) const
 {
-    //ProfilePhase prof(Prof::GenerateCameraRay);
+    common::tool::ProfilePhase prof(common::tool::Prof::GenerateCameraRay);
     //++totalRays;
     // Find point on film, _pFilm_, corresponding to _sample.pFilm_
     common::math::Vec2f s(sample.pFilm.x / film->fullResolution.x,
@@ -3,6 +3,7 @@
 #include <vector>
 #include "../../common/math/Constants.h"
 #include "ColorExtern.h"
+#include "SpectrumLane.h"
 
 namespace core
 {
@@ -10,12 +11,20 @@ namespace color
 {
 
 
+// Samples are stored padded to a whole number of SIMD lanes. The padding
+// always holds zero, so lane-wide arithmetic that maps zero to zero leaves
+// it alone; the few operations that do not clear it afterwards.
 template<int SPECTRUM_SAMPLES_NUMBER>
 class CoefficientSpectrum
 {
+    typedef typename SpectrumLaneFor<SPECTRUM_SAMPLES_NUMBER>::Type Lane;
+
 public:
     static const int SAMPLE_NUMBER = SPECTRUM_SAMPLES_NUMBER;
 
+    static const int PADDED_SAMPLE_NUMBER =
+        (SPECTRUM_SAMPLES_NUMBER + Lane::WIDTH - 1) / Lane::WIDTH * Lane::WIDTH;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Construction
     ////////////////////////////////////////////////////////////////////////////////
@@ -26,49 +35,30 @@ public:
         {
             c[i] = v;
         }
+        ClearPadding();
     }
 
-    CoefficientSpectrum(const CoefficientSpectrum &s)
-    {
-        Clone(s);
-    }
+    CoefficientSpectrum(const CoefficientSpectrum &s) = default;
 
-    CoefficientSpectrum &operator=(const CoefficientSpectrum &s)
-    {
-        Clone(s);
-        return *this;
-    }
-
-    __forceinline
-        void Clone(const CoefficientSpectrum &s)
-    {
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
-        {
-            (*this)[i] = s[i];
-        }
-    }
+    CoefficientSpectrum &operator=(const CoefficientSpectrum &s) = default;
 
 
-    __forceinline
-        const Float& operator [](const size_t index) const
+    const Float& operator [](const size_t index) const
     {
-        CHECK_LT(index, SPECTRUM_SAMPLES_NUMBER);
         return c[index];
     }
 
-    __forceinline
-        Float& operator [](const size_t index)
+    Float& operator [](const size_t index)
     {
-        CHECK_LT(index, SPECTRUM_SAMPLES_NUMBER);
         return c[index];
     }
 
 
     bool IsBlack() const
     {
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            if (FLOAT_0 != c[i])
+            if (!Lane::Load(c + i).AllZero())
             {
                 return false;
             }
@@ -84,69 +74,100 @@ public:
 
     bool operator==(const CoefficientSpectrum &s2) const
     {
-        CoefficientSpectrum s1 = *this;
         for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
         {
-            if (s1[i] != s2[i])
+            if (c[i] != s2.c[i])
             {
                 return false;
             }
         }
 
-        return s1;
+        return true;
     }
 
     bool operator!=(const CoefficientSpectrum &s2) const
     {
-        CoefficientSpectrum s1 = *this;
-        return !(s1 == s2);
+        return !(*this == s2);
     }
 
     ////////////////////////////////////////////////////////////////////////////////
     // Assignment Operators
     ////////////////////////////////////////////////////////////////////////////////
 
-    CoefficientSpectrum operator+=(const CoefficientSpectrum &s2)
+    CoefficientSpectrum &operator+=(const CoefficientSpectrum &s2)
     {
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] += s2[i];
+            (Lane::Load(c + i) + Lane::Load(s2.c + i)).Store(c + i);
         }
 
-        return ret;
+        return *this;
     }
 
-    CoefficientSpectrum operator*=(const CoefficientSpectrum &s2)
+    CoefficientSpectrum &operator*=(const CoefficientSpectrum &s2)
     {
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] *= s2[i];
+            (Lane::Load(c + i) * Lane::Load(s2.c + i)).Store(c + i);
         }
 
-        return ret;
+        return *this;
     }
 
-    CoefficientSpectrum operator*=(const Float &a)
+    CoefficientSpectrum &operator*=(const Float &a)
     {
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        Lane la = Lane::Set(a);
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] *= a;
+            (Lane::Load(c + i) * la).Store(c + i);
         }
 
-        return ret;
+        return *this;
     }
 
-    CoefficientSpectrum operator/=(const Float &a)
+    CoefficientSpectrum &operator/=(const Float &a)
     {
         CHECK_NE(a, FLOAT_0);
 
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        Lane la = Lane::Set(a);
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
+        {
+            (Lane::Load(c + i) / la).Store(c + i);
+        }
+
+        return *this;
+    }
+
+    // *this *= s2 * a in a single pass, e.g. beta *= f * AbsDot(wi, n) / pdf
+    CoefficientSpectrum &MulScaled(const CoefficientSpectrum &s2, Float a)
+    {
+        Lane la = Lane::Set(a);
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
+        {
+            (Lane::Load(c + i) * (Lane::Load(s2.c + i) * la)).Store(c + i);
+        }
+
+        return *this;
+    }
+
+    // *this += s1 * s2 in a single pass, e.g. L += beta * Le
+    CoefficientSpectrum &AddProduct(const CoefficientSpectrum &s1, const CoefficientSpectrum &s2)
+    {
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
+        {
+            (Lane::Load(c + i) + Lane::Load(s1.c + i) * Lane::Load(s2.c + i)).Store(c + i);
+        }
+
+        return *this;
+    }
+
+    CoefficientSpectrum operator-() const
+    {
+        CoefficientSpectrum ret(Uninitialized{});
+        Lane zero = Lane::Set(FLOAT_0);
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] /= a;
+            (zero - Lane::Load(c + i)).Store(ret.c + i);
         }
 
         return ret;
@@ -158,10 +179,10 @@ public:
 
     CoefficientSpectrum operator+(const CoefficientSpectrum &s2) const
     {
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        CoefficientSpectrum ret(Uninitialized{});
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] += s2[i];
+            (Lane::Load(c + i) + Lane::Load(s2.c + i)).Store(ret.c + i);
         }
 
         return ret;
@@ -169,10 +190,10 @@ public:
 
     CoefficientSpectrum operator-(const CoefficientSpectrum &s2) const
     {
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        CoefficientSpectrum ret(Uninitialized{});
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] -= s2[i];
+            (Lane::Load(c + i) - Lane::Load(s2.c + i)).Store(ret.c + i);
         }
 
         return ret;
@@ -182,21 +203,23 @@ public:
     {
         CHECK(!s2.IsBlack());
 
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        CoefficientSpectrum ret(Uninitialized{});
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] /= s2[i];
+            (Lane::Load(c + i) / Lane::Load(s2.c + i)).Store(ret.c + i);
         }
+        // 0 / 0 in the padding
+        ret.ClearPadding();
 
         return ret;
     }
 
     CoefficientSpectrum operator*(const CoefficientSpectrum &s2) const
     {
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        CoefficientSpectrum ret(Uninitialized{});
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] *= s2[i];
+            (Lane::Load(c + i) * Lane::Load(s2.c + i)).Store(ret.c + i);
         }
 
         return ret;
@@ -204,10 +227,11 @@ public:
 
     CoefficientSpectrum operator*(const Float &a) const
     {
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        CoefficientSpectrum ret(Uninitialized{});
+        Lane la = Lane::Set(a);
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] *= a;
+            (Lane::Load(c + i) * la).Store(ret.c + i);
         }
 
         return ret;
@@ -223,10 +247,11 @@ public:
     {
         CHECK_NE(a, FLOAT_0);
 
-        CoefficientSpectrum ret = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        CoefficientSpectrum ret(Uninitialized{});
+        Lane la = Lane::Set(a);
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] /= a;
+            (Lane::Load(c + i) / la).Store(ret.c + i);
         }
 
         return ret;
@@ -238,31 +263,60 @@ public:
 
     friend
         CoefficientSpectrum Sqrt(const CoefficientSpectrum &s)
+    {
+        CoefficientSpectrum ret(Uninitialized{});
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
+        {
+            Sqrt(Lane::Load(s.c + i)).Store(ret.c + i);
+        }
+        return ret;
+    }
+
+    friend
+        CoefficientSpectrum Exp(const CoefficientSpectrum &s)
     {
         CoefficientSpectrum ret;
         for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
         {
-            ret[i] = std::sqrt(s[i]);
+            ret.c[i] = std::exp(s.c[i]);
         }
         return ret;
     }
 
     CoefficientSpectrum Clamp(Float low = 0, Float high = (std::numeric_limits<Float>::max)()) const
     {
-        CoefficientSpectrum ret;
-        CoefficientSpectrum s = *this;
-        for (int i = 0; i < SPECTRUM_SAMPLES_NUMBER; ++i)
+        CoefficientSpectrum ret(Uninitialized{});
+        Lane lo = Lane::Set(low), hi = Lane::Set(high);
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            ret[i] = common::math::Clamp(s[i], low, high);
+            Min(Max(Lane::Load(c + i), lo), hi).Store(ret.c + i);
         }
+        ret.ClearPadding();
 
         return ret;
     }
 
     Float MaxComponentValue() const
     {
-        Float m = c[0];
-        for (int i = 1; i < SAMPLE_NUMBER; ++i)
+        // Whole lanes first, then the samples sharing a lane with padding
+        const int wholeLanes = SPECTRUM_SAMPLES_NUMBER / Lane::WIDTH * Lane::WIDTH;
+        Float m;
+        int i;
+        if (wholeLanes > 0)
+        {
+            Lane lm = Lane::Load(c);
+            for (i = Lane::WIDTH; i < wholeLanes; i += Lane::WIDTH)
+            {
+                lm = Max(lm, Lane::Load(c + i));
+            }
+            m = lm.MaxLane();
+        }
+        else
+        {
+            m = c[0];
+            i = 1;
+        }
+        for (; i < SPECTRUM_SAMPLES_NUMBER; ++i)
         {
             m = (std::max)(m, c[i]);
         }
@@ -271,9 +325,9 @@ public:
 
     bool HasNaNs() const
     {
-        for (int i = 0; i < SAMPLE_NUMBER; ++i)
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
         {
-            if (std::isnan(c[i]))
+            if (Lane::Load(c + i).AnyNaN())
             {
                 return true;
             }
@@ -282,7 +336,26 @@ public:
     }
 
 protected:
-    Float c[SPECTRUM_SAMPLES_NUMBER];
+
+    struct Uninitialized
+    {};
+
+    // Every sample is written by the caller
+    explicit CoefficientSpectrum(Uninitialized)
+    {}
+
+    void ClearPadding()
+    {
+        for (int i = SPECTRUM_SAMPLES_NUMBER; i < PADDED_SAMPLE_NUMBER; ++i)
+        {
+            c[i] = FLOAT_0;
+        }
+    }
+
+
+    // Only Float aligned: lanes load and store unaligned, so spectra keep
+    // their place in MemoryArena blocks and in the BxDFs allocated there
+    Float c[PADDED_SAMPLE_NUMBER];
 };
 
 
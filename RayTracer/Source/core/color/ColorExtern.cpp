@@ -1014,8 +1014,7 @@ Float InterpolateSpectrumSamples(const Float *lambda, const Float *vals, int n,
     {
         return vals[n - 1];
     }
-    int offset = 0;
-    common::math::FindInterval(n, [&](int index)
+    int offset = common::math::FindInterval(n, [&](int index)
     {
         return lambda[index] <= l;
     });
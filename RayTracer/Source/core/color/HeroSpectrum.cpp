@@ -0,0 +1,209 @@
+#include "HeroSpectrum.h"
+#include "RGBToSpectrumTable.h"
+
+namespace core
+{
+namespace color
+{
+
+
+enum RGBBasis
+{
+    White,
+    Cyan,
+    Magenta,
+    Yellow,
+    Red,
+    Green,
+    Blue
+};
+
+
+Float HeroSpectrum::rgbRefl2Spect[7][HERO_TABLE_SIZE];
+Float HeroSpectrum::rgbIllum2Spect[7][HERO_TABLE_SIZE];
+
+
+// Linear lookup into a table sampled every nanometer from _lambdaStart_
+static inline
+Float LookupTable(const Float *table, int size, Float lambdaStart, Float lambda)
+{
+    Float t = common::math::Clamp(lambda - lambdaStart, FLOAT_0, static_cast<Float>(size - 1));
+    int i = (std::min)(static_cast<int>(t), size - 2);
+    return common::math::Lerp(t - i, table[i], table[i + 1]);
+}
+
+
+void HeroSpectrum::Init()
+{
+    const Float *refl[7] = {RGB_REFL_2_SPECT_WHITE, RGB_REFL_2_SPECT_CYAN,
+        RGB_REFL_2_SPECT_MAGENTA, RGB_REFL_2_SPECT_YELLOW, RGB_REFL_2_SPECT_RED,
+        RGB_REFL_2_SPECT_GREEN, RGB_REFL_2_SPECT_BLUE};
+    const Float *illum[7] = {RGB_ILLUM_2_SPECT_WHITE, RGB_ILLUM_2_SPECT_CYAN,
+        RGB_ILLUM_2_SPECT_MAGENTA, RGB_ILLUM_2_SPECT_YELLOW, RGB_ILLUM_2_SPECT_RED,
+        RGB_ILLUM_2_SPECT_GREEN, RGB_ILLUM_2_SPECT_BLUE};
+
+    for (int b = 0; b < 7; ++b)
+    {
+        for (int i = 0; i < HERO_TABLE_SIZE; ++i)
+        {
+            Float lambda = static_cast<Float>(SAMPLED_LAMBDA_START + i);
+            rgbRefl2Spect[b][i] = InterpolateSpectrumSamples(RGB_2_SPECT_LAMBDA, refl[b],
+                RGB_2_SPECT_SAMPLES_NUMBER, lambda);
+            rgbIllum2Spect[b][i] = InterpolateSpectrumSamples(RGB_2_SPECT_LAMBDA, illum[b],
+                RGB_2_SPECT_SAMPLES_NUMBER, lambda);
+        }
+    }
+}
+
+HeroSpectrum HeroSpectrum::FromRGB(const Float rgb[3], const SampledWavelengths &lambda, SpectrumType type)
+{
+    HeroSpectrum r;
+    const RGBToSpectrumTable *table = GetRGBToSpectrumTable();
+    if (SpectrumType::Reflectance == type && nullptr != table)
+    {
+        Float scale;
+        SigmoidPolynomial polynomial = table->Lookup(rgb, &scale);
+        for (int i = 0; i < HERO_WAVELENGTHS_NUMBER; ++i)
+        {
+            r.c[i] = scale * polynomial(lambda[i]);
+        }
+        return r;
+    }
+
+    // Same split as _SampledSpectrum::FromRGB()_: white for the smallest
+    // channel, then one secondary and one primary basis spectrum
+    int secondary, primary;
+    Float wWhite, wSecondary, wPrimary;
+    if (rgb[0] <= rgb[1] && rgb[0] <= rgb[2])
+    {
+        wWhite = rgb[0];
+        secondary = Cyan;
+        if (rgb[1] <= rgb[2])
+        {
+            wSecondary = rgb[1] - rgb[0];
+            primary = Blue;
+            wPrimary = rgb[2] - rgb[1];
+        }
+        else
+        {
+            wSecondary = rgb[2] - rgb[0];
+            primary = Green;
+            wPrimary = rgb[1] - rgb[2];
+        }
+    }
+    else if (rgb[1] <= rgb[0] && rgb[1] <= rgb[2])
+    {
+        wWhite = rgb[1];
+        secondary = Magenta;
+        if (rgb[0] <= rgb[2])
+        {
+            wSecondary = rgb[0] - rgb[1];
+            primary = Blue;
+            wPrimary = rgb[2] - rgb[0];
+        }
+        else
+        {
+            wSecondary = rgb[2] - rgb[1];
+            primary = Red;
+            wPrimary = rgb[0] - rgb[2];
+        }
+    }
+    else
+    {
+        wWhite = rgb[2];
+        secondary = Yellow;
+        if (rgb[0] <= rgb[1])
+        {
+            wSecondary = rgb[0] - rgb[2];
+            primary = Green;
+            wPrimary = rgb[1] - rgb[0];
+        }
+        else
+        {
+            wSecondary = rgb[1] - rgb[2];
+            primary = Red;
+            wPrimary = rgb[0] - rgb[1];
+        }
+    }
+
+    bool reflectance = SpectrumType::Reflectance == type;
+    const Float (*basis)[HERO_TABLE_SIZE] = reflectance ? rgbRefl2Spect : rgbIllum2Spect;
+    Float scale = reflectance ? static_cast<Float>(0.94F) : static_cast<Float>(0.86445F);
+    const Float lambdaStart = static_cast<Float>(SAMPLED_LAMBDA_START);
+
+    for (int i = 0; i < HERO_WAVELENGTHS_NUMBER; ++i)
+    {
+        Float v = wWhite * LookupTable(basis[White], HERO_TABLE_SIZE, lambdaStart, lambda[i]) +
+            wSecondary * LookupTable(basis[secondary], HERO_TABLE_SIZE, lambdaStart, lambda[i]) +
+            wPrimary * LookupTable(basis[primary], HERO_TABLE_SIZE, lambdaStart, lambda[i]);
+        r.c[i] = (std::max)(FLOAT_0, scale * v);
+    }
+    return r;
+}
+
+HeroSpectrum HeroSpectrum::FromSpectrum(const SampledSpectrum &s, const SampledWavelengths &lambda,
+    SpectrumType type)
+{
+    const Float binsPerNm = static_cast<Float>(SPECTRAL_SAMPLES_NUMBER)
+        / static_cast<Float>(SAMPLED_LAMBDA_END - SAMPLED_LAMBDA_START);
+
+    HeroSpectrum r;
+    for (int i = 0; i < HERO_WAVELENGTHS_NUMBER; ++i)
+    {
+        int bin = static_cast<int>((lambda[i] - SAMPLED_LAMBDA_START) * binsPerNm);
+        r.c[i] = s[common::math::Clamp(bin, 0, SPECTRAL_SAMPLES_NUMBER - 1)];
+    }
+    return r;
+}
+
+HeroSpectrum HeroSpectrum::FromSpectrum(const RGBSpectrum &s, const SampledWavelengths &lambda,
+    SpectrumType type)
+{
+    Float rgb[3];
+    s.ToRGB(rgb);
+    return FromRGB(rgb, lambda, type);
+}
+
+
+void HeroSpectrum::ToXYZ(const SampledWavelengths &lambda, Float xyz[3]) const
+{
+    const Float cieStart = CIE_lambda[0];
+
+    xyz[0] = xyz[1] = xyz[2] = FLOAT_0;
+    for (int i = 0; i < HERO_WAVELENGTHS_NUMBER; ++i)
+    {
+        // Terminated secondary wavelengths carry no weight
+        if (FLOAT_0 == lambda.Pdf(i))
+        {
+            continue;
+        }
+        Float v = c[i] / lambda.Pdf(i);
+        xyz[0] += v * LookupTable(CIE_X, CIE_SAMPLES_NUMBER, cieStart, lambda[i]);
+        xyz[1] += v * LookupTable(CIE_Y, CIE_SAMPLES_NUMBER, cieStart, lambda[i]);
+        xyz[2] += v * LookupTable(CIE_Z, CIE_SAMPLES_NUMBER, cieStart, lambda[i]);
+    }
+
+    Float scale = FLOAT_1 / static_cast<Float>(CIE_Y_INTEGRAL * HERO_WAVELENGTHS_NUMBER);
+    xyz[0] *= scale;
+    xyz[1] *= scale;
+    xyz[2] *= scale;
+}
+
+Float HeroSpectrum::y(const SampledWavelengths &lambda) const
+{
+    const Float cieStart = CIE_lambda[0];
+
+    Float yy = FLOAT_0;
+    for (int i = 0; i < HERO_WAVELENGTHS_NUMBER; ++i)
+    {
+        if (FLOAT_0 != lambda.Pdf(i))
+        {
+            yy += c[i] / lambda.Pdf(i) * LookupTable(CIE_Y, CIE_SAMPLES_NUMBER, cieStart, lambda[i]);
+        }
+    }
+    return yy / static_cast<Float>(CIE_Y_INTEGRAL * HERO_WAVELENGTHS_NUMBER);
+}
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "CoefficientSpectrum.h"
+#include "Spectrum.h"
+#include "SampledSpectrum.h"
+
+namespace core
+{
+namespace color
+{
+
+
+// Wavelengths traced together along one path; 8 also fits a 256-bit register
+#ifndef HERO_WAVELENGTHS_NUMBER
+#define HERO_WAVELENGTHS_NUMBER 4
+#endif
+
+#define HERO_TABLE_SIZE (SAMPLED_LAMBDA_END - SAMPLED_LAMBDA_START + 1)
+
+
+// A hero wavelength sampled uniformly over the visible range plus companions
+// spaced evenly after it, wrapping around at the end of the range
+class SampledWavelengths
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    SampledWavelengths()
+    {
+        for (int i = 0; i < HERO_WAVELENGTHS_NUMBER; ++i)
+        {
+            lambda[i] = FLOAT_0;
+            pdf[i] = FLOAT_0;
+        }
+    }
+
+
+    static SampledWavelengths SampleUniform(Float u)
+    {
+        const Float lambdaMin = static_cast<Float>(SAMPLED_LAMBDA_START);
+        const Float lambdaMax = static_cast<Float>(SAMPLED_LAMBDA_END);
+        const Float delta = (lambdaMax - lambdaMin) / HERO_WAVELENGTHS_NUMBER;
+
+        SampledWavelengths swl;
+        swl.lambda[0] = common::math::Lerp(u, lambdaMin, lambdaMax);
+        for (int i = 1; i < HERO_WAVELENGTHS_NUMBER; ++i)
+        {
+            swl.lambda[i] = swl.lambda[i - 1] + delta;
+            if (swl.lambda[i] > lambdaMax)
+            {
+                swl.lambda[i] = lambdaMin + (swl.lambda[i] - lambdaMax);
+            }
+        }
+        for (int i = 0; i < HERO_WAVELENGTHS_NUMBER; ++i)
+        {
+            swl.pdf[i] = FLOAT_1 / (lambdaMax - lambdaMin);
+        }
+        return swl;
+    }
+
+
+    Float operator[](int i) const
+    {
+        return lambda[i];
+    }
+
+    Float Pdf(int i) const
+    {
+        return pdf[i];
+    }
+
+    // Keeps only the hero wavelength, once the path took a direction that
+    // depends on it (dispersion)
+    void TerminateSecondary()
+    {
+        if (SecondaryTerminated())
+        {
+            return;
+        }
+        for (int i = 1; i < HERO_WAVELENGTHS_NUMBER; ++i)
+        {
+            pdf[i] = FLOAT_0;
+        }
+        pdf[0] /= HERO_WAVELENGTHS_NUMBER;
+    }
+
+    bool SecondaryTerminated() const
+    {
+        for (int i = 1; i < HERO_WAVELENGTHS_NUMBER; ++i)
+        {
+            if (FLOAT_0 != pdf[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    Float lambda[HERO_WAVELENGTHS_NUMBER];
+    Float pdf[HERO_WAVELENGTHS_NUMBER];
+};
+
+
+// Spectral values at the wavelengths of a _SampledWavelengths_
+class HeroSpectrum : public CoefficientSpectrum<HERO_WAVELENGTHS_NUMBER>
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    HeroSpectrum(Float v = FLOAT_0) : CoefficientSpectrum<HERO_WAVELENGTHS_NUMBER>(v)
+    {}
+
+    HeroSpectrum(const CoefficientSpectrum<HERO_WAVELENGTHS_NUMBER> &v)
+        : CoefficientSpectrum<HERO_WAVELENGTHS_NUMBER>(v)
+    {}
+
+
+    // Tabulates the RGB basis spectra at 1nm; call once at startup
+    static void Init();
+
+    // Upsamples _rgb_ at each wavelength from the tabulated basis spectra
+    static HeroSpectrum FromRGB(const Float rgb[3], const SampledWavelengths &lambda,
+        SpectrumType type = SpectrumType::Reflectance);
+
+    // Reads the bins of _s_ that hold each wavelength
+    static HeroSpectrum FromSpectrum(const SampledSpectrum &s, const SampledWavelengths &lambda,
+        SpectrumType type = SpectrumType::Reflectance);
+
+    static HeroSpectrum FromSpectrum(const RGBSpectrum &s, const SampledWavelengths &lambda,
+        SpectrumType type = SpectrumType::Reflectance);
+
+
+    // Monte Carlo estimate of CIE XYZ, weighting each wavelength by the
+    // matching functions over its pdf
+    void ToXYZ(const SampledWavelengths &lambda, Float xyz[3]) const;
+
+    Float y(const SampledWavelengths &lambda) const;
+
+private:
+    static Float rgbRefl2Spect[7][HERO_TABLE_SIZE];
+    static Float rgbIllum2Spect[7][HERO_TABLE_SIZE];
+};
+
+
+// Lets an integrator templated on the spectrum it carries along a path take
+// dense BSDF and light values as they are, or at the path's wavelengths
+template <typename S>
+S AtWavelengths(const Spectrum &s, const SampledWavelengths &lambda,
+    SpectrumType type = SpectrumType::Reflectance);
+
+template <>
+inline
+Spectrum AtWavelengths<Spectrum>(const Spectrum &s, const SampledWavelengths &lambda, SpectrumType type)
+{
+    return s;
+}
+
+template <>
+inline
+HeroSpectrum AtWavelengths<HeroSpectrum>(const Spectrum &s, const SampledWavelengths &lambda, SpectrumType type)
+{
+    return HeroSpectrum::FromSpectrum(s, lambda, type);
+}
+
+
+inline
+Float Luminance(const Spectrum &s, const SampledWavelengths &lambda)
+{
+    return s.y();
+}
+
+inline
+Float Luminance(const HeroSpectrum &s, const SampledWavelengths &lambda)
+{
+    return s.y(lambda);
+}
+
+
+}
+}
\ No newline at end of file
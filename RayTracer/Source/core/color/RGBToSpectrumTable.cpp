@@ -0,0 +1,414 @@
+#include "RGBToSpectrumTable.h"
+#include "ColorExtern.h"
+#include "../../common/tool/MultiThread.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace core
+{
+namespace color
+{
+
+
+static std::unique_ptr<RGBToSpectrumTable> rgbToSpectrumTable;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Optimization
+////////////////////////////////////////////////////////////////////////////////
+
+// Wavelength step of the quadrature used while fitting, in nm
+static const int FIT_LAMBDA_STEP = 5;
+static const int FIT_SAMPLES_NUMBER = (SAMPLED_LAMBDA_END - SAMPLED_LAMBDA_START) / FIT_LAMBDA_STEP + 1;
+
+// The fit runs on wavelengths mapped to [0, 1], which keeps the three
+// coefficients at similar scales
+struct FitTables
+{
+    double lambda[FIT_SAMPLES_NUMBER];
+    // Quadrature weight times the CIE matching functions
+    double xyzWeight[FIT_SAMPLES_NUMBER][3];
+    // XYZ of the constant spectrum 1, the CIELAB white point
+    double whiteXYZ[3];
+};
+
+static FitTables MakeFitTables()
+{
+    FitTables tables;
+    const Float cieStart = CIE_lambda[0];
+    for (int k = 0; k < FIT_SAMPLES_NUMBER; ++k)
+    {
+        int nm = SAMPLED_LAMBDA_START + k * FIT_LAMBDA_STEP;
+        int cie = static_cast<int>(nm - cieStart);
+        // Trapezoid rule, normalized the way SampledSpectrum::ToXYZ() is
+        double weight = (0 == k || FIT_SAMPLES_NUMBER - 1 == k) ? 0.5 * FIT_LAMBDA_STEP : FIT_LAMBDA_STEP;
+        weight /= CIE_Y_INTEGRAL;
+        tables.lambda[k] = static_cast<double>(nm - SAMPLED_LAMBDA_START)
+            / (SAMPLED_LAMBDA_END - SAMPLED_LAMBDA_START);
+        tables.xyzWeight[k][0] = weight * CIE_X[cie];
+        tables.xyzWeight[k][1] = weight * CIE_Y[cie];
+        tables.xyzWeight[k][2] = weight * CIE_Z[cie];
+    }
+
+    for (int j = 0; j < 3; ++j)
+    {
+        tables.whiteXYZ[j] = 0.0;
+        for (int k = 0; k < FIT_SAMPLES_NUMBER; ++k)
+        {
+            tables.whiteXYZ[j] += tables.xyzWeight[k][j];
+        }
+    }
+    return tables;
+}
+
+static double LabF(double t)
+{
+    const double delta = 6.0 / 29.0;
+    return t > delta * delta * delta ? std::cbrt(t) : t / (3.0 * delta * delta) + 4.0 / 29.0;
+}
+
+static void XYZToLab(const FitTables &tables, const double xyz[3], double lab[3])
+{
+    double fx = LabF(xyz[0] / tables.whiteXYZ[0]);
+    double fy = LabF(xyz[1] / tables.whiteXYZ[1]);
+    double fz = LabF(xyz[2] / tables.whiteXYZ[2]);
+    lab[0] = 116.0 * fy - 16.0;
+    lab[1] = 500.0 * (fx - fy);
+    lab[2] = 200.0 * (fy - fz);
+}
+
+static double SigmoidD(double x)
+{
+    return 0.5 + x / (2.0 * std::sqrt(1.0 + x * x));
+}
+
+// CIELAB difference between the spectrum of _c_ and _targetLab_
+static void Residual(const FitTables &tables, const double c[3], const double targetLab[3], double residual[3])
+{
+    double xyz[3] = {0.0, 0.0, 0.0};
+    for (int k = 0; k < FIT_SAMPLES_NUMBER; ++k)
+    {
+        double lambda = tables.lambda[k];
+        double s = SigmoidD((c[0] * lambda + c[1]) * lambda + c[2]);
+        for (int j = 0; j < 3; ++j)
+        {
+            xyz[j] += s * tables.xyzWeight[k][j];
+        }
+    }
+    double lab[3];
+    XYZToLab(tables, xyz, lab);
+    for (int j = 0; j < 3; ++j)
+    {
+        residual[j] = lab[j] - targetLab[j];
+    }
+}
+
+static double Norm(const double v[3])
+{
+    return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+// Solves the 3x3 system _a_ x = _b_ by Cramer's rule
+static bool Solve3x3(const double a[3][3], const double b[3], double x[3])
+{
+    double det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+        - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+        + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    if (std::abs(det) < 1e-15)
+    {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        double m[3][3];
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int col = 0; col < 3; ++col)
+            {
+                m[r][col] = (col == i) ? b[r] : a[r][col];
+            }
+        }
+        x[i] = (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+            - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+            + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) / det;
+    }
+    return true;
+}
+
+// Gauss-Newton from the coefficients in _c_; returns the remaining error
+static double GaussNewton(const FitTables &tables, const double rgb[3], double c[3])
+{
+    // Target XYZ of _rgb_
+    Float rgbf[3] = {static_cast<Float>(rgb[0]), static_cast<Float>(rgb[1]), static_cast<Float>(rgb[2])};
+    Float xyzf[3];
+    RGBToXYZ(rgbf, xyzf);
+    double xyz[3] = {xyzf[0], xyzf[1], xyzf[2]}, targetLab[3];
+    XYZToLab(tables, xyz, targetLab);
+
+    double r = 0.0;
+    for (int iteration = 0; iteration < 50; ++iteration)
+    {
+        double residual[3];
+        Residual(tables, c, targetLab, residual);
+        r = Norm(residual);
+
+        // Jacobian by central differences
+        double jacobian[3][3];
+        for (int i = 0; i < 3; ++i)
+        {
+            const double eps = 1e-5;
+            double c0[3] = {c[0], c[1], c[2]}, c1[3] = {c[0], c[1], c[2]};
+            c0[i] -= eps;
+            c1[i] += eps;
+            double r0[3], r1[3];
+            Residual(tables, c0, targetLab, r0);
+            Residual(tables, c1, targetLab, r1);
+            for (int j = 0; j < 3; ++j)
+            {
+                jacobian[j][i] = (r1[j] - r0[j]) / (2.0 * eps);
+            }
+        }
+
+        double step[3];
+        if (!Solve3x3(jacobian, residual, step))
+        {
+            break;
+        }
+
+        // Halve the step until the error drops, which keeps the iteration
+        // stable on saturated colors near the edge of the gamut
+        double next[3], nextResidual[3], nextR = r;
+        for (double t = 1.0; t > 1e-3; t *= 0.5)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                next[i] = c[i] - t * step[i];
+            }
+            Residual(tables, next, targetLab, nextResidual);
+            nextR = Norm(nextResidual);
+            if (nextR < r)
+            {
+                break;
+            }
+        }
+        if (nextR >= r)
+        {
+            break;
+        }
+        std::copy(next, next + 3, c);
+        r = nextR;
+        if (r < 1e-6)
+        {
+            break;
+        }
+    }
+    return r;
+}
+
+static float SmoothStep(float x)
+{
+    return x * x * (3.0F - 2.0F * x);
+}
+
+
+std::unique_ptr<RGBToSpectrumTable> RGBToSpectrumTable::Optimize(int resolution, Float *maxError)
+{
+    std::unique_ptr<RGBToSpectrumTable> table(new RGBToSpectrumTable(resolution));
+    const FitTables tables = MakeFitTables();
+    const int res = resolution;
+
+    // Each task fits one (maxChannel, y, x) column through every z slice,
+    // starting a fifth of the way up and seeding each slice with its
+    // neighbour's result
+    std::vector<double> errors(3 * res * res, 0.0);
+    common::tool::ParallelFor([&](int64_t index)
+    {
+        int maxChannel = static_cast<int>(index / (res * res));
+        int yi = static_cast<int>(index / res % res), xi = static_cast<int>(index % res);
+        Float x = static_cast<Float>(xi) / (res - 1), y = static_cast<Float>(yi) / (res - 1);
+        const int start = res / 5;
+
+        auto fit = [&](int zi, double c[3])
+        {
+            double z = table->zNodes[zi], rgb[3];
+            rgb[maxChannel] = z;
+            rgb[(maxChannel + 1) % 3] = x * z;
+            rgb[(maxChannel + 2) % 3] = y * z;
+            double error = GaussNewton(tables, rgb, c);
+            errors[index] = (std::max)(errors[index], error);
+
+            // Back from [0, 1] to wavelengths in nm
+            const double a = SAMPLED_LAMBDA_START, s = 1.0 / (SAMPLED_LAMBDA_END - SAMPLED_LAMBDA_START);
+            float *out = table->Coefficients(maxChannel, zi, yi, xi);
+            out[0] = static_cast<float>(c[0] * s * s);
+            out[1] = static_cast<float>(c[1] * s - 2.0 * c[0] * a * s * s);
+            out[2] = static_cast<float>(c[2] - c[1] * a * s + c[0] * a * a * s * s);
+        };
+
+        double c[3] = {0.0, 0.0, 0.0}, cStart[3];
+        for (int zi = start; zi < res; ++zi)
+        {
+            fit(zi, c);
+            if (start == zi)
+            {
+                std::copy(c, c + 3, cStart);
+            }
+        }
+        for (int zi = start - 1; zi >= 0; --zi)
+        {
+            fit(zi, cStart);
+        }
+    }, 3 * res * res, res);
+
+    if (maxError)
+    {
+        *maxError = static_cast<Float>(*std::max_element(errors.begin(), errors.end()));
+    }
+    return table;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Construction
+////////////////////////////////////////////////////////////////////////////////
+
+RGBToSpectrumTable::RGBToSpectrumTable(int resolution)
+    : resolution(resolution),
+    zNodes(resolution),
+    coefficients(3 * 3 * resolution * resolution * resolution, 0.0F)
+{
+    CHECK_GE(resolution, 2);
+    for (int i = 0; i < resolution; ++i)
+    {
+        zNodes[i] = SmoothStep(SmoothStep(static_cast<float>(i) / (resolution - 1)));
+    }
+}
+
+
+std::unique_ptr<RGBToSpectrumTable> RGBToSpectrumTable::Read(const std::string &filename)
+{
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (!file)
+    {
+        return nullptr;
+    }
+    RGBToSpectrumTableHeader header;
+    if (1 != fread(&header, sizeof(RGBToSpectrumTableHeader), 1, file) || !header.IsValid())
+    {
+        fclose(file);
+        return nullptr;
+    }
+    std::unique_ptr<RGBToSpectrumTable> table(new RGBToSpectrumTable(static_cast<int>(header.resolution)));
+    bool ok = table->zNodes.size() == fread(table->zNodes.data(), sizeof(float), table->zNodes.size(), file)
+        && table->coefficients.size() == fread(table->coefficients.data(), sizeof(float),
+            table->coefficients.size(), file);
+    fclose(file);
+    if (!ok)
+    {
+        return nullptr;
+    }
+    return table;
+}
+
+bool RGBToSpectrumTable::Write(const std::string &filename) const
+{
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    RGBToSpectrumTableHeader header;
+    header.resolution = static_cast<uint32_t>(resolution);
+    bool ok = 1 == fwrite(&header, sizeof(RGBToSpectrumTableHeader), 1, file)
+        && zNodes.size() == fwrite(zNodes.data(), sizeof(float), zNodes.size(), file)
+        && coefficients.size() == fwrite(coefficients.data(), sizeof(float), coefficients.size(), file);
+    return 0 == fclose(file) && ok;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Lookup
+////////////////////////////////////////////////////////////////////////////////
+
+SigmoidPolynomial RGBToSpectrumTable::operator()(const Float rgb[3]) const
+{
+    Float r = common::math::Clamp(rgb[0], FLOAT_0, FLOAT_1);
+    Float g = common::math::Clamp(rgb[1], FLOAT_0, FLOAT_1);
+    Float b = common::math::Clamp(rgb[2], FLOAT_0, FLOAT_1);
+
+    // Find the largest channel and the coordinates of _rgb_ in its grid
+    const Float c[3] = {r, g, b};
+    int maxChannel = (r > g) ? ((r > b) ? 0 : 2) : ((g > b) ? 1 : 2);
+    Float z = c[maxChannel];
+    if (FLOAT_0 == z)
+    {
+        return SigmoidPolynomial(FLOAT_0, FLOAT_0, -std::numeric_limits<Float>::infinity());
+    }
+    Float x = c[(maxChannel + 1) % 3] * (resolution - 1) / z;
+    Float y = c[(maxChannel + 2) % 3] * (resolution - 1) / z;
+
+    int xi = (std::min)(static_cast<int>(x), resolution - 2);
+    int yi = (std::min)(static_cast<int>(y), resolution - 2);
+    int zi = common::math::FindInterval(resolution, [&](int i)
+    {
+        return zNodes[i] < z;
+    });
+    Float dx = x - xi, dy = y - yi;
+    Float dz = (z - zNodes[zi]) / (zNodes[zi + 1] - zNodes[zi]);
+
+    // Trilinearly interpolate the coefficients from the eight corners
+    const float *base = Coefficients(maxChannel, zi, yi, xi);
+    const int dxStride = 3, dyStride = 3 * resolution, dzStride = 3 * resolution * resolution;
+    Float coefficients[3] = {FLOAT_0, FLOAT_0, FLOAT_0};
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        int ox = corner & 1, oy = (corner >> 1) & 1, oz = corner >> 2;
+        Float weight = (ox ? dx : FLOAT_1 - dx) * (oy ? dy : FLOAT_1 - dy) * (oz ? dz : FLOAT_1 - dz);
+        const float *co = base + ox * dxStride + oy * dyStride + oz * dzStride;
+        coefficients[0] += weight * co[0];
+        coefficients[1] += weight * co[1];
+        coefficients[2] += weight * co[2];
+    }
+    return SigmoidPolynomial(coefficients[0], coefficients[1], coefficients[2]);
+}
+
+SigmoidPolynomial RGBToSpectrumTable::Lookup(const Float rgb[3], Float *scale) const
+{
+    Float m = (std::max)(rgb[0], (std::max)(rgb[1], rgb[2]));
+    if (m <= FLOAT_1)
+    {
+        *scale = FLOAT_1;
+        return (*this)(rgb);
+    }
+    *scale = FLOAT_2 * m;
+    Float scaled[3] = {rgb[0] / *scale, rgb[1] / *scale, rgb[2] / *scale};
+    return (*this)(scaled);
+}
+
+
+bool LoadRGBToSpectrumTable(const std::string &filename)
+{
+    std::unique_ptr<RGBToSpectrumTable> table = RGBToSpectrumTable::Read(filename);
+    if (!table)
+    {
+        return false;
+    }
+    SetRGBToSpectrumTable(std::move(table));
+    return true;
+}
+
+void SetRGBToSpectrumTable(std::unique_ptr<RGBToSpectrumTable> table)
+{
+    rgbToSpectrumTable = std::move(table);
+}
+
+const RGBToSpectrumTable *GetRGBToSpectrumTable()
+{
+    return rgbToSpectrumTable.get();
+}
+
+
+}
+}
\ No newline at end of file
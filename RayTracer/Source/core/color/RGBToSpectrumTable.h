@@ -0,0 +1,146 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "../../common/math/Constants.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace core
+{
+namespace color
+{
+
+
+// s(c0 lambda^2 + c1 lambda + c2) with lambda in nm and the sigmoid
+// s(x) = 1/2 + x / (2 sqrt(1 + x^2)): smooth, and bounded to [0, 1] like a
+// reflectance
+class SigmoidPolynomial
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    SigmoidPolynomial(Float c0 = FLOAT_0, Float c1 = FLOAT_0, Float c2 = FLOAT_0)
+        : c0(c0), c1(c1), c2(c2)
+    {}
+
+
+    Float operator()(Float lambda) const
+    {
+        return Sigmoid((c0 * lambda + c1) * lambda + c2);
+    }
+
+    static Float Sigmoid(Float x)
+    {
+        if (std::isinf(x))
+        {
+            return x > FLOAT_0 ? FLOAT_1 : FLOAT_0;
+        }
+        return FLOAT_INV_2 + x / (FLOAT_2 * std::sqrt(FLOAT_1 + x * x));
+    }
+
+    Float c0, c1, c2;
+};
+
+
+struct RGBToSpectrumTableHeader
+{
+    static constexpr uint32_t MAGIC = 0x53424752; // "RGBS"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic = MAGIC;
+    uint32_t version = VERSION;
+    uint32_t resolution = 0;
+
+
+    bool IsValid() const
+    {
+        return MAGIC == magic && VERSION == version && resolution >= 2;
+    }
+};
+
+
+// Sigmoid polynomial coefficients fitted offline (SpectrumTableBaker) to a
+// grid of RGB values, after Jakob and Hanika, "A Low-Dimensional Function
+// Space for Efficient Spectral Upsampling". The grid is indexed by the
+// largest channel, its value z and the other two channels divided by z.
+//
+// The fit targets the renderer's own SampledSpectrum::ToXYZ() and
+// XYZToRGB(), so ToRGB(FromRGB(rgb)) returns _rgb_ up to the fit error.
+// Bright, nearly white reflectances sit just outside what a spectrum
+// bounded by 1 reaches under that equal energy integral and keep a few
+// CIELAB units of error.
+class RGBToSpectrumTable
+{
+public:
+
+    static constexpr int DEFAULT_RESOLUTION = 32;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    explicit RGBToSpectrumTable(int resolution);
+
+
+    // Fits every grid entry with Gauss-Newton iterations in CIELAB; takes
+    // seconds, which is why the table is baked ahead of time. Writes the
+    // largest remaining CIELAB error to _maxError_ when it is given.
+    static std::unique_ptr<RGBToSpectrumTable> Optimize(int resolution, Float *maxError = nullptr);
+
+    static std::unique_ptr<RGBToSpectrumTable> Read(const std::string &filename);
+
+    bool Write(const std::string &filename) const;
+
+
+    // Trilinear lookup for _rgb_ in [0, 1]
+    SigmoidPolynomial operator()(const Float rgb[3]) const;
+
+    // Any non-negative _rgb_: the spectrum is _*scale_ times the returned
+    // polynomial, which brightens values above 1 the way pbrt-v4's
+    // RGBUnboundedSpectrum does
+    SigmoidPolynomial Lookup(const Float rgb[3], Float *scale) const;
+
+    int Resolution() const
+    {
+        return resolution;
+    }
+
+private:
+
+    float *Coefficients(int maxChannel, int zi, int yi, int xi)
+    {
+        return &coefficients[3 * (((maxChannel * resolution + zi) * resolution + yi) * resolution + xi)];
+    }
+
+    const float *Coefficients(int maxChannel, int zi, int yi, int xi) const
+    {
+        return &coefficients[3 * (((maxChannel * resolution + zi) * resolution + yi) * resolution + xi)];
+    }
+
+
+    int resolution;
+    // Values of the largest channel at each z slice, denser near 0 and 1
+    std::vector<float> zNodes;
+    std::vector<float> coefficients;
+};
+
+
+// Once a table is set, SampledSpectrum::FromRGB() and HeroSpectrum::FromRGB()
+// evaluate its sigmoid polynomials for reflectances instead of blending the
+// Smits basis spectra. Illuminants keep the Smits illuminant basis: the
+// table is fitted against an equal energy white, so its spectra are
+// reflectances, not emission.
+bool LoadRGBToSpectrumTable(const std::string &filename);
+
+void SetRGBToSpectrumTable(std::unique_ptr<RGBToSpectrumTable> table);
+
+const RGBToSpectrumTable *GetRGBToSpectrumTable();
+
+
+}
+}
\ No newline at end of file
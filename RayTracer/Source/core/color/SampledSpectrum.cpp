@@ -1,4 +1,5 @@
 #include "SampledSpectrum.h"
+#include "RGBToSpectrumTable.h"
 
 namespace core
 {
@@ -85,9 +86,49 @@ void SampledSpectrum::Init()
     }
 }
 
+// Wavelength at the center of each bin, for evaluating the sigmoid
+// polynomials of _RGBToSpectrumTable_
+static SampledSpectrum BinCenters()
+{
+    SampledSpectrum r;
+    for (int i = 0; i < SPECTRAL_SAMPLES_NUMBER; ++i)
+    {
+        r[i] = common::math::Lerp((static_cast<Float>(i) + FLOAT_INV_2) / static_cast<Float>(SPECTRAL_SAMPLES_NUMBER)
+            , SAMPLED_LAMBDA_START, SAMPLED_LAMBDA_END);
+    }
+    return r;
+}
+
+static const SampledSpectrum binCenters = BinCenters();
+
 SampledSpectrum SampledSpectrum::FromRGB(const Float rgb[3], SpectrumType type)
 {
     SampledSpectrum r;
+    const RGBToSpectrumTable *table = GetRGBToSpectrumTable();
+    if (SpectrumType::Reflectance == type && nullptr != table)
+    {
+        if ((std::max)(rgb[0], (std::max)(rgb[1], rgb[2])) <= FLOAT_0)
+        {
+            return r;
+        }
+
+        // Evaluate the fitted sigmoid polynomial at the bin centers a SIMD
+        // lane at a time
+        typedef SpectrumLaneFor<SPECTRAL_SAMPLES_NUMBER>::Type Lane;
+        Float scale;
+        SigmoidPolynomial polynomial = table->Lookup(rgb, &scale);
+        Lane c0 = Lane::Set(polynomial.c0), c1 = Lane::Set(polynomial.c1), c2 = Lane::Set(polynomial.c2);
+        Lane one = Lane::Set(FLOAT_1), halfScale = Lane::Set(FLOAT_INV_2 * scale);
+        for (int i = 0; i < PADDED_SAMPLE_NUMBER; i += Lane::WIDTH)
+        {
+            Lane lambda = Lane::Load(binCenters.c + i);
+            Lane x = (c0 * lambda + c1) * lambda + c2;
+            (halfScale + halfScale * x / Sqrt(one + x * x)).Store(r.c + i);
+        }
+        r.ClearPadding();
+        return r;
+    }
+
     if (SpectrumType::Reflectance == type)
     {
         // Convert reflectance spectrum to RGB
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "../../common/math/Constants.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+// SSE2 is part of every x64 target; AVX only when the build enables it
+// (/arch:AVX, -mavx). Double precision builds use scalar lanes.
+#ifndef FLOAT_AS_DOUBLE
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPECTRUM_SSE
+#include <emmintrin.h>
+#endif
+#if defined(SPECTRUM_SSE) && defined(__AVX__)
+#define SPECTRUM_AVX
+#include <immintrin.h>
+#endif
+#endif
+
+namespace core
+{
+namespace color
+{
+
+
+// A lane is the group of spectrum samples CoefficientSpectrum processes at
+// once. Loads and stores are unaligned since spectra also live in
+// MemoryArena blocks, which only guarantee std::max_align_t.
+struct ScalarLane
+{
+    static const int WIDTH = 1;
+    Float v;
+
+    static ScalarLane Load(const Float *p)
+    {
+        return { *p };
+    }
+
+    static ScalarLane Set(Float a)
+    {
+        return { a };
+    }
+
+    void Store(Float *p) const
+    {
+        *p = v;
+    }
+
+    friend ScalarLane operator+(ScalarLane a, ScalarLane b) { return { a.v + b.v }; }
+    friend ScalarLane operator-(ScalarLane a, ScalarLane b) { return { a.v - b.v }; }
+    friend ScalarLane operator*(ScalarLane a, ScalarLane b) { return { a.v * b.v }; }
+    friend ScalarLane operator/(ScalarLane a, ScalarLane b) { return { a.v / b.v }; }
+    friend ScalarLane Min(ScalarLane a, ScalarLane b) { return { (std::min)(a.v, b.v) }; }
+    friend ScalarLane Max(ScalarLane a, ScalarLane b) { return { (std::max)(a.v, b.v) }; }
+    friend ScalarLane Sqrt(ScalarLane a) { return { std::sqrt(a.v) }; }
+
+    bool AllZero() const
+    {
+        return FLOAT_0 == v;
+    }
+
+    bool AnyNaN() const
+    {
+        return std::isnan(v);
+    }
+
+    Float MaxLane() const
+    {
+        return v;
+    }
+
+    Float SumLane() const
+    {
+        return v;
+    }
+};
+
+
+#ifdef SPECTRUM_SSE
+struct SSELane
+{
+    static const int WIDTH = 4;
+    __m128 v;
+
+    static SSELane Load(const Float *p)
+    {
+        return { _mm_loadu_ps(p) };
+    }
+
+    static SSELane Set(Float a)
+    {
+        return { _mm_set1_ps(a) };
+    }
+
+    void Store(Float *p) const
+    {
+        _mm_storeu_ps(p, v);
+    }
+
+    friend SSELane operator+(SSELane a, SSELane b) { return { _mm_add_ps(a.v, b.v) }; }
+    friend SSELane operator-(SSELane a, SSELane b) { return { _mm_sub_ps(a.v, b.v) }; }
+    friend SSELane operator*(SSELane a, SSELane b) { return { _mm_mul_ps(a.v, b.v) }; }
+    friend SSELane operator/(SSELane a, SSELane b) { return { _mm_div_ps(a.v, b.v) }; }
+    friend SSELane Min(SSELane a, SSELane b) { return { _mm_min_ps(a.v, b.v) }; }
+    friend SSELane Max(SSELane a, SSELane b) { return { _mm_max_ps(a.v, b.v) }; }
+    friend SSELane Sqrt(SSELane a) { return { _mm_sqrt_ps(a.v) }; }
+
+    bool AllZero() const
+    {
+        return 0xF == _mm_movemask_ps(_mm_cmpeq_ps(v, _mm_setzero_ps()));
+    }
+
+    bool AnyNaN() const
+    {
+        return 0 != _mm_movemask_ps(_mm_cmpunord_ps(v, v));
+    }
+
+    Float MaxLane() const
+    {
+        __m128 m = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(m);
+    }
+
+    Float SumLane() const
+    {
+        __m128 s = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        s = _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(s);
+    }
+};
+#endif
+
+
+#ifdef SPECTRUM_AVX
+struct AVXLane
+{
+    static const int WIDTH = 8;
+    __m256 v;
+
+    static AVXLane Load(const Float *p)
+    {
+        return { _mm256_loadu_ps(p) };
+    }
+
+    static AVXLane Set(Float a)
+    {
+        return { _mm256_set1_ps(a) };
+    }
+
+    void Store(Float *p) const
+    {
+        _mm256_storeu_ps(p, v);
+    }
+
+    friend AVXLane operator+(AVXLane a, AVXLane b) { return { _mm256_add_ps(a.v, b.v) }; }
+    friend AVXLane operator-(AVXLane a, AVXLane b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    friend AVXLane operator*(AVXLane a, AVXLane b) { return { _mm256_mul_ps(a.v, b.v) }; }
+    friend AVXLane operator/(AVXLane a, AVXLane b) { return { _mm256_div_ps(a.v, b.v) }; }
+    friend AVXLane Min(AVXLane a, AVXLane b) { return { _mm256_min_ps(a.v, b.v) }; }
+    friend AVXLane Max(AVXLane a, AVXLane b) { return { _mm256_max_ps(a.v, b.v) }; }
+    friend AVXLane Sqrt(AVXLane a) { return { _mm256_sqrt_ps(a.v) }; }
+
+    bool AllZero() const
+    {
+        return 0xFF == _mm256_movemask_ps(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_EQ_OQ));
+    }
+
+    bool AnyNaN() const
+    {
+        return 0 != _mm256_movemask_ps(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+    }
+
+    Float MaxLane() const
+    {
+        SSELane half = { _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)) };
+        return half.MaxLane();
+    }
+
+    Float SumLane() const
+    {
+        SSELane half = { _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)) };
+        return half.SumLane();
+    }
+};
+#endif
+
+
+// RGB (padded to 4) fits one SSE register; denser spectra use AVX when the
+// build enables it
+template <int SPECTRUM_SAMPLES_NUMBER>
+struct SpectrumLaneFor
+{
+#if defined(SPECTRUM_AVX)
+    typedef typename std::conditional<(SPECTRUM_SAMPLES_NUMBER <= 4), SSELane, AVXLane>::type Type;
+#elif defined(SPECTRUM_SSE)
+    typedef SSELane Type;
+#else
+    typedef ScalarLane Type;
+#endif
+};
+
+
+}
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "../../common/math/Vec2.h"
 #include "../../common/math/Bounds2.h"
 #include "../color/ColorExtern.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -89,7 +90,7 @@ std::unique_ptr<FilmTile> Film::GetFilmTile(const common::math::Bounds2i &sample
 
 void Film::MergeFilmTile(std::unique_ptr<FilmTile> tile)
 {
-    //ProfilePhase p(Prof::MergeFilmTile);
+    common::tool::ProfilePhase p(common::tool::Prof::MergeFilmTile);
     //VLOG(1) << "Merging film tile " << tile->pixelBounds;
     std::lock_guard<std::mutex> lock(_mutex);
 
@@ -101,7 +102,7 @@ void Film::MergeFilmTile(std::unique_ptr<FilmTile> tile)
         tilePixel.contribSum.ToXYZ(xyz);
         for (int i = 0; i < 3; ++i)
         {
-            mergePixel.xyz[i] += xyz[i];
+            mergePixel.xyz[i] += xyz[i] + tilePixel.xyzSum[i];
         }
         mergePixel.filterWeightSum += tilePixel.filterWeightSum;
     }
@@ -123,9 +124,8 @@ void Film::SetImage(const color::Spectrum *img) const
 
 void Film::AddSplat(const common::math::Vec2f &p, color::Spectrum v)
 {
+    common::tool::ProfilePhase pp(common::tool::Prof::SplatFilm);
     /*
-    ProfilePhase pp(Prof::SplatFilm);
-
     if (v.HasNaNs())
     {
         LOG(ERROR) << StringPrintf("Ignoring splatted spectrum with NaN values "
@@ -159,8 +159,7 @@ void Film::AddSplat(const common::math::Vec2f &p, color::Spectrum v)
     Pixel &pixel = GetPixel((common::math::Vec2i)p);
     for (int i = 0; i < 3; ++i)
     {
-        // TODO
-        //pixel.splatXYZ[i] += xyz[i];
+        pixel.splatXYZ[i].Add(xyz[i]);
     }
 }
 
@@ -6,6 +6,7 @@
 
 #include "FilmTile.h"
 #include "../sampler/filter/Filter.h"
+#include "../../common/tool/MultiThread.h"
 
 #include <atomic>
 #include <mutex>
@@ -68,7 +69,7 @@ private:
         Float xyz[3];
         Float filterWeightSum;
         
-        std::atomic<Float> splatXYZ[3];
+        common::tool::AtomicFloat splatXYZ[3];
         Float pad;
     };
 
@@ -4,6 +4,7 @@
 #include "../../common/math/Vec2.h"
 #include "../../common/math/Bounds2.h"
 #include "../color/Spectrum.h"
+#include "../../common/tool/Stats.h"
 
 class Filter;
 
@@ -17,6 +18,7 @@ struct FilmTilePixel
 {
     color::Spectrum contribSum = color::Spectrum(FLOAT_0);
     Float filterWeightSum = FLOAT_0;
+    Float xyzSum[3] = {FLOAT_0, FLOAT_0, FLOAT_0};
 };
 
 
@@ -45,9 +47,65 @@ public:
     void AddSample(const common::math::Vec2f &pFilm, color::Spectrum L,
         Float sampleWeight = FLOAT_1)
     {
-        //ProfilePhase _(Prof::AddFilmSample);
+        common::tool::ProfilePhase _(common::tool::Prof::AddFilmSample);
         if (L.y() > maxSampleLuminance)
             L *= maxSampleLuminance / L.y();
+        ForEachFilterWeight(pFilm, [&](FilmTilePixel &pixel, Float filterWeight)
+        {
+            pixel.contribSum += L * sampleWeight * filterWeight;
+            pixel.filterWeightSum += filterWeight;
+        });
+    }
+
+    // Hero-wavelength integrators hand over CIE XYZ already weighted by the
+    // pdfs of their wavelengths instead of a dense _Spectrum_
+    void AddSampleXYZ(const common::math::Vec2f &pFilm, const Float xyz[3],
+        Float sampleWeight = FLOAT_1)
+    {
+        common::tool::ProfilePhase _(common::tool::Prof::AddFilmSample);
+        Float scale = sampleWeight;
+        if (xyz[1] > maxSampleLuminance)
+            scale *= maxSampleLuminance / xyz[1];
+        ForEachFilterWeight(pFilm, [&](FilmTilePixel &pixel, Float filterWeight)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                pixel.xyzSum[i] += xyz[i] * scale * filterWeight;
+            }
+            pixel.filterWeightSum += filterWeight;
+        });
+    }
+
+    inline
+    FilmTilePixel &GetPixel(const common::math::Vec2i &p)
+    {
+        CHECK(InsideExclusive(p, pixelBounds));
+        int width = pixelBounds.point_max.x - pixelBounds.point_min.x;
+        int offset = (p.x - pixelBounds.point_min.x) + (p.y - pixelBounds.point_min.y) * width;
+        return pixels[offset];
+    }
+
+    inline
+    const FilmTilePixel &GetPixel(const common::math::Vec2i &p) const
+    {
+        CHECK(InsideExclusive(p, pixelBounds));
+        int width = pixelBounds.point_max.x - pixelBounds.point_min.x;
+        int offset = (p.x - pixelBounds.point_min.x) + (p.y - pixelBounds.point_min.y) * width;
+        return pixels[offset];
+    }
+
+    const common::math::Bounds2i GetPixelBounds() const
+    {
+        return pixelBounds;
+    }
+
+private:
+
+    // Calls _func_ with every pixel under the filter footprint of _pFilm_
+    // and the filter's weight there
+    template <typename Func>
+    void ForEachFilterWeight(const common::math::Vec2f &pFilm, Func func)
+    {
         // Compute sample's raster bounds
         common::math::Vec2f pFilmDiscrete = pFilm - common::math::Vec2f(FLOAT_INV_2);
         common::math::Vec2i p0 = (common::math::Vec2i)Ceil(pFilmDiscrete - filterRadius);
@@ -81,38 +139,11 @@ public:
                 int offset = ify[y - p0.y] * filterTableSize + ifx[x - p0.x];
                 Float filterWeight = filterTable[offset];
 
-                // Update pixel values with filtered sample contribution
-                FilmTilePixel &pixel = GetPixel(common::math::Vec2i(x, y));
-                pixel.contribSum += L * sampleWeight * filterWeight;
-                pixel.filterWeightSum += filterWeight;
+                func(GetPixel(common::math::Vec2i(x, y)), filterWeight);
             }
         }
     }
 
-    inline
-    FilmTilePixel &GetPixel(const common::math::Vec2i &p)
-    {
-        CHECK(InsideExclusive(p, pixelBounds));
-        int width = pixelBounds.point_max.x - pixelBounds.point_min.x;
-        int offset = (p.x - pixelBounds.point_min.x) + (p.y - pixelBounds.point_min.y) * width;
-        return pixels[offset];
-    }
-
-    inline
-    const FilmTilePixel &GetPixel(const common::math::Vec2i &p) const
-    {
-        CHECK(InsideExclusive(p, pixelBounds));
-        int width = pixelBounds.point_max.x - pixelBounds.point_min.x;
-        int offset = (p.x - pixelBounds.point_min.x) + (p.y - pixelBounds.point_min.y) * width;
-        return pixels[offset];
-    }
-
-    const common::math::Bounds2i GetPixelBounds() const
-    {
-        return pixelBounds;
-    }
-
-private:
     // FilmTile Private Data
     const common::math::Bounds2i pixelBounds;
     const common::math::Vec2f filterRadius, invFilterRadius;
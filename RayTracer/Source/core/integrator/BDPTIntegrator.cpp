@@ -0,0 +1,667 @@
+#include "BDPTIntegrator.h"
+#include "LightDistribution.h"
+#include "../bxdf/BxDF.h"
+#include "../bxdf/BSDF.h"
+#include "../color/Spectrum.h"
+#include "../film/Film.h"
+#include "../film/FilmTile.h"
+#include "../interaction/Interaction.h"
+#include "../interaction/SurfaceInteraction.h"
+#include "../interaction/MediumInteraction.h"
+#include "../light/Light.h"
+#include "../light/VisibilityTester.h"
+#include "../scene/Scene.h"
+#include "../sampler/Sampler.h"
+#include "../sampler/Sampling.h"
+#include "../texture/ImageTexture.h"
+#include "../../common/math/RayDifferential.h"
+#include "../../common/tool/LookupCache.h"
+#include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/MultiThread.h"
+#include "../../common/tool/Stats.h"
+
+namespace core
+{
+namespace integrator
+{
+
+
+template <typename T>
+inline
+T Remap0(T f)
+{
+    return 0 != f ? f : 1;
+}
+
+
+static int RandomWalk(const core::scene::Scene &scene, common::math::RayDifferentialf ray,
+    core::sampler::Sampler &sampler, common::tool::MemoryArena &arena,
+    core::color::Spectrum beta, Float pdf, int maxDepth,
+    core::material::TransportMode mode, Vertex *path)
+{
+    if (0 == maxDepth)
+    {
+        return 0;
+    }
+    int bounces = 0;
+    // Declare variables for forward and reverse probability densities
+    Float pdfFwd = pdf, pdfRev = FLOAT_0;
+    while (true)
+    {
+        // Attempt to create the next subpath vertex in _path_
+        core::interaction::MediumInteraction mi;
+
+        /* TODO
+        VLOG(2) << "Random walk. Bounces " << bounces << ", beta " << beta
+            << ", pdfFwd " << pdfFwd << ", pdfRev " << pdfRev;
+        */
+        // Trace a ray and sample the medium, if any
+        core::interaction::SurfaceInteraction isect;
+        bool foundIntersection = scene.Intersect(ray, &isect);
+        if (ray.medium)
+        {
+            beta *= ray.medium->Sample(ray, sampler, arena, &mi);
+        }
+        if (beta.IsBlack())
+        {
+            break;
+        }
+        Vertex &vertex = path[bounces], &prev = path[bounces - 1];
+        if (mi.IsValid())
+        {
+            // Record medium interaction in _path_ and compute forward density
+            vertex = Vertex::CreateMedium(mi, beta, pdfFwd, prev);
+            if (++bounces >= maxDepth)
+            {
+                break;
+            }
+
+            // Sample direction and compute reverse density at preceding vertex
+            common::math::Vec3f wi;
+            pdfFwd = pdfRev = mi.phase->Sample_p(-ray.dir, &wi, sampler.Get2D());
+            ray = mi.SpawnRay(wi);
+        }
+        else
+        {
+            // Handle surface interaction for path generation
+            if (!foundIntersection)
+            {
+                // Capture escaped rays when tracing from the camera
+                if (core::material::TransportMode::Radiance == mode)
+                {
+                    vertex = Vertex::CreateLight(EndpointInteraction(ray), beta, pdfFwd);
+                    ++bounces;
+                }
+                break;
+            }
+
+            // Compute scattering functions for _mode_ and skip over medium
+            // boundaries
+            isect.ComputeScatteringFunctions(ray, arena, true, mode);
+            if (!isect.bsdf)
+            {
+                ray = isect.SpawnRay(ray.dir);
+                continue;
+            }
+
+            // Initialize _vertex_ with surface intersection information
+            vertex = Vertex::CreateSurface(isect, beta, pdfFwd, prev);
+            if (++bounces >= maxDepth)
+            {
+                break;
+            }
+
+            // Sample BSDF at current vertex and compute reverse probability
+            common::math::Vec3f wi, wo = isect.wo;
+            core::bxdf::BxDFType type;
+            core::color::Spectrum f = isect.bsdf->Sample_f(wo, &wi, sampler.Get2D(), &pdfFwd,
+                core::bxdf::BxDFType::BSDF_ALL, &type);
+            /* TODO
+            VLOG(2) << "Random walk sampled dir " << wi << " f: " << f
+                << ", pdfFwd: " << pdfFwd;
+            */
+            if (f.IsBlack() || FLOAT_0 == pdfFwd)
+            {
+                break;
+            }
+            beta.MulScaled(f, AbsDot(wi, isect.shading.n) / pdfFwd);
+            /* TODO
+            VLOG(2) << "Random walk beta now " << beta;
+            */
+            pdfRev = isect.bsdf->Pdf(wi, wo, core::bxdf::BxDFType::BSDF_ALL);
+            if (type & core::bxdf::BxDFType::BSDF_SPECULAR)
+            {
+                vertex.delta = true;
+                pdfRev = pdfFwd = FLOAT_0;
+            }
+            beta *= CorrectShadingNormal(isect, wo, wi, mode);
+            /* TODO
+            VLOG(2) << "Random walk beta after shading normal correction " << beta;
+            */
+            ray = isect.SpawnRay(wi);
+        }
+
+        // Compute reverse area density at preceding vertex
+        prev.pdfRev = vertex.ConvertDensity(pdfRev, prev);
+    }
+
+    return bounces;
+}
+
+int GenerateCameraSubpath(const core::scene::Scene &scene, core::sampler::Sampler &sampler,
+    common::tool::MemoryArena &arena, int maxDepth,
+    const core::camera::Camera &camera, const common::math::Vec2f &pFilm,
+    Vertex *path)
+{
+    if (0 == maxDepth)
+    {
+        return 0;
+    }
+    common::tool::ProfilePhase _(common::tool::Prof::BDPTGenerateSubpath);
+
+    // Sample initial ray for camera subpath
+    core::camera::CameraSample cameraSample;
+    cameraSample.pFilm = pFilm;
+    cameraSample.time = sampler.Get1D();
+    cameraSample.pLens = sampler.Get2D();
+    common::math::RayDifferentialf ray;
+    core::color::Spectrum beta(camera.GenerateRayDifferential(cameraSample, &ray));
+    ray.ScaleDifferentials(FLOAT_1 / std::sqrt(static_cast<Float>(sampler.samples_per_pixel)));
+
+    // Generate first vertex on camera subpath and start random walk
+    Float pdfPos, pdfDir;
+    path[0] = Vertex::CreateCamera(&camera, ray, beta);
+    camera.Pdf_We(ray, &pdfPos, &pdfDir);
+    /* TODO
+    VLOG(2) << "Starting camera subpath. Ray: " << ray << ", beta " << beta
+        << ", pdfPos " << pdfPos << ", pdfDir " << pdfDir;
+    */
+
+    return RandomWalk(scene, ray, sampler, arena, beta, pdfDir, maxDepth - 1,
+        core::material::TransportMode::Radiance, path + 1) + 1;
+}
+
+int GenerateLightSubpath(const core::scene::Scene &scene, core::sampler::Sampler &sampler,
+    common::tool::MemoryArena &arena, int maxDepth,
+    Float time, const core::sampler::Distribution1D &lightDistr,
+    const LightIndexMap &lightToIndex,
+    Vertex *path)
+{
+    if (0 == maxDepth)
+    {
+        return 0;
+    }
+    common::tool::ProfilePhase _(common::tool::Prof::BDPTGenerateSubpath);
+
+    // Sample initial ray for light subpath
+    Float lightPdf;
+    int lightNum = lightDistr.SampleDiscrete(sampler.Get1D(), &lightPdf);
+    const std::shared_ptr<core::light::Light> &light = scene.lights[lightNum];
+    common::math::Vec2f u1 = sampler.Get2D();
+    common::math::Vec2f u2 = sampler.Get2D();
+    common::math::Rayf ray;
+    common::math::Vec3f nLight;
+    Float pdfPos, pdfDir;
+    core::color::Spectrum Le = light->Sample_Le(u1, u2, time, &ray, &nLight, &pdfPos, &pdfDir);
+    if (FLOAT_0 == pdfPos || FLOAT_0 == pdfDir || Le.IsBlack())
+    {
+        return 0;
+    }
+
+    // Generate first vertex on light subpath and start random walk
+    path[0] = Vertex::CreateLight(light.get(), ray, nLight, Le, pdfPos * lightPdf);
+    core::color::Spectrum beta = Le * AbsDot(nLight, ray.dir) / (lightPdf * pdfPos * pdfDir);
+    /* TODO
+    VLOG(2) << "Starting light subpath. Ray: " << ray << ", Le " << Le <<
+        ", beta " << beta << ", pdfPos " << pdfPos << ", pdfDir " << pdfDir;
+    */
+    int nVertices = RandomWalk(scene, common::math::RayDifferentialf(ray), sampler, arena, beta, pdfDir,
+        maxDepth - 1, core::material::TransportMode::Importance, path + 1);
+
+    // Correct subpath sampling densities for infinite area lights
+    if (path[0].IsInfiniteLight())
+    {
+        // Set spatial density of _path[1]_ for infinite area light
+        if (nVertices > 0)
+        {
+            path[1].pdfFwd = pdfPos;
+            if (path[1].IsOnSurface())
+            {
+                path[1].pdfFwd *= AbsDot(ray.dir, path[1].ng());
+            }
+        }
+
+        // Set spatial density of _path[0]_ for infinite area light
+        path[0].pdfFwd = InfiniteLightDensity(scene, lightDistr, lightToIndex, ray.dir);
+    }
+
+    return nVertices + 1;
+}
+
+// The MIS weight of a strategy (s, t) is 1 / (1 + sum of ratios), where
+// each ratio compares it with a hypothetical strategy that moves the
+// connection one or more vertices along either subpath. Only the two
+// vertices next to the connection on each side see different densities
+// for different (s, t); everything further away is shared by all
+// strategies, so its part of the sum is accumulated once per subpath here
+// as S_i = r_i * (valid_i + S_{i-1}) rather than once per connection.
+void ComputeSubpathMISSums(Vertex *path, int nVertices, bool isCameraPath)
+{
+    Float sum = FLOAT_0;
+    for (int i = 0; i < nVertices; ++i)
+    {
+        Vertex &v = path[i];
+        if (isCameraPath && 0 == i)
+        {
+            // The camera vertex itself is never reached by a light subpath
+            v.misSum = FLOAT_0;
+            continue;
+        }
+        bool deltaPrev = i > 0 ? path[i - 1].delta : v.IsDeltaLight();
+        Float valid = (!v.delta && !deltaPrev) ? FLOAT_1 : FLOAT_0;
+        sum = Remap0(v.pdfRev) / Remap0(v.pdfFwd) * (valid + sum);
+        v.misSum = sum;
+    }
+}
+
+static Float MISWeight(const core::scene::Scene &scene, Vertex *lightVertices,
+    Vertex *cameraVertices, Vertex &sampled, int s, int t,
+    const core::sampler::Distribution1D &lightPdf,
+    const LightIndexMap &lightToIndex)
+{
+    if (2 == s + t)
+    {
+        return FLOAT_1;
+    }
+
+    // Look up connection vertices and their predecessors
+    const Vertex *qs = s > 0 ? &lightVertices[s - 1] : nullptr,
+        *pt = t > 0 ? &cameraVertices[t - 1] : nullptr,
+        *qsMinus = s > 1 ? &lightVertices[s - 2] : nullptr,
+        *ptMinus = t > 1 ? &cameraVertices[t - 2] : nullptr;
+
+    // Use the endpoint sampled during the connection for single-vertex
+    // subpaths
+    if (1 == s)
+    {
+        qs = &sampled;
+    }
+    else if (1 == t)
+    {
+        pt = &sampled;
+    }
+
+    // Reverse densities of the connection vertices and their predecessors
+    // for this strategy; the subpaths themselves are left untouched
+    CHECK(nullptr != pt);
+    Float ptRev = s > 0
+        ? qs->Pdf(scene, qsMinus, *pt)
+        : pt->PdfLightOrigin(scene, *ptMinus, lightPdf, lightToIndex);
+    Float ptMinusRev = FLOAT_0;
+    if (nullptr != ptMinus)
+    {
+        ptMinusRev = s > 0 ? pt->Pdf(scene, qs, *ptMinus) : pt->PdfLight(scene, *ptMinus);
+    }
+    Float qsRev = FLOAT_0, qsMinusRev = FLOAT_0;
+    if (nullptr != qs)
+    {
+        qsRev = pt->Pdf(scene, ptMinus, *qs);
+        if (nullptr != qsMinus)
+        {
+            qsMinusRev = qs->Pdf(scene, pt, *qsMinus);
+        }
+    }
+
+    Float sumRi = FLOAT_0;
+
+    // Consider hypothetical connection strategies along the camera subpath;
+    // _pt_ is connected, so it is never treated as a delta vertex here
+    if (t > 1)
+    {
+        Float inner = FLOAT_0;
+        if (t > 2)
+        {
+            Float valid = (!ptMinus->delta && !cameraVertices[t - 3].delta) ? FLOAT_1 : FLOAT_0;
+            inner = Remap0(ptMinusRev) / Remap0(ptMinus->pdfFwd) * (valid + cameraVertices[t - 3].misSum);
+        }
+        Float valid = !ptMinus->delta ? FLOAT_1 : FLOAT_0;
+        sumRi += Remap0(ptRev) / Remap0(pt->pdfFwd) * (valid + inner);
+    }
+
+    // Consider hypothetical connection strategies along the light subpath
+    if (s > 0)
+    {
+        Float inner = FLOAT_0;
+        if (s > 1)
+        {
+            bool deltaLightvertex = s > 2 ? lightVertices[s - 3].delta : qsMinus->IsDeltaLight();
+            Float valid = (!qsMinus->delta && !deltaLightvertex) ? FLOAT_1 : FLOAT_0;
+            Float prefix = s > 2 ? lightVertices[s - 3].misSum : FLOAT_0;
+            inner = Remap0(qsMinusRev) / Remap0(qsMinus->pdfFwd) * (valid + prefix);
+        }
+        bool deltaLightvertex = s > 1 ? qsMinus->delta : qs->IsDeltaLight();
+        Float valid = !deltaLightvertex ? FLOAT_1 : FLOAT_0;
+        sumRi += Remap0(qsRev) / Remap0(qs->pdfFwd) * (valid + inner);
+    }
+
+    return FLOAT_1 / (FLOAT_1 + sumRi);
+}
+
+static core::color::Spectrum G(const core::scene::Scene &scene, core::sampler::Sampler &sampler,
+    const Vertex &v0, const Vertex &v1)
+{
+    common::math::Vec3f d = v0.p() - v1.p();
+    Float g = FLOAT_1 / LengthSquared(d);
+    d *= std::sqrt(g);
+    if (v0.IsOnSurface())
+    {
+        g *= AbsDot(v0.ns(), d);
+    }
+    if (v1.IsOnSurface())
+    {
+        g *= AbsDot(v1.ns(), d);
+    }
+    core::light::VisibilityTester vis(v0.GetInteraction(), v1.GetInteraction());
+    return g * vis.Tr(scene, sampler);
+}
+
+core::color::Spectrum ConnectBDPT(const core::scene::Scene &scene, Vertex *lightVertices, Vertex *cameraVertices,
+    int s, int t, const core::sampler::Distribution1D &lightDistr,
+    const LightIndexMap &lightToIndex,
+    const core::camera::Camera &camera, core::sampler::Sampler &sampler,
+    common::math::Vec2f *pRaster, Float *misWeightPtr)
+{
+    common::tool::ProfilePhase _(common::tool::Prof::BDPTConnectSubpaths);
+    core::color::Spectrum L(FLOAT_0);
+    // Ignore invalid connections related to infinite area lights
+    if (t > 1 && 0 != s && VertexType::Light == cameraVertices[t - 1].type)
+    {
+        return core::color::Spectrum(FLOAT_0);
+    }
+
+    // Perform connection and write contribution to _L_
+    Vertex sampled;
+    if (0 == s)
+    {
+        // Interpret the camera subpath as a complete path
+        const Vertex &pt = cameraVertices[t - 1];
+        if (pt.IsLight())
+        {
+            L = pt.Le(scene, cameraVertices[t - 2]) * pt.beta;
+        }
+        CHECK(!L.HasNaNs());
+    }
+    else if (1 == t)
+    {
+        // Sample a point on the camera and connect it to the light subpath
+        const Vertex &qs = lightVertices[s - 1];
+        if (qs.IsConnectible())
+        {
+            core::light::VisibilityTester vis;
+            common::math::Vec3f wi;
+            Float pdf;
+            core::color::Spectrum Wi = camera.Sample_Wi(qs.GetInteraction(), sampler.Get2D(),
+                &wi, &pdf, pRaster, &vis);
+            if (pdf > FLOAT_0 && !Wi.IsBlack())
+            {
+                // Initialize dynamically sampled vertex and _L_ for $t=1$ case
+                sampled = Vertex::CreateCamera(&camera, vis.P1(), Wi / pdf);
+                L = qs.beta * qs.f(sampled, core::material::TransportMode::Importance) * sampled.beta;
+                if (qs.IsOnSurface())
+                {
+                    L *= AbsDot(wi, qs.ns());
+                }
+                CHECK(!L.HasNaNs());
+                // Only check visibility after we know that the path would
+                // make a non-zero contribution.
+                if (!L.IsBlack())
+                {
+                    L *= vis.Tr(scene, sampler);
+                }
+            }
+        }
+    }
+    else if (1 == s)
+    {
+        // Sample a point on a light and connect it to the camera subpath
+        const Vertex &pt = cameraVertices[t - 1];
+        if (pt.IsConnectible())
+        {
+            Float lightPdf;
+            core::light::VisibilityTester vis;
+            common::math::Vec3f wi;
+            Float pdf;
+            int lightNum = lightDistr.SampleDiscrete(sampler.Get1D(), &lightPdf);
+            const std::shared_ptr<core::light::Light> &light = scene.lights[lightNum];
+            core::color::Spectrum lightWeight = light->Sample_Li(pt.GetInteraction(), sampler.Get2D(),
+                &wi, &pdf, &vis);
+            if (pdf > FLOAT_0 && !lightWeight.IsBlack())
+            {
+                EndpointInteraction ei(vis.P1(), light.get());
+                sampled = Vertex::CreateLight(ei, lightWeight / (pdf * lightPdf), FLOAT_0);
+                sampled.pdfFwd = sampled.PdfLightOrigin(scene, pt, lightDistr, lightToIndex);
+                L = pt.beta * pt.f(sampled, core::material::TransportMode::Radiance) * sampled.beta;
+                if (pt.IsOnSurface())
+                {
+                    L *= AbsDot(wi, pt.ns());
+                }
+                // Only check visibility if the path would carry radiance.
+                if (!L.IsBlack())
+                {
+                    L *= vis.Tr(scene, sampler);
+                }
+            }
+        }
+    }
+    else
+    {
+        // Handle all other bidirectional connection cases
+        const Vertex &qs = lightVertices[s - 1], &pt = cameraVertices[t - 1];
+        if (qs.IsConnectible() && pt.IsConnectible())
+        {
+            L = qs.beta * qs.f(pt, core::material::TransportMode::Importance)
+                * pt.f(qs, core::material::TransportMode::Radiance) * pt.beta;
+            /* TODO
+            VLOG(2) << "General connect s: " << s << ", t: " << t <<
+                " qs: " << qs << ", pt: " << pt << ", qs.f(pt): " << qs.f(pt, TransportMode::Importance) <<
+                ", pt.f(qs): " << pt.f(qs, TransportMode::Radiance) << ", G: " << G(scene, sampler, qs, pt) <<
+                ", dist^2: " << DistanceSquared(qs.p(), pt.p());
+            */
+            if (!L.IsBlack())
+            {
+                L *= G(scene, sampler, qs, pt);
+            }
+        }
+    }
+
+    //++totalPaths;
+    if (L.IsBlack())
+    {
+        //++zeroRadiancePaths;
+    }
+    //ReportValue(pathLength, s + t - 2);
+
+    // Compute MIS weight for connection strategy
+    Float misWeight = L.IsBlack()
+        ? FLOAT_0
+        : MISWeight(scene, lightVertices, cameraVertices, sampled, s, t, lightDistr, lightToIndex);
+    /* TODO
+    VLOG(2) << "MIS weight for (s,t) = (" << s << ", " << t << ") connection: "
+        << misWeight;
+    */
+    CHECK(!std::isnan(misWeight));
+    L *= misWeight;
+    if (misWeightPtr)
+    {
+        *misWeightPtr = misWeight;
+    }
+
+    return L;
+}
+
+
+void BDPTIntegrator::Render(const core::scene::Scene &scene)
+{
+    common::tool::ProfilePhase p(common::tool::Prof::IntegratorRender);
+    // Image textures are built in the background while the scene is set up
+    core::texture::WaitForImageTextures();
+    std::unique_ptr<LightDistribution> lightDistribution =
+        CreateLightSampleDistribution(lightSampleStrategy, scene);
+
+    // Compute a reverse mapping from light pointers to offsets into the
+    // scene lights vector (and, equivalently, offsets into
+    // lightDistr). Added after book text was finalized; this is critical
+    // to reasonable performance with 100s+ of light sources.
+    LightIndexMap lightToIndex;
+    for (size_t i = 0; i < scene.lights.size(); ++i)
+    {
+        lightToIndex[scene.lights[i].get()] = i;
+    }
+
+    // Partition the image into tiles
+    core::film::Film *film = camera->film;
+    const common::math::Bounds2i sampleBounds = film->GetSampleBounds();
+    const common::math::Vec2i sampleExtent = sampleBounds.Diagonal();
+    const int tileSize = 16;
+    const int nXTiles = (sampleExtent.x + tileSize - 1) / tileSize;
+    const int nYTiles = (sampleExtent.y + tileSize - 1) / tileSize;
+    //ProgressReporter reporter(nXTiles * nYTiles, "Rendering");
+
+    // Render and write the output image to disk
+    if (scene.lights.size() > 0)
+    {
+        common::tool::ParallelFor2D([&](const common::math::Vec2i tile)
+        {
+            // Render a single tile using BDPT
+            common::tool::MemoryArena arena;
+            int seed = nXTiles * tile.y + tile.x;
+            std::unique_ptr<core::sampler::Sampler> tileSampler = sampler->Clone(seed);
+            int x0 = sampleBounds.point_min.x + tile.x * tileSize;
+            int x1 = (std::min)(x0 + tileSize, sampleBounds.point_max.x);
+            int y0 = sampleBounds.point_min.y + tile.y * tileSize;
+            int y1 = (std::min)(y0 + tileSize, sampleBounds.point_max.y);
+            common::math::Bounds2i tileBounds(common::math::Vec2i(x0, y0), common::math::Vec2i(x1, y1));
+            std::unique_ptr<core::film::FilmTile> filmTile = film->GetFilmTile(tileBounds);
+            for (common::math::Vec2i pPixel : tileBounds)
+            {
+                tileSampler->StartPixel(pPixel);
+                common::tool::LookupCacheStartPixel();
+                if (!InsideExclusive(pPixel, pixelBounds))
+                {
+                    continue;
+                }
+                do
+                {
+                    // Generate a single sample using BDPT
+                    common::math::Vec2f pFilm = common::math::Vec2f(pPixel) + tileSampler->Get2D();
+
+                    // Trace the camera subpath; both subpaths live in the
+                    // tile arena and are released with it after the sample
+                    Vertex *cameraVertices = arena.Alloc<Vertex>(maxDepth + 2);
+                    Vertex *lightVertices = arena.Alloc<Vertex>(maxDepth + 1);
+                    int nCamera = GenerateCameraSubpath(scene, *tileSampler, arena, maxDepth + 2,
+                        *camera, pFilm, cameraVertices);
+
+                    // Get a distribution for sampling the light at the
+                    // start of the light subpath. Because the light path
+                    // follows multiple bounces, basing the sampling
+                    // distribution on any of the vertices of the camera
+                    // path is unlikely to be a good strategy. We use the
+                    // PowerLightDistribution by default here, which
+                    // doesn't use the point passed to it.
+                    const core::sampler::Distribution1D *lightDistr =
+                        lightDistribution->Lookup(cameraVertices[0].p());
+
+                    // Now trace the light subpath
+                    int nLight = GenerateLightSubpath(scene, *tileSampler, arena, maxDepth + 1,
+                        cameraVertices[0].time(), *lightDistr, lightToIndex, lightVertices);
+
+                    ComputeSubpathMISSums(cameraVertices, nCamera, true);
+                    ComputeSubpathMISSums(lightVertices, nLight, false);
+
+                    // Execute all BDPT connection strategies
+                    core::color::Spectrum L(FLOAT_0);
+                    for (int t = 1; t <= nCamera; ++t)
+                    {
+                        for (int s = 0; s <= nLight; ++s)
+                        {
+                            int depth = t + s - 2;
+                            if ((1 == s && 1 == t) || depth < 0 || depth > maxDepth)
+                            {
+                                continue;
+                            }
+
+                            // Execute the $(s, t)$ connection strategy and
+                            // update _L_
+                            common::math::Vec2f pFilmNew = pFilm;
+                            Float misWeight = FLOAT_0;
+                            core::color::Spectrum Lpath = ConnectBDPT(scene, lightVertices, cameraVertices,
+                                s, t, *lightDistr, lightToIndex, *camera, *tileSampler, &pFilmNew, &misWeight);
+                            /* TODO
+                            VLOG(2) << "Connect bdpt s: " << s << ", t: " << t <<
+                                ", Lpath: " << Lpath << ", misWeight: " << misWeight;
+                            */
+                            if (1 != t)
+                            {
+                                L += Lpath;
+                            }
+                            else
+                            {
+                                // Light subpaths that hit the lens land on
+                                // an arbitrary pixel and are splatted
+                                // atomically into the film
+                                film->AddSplat(pFilmNew, Lpath);
+                            }
+                        }
+                    }
+                    /* TODO
+                    VLOG(2) << "Add film sample pFilm: " << pFilm << ", L: " << L <<
+                        ", (y: " << L.y() << ")";
+                    */
+                    filmTile->AddSample(pFilm, L);
+                    arena.Reset();
+                }
+                while (tileSampler->StartNextSample());
+            }
+            film->MergeFilmTile(std::move(filmTile));
+            //reporter.Update();
+            /* TODO
+            LOG(INFO) << "Finished image tile " << tileBounds;
+            */
+        }, common::math::Vec2i(nXTiles, nYTiles));
+        //reporter.Done();
+    }
+    film->WriteImage(FLOAT_1 / sampler->samples_per_pixel);
+    common::tool::ReportRenderStats(film->filename);
+}
+
+/* TODO
+BDPTIntegrator *CreateBDPTIntegrator(const ParamSet &params,
+    std::shared_ptr<core::sampler::Sampler> sampler,
+    std::shared_ptr<const core::camera::Camera> camera)
+{
+    int maxDepth = params.FindOneInt("maxdepth", 5);
+    int np;
+    const int *pb = params.FindInt("pixelbounds", &np);
+    common::math::Bounds2i pixelBounds = camera->film->GetSampleBounds();
+    if (pb)
+    {
+        if (np != 4)
+            Error("Expected four values for \"pixelbounds\" parameter. Got %d.",
+                np);
+        else
+        {
+            pixelBounds = Intersect(pixelBounds,
+                common::math::Bounds2i{{pb[0], pb[2]}, {pb[1], pb[3]}});
+            if (0 == pixelBounds.Area())
+                Error("Degenerate \"pixelbounds\" specified.");
+        }
+    }
+    std::string lightStrategy = params.FindOneString("lightsamplestrategy", "power");
+    return new BDPTIntegrator(sampler, camera, maxDepth, pixelBounds, lightStrategy);
+}
+*/
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Integrator.h"
+#include "BDPTVertex.h"
+#include "../camera/Camera.h"
+#include "../sampler/Sampler.h"
+#include "../scene/Scene.h"
+#include "../../common/math/Bounds2.h"
+
+namespace core
+{
+namespace integrator
+{
+
+
+int GenerateCameraSubpath(const core::scene::Scene &scene, core::sampler::Sampler &sampler,
+    common::tool::MemoryArena &arena, int maxDepth,
+    const core::camera::Camera &camera, const common::math::Vec2f &pFilm,
+    Vertex *path);
+
+int GenerateLightSubpath(const core::scene::Scene &scene, core::sampler::Sampler &sampler,
+    common::tool::MemoryArena &arena, int maxDepth,
+    Float time, const core::sampler::Distribution1D &lightDistr,
+    const LightIndexMap &lightToIndex,
+    Vertex *path);
+
+// Precomputes the per-vertex MIS partial sums of a finished subpath; must
+// be called once on both subpaths before any ConnectBDPT() on them.
+void ComputeSubpathMISSums(Vertex *path, int nVertices, bool isCameraPath);
+
+core::color::Spectrum ConnectBDPT(const core::scene::Scene &scene, Vertex *lightVertices, Vertex *cameraVertices,
+    int s, int t, const core::sampler::Distribution1D &lightDistr,
+    const LightIndexMap &lightToIndex,
+    const core::camera::Camera &camera, core::sampler::Sampler &sampler,
+    common::math::Vec2f *pRaster, Float *misWeight = nullptr);
+
+
+class BDPTIntegrator : public Integrator
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    BDPTIntegrator(std::shared_ptr<core::sampler::Sampler> sampler,
+        std::shared_ptr<const core::camera::Camera> camera, int maxDepth,
+        const common::math::Bounds2i &pixelBounds,
+        const std::string &lightSampleStrategy = "power")
+        : sampler(sampler),
+        camera(camera),
+        maxDepth(maxDepth),
+        pixelBounds(pixelBounds),
+        lightSampleStrategy(lightSampleStrategy)
+    {}
+
+
+    void Render(const core::scene::Scene &scene);
+
+private:
+
+    std::shared_ptr<core::sampler::Sampler> sampler;
+
+    std::shared_ptr<const core::camera::Camera> camera;
+
+    const int maxDepth;
+
+    const common::math::Bounds2i pixelBounds;
+
+    const std::string lightSampleStrategy;
+};
+
+/* TODO
+BDPTIntegrator *CreateBDPTIntegrator(const ParamSet &params,
+    std::shared_ptr<core::sampler::Sampler> sampler,
+    std::shared_ptr<const core::camera::Camera> camera);
+*/
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,522 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "../bxdf/BxDF.h"
+#include "../bxdf/BSDF.h"
+#include "../camera/Camera.h"
+#include "../color/Spectrum.h"
+#include "../interaction/Interaction.h"
+#include "../interaction/SurfaceInteraction.h"
+#include "../interaction/MediumInteraction.h"
+#include "../light/Light.h"
+#include "../light/AreaLight.h"
+#include "../primitive/Primitive.h"
+#include "../sampler/Sampling.h"
+#include "../scene/Scene.h"
+#include "../../common/math/Bounds3.h"
+#include "../../common/math/Ray.h"
+#include "../../common/math/RayDifferential.h"
+#include <cstring>
+#include <unordered_map>
+
+namespace core
+{
+namespace integrator
+{
+
+
+typedef std::unordered_map<const core::light::Light *, size_t> LightIndexMap;
+
+
+inline
+Float CorrectShadingNormal(const core::interaction::SurfaceInteraction &isect,
+    const common::math::Vec3f &wo, const common::math::Vec3f &wi, core::material::TransportMode mode)
+{
+    if (core::material::TransportMode::Importance == mode)
+    {
+        Float num = AbsDot(wo, isect.shading.n) * AbsDot(wi, isect.n);
+        Float denom = AbsDot(wo, isect.n) * AbsDot(wi, isect.shading.n);
+        // wi is occasionally perpendicular to isect.shading.n; this is
+        // fine, but we don't want to return an infinite or NaN value in
+        // that case.
+        if (FLOAT_0 == denom)
+        {
+            return FLOAT_0;
+        }
+        return num / denom;
+    }
+
+    return FLOAT_1;
+}
+
+inline
+Float InfiniteLightDensity(const core::scene::Scene &scene, const core::sampler::Distribution1D &lightDistr,
+    const LightIndexMap &lightToDistrIndex, const common::math::Vec3f &w)
+{
+    Float pdf = FLOAT_0;
+    for (const auto &light : scene.infiniteLights)
+    {
+        CHECK(lightToDistrIndex.find(light.get()) != lightToDistrIndex.end());
+        size_t index = lightToDistrIndex.find(light.get())->second;
+        pdf += light->Pdf_Li(core::interaction::Interaction(), -w) * lightDistr.func[index];
+    }
+
+    return pdf / (lightDistr.funcInt * lightDistr.Count());
+}
+
+
+struct EndpointInteraction : core::interaction::Interaction
+{
+    union
+    {
+        const core::camera::Camera *camera;
+        const core::light::Light *light;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    EndpointInteraction() : Interaction(), light(nullptr)
+    {}
+
+    EndpointInteraction(const Interaction &it, const core::camera::Camera *camera)
+        : Interaction(it), camera(camera)
+    {}
+
+    EndpointInteraction(const core::camera::Camera *camera, const common::math::Rayf &ray)
+        : Interaction(ray.origin, ray.time, ray.medium), camera(camera)
+    {}
+
+    EndpointInteraction(const core::light::Light *light, const common::math::Rayf &r, const common::math::Vec3f &nl)
+        : Interaction(r.origin, r.time, r.medium), light(light)
+    {
+        n = nl;
+    }
+
+    EndpointInteraction(const Interaction &it, const core::light::Light *light)
+        : Interaction(it), light(light)
+    {}
+
+    EndpointInteraction(const common::math::Rayf &ray)
+        : Interaction(ray(FLOAT_1), ray.time, ray.medium), light(nullptr)
+    {
+        n = -ray.dir;
+    }
+};
+
+
+enum class VertexType
+{
+    Camera,
+    Light,
+    Surface,
+    Medium
+};
+
+
+struct Vertex
+{
+    VertexType type;
+    core::color::Spectrum beta;
+    union
+    {
+        EndpointInteraction ei;
+        core::interaction::MediumInteraction mi;
+        core::interaction::SurfaceInteraction si;
+    };
+    bool delta = false;
+    Float pdfFwd = FLOAT_0, pdfRev = FLOAT_0;
+
+    // Running sum of the MIS ratio products of all hypothetical strategies
+    // that would split the subpath before this vertex (see
+    // ComputeSubpathMISSums()). Filled in once per subpath so that each
+    // connection only has to patch the two vertices next to it.
+    Float misSum = FLOAT_0;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    Vertex() : ei()
+    {}
+
+    Vertex(VertexType type, const EndpointInteraction &ei, const core::color::Spectrum &beta)
+        : type(type), beta(beta), ei(ei)
+    {}
+
+    Vertex(const core::interaction::SurfaceInteraction &si, const core::color::Spectrum &beta)
+        : type(VertexType::Surface), beta(beta), si(si)
+    {}
+
+    Vertex(const core::interaction::MediumInteraction &mi, const core::color::Spectrum &beta)
+        : type(VertexType::Medium), beta(beta), mi(mi)
+    {}
+
+    // Need to define these two to make compilers happy with the non-POD
+    // objects in the anonymous union above.
+    Vertex(const Vertex &v)
+    {
+        std::memcpy(this, &v, sizeof(Vertex));
+    }
+
+    Vertex &operator=(const Vertex &v)
+    {
+        std::memcpy(this, &v, sizeof(Vertex));
+        return *this;
+    }
+
+    static inline
+    Vertex CreateCamera(const core::camera::Camera *camera, const common::math::Rayf &ray,
+        const core::color::Spectrum &beta);
+
+    static inline
+    Vertex CreateCamera(const core::camera::Camera *camera, const core::interaction::Interaction &it,
+        const core::color::Spectrum &beta);
+
+    static inline
+    Vertex CreateLight(const core::light::Light *light, const common::math::Rayf &ray,
+        const common::math::Vec3f &nLight, const core::color::Spectrum &Le, Float pdf);
+
+    static inline
+    Vertex CreateLight(const EndpointInteraction &ei, const core::color::Spectrum &beta, Float pdf);
+
+    static inline
+    Vertex CreateMedium(const core::interaction::MediumInteraction &mi, const core::color::Spectrum &beta,
+        Float pdf, const Vertex &prev);
+
+    static inline
+    Vertex CreateSurface(const core::interaction::SurfaceInteraction &si, const core::color::Spectrum &beta,
+        Float pdf, const Vertex &prev);
+
+
+    const core::interaction::Interaction &GetInteraction() const
+    {
+        switch (type)
+        {
+        case VertexType::Medium:
+            return mi;
+        case VertexType::Surface:
+            return si;
+        default:
+            return ei;
+        }
+    }
+
+    const common::math::Vec3f &p() const
+    {
+        return GetInteraction().p;
+    }
+
+    Float time() const
+    {
+        return GetInteraction().time;
+    }
+
+    const common::math::Vec3f &ng() const
+    {
+        return GetInteraction().n;
+    }
+
+    const common::math::Vec3f &ns() const
+    {
+        if (VertexType::Surface == type)
+        {
+            return si.shading.n;
+        }
+        return GetInteraction().n;
+    }
+
+    bool IsOnSurface() const
+    {
+        return ng() != common::math::Vec3f(FLOAT_0);
+    }
+
+
+    core::color::Spectrum f(const Vertex &next, core::material::TransportMode mode) const
+    {
+        common::math::Vec3f wi = next.p() - p();
+        if (FLOAT_0 == LengthSquared(wi))
+        {
+            return core::color::Spectrum(FLOAT_0);
+        }
+        wi = Normalize(wi);
+        switch (type)
+        {
+        case VertexType::Surface:
+            return si.bsdf->f(si.wo, wi) * CorrectShadingNormal(si, si.wo, wi, mode);
+        case VertexType::Medium:
+            return core::color::Spectrum(mi.phase->p(mi.wo, wi));
+        default:
+            //LOG(FATAL) << "Vertex::f(): Unimplemented";
+            CHECK(false);
+            return core::color::Spectrum(FLOAT_0);
+        }
+    }
+
+    bool IsConnectible() const
+    {
+        switch (type)
+        {
+        case VertexType::Medium:
+            return true;
+        case VertexType::Light:
+            return 0 == (ei.light->flags & static_cast<int>(core::light::LightFlags::DeltaDirection));
+        case VertexType::Camera:
+            return true;
+        case VertexType::Surface:
+            return si.bsdf->NumComponents(core::bxdf::BxDFType(core::bxdf::BxDFType::BSDF_DIFFUSE
+                | core::bxdf::BxDFType::BSDF_GLOSSY | core::bxdf::BxDFType::BSDF_REFLECTION
+                | core::bxdf::BxDFType::BSDF_TRANSMISSION)) > 0;
+        }
+        //LOG(FATAL) << "Unhandled vertex type in IsConnectable()";
+        return false;
+    }
+
+    bool IsLight() const
+    {
+        return VertexType::Light == type
+            || (VertexType::Surface == type && si.primitive->GetAreaLight());
+    }
+
+    bool IsDeltaLight() const
+    {
+        return VertexType::Light == type && ei.light && core::light::IsDeltaLight(ei.light->flags);
+    }
+
+    bool IsInfiniteLight() const
+    {
+        return VertexType::Light == type
+            && (!ei.light || (ei.light->flags & static_cast<int>(core::light::LightFlags::Infinite))
+                || (ei.light->flags & static_cast<int>(core::light::LightFlags::DeltaDirection)));
+    }
+
+    core::color::Spectrum Le(const core::scene::Scene &scene, const Vertex &v) const
+    {
+        if (!IsLight())
+        {
+            return core::color::Spectrum(FLOAT_0);
+        }
+        common::math::Vec3f w = v.p() - p();
+        if (FLOAT_0 == LengthSquared(w))
+        {
+            return core::color::Spectrum(FLOAT_0);
+        }
+        w = Normalize(w);
+        if (IsInfiniteLight())
+        {
+            // Return emitted radiance for infinite light sources
+            core::color::Spectrum Le(FLOAT_0);
+            for (const auto &light : scene.infiniteLights)
+            {
+                Le += light->Le(common::math::RayDifferentialf(common::math::Rayf(p(), -w)));
+            }
+            return Le;
+        }
+        else
+        {
+            const core::light::AreaLight *light = si.primitive->GetAreaLight();
+            CHECK(nullptr != light);
+            return light->L(si, w);
+        }
+    }
+
+
+    Float ConvertDensity(Float pdf, const Vertex &next) const
+    {
+        // Return solid angle density if _next_ is an infinite area light
+        if (next.IsInfiniteLight())
+        {
+            return pdf;
+        }
+        common::math::Vec3f w = next.p() - p();
+        if (FLOAT_0 == LengthSquared(w))
+        {
+            return FLOAT_0;
+        }
+        Float invDist2 = FLOAT_1 / LengthSquared(w);
+        if (next.IsOnSurface())
+        {
+            pdf *= AbsDot(next.ng(), w * std::sqrt(invDist2));
+        }
+        return pdf * invDist2;
+    }
+
+    Float Pdf(const core::scene::Scene &scene, const Vertex *prev, const Vertex &next) const
+    {
+        if (VertexType::Light == type)
+        {
+            return PdfLight(scene, next);
+        }
+
+        // Compute directions to preceding and next vertex
+        common::math::Vec3f wn = next.p() - p();
+        if (FLOAT_0 == LengthSquared(wn))
+        {
+            return FLOAT_0;
+        }
+        wn = Normalize(wn);
+        common::math::Vec3f wp;
+        if (prev)
+        {
+            wp = prev->p() - p();
+            if (FLOAT_0 == LengthSquared(wp))
+            {
+                return FLOAT_0;
+            }
+            wp = Normalize(wp);
+        }
+        else
+        {
+            CHECK(VertexType::Camera == type);
+        }
+
+        // Compute directional density depending on the vertex types
+        Float pdf = FLOAT_0, unused;
+        if (VertexType::Camera == type)
+        {
+            ei.camera->Pdf_We(ei.SpawnRay(wn), &unused, &pdf);
+        }
+        else if (VertexType::Surface == type)
+        {
+            pdf = si.bsdf->Pdf(wp, wn);
+        }
+        else if (VertexType::Medium == type)
+        {
+            pdf = mi.phase->p(wp, wn);
+        }
+        else
+        {
+            //LOG(FATAL) << "Vertex::Pdf(): Unimplemented";
+            CHECK(false);
+        }
+
+        // Return probability per unit area at vertex _next_
+        return ConvertDensity(pdf, next);
+    }
+
+    Float PdfLight(const core::scene::Scene &scene, const Vertex &v) const
+    {
+        common::math::Vec3f w = v.p() - p();
+        Float invDist2 = FLOAT_1 / LengthSquared(w);
+        w *= std::sqrt(invDist2);
+        Float pdf;
+        if (IsInfiniteLight())
+        {
+            // Compute planar sampling density for infinite light sources
+            common::math::Vec3f worldCenter;
+            Float worldRadius;
+            scene.WorldBound().BoundingSphere(&worldCenter, &worldRadius);
+            pdf = FLOAT_1 / (common::math::PI * worldRadius * worldRadius);
+        }
+        else
+        {
+            // Get pointer _light_ to the light source at the vertex
+            CHECK(IsLight());
+            const core::light::Light *light = VertexType::Light == type
+                ? ei.light : si.primitive->GetAreaLight();
+            CHECK(nullptr != light);
+
+            // Compute sampling density for non-infinite light sources
+            Float pdfPos, pdfDir;
+            light->Pdf_Le(common::math::Rayf(p(), w, (std::numeric_limits<Float>::max)(), FLOAT_0, time()),
+                ng(), &pdfPos, &pdfDir);
+            pdf = pdfDir * invDist2;
+        }
+        if (v.IsOnSurface())
+        {
+            pdf *= AbsDot(v.ng(), w);
+        }
+        return pdf;
+    }
+
+    Float PdfLightOrigin(const core::scene::Scene &scene, const Vertex &v,
+        const core::sampler::Distribution1D &lightDistr, const LightIndexMap &lightToDistrIndex) const
+    {
+        common::math::Vec3f w = v.p() - p();
+        if (FLOAT_0 == LengthSquared(w))
+        {
+            return FLOAT_0;
+        }
+        w = Normalize(w);
+        if (IsInfiniteLight())
+        {
+            // Return solid angle density for infinite light sources
+            return InfiniteLightDensity(scene, lightDistr, lightToDistrIndex, w);
+        }
+        else
+        {
+            // Return solid angle density for non-infinite light sources
+            Float pdfPos, pdfDir, pdfChoice = FLOAT_0;
+
+            // Get pointer _light_ to the light source at the vertex
+            CHECK(IsLight());
+            const core::light::Light *light = VertexType::Light == type
+                ? ei.light : si.primitive->GetAreaLight();
+            CHECK(nullptr != light);
+
+            // Compute the discrete probability of sampling _light_, _pdfChoice_
+            CHECK(lightToDistrIndex.find(light) != lightToDistrIndex.end());
+            size_t index = lightToDistrIndex.find(light)->second;
+            pdfChoice = lightDistr.DiscretePDF(static_cast<int>(index));
+
+            light->Pdf_Le(common::math::Rayf(p(), w, (std::numeric_limits<Float>::max)(), FLOAT_0, time()),
+                ng(), &pdfPos, &pdfDir);
+            return pdfPos * pdfChoice;
+        }
+    }
+};
+
+
+inline
+Vertex Vertex::CreateCamera(const core::camera::Camera *camera, const common::math::Rayf &ray,
+    const core::color::Spectrum &beta)
+{
+    return Vertex(VertexType::Camera, EndpointInteraction(camera, ray), beta);
+}
+
+inline
+Vertex Vertex::CreateCamera(const core::camera::Camera *camera, const core::interaction::Interaction &it,
+    const core::color::Spectrum &beta)
+{
+    return Vertex(VertexType::Camera, EndpointInteraction(it, camera), beta);
+}
+
+inline
+Vertex Vertex::CreateLight(const core::light::Light *light, const common::math::Rayf &ray,
+    const common::math::Vec3f &Nl, const core::color::Spectrum &Le, Float pdf)
+{
+    Vertex v(VertexType::Light, EndpointInteraction(light, ray, Nl), Le);
+    v.pdfFwd = pdf;
+    return v;
+}
+
+inline
+Vertex Vertex::CreateLight(const EndpointInteraction &ei, const core::color::Spectrum &beta, Float pdf)
+{
+    Vertex v(VertexType::Light, ei, beta);
+    v.pdfFwd = pdf;
+    return v;
+}
+
+inline
+Vertex Vertex::CreateMedium(const core::interaction::MediumInteraction &mi, const core::color::Spectrum &beta,
+    Float pdf, const Vertex &prev)
+{
+    Vertex v(mi, beta);
+    v.pdfFwd = prev.ConvertDensity(pdf, v);
+    return v;
+}
+
+inline
+Vertex Vertex::CreateSurface(const core::interaction::SurfaceInteraction &si, const core::color::Spectrum &beta,
+    Float pdf, const Vertex &prev)
+{
+    Vertex v(si, beta);
+    v.pdfFwd = prev.ConvertDensity(pdf, v);
+    return v;
+}
+
+
+}
+}
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include "../sampler/Sampling.h"
 #include "../../common/math/RayDifferential.h"
 #include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -48,7 +49,7 @@ core::color::Spectrum DirectLightingIntegrator::Li(const common::math::RayDiffer
     const core::scene::Scene &scene, core::sampler::Sampler &sampler,
     common::tool::MemoryArena &arena, int depth) const
 {
-    //ProfilePhase p(Prof::SamplerIntegratorLi);
+    common::tool::ProfilePhase p(common::tool::Prof::SamplerIntegratorLi);
     core::color::Spectrum L(FLOAT_0);
     // Find closest ray intersection or return background radiance
     core::interaction::SurfaceInteraction isect;
@@ -1,6 +1,7 @@
 #include "Integrator.h"
 #include "../bxdf/BxDF.h"
 #include "../bxdf/BSDF.h"
+#include "../color/HeroSpectrum.h"
 #include "../color/Spectrum.h"
 #include "../interaction/Interaction.h"
 #include "../interaction/SurfaceInteraction.h"
@@ -14,6 +15,7 @@
 #include "../sampler/Sampling.h"
 #include "../../common/math/RayDifferential.h"
 #include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -27,171 +29,170 @@ Integrator::~Integrator()
 }
 
 
-core::color::Spectrum UniformSampleAllLights(const core::interaction::Interaction &it, const core::scene::Scene &scene,
-    common::tool::MemoryArena &arena, core::sampler::Sampler &sampler,
-    const std::vector<int> &nLightSamples,
-    bool handleMedia)
+template <>
+core::color::Spectrum Le<core::color::Spectrum>(const core::interaction::SurfaceInteraction &isect,
+    const common::math::Vec3f &w, const core::color::SampledWavelengths &lambda)
 {
-    //ProfilePhase p(Prof::DirectLighting);
-    core::color::Spectrum L(FLOAT_0);
-    for (size_t j = 0; j < scene.lights.size(); ++j)
-    {
-        // Accumulate contribution of _j_th light to _L_
-        const std::shared_ptr<core::light::Light> &light = scene.lights[j];
-        int nSamples = nLightSamples[j];
-        const common::math::Vec2f *uLightArray = sampler.Get2DArray(nSamples);
-        const common::math::Vec2f *uScatteringArray = sampler.Get2DArray(nSamples);
-        if (!uLightArray || !uScatteringArray)
-        {
-            // Use a single sample for illumination from _light_
-            common::math::Vec2f uLight = sampler.Get2D();
-            common::math::Vec2f uScattering = sampler.Get2D();
-            L += EstimateDirect(it, uScattering, *light, uLight, scene, sampler,
-                arena, handleMedia);
-        }
-        else
-        {
-            // Estimate direct lighting using sample arrays
-            core::color::Spectrum Ld(FLOAT_0);
-            for (int k = 0; k < nSamples; ++k)
-            {
-                Ld += EstimateDirect(it, uScatteringArray[k], *light,
-                    uLightArray[k], scene, sampler, arena,
-                    handleMedia);
-            }
-            L += Ld / static_cast<Float>(nSamples);
-        }
-    }
-    return L;
+    return isect.Le(w);
 }
 
-core::color::Spectrum UniformSampleOneLight(const core::interaction::Interaction &it, const core::scene::Scene &scene,
-    common::tool::MemoryArena &arena, core::sampler::Sampler &sampler,
-    bool handleMedia, const core::sampler::Distribution1D *lightDistrib)
+template <>
+core::color::HeroSpectrum Le<core::color::HeroSpectrum>(const core::interaction::SurfaceInteraction &isect,
+    const common::math::Vec3f &w, const core::color::SampledWavelengths &lambda)
 {
-    //ProfilePhase p(Prof::DirectLighting);
-    // Randomly choose a single light to sample, _light_
-    int nLights = static_cast<int>(scene.lights.size());
-    if (0 == nLights)
-    {
-        return core::color::Spectrum(FLOAT_0);
-    }
-    int lightNum;
-    Float lightPdf;
-    if (lightDistrib)
-    {
-        lightNum = lightDistrib->SampleDiscrete(sampler.Get1D(), &lightPdf);
-        if (0 == lightPdf)
-        {
-            return core::color::Spectrum(FLOAT_0);
-        }
-    }
-    else
-    {
-        lightNum = (std::min)(static_cast<int>(sampler.Get1D() * nLights), nLights - 1);
-        lightPdf = FLOAT_1 / nLights;
-    }
-    const std::shared_ptr<core::light::Light> &light = scene.lights[lightNum];
-    common::math::Vec2f uLight = sampler.Get2D();
-    common::math::Vec2f uScattering = sampler.Get2D();
-    return EstimateDirect(it, uScattering, *light, uLight,
-        scene, sampler, arena, handleMedia) / lightPdf;
+    return isect.Le(w, lambda);
 }
 
-core::color::Spectrum EstimateDirect(const core::interaction::Interaction &it, const common::math::Vec2f &uScattering,
-    const core::light::Light &light, const common::math::Vec2f &uLight,
-    const core::scene::Scene &scene, core::sampler::Sampler &sampler,
-    common::tool::MemoryArena &arena, bool handleMedia, bool specular)
+template <>
+core::color::Spectrum Le<core::color::Spectrum>(const core::light::Light &light,
+    const common::math::RayDifferentialf &ray, const core::color::SampledWavelengths &lambda)
 {
-    core::bxdf::BxDFType bsdfFlags = specular ? core::bxdf::BxDFType::BSDF_ALL
-        : core::bxdf::BxDFType(core::bxdf::BxDFType::BSDF_ALL & ~core::bxdf::BxDFType::BSDF_SPECULAR);
-    core::color::Spectrum Ld(FLOAT_0);
-    // Sample light source with multiple importance sampling
-    common::math::Vec3f wi;
-    Float lightPdf = FLOAT_0, scatteringPdf = FLOAT_0;
-    core::light::VisibilityTester visibility;
-    core::color::Spectrum Li = light.Sample_Li(it, uLight, &wi, &lightPdf, &visibility);
-    /* TODO
-    VLOG(2) << "EstimateDirect uLight:" << uLight << " -> Li: " << Li << ", wi: "
-        << wi << ", pdf: " << lightPdf;
-    */
-    if (lightPdf > FLOAT_0 && !Li.IsBlack())
+    return light.Le(ray);
+}
+
+template <>
+core::color::HeroSpectrum Le<core::color::HeroSpectrum>(const core::light::Light &light,
+    const common::math::RayDifferentialf &ray, const core::color::SampledWavelengths &lambda)
+{
+    return light.Le(ray, lambda);
+}
+
+template <>
+core::color::Spectrum Sample_f<core::color::Spectrum>(const core::bxdf::BSDF &bsdf,
+    const common::math::Vec3f &wo, common::math::Vec3f *wi, const common::math::Vec2f &u, Float *pdf,
+    core::color::SampledWavelengths &lambda, core::bxdf::BxDFType type, core::bxdf::BxDFType *sampledType)
+{
+    return bsdf.Sample_f(wo, wi, u, pdf, type, sampledType);
+}
+
+template <>
+core::color::HeroSpectrum Sample_f<core::color::HeroSpectrum>(const core::bxdf::BSDF &bsdf,
+    const common::math::Vec3f &wo, common::math::Vec3f *wi, const common::math::Vec2f &u, Float *pdf,
+    core::color::SampledWavelengths &lambda, core::bxdf::BxDFType type, core::bxdf::BxDFType *sampledType)
+{
+    return bsdf.Sample_f(wo, wi, u, pdf, lambda, type, sampledType);
+}
+
+
+// Light sampling and BSDF evaluation in the same two forms, for
+// EstimateDirect()
+template <typename S>
+static S Sample_Li(const core::light::Light &light, const core::interaction::Interaction &ref,
+    const common::math::Vec2f &u, const core::color::SampledWavelengths &lambda, common::math::Vec3f *wi,
+    Float *pdf, core::light::VisibilityTester *vis);
+
+template <>
+core::color::Spectrum Sample_Li<core::color::Spectrum>(const core::light::Light &light,
+    const core::interaction::Interaction &ref, const common::math::Vec2f &u,
+    const core::color::SampledWavelengths &lambda, common::math::Vec3f *wi, Float *pdf,
+    core::light::VisibilityTester *vis)
+{
+    return light.Sample_Li(ref, u, wi, pdf, vis);
+}
+
+template <>
+core::color::HeroSpectrum Sample_Li<core::color::HeroSpectrum>(const core::light::Light &light,
+    const core::interaction::Interaction &ref, const common::math::Vec2f &u,
+    const core::color::SampledWavelengths &lambda, common::math::Vec3f *wi, Float *pdf,
+    core::light::VisibilityTester *vis)
+{
+    return light.Sample_Li(ref, u, lambda, wi, pdf, vis);
+}
+
+template <typename S>
+static S EvaluateBSDF(const core::bxdf::BSDF &bsdf, const common::math::Vec3f &wo, const common::math::Vec3f &wi,
+    const core::color::SampledWavelengths &lambda, core::bxdf::BxDFType flags);
+
+template <>
+core::color::Spectrum EvaluateBSDF<core::color::Spectrum>(const core::bxdf::BSDF &bsdf,
+    const common::math::Vec3f &wo, const common::math::Vec3f &wi, const core::color::SampledWavelengths &lambda,
+    core::bxdf::BxDFType flags)
+{
+    return bsdf.f(wo, wi, flags);
+}
+
+template <>
+core::color::HeroSpectrum EvaluateBSDF<core::color::HeroSpectrum>(const core::bxdf::BSDF &bsdf,
+    const common::math::Vec3f &wo, const common::math::Vec3f &wi, const core::color::SampledWavelengths &lambda,
+    core::bxdf::BxDFType flags)
+{
+    return bsdf.f(wo, wi, lambda, flags);
+}
+
+
+// The light sampling half of EstimateDirect() once the BSDF or phase
+// function value _f_ and its pdf are known for the sampled direction:
+// tests visibility and applies the MIS weight
+template <typename S>
+static S WeightLightSample(const core::light::Light &light, S Li,
+    Float lightPdf, const S &f, Float scatteringPdf,
+    const core::light::VisibilityTester &visibility,
+    const core::scene::Scene &scene, core::sampler::Sampler &sampler, bool handleMedia,
+    const core::color::SampledWavelengths &lambda)
+{
+    S Ld(FLOAT_0);
+    if (!f.IsBlack())
     {
-        // Compute BSDF or phase function's value for light sample
-        core::color::Spectrum f;
-        if (it.IsSurfaceInteraction())
+        // Compute effect of visibility for light source sample
+        if (handleMedia)
         {
-            // Evaluate BSDF for light sampling strategy
-            const core::interaction::SurfaceInteraction &isect = (const core::interaction::SurfaceInteraction &)it;
-            f = isect.bsdf->f(isect.wo, wi, bsdfFlags) * AbsDot(wi, isect.shading.n);
-            scatteringPdf = isect.bsdf->Pdf(isect.wo, wi, bsdfFlags);
+            Li *= core::color::AtWavelengths<S>(visibility.Tr(scene, sampler), lambda);
             /* TODO
-            VLOG(2) << "  surf f*dot :" << f << ", scatteringPdf: " << scatteringPdf;
+            VLOG(2) << "  after Tr, Li: " << Li;
             */
         }
         else
         {
-            // Evaluate phase function for light sampling strategy
-            const core::interaction::MediumInteraction &mi = (const core::interaction::MediumInteraction &)it;
-            Float p = mi.phase->p(mi.wo, wi);
-            f = core::color::Spectrum(p);
-            scatteringPdf = p;
-            /* TODO
-            VLOG(2) << "  medium p: " << p;
-            */
-        }
-        if (!f.IsBlack())
-        {
-            // Compute effect of visibility for light source sample
-            if (handleMedia)
+            if (!visibility.Unoccluded(scene))
             {
-                Li *= visibility.Tr(scene, sampler);
                 /* TODO
-                VLOG(2) << "  after Tr, Li: " << Li;
+                VLOG(2) << "  shadow ray blocked";
+                Li = S(FLOAT_0);
                 */
             }
+            /* TODO
             else
+                VLOG(2) << "  shadow ray unoccluded";
+            */
+        }
+
+        // Add light's contribution to reflected radiance
+        if (!Li.IsBlack())
+        {
+            if (core::light::IsDeltaLight(light.flags))
             {
-                if (!visibility.Unoccluded(scene))
-                {
-                    /* TODO
-                    VLOG(2) << "  shadow ray blocked";
-                    Li = core::color::Spectrum(FLOAT_0);
-                    */
-                }
-                /* TODO
-                else
-                    VLOG(2) << "  shadow ray unoccluded";
-                */
+                Ld += f * Li / lightPdf;
             }
-
-            // Add light's contribution to reflected radiance
-            if (!Li.IsBlack())
+            else
             {
-                if (core::light::IsDeltaLight(light.flags))
-                {
-                    Ld += f * Li / lightPdf;
-                }
-                else
-                {
-                    Float weight = core::sampler::PowerHeuristic(1, lightPdf, 1, scatteringPdf);
-                    Ld += f * Li * weight / lightPdf;
-                }
+                Float weight = core::sampler::PowerHeuristic(1, lightPdf, 1, scatteringPdf);
+                Ld += f * Li * weight / lightPdf;
             }
         }
     }
+    return Ld;
+}
 
-    // Sample BSDF with multiple importance sampling
+// The BSDF or phase function sampling half of EstimateDirect()
+template <typename S>
+static S SampleScattering(const core::interaction::Interaction &it,
+    const common::math::Vec2f &uScattering, const core::light::Light &light,
+    const core::scene::Scene &scene, core::sampler::Sampler &sampler, bool handleMedia,
+    core::bxdf::BxDFType bsdfFlags, core::color::SampledWavelengths &lambda)
+{
+    S Ld(FLOAT_0);
     if (!core::light::IsDeltaLight(light.flags))
     {
-        core::color::Spectrum f;
+        common::math::Vec3f wi;
+        Float lightPdf = FLOAT_0, scatteringPdf = FLOAT_0;
+        S f;
         bool sampledSpecular = false;
         if (it.IsSurfaceInteraction())
         {
             // Sample scattered direction for surface interactions
             core::bxdf::BxDFType sampledType;
             const core::interaction::SurfaceInteraction &isect = (const core::interaction::SurfaceInteraction &)it;
-            f = isect.bsdf->Sample_f(isect.wo, &wi, uScattering, &scatteringPdf,
+            f = Sample_f<S>(*isect.bsdf, isect.wo, &wi, uScattering, &scatteringPdf, lambda,
                 bsdfFlags, &sampledType);
             f *= AbsDot(wi, isect.shading.n);
             sampledSpecular = (sampledType & core::bxdf::BxDFType::BSDF_SPECULAR) != 0;
@@ -201,7 +202,7 @@ core::color::Spectrum EstimateDirect(const core::interaction::Interaction &it, c
             // Sample scattered direction for medium interactions
             const core::interaction::MediumInteraction &mi = (const core::interaction::MediumInteraction &)it;
             Float p = mi.phase->Sample_p(mi.wo, &wi, uScattering);
-            f = core::color::Spectrum(p);
+            f = S(p);
             scatteringPdf = p;
         }
 
@@ -232,27 +233,222 @@ core::color::Spectrum EstimateDirect(const core::interaction::Interaction &it, c
                 : scene.Intersect(ray, &lightIsect);
 
             // Add light contribution from material sampling
-            core::color::Spectrum Li(FLOAT_0);
+            S Li(FLOAT_0);
             if (foundSurfaceInteraction)
             {
                 if (lightIsect.primitive->GetAreaLight() == &light)
                 {
-                    Li = lightIsect.Le(-wi);
+                    Li = Le<S>(lightIsect, -wi, lambda);
                 }
             }
             else
             {
-                Li = light.Le(ray);
+                Li = Le<S>(light, ray, lambda);
             }
             if (!Li.IsBlack())
             {
-                Ld += f * Li * Tr * weight / scatteringPdf;
+                Ld += f * Li * core::color::AtWavelengths<S>(Tr, lambda) * weight / scatteringPdf;
             }
         }
     }
     return Ld;
 }
 
+// EstimateDirect() for all _nSamples_ samples of one light at a surface
+// point: every light sample is drawn first so the BSDF is evaluated for
+// all of their directions with one batched f() and Pdf() call
+static core::color::Spectrum EstimateDirect(const core::interaction::SurfaceInteraction &isect,
+    const common::math::Vec2f *uScattering, const core::light::Light &light,
+    const common::math::Vec2f *uLight, int nSamples,
+    const core::scene::Scene &scene, core::sampler::Sampler &sampler,
+    common::tool::MemoryArena &arena, bool handleMedia)
+{
+    core::bxdf::BxDFType bsdfFlags =
+        core::bxdf::BxDFType(core::bxdf::BxDFType::BSDF_ALL & ~core::bxdf::BxDFType::BSDF_SPECULAR);
+    common::math::Vec3f *wi = arena.Alloc<common::math::Vec3f>(nSamples);
+    Float *lightPdf = arena.Alloc<Float>(nSamples, false);
+    Float *scatteringPdf = arena.Alloc<Float>(nSamples, false);
+    core::color::Spectrum *Li = arena.Alloc<core::color::Spectrum>(nSamples, false);
+    core::color::Spectrum *f = arena.Alloc<core::color::Spectrum>(nSamples, false);
+    core::light::VisibilityTester *visibility = arena.Alloc<core::light::VisibilityTester>(nSamples);
+    for (int k = 0; k < nSamples; ++k)
+    {
+        lightPdf[k] = FLOAT_0;
+        Li[k] = light.Sample_Li(isect, uLight[k], &wi[k], &lightPdf[k], &visibility[k]);
+    }
+    isect.bsdf->f(isect.wo, nSamples, wi, f, bsdfFlags);
+    isect.bsdf->Pdf(isect.wo, nSamples, wi, scatteringPdf, bsdfFlags);
+
+    core::color::SampledWavelengths lambda;
+    core::color::Spectrum Ld(FLOAT_0);
+    for (int k = 0; k < nSamples; ++k)
+    {
+        if (lightPdf[k] > FLOAT_0 && !Li[k].IsBlack())
+        {
+            Ld += WeightLightSample<core::color::Spectrum>(light, Li[k], lightPdf[k],
+                f[k] * AbsDot(wi[k], isect.shading.n), scatteringPdf[k], visibility[k], scene, sampler,
+                handleMedia, lambda);
+        }
+        Ld += SampleScattering<core::color::Spectrum>(isect, uScattering[k], light, scene, sampler,
+            handleMedia, bsdfFlags, lambda);
+    }
+    return Ld;
+}
+
+
+core::color::Spectrum UniformSampleAllLights(const core::interaction::Interaction &it, const core::scene::Scene &scene,
+    common::tool::MemoryArena &arena, core::sampler::Sampler &sampler,
+    const std::vector<int> &nLightSamples,
+    bool handleMedia)
+{
+    common::tool::ProfilePhase p(common::tool::Prof::DirectLighting);
+    core::color::Spectrum L(FLOAT_0);
+    for (size_t j = 0; j < scene.lights.size(); ++j)
+    {
+        // Accumulate contribution of _j_th light to _L_
+        const std::shared_ptr<core::light::Light> &light = scene.lights[j];
+        int nSamples = nLightSamples[j];
+        const common::math::Vec2f *uLightArray = sampler.Get2DArray(nSamples);
+        const common::math::Vec2f *uScatteringArray = sampler.Get2DArray(nSamples);
+        if (!uLightArray || !uScatteringArray)
+        {
+            // Use a single sample for illumination from _light_
+            common::math::Vec2f uLight = sampler.Get2D();
+            common::math::Vec2f uScattering = sampler.Get2D();
+            L += EstimateDirect(it, uScattering, *light, uLight, scene, sampler,
+                arena, handleMedia);
+        }
+        else
+        {
+            // Estimate direct lighting using sample arrays
+            core::color::Spectrum Ld(FLOAT_0);
+            if (it.IsSurfaceInteraction() && nSamples > 1)
+            {
+                Ld = EstimateDirect((const core::interaction::SurfaceInteraction &)it, uScatteringArray,
+                    *light, uLightArray, nSamples, scene, sampler, arena, handleMedia);
+            }
+            else
+            {
+                for (int k = 0; k < nSamples; ++k)
+                {
+                    Ld += EstimateDirect(it, uScatteringArray[k], *light,
+                        uLightArray[k], scene, sampler, arena,
+                        handleMedia);
+                }
+            }
+            L += Ld / static_cast<Float>(nSamples);
+        }
+    }
+    return L;
+}
+
+// EstimateDirect() returning the spectrum of UniformSampleOneLight<S>()
+template <typename S>
+static S EstimateDirect(const core::interaction::Interaction &it, const common::math::Vec2f &uScattering,
+    const core::light::Light &light, const common::math::Vec2f &uLight,
+    const core::scene::Scene &scene, core::sampler::Sampler &sampler,
+    bool handleMedia, bool specular, core::color::SampledWavelengths &lambda)
+{
+    core::bxdf::BxDFType bsdfFlags = specular ? core::bxdf::BxDFType::BSDF_ALL
+        : core::bxdf::BxDFType(core::bxdf::BxDFType::BSDF_ALL & ~core::bxdf::BxDFType::BSDF_SPECULAR);
+    S Ld(FLOAT_0);
+    // Sample light source with multiple importance sampling
+    common::math::Vec3f wi;
+    Float lightPdf = FLOAT_0, scatteringPdf = FLOAT_0;
+    core::light::VisibilityTester visibility;
+    S Li = Sample_Li<S>(light, it, uLight, lambda, &wi, &lightPdf, &visibility);
+    /* TODO
+    VLOG(2) << "EstimateDirect uLight:" << uLight << " -> Li: " << Li << ", wi: "
+        << wi << ", pdf: " << lightPdf;
+    */
+    if (lightPdf > FLOAT_0 && !Li.IsBlack())
+    {
+        // Compute BSDF or phase function's value for light sample
+        S f;
+        if (it.IsSurfaceInteraction())
+        {
+            // Evaluate BSDF for light sampling strategy
+            const core::interaction::SurfaceInteraction &isect = (const core::interaction::SurfaceInteraction &)it;
+            f = EvaluateBSDF<S>(*isect.bsdf, isect.wo, wi, lambda, bsdfFlags) * AbsDot(wi, isect.shading.n);
+            scatteringPdf = isect.bsdf->Pdf(isect.wo, wi, bsdfFlags);
+            /* TODO
+            VLOG(2) << "  surf f*dot :" << f << ", scatteringPdf: " << scatteringPdf;
+            */
+        }
+        else
+        {
+            // Evaluate phase function for light sampling strategy
+            const core::interaction::MediumInteraction &mi = (const core::interaction::MediumInteraction &)it;
+            Float p = mi.phase->p(mi.wo, wi);
+            f = S(p);
+            scatteringPdf = p;
+            /* TODO
+            VLOG(2) << "  medium p: " << p;
+            */
+        }
+        Ld += WeightLightSample<S>(light, Li, lightPdf, f, scatteringPdf, visibility, scene, sampler, handleMedia,
+            lambda);
+    }
+
+    // Sample BSDF with multiple importance sampling
+    Ld += SampleScattering<S>(it, uScattering, light, scene, sampler, handleMedia, bsdfFlags, lambda);
+    return Ld;
+}
+
+template <typename S>
+S UniformSampleOneLight(const core::interaction::Interaction &it, const core::scene::Scene &scene,
+    common::tool::MemoryArena &arena, core::sampler::Sampler &sampler,
+    core::color::SampledWavelengths &lambda, bool handleMedia,
+    const core::sampler::Distribution1D *lightDistrib)
+{
+    common::tool::ProfilePhase p(common::tool::Prof::DirectLighting);
+    // Randomly choose a single light to sample, _light_
+    int nLights = static_cast<int>(scene.lights.size());
+    if (0 == nLights)
+    {
+        return S(FLOAT_0);
+    }
+    int lightNum;
+    Float lightPdf;
+    if (lightDistrib)
+    {
+        lightNum = lightDistrib->SampleDiscrete(sampler.Get1D(), &lightPdf);
+        if (0 == lightPdf)
+        {
+            return S(FLOAT_0);
+        }
+    }
+    else
+    {
+        lightNum = (std::min)(static_cast<int>(sampler.Get1D() * nLights), nLights - 1);
+        lightPdf = FLOAT_1 / nLights;
+    }
+    const std::shared_ptr<core::light::Light> &light = scene.lights[lightNum];
+    common::math::Vec2f uLight = sampler.Get2D();
+    common::math::Vec2f uScattering = sampler.Get2D();
+    return EstimateDirect<S>(it, uScattering, *light, uLight,
+        scene, sampler, handleMedia, false, lambda) / lightPdf;
+}
+
+core::color::Spectrum UniformSampleOneLight(const core::interaction::Interaction &it, const core::scene::Scene &scene,
+    common::tool::MemoryArena &arena, core::sampler::Sampler &sampler,
+    bool handleMedia, const core::sampler::Distribution1D *lightDistrib)
+{
+    core::color::SampledWavelengths lambda;
+    return UniformSampleOneLight<core::color::Spectrum>(it, scene, arena, sampler, lambda, handleMedia,
+        lightDistrib);
+}
+
+core::color::Spectrum EstimateDirect(const core::interaction::Interaction &it, const common::math::Vec2f &uScattering,
+    const core::light::Light &light, const common::math::Vec2f &uLight,
+    const core::scene::Scene &scene, core::sampler::Sampler &sampler,
+    common::tool::MemoryArena &arena, bool handleMedia, bool specular)
+{
+    core::color::SampledWavelengths lambda;
+    return EstimateDirect<core::color::Spectrum>(it, uScattering, light, uLight, scene, sampler,
+        handleMedia, specular, lambda);
+}
+
 std::unique_ptr<core::sampler::Distribution1D> ComputeLightPowerDistribution(
     const core::scene::Scene &scene)
 {
@@ -270,5 +466,18 @@ std::unique_ptr<core::sampler::Distribution1D> ComputeLightPowerDistribution(
 }
 
 
+template core::color::Spectrum UniformSampleOneLight<core::color::Spectrum>(
+    const core::interaction::Interaction &it, const core::scene::Scene &scene,
+    common::tool::MemoryArena &arena, core::sampler::Sampler &sampler,
+    core::color::SampledWavelengths &lambda, bool handleMedia,
+    const core::sampler::Distribution1D *lightDistrib);
+
+template core::color::HeroSpectrum UniformSampleOneLight<core::color::HeroSpectrum>(
+    const core::interaction::Interaction &it, const core::scene::Scene &scene,
+    common::tool::MemoryArena &arena, core::sampler::Sampler &sampler,
+    core::color::SampledWavelengths &lambda, bool handleMedia,
+    const core::sampler::Distribution1D *lightDistrib);
+
+
 }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../ForwardDeclaration.h"
+#include "../bxdf/BxDF.h"
 #include <vector>
 
 namespace core
@@ -37,6 +38,56 @@ core::color::Spectrum EstimateDirect(const core::interaction::Interaction &it, c
     common::tool::MemoryArena &arena, bool handleMedia = false,
     bool specular = false);
 
+// UniformSampleOneLight() returning dense spectra for _Spectrum_, or
+// values at the wavelengths of _lambda_ for _HeroSpectrum_
+template <typename S>
+S UniformSampleOneLight(const core::interaction::Interaction &it, const core::scene::Scene &scene,
+    common::tool::MemoryArena &arena, core::sampler::Sampler &sampler,
+    core::color::SampledWavelengths &lambda, bool handleMedia = false,
+    const core::sampler::Distribution1D *lightDistrib = nullptr);
+
+
+// Emission and BSDF sampling for integrators templated on the spectrum they
+// carry along a path, in the same two forms
+template <typename S>
+S Le(const core::interaction::SurfaceInteraction &isect, const common::math::Vec3f &w,
+    const core::color::SampledWavelengths &lambda);
+
+template <typename S>
+S Le(const core::light::Light &light, const common::math::RayDifferentialf &ray,
+    const core::color::SampledWavelengths &lambda);
+
+template <typename S>
+S Sample_f(const core::bxdf::BSDF &bsdf, const common::math::Vec3f &wo, common::math::Vec3f *wi,
+    const common::math::Vec2f &u, Float *pdf, core::color::SampledWavelengths &lambda,
+    core::bxdf::BxDFType type, core::bxdf::BxDFType *sampledType);
+
+template <>
+core::color::Spectrum Le<core::color::Spectrum>(const core::interaction::SurfaceInteraction &isect,
+    const common::math::Vec3f &w, const core::color::SampledWavelengths &lambda);
+
+template <>
+core::color::HeroSpectrum Le<core::color::HeroSpectrum>(const core::interaction::SurfaceInteraction &isect,
+    const common::math::Vec3f &w, const core::color::SampledWavelengths &lambda);
+
+template <>
+core::color::Spectrum Le<core::color::Spectrum>(const core::light::Light &light,
+    const common::math::RayDifferentialf &ray, const core::color::SampledWavelengths &lambda);
+
+template <>
+core::color::HeroSpectrum Le<core::color::HeroSpectrum>(const core::light::Light &light,
+    const common::math::RayDifferentialf &ray, const core::color::SampledWavelengths &lambda);
+
+template <>
+core::color::Spectrum Sample_f<core::color::Spectrum>(const core::bxdf::BSDF &bsdf,
+    const common::math::Vec3f &wo, common::math::Vec3f *wi, const common::math::Vec2f &u, Float *pdf,
+    core::color::SampledWavelengths &lambda, core::bxdf::BxDFType type, core::bxdf::BxDFType *sampledType);
+
+template <>
+core::color::HeroSpectrum Sample_f<core::color::HeroSpectrum>(const core::bxdf::BSDF &bsdf,
+    const common::math::Vec3f &wo, common::math::Vec3f *wi, const common::math::Vec2f &u, Float *pdf,
+    core::color::SampledWavelengths &lambda, core::bxdf::BxDFType type, core::bxdf::BxDFType *sampledType);
+
 std::unique_ptr<core::sampler::Distribution1D> ComputeLightPowerDistribution(
     const core::scene::Scene &scene);
 
@@ -15,6 +15,7 @@
 #include "../sampler/Sampling.h"
 #include "../../common/math/RayDifferential.h"
 #include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/Stats.h"
 #include <numeric>
 
 namespace core
@@ -23,6 +24,11 @@ namespace integrator
 {
 
 
+STAT_COUNTER("SpatialLightDistribution/Lookups", nLookups);
+STAT_COUNTER("SpatialLightDistribution/Hash table probes", nProbesTotal);
+STAT_COUNTER("SpatialLightDistribution/Distributions created", nCreated);
+
+
 LightDistribution::~LightDistribution()
 {}
 
@@ -133,8 +139,8 @@ SpatialLightDistribution::~SpatialLightDistribution()
 
 const core::sampler::Distribution1D *SpatialLightDistribution::Lookup(const common::math::Vec3f &p) const
 {
-    //ProfilePhase _(Prof::LightDistribLookup);
-    //++nLookups;
+    common::tool::ProfilePhase _(common::tool::Prof::LightDistribLookup);
+    ++nLookups;
 
     // First, compute integer voxel coordinates for the given point |p|
     // with respect to the overall voxel grid.
@@ -192,7 +198,7 @@ const core::sampler::Distribution1D *SpatialLightDistribution::Lookup(const comm
                 // the sampling distribution is ready.  We assume that this
                 // is a rare case, so don't do anything more sophisticated
                 // than spinning.
-                //ProfilePhase _(Prof::LightDistribSpinWait);
+                common::tool::ProfilePhase _(common::tool::Prof::LightDistribSpinWait);
                 while ((dist = entry.distribution.load(std::memory_order_acquire)) ==
                     nullptr)
                     // spin :-(. If we were fancy, we'd have any threads
@@ -201,7 +207,7 @@ const core::sampler::Distribution1D *SpatialLightDistribution::Lookup(const comm
                     ;
             }
             // We have a valid sampling distribution.
-            //ReportValue(nProbesPerLookup, nProbes);
+            nProbesTotal += nProbes;
             return dist;
         }
         else if (entryPackedPos != invalidPackedPos)
@@ -234,7 +240,7 @@ const core::sampler::Distribution1D *SpatialLightDistribution::Lookup(const comm
                 // written.
                 core::sampler::Distribution1D *dist = ComputeDistribution(pi);
                 entry.distribution.store(dist, std::memory_order_release);
-                //ReportValue(nProbesPerLookup, nProbes);
+                nProbesTotal += nProbes;
                 return dist;
             }
         }
@@ -243,9 +249,8 @@ const core::sampler::Distribution1D *SpatialLightDistribution::Lookup(const comm
 
 core::sampler::Distribution1D * SpatialLightDistribution::ComputeDistribution(common::math::Vec3i pi) const
 {
-    //ProfilePhase _(Prof::LightDistribCreation);
-    //++nCreated;
-    //++nDistributions;
+    common::tool::ProfilePhase _(common::tool::Prof::LightDistribCreation);
+    ++nCreated;
 
     // Compute the world-space bounding box of the voxel corresponding to
     // |pi|.
@@ -16,6 +16,7 @@
 #include "../sampler/Sampling.h"
 #include "../../common/math/RayDifferential.h"
 #include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -27,11 +28,12 @@ PathIntegrator::PathIntegrator(int maxDepth,
     std::shared_ptr<const core::camera::Camera> camera,
     std::shared_ptr<core::sampler::Sampler> sampler,
     const common::math::Bounds2i &pixelBounds, Float rrThreshold,
-    const std::string &lightSampleStrategy)
+    const std::string &lightSampleStrategy, bool heroWavelengths)
     : SamplerIntegrator(camera, sampler, pixelBounds),
     maxDepth(maxDepth),
     rrThreshold(rrThreshold),
-    lightSampleStrategy(lightSampleStrategy)
+    lightSampleStrategy(lightSampleStrategy),
+    heroWavelengths(heroWavelengths)
 {}
 
 void PathIntegrator::Preprocess(const core::scene::Scene &scene, core::sampler::Sampler &sampler)
@@ -43,8 +45,26 @@ core::color::Spectrum PathIntegrator::Li(const common::math::RayDifferentialf &r
     core::sampler::Sampler &sampler, common::tool::MemoryArena &arena,
     int depth) const
 {
-    //ProfilePhase p(Prof::SamplerIntegratorLi);
-    core::color::Spectrum L(FLOAT_0), beta(FLOAT_1);
+    core::color::SampledWavelengths lambda;
+    return Trace<core::color::Spectrum>(r, scene, sampler, arena, lambda);
+}
+
+void PathIntegrator::LiXYZ(const common::math::RayDifferentialf &r, const core::scene::Scene &scene,
+    core::sampler::Sampler &sampler, common::tool::MemoryArena &arena, Float xyz[3]) const
+{
+    core::color::SampledWavelengths lambda = core::color::SampledWavelengths::SampleUniform(sampler.Get1D());
+    core::color::HeroSpectrum L = Trace<core::color::HeroSpectrum>(r, scene, sampler, arena, lambda);
+
+    L.ToXYZ(lambda, xyz);
+}
+
+template <typename S>
+S PathIntegrator::Trace(const common::math::RayDifferentialf &r, const core::scene::Scene &scene,
+    core::sampler::Sampler &sampler, common::tool::MemoryArena &arena,
+    core::color::SampledWavelengths &lambda) const
+{
+    common::tool::ProfilePhase p(common::tool::Prof::SamplerIntegratorLi);
+    S L(FLOAT_0), beta(FLOAT_1);
     common::math::RayDifferentialf ray(r);
     bool specularBounce = false;
     int bounces;
@@ -75,7 +95,7 @@ core::color::Spectrum PathIntegrator::Li(const common::math::RayDifferentialf &r
             // Add emitted light at path vertex or from the environment
             if (foundIntersection)
             {
-                L += beta * isect.Le(-ray.dir);
+                L.AddProduct(beta, Le<S>(isect, -ray.dir, lambda));
                 /* TODO
                 VLOG(2) << "Added Le -> L = " << L;
                 */
@@ -83,7 +103,7 @@ core::color::Spectrum PathIntegrator::Li(const common::math::RayDifferentialf &r
             else
             {
                 for (const auto &light : scene.infiniteLights)
-                    L += beta * light->Le(ray);
+                    L.AddProduct(beta, Le<S>(*light, ray, lambda));
                 /* TODO
                 VLOG(2) << "Added infinite area lights -> L = " << L;
                 */
@@ -113,8 +133,7 @@ core::color::Spectrum PathIntegrator::Li(const common::math::RayDifferentialf &r
             core::bxdf::BxDFType(core::bxdf::BxDFType::BSDF_ALL & ~core::bxdf::BxDFType::BSDF_SPECULAR)) > 0)
         {
             //++totalPaths;
-            core::color::Spectrum Ld = beta * UniformSampleOneLight(isect, scene, arena,
-                sampler, false, distrib);
+            S Ld = beta * UniformSampleOneLight<S>(isect, scene, arena, sampler, lambda, false, distrib);
             /* TODO
             VLOG(2) << "Sampled direct lighting Ld = " << Ld;
             */
@@ -122,7 +141,7 @@ core::color::Spectrum PathIntegrator::Li(const common::math::RayDifferentialf &r
             {
                 //++zeroRadiancePaths;
             }
-            CHECK_GE(Ld.y(), FLOAT_0);
+            CHECK_GE(core::color::Luminance(Ld, lambda), FLOAT_0);
             L += Ld;
         }
 
@@ -130,7 +149,7 @@ core::color::Spectrum PathIntegrator::Li(const common::math::RayDifferentialf &r
         common::math::Vec3f wo = -ray.dir, wi;
         Float pdf;
         core::bxdf::BxDFType flags;
-        core::color::Spectrum f = isect.bsdf->Sample_f(wo, &wi, sampler.Get2D(), &pdf,
+        S f = Sample_f<S>(*isect.bsdf, wo, &wi, sampler.Get2D(), &pdf, lambda,
             core::bxdf::BxDFType::BSDF_ALL, &flags);
         /* TODO
         VLOG(2) << "Sampled BSDF, f = " << f << ", pdf = " << pdf;
@@ -139,12 +158,12 @@ core::color::Spectrum PathIntegrator::Li(const common::math::RayDifferentialf &r
         {
             break;
         }
-        beta *= f * AbsDot(wi, isect.shading.n) / pdf;
+        beta.MulScaled(f, AbsDot(wi, isect.shading.n) / pdf);
         /* TODO
         VLOG(2) << "Updated beta = " << beta;
         */
-        CHECK_GE(beta.y(), FLOAT_0);
-        CHECK(!std::isinf(beta.y()));
+        CHECK_GE(core::color::Luminance(beta, lambda), FLOAT_0);
+        CHECK(!std::isinf(core::color::Luminance(beta, lambda)));
         specularBounce = (flags & core::bxdf::BxDFType::BSDF_SPECULAR) != 0;
         if ((flags & core::bxdf::BxDFType::BSDF_SPECULAR) && (flags & core::bxdf::BxDFType::BSDF_TRANSMISSION))
         {
@@ -161,35 +180,35 @@ core::color::Spectrum PathIntegrator::Li(const common::math::RayDifferentialf &r
         {
             // Importance sample the BSSRDF
             core::interaction::SurfaceInteraction pi;
-            core::color::Spectrum S = isect.bssrdf->Sample_S(
-                scene, sampler.Get1D(), sampler.Get2D(), arena, &pi, &pdf);
-            CHECK(!std::isinf(beta.y()));
-            if (S.IsBlack() || FLOAT_0 == pdf)
+            S Sp = core::color::AtWavelengths<S>(isect.bssrdf->Sample_S(
+                scene, sampler.Get1D(), sampler.Get2D(), arena, &pi, &pdf), lambda);
+            CHECK(!std::isinf(core::color::Luminance(beta, lambda)));
+            if (Sp.IsBlack() || FLOAT_0 == pdf)
             {
                 break;
             }
-            beta *= S / pdf;
+            beta *= Sp / pdf;
 
             // Account for the direct subsurface scattering component
-            L += beta * UniformSampleOneLight(pi, scene, arena, sampler, false,
-                lightDistribution->Lookup(pi.p));
+            L.AddProduct(beta, UniformSampleOneLight<S>(pi, scene, arena, sampler, lambda, false,
+                lightDistribution->Lookup(pi.p)));
 
             // Account for the indirect subsurface scattering component
-            core::color::Spectrum f = pi.bsdf->Sample_f(pi.wo, &wi, sampler.Get2D(), &pdf,
+            S f = Sample_f<S>(*pi.bsdf, pi.wo, &wi, sampler.Get2D(), &pdf, lambda,
                 core::bxdf::BxDFType::BSDF_ALL, &flags);
             if (f.IsBlack() || FLOAT_0 == pdf)
             {
                 break;
             }
-            beta *= f * AbsDot(wi, pi.shading.n) / pdf;
-            CHECK(!std::isinf(beta.y()));
+            beta.MulScaled(f, AbsDot(wi, pi.shading.n) / pdf);
+            CHECK(!std::isinf(core::color::Luminance(beta, lambda)));
             specularBounce = (flags & core::bxdf::BxDFType::BSDF_SPECULAR) != 0;
             ray = pi.SpawnRay(wi);
         }
 
         // Possibly terminate the path with Russian roulette.
         // Factor out radiance scaling due to refraction in rrBeta.
-        core::color::Spectrum rrBeta = beta * etaScale;
+        S rrBeta = beta * etaScale;
         if (rrBeta.MaxComponentValue() < rrThreshold && bounces > 3)
         {
             Float q = (std::max)(static_cast<Float>(0.05F), FLOAT_1 - rrBeta.MaxComponentValue());
@@ -198,7 +217,7 @@ core::color::Spectrum PathIntegrator::Li(const common::math::RayDifferentialf &r
                 break;
             }
             beta /= FLOAT_1 - q;
-            CHECK(!std::isinf(beta.y()));
+            CHECK(!std::isinf(core::color::Luminance(beta, lambda)));
         }
     }
     //ReportValue(pathLength, bounces);
@@ -230,8 +249,9 @@ PathIntegrator *CreatePathIntegrator(const ParamSet &params,
     Float rrThreshold = params.FindOneFloat("rrthreshold", 1.);
     std::string lightStrategy =
         params.FindOneString("lightsamplestrategy", "spatial");
+    bool heroWavelengths = params.FindOneBool("herowavelengths", false);
     return new PathIntegrator(maxDepth, camera, sampler, pixelBounds,
-        rrThreshold, lightStrategy);
+        rrThreshold, lightStrategy, heroWavelengths);
 }
 */
 
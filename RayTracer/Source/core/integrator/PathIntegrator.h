@@ -1,6 +1,7 @@
 #pragma once
 
 #include "SamplerIntegrator.h"
+#include "../color/HeroSpectrum.h"
 
 namespace core
 {
@@ -19,7 +20,7 @@ public:
     PathIntegrator(int maxDepth, std::shared_ptr<const core::camera::Camera> camera,
         std::shared_ptr<core::sampler::Sampler> sampler,
         const common::math::Bounds2i &pixelBounds, Float rrThreshold = FLOAT_1,
-        const std::string &lightSampleStrategy = "spatial");
+        const std::string &lightSampleStrategy = "spatial", bool heroWavelengths = false);
 
 
     void Preprocess(const core::scene::Scene &scene, core::sampler::Sampler &sampler);
@@ -27,14 +28,32 @@ public:
     core::color::Spectrum Li(const common::math::RayDifferentialf &ray, const core::scene::Scene &scene,
         core::sampler::Sampler &sampler, common::tool::MemoryArena &arena, int depth) const;
 
+    bool IsSpectral() const
+    {
+        return heroWavelengths;
+    }
+
+    void LiXYZ(const common::math::RayDifferentialf &ray, const core::scene::Scene &scene,
+        core::sampler::Sampler &sampler, common::tool::MemoryArena &arena, Float xyz[3]) const;
+
 private:
 
+    // Path tracing loop shared by dense spectra (_Spectrum_) and the
+    // hero-wavelength mode (_HeroSpectrum_ at _lambda_)
+    template <typename S>
+    S Trace(const common::math::RayDifferentialf &r, const core::scene::Scene &scene,
+        core::sampler::Sampler &sampler, common::tool::MemoryArena &arena,
+        core::color::SampledWavelengths &lambda) const;
+
+
     const int maxDepth;
 
     const Float rrThreshold;
 
     const std::string lightSampleStrategy;
 
+    const bool heroWavelengths;
+
     std::unique_ptr<LightDistribution> lightDistribution;
 };
 
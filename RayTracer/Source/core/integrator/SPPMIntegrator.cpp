@@ -0,0 +1,593 @@
+#include "SPPMIntegrator.h"
+#include "../bxdf/BxDF.h"
+#include "../bxdf/BSDF.h"
+#include "../color/Spectrum.h"
+#include "../film/Film.h"
+#include "../interaction/Interaction.h"
+#include "../interaction/SurfaceInteraction.h"
+#include "../light/Light.h"
+#include "../scene/Scene.h"
+#include "../sampler/Sampler.h"
+#include "../sampler/Sampling.h"
+#include "../texture/ImageTexture.h"
+#include "../../common/math/Bounds3.h"
+#include "../../common/math/RayDifferential.h"
+#include "../../common/tool/LookupCache.h"
+#include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/MultiThread.h"
+#include "../../common/tool/Stats.h"
+#include <atomic>
+#include <vector>
+
+namespace core
+{
+namespace integrator
+{
+
+
+STAT_COUNTER("Memory/SPPM pixels and visible points (bytes)", pixelMemoryBytes);
+
+
+// Radiance sums are only ever needed as RGB when the image is written, so
+// they are reduced on the fly instead of keeping a Spectrum of
+// SAMPLE_NUMBER Floats for each of them.
+static void AddRGB(Float rgb[3], const core::color::Spectrum &s)
+{
+    Float c[3];
+    s.ToRGB(c);
+    rgb[0] += c[0];
+    rgb[1] += c[1];
+    rgb[2] += c[2];
+}
+
+
+struct SPPMPixel
+{
+    Float radius = FLOAT_0;
+    Float Ld[3] = { FLOAT_0, FLOAT_0, FLOAT_0 };
+
+    // Photon flux already weighted by the visible point's _beta_, so the
+    // update step never needs the visible point again.
+    common::tool::AtomicFloat Phi[3];
+    std::atomic<int> M;
+    Float N = FLOAT_0;
+    Float tau[3] = { FLOAT_0, FLOAT_0, FLOAT_0 };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    SPPMPixel() : M(0)
+    {}
+};
+
+
+// Where the camera path of _pixel_ ended in this iteration. Only pixels
+// whose path produced one have one, kept densely apart from the pixels;
+// the throughput is only ever multiplied into RGB flux, so it is kept as
+// RGB too.
+struct SPPMVisiblePoint
+{
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    SPPMVisiblePoint(SPPMPixel *pixel, const common::math::Vec3f &p, const common::math::Vec3f &wo,
+        const core::bxdf::BSDF *bsdf, const core::color::Spectrum &beta)
+        : pixel(pixel), p(p), wo(wo), bsdf(bsdf)
+    {
+        beta.ToRGB(this->beta);
+    }
+
+
+    SPPMPixel *pixel;
+    common::math::Vec3f p;
+    common::math::Vec3f wo;
+    // Lives in the camera pass arena, which is kept until the iteration ends
+    const core::bxdf::BSDF *bsdf;
+    Float beta[3];
+};
+
+
+struct SPPMPixelListNode
+{
+    SPPMVisiblePoint *vp;
+    SPPMPixelListNode *next;
+};
+
+
+static bool ToGrid(const common::math::Vec3f &p, const common::math::Bounds3f &bounds, const int gridRes[3],
+    common::math::Vec3i *pi)
+{
+    bool inBounds = true;
+    common::math::Vec3f pg = bounds.Offset(p);
+    for (int i = 0; i < 3; ++i)
+    {
+        (*pi)[i] = static_cast<int>(gridRes[i] * pg[i]);
+        inBounds &= ((*pi)[i] >= 0 && (*pi)[i] < gridRes[i]);
+        (*pi)[i] = common::math::Clamp((*pi)[i], 0, gridRes[i] - 1);
+    }
+
+    return inBounds;
+}
+
+inline
+unsigned int HashGrid(const common::math::Vec3i &p, int hashSize)
+{
+    return (unsigned int)((p.x * 73856093) ^ (p.y * 19349663) ^ (p.z * 83492791)) % hashSize;
+}
+
+
+void SPPMIntegrator::Render(const core::scene::Scene &scene)
+{
+    common::tool::ProfilePhase p(common::tool::Prof::IntegratorRender);
+    CHECK_GE(sampler->samples_per_pixel, nIterations);
+    // Image textures are built in the background while the scene is set up
+    core::texture::WaitForImageTextures();
+
+    // Initialize _pixelBounds_ and _pixels_ array for SPPM
+    common::math::Bounds2i pixelBounds = camera->film->croppedPixelBounds;
+    int nPixels = pixelBounds.Area();
+    std::unique_ptr<SPPMPixel[]> pixels(new SPPMPixel[nPixels]);
+    for (int i = 0; i < nPixels; ++i)
+    {
+        pixels[i].radius = initialSearchRadius;
+    }
+    const Float invSqrtSPP = FLOAT_1 / std::sqrt(static_cast<Float>(nIterations));
+    pixelMemoryBytes += static_cast<int64_t>(nPixels) * sizeof(SPPMPixel);
+
+    // Each thread appends the visible points of its tiles to its own list;
+    // they are gathered into _visiblePoints_ for the grid. The lists keep
+    // their capacity from one iteration to the next.
+    std::vector<std::vector<SPPMVisiblePoint>> threadVisiblePoints(common::tool::MaxThreadIndex());
+    std::vector<SPPMVisiblePoint> visiblePoints;
+
+    // Compute _lightDistr_ for sampling lights proportional to power
+    std::unique_ptr<core::sampler::Distribution1D> lightDistr = ComputeLightPowerDistribution(scene);
+
+    // Perform _nIterations_ of SPPM integration
+
+    // Compute number of tiles to use for SPPM camera pass
+    common::math::Vec2i pixelExtent = pixelBounds.Diagonal();
+    const int tileSize = 16;
+    common::math::Vec2i nTiles((pixelExtent.x + tileSize - 1) / tileSize,
+        (pixelExtent.y + tileSize - 1) / tileSize);
+    //ProgressReporter progress(2 * nIterations, "Rendering");
+    for (int iter = 0; iter < nIterations; ++iter)
+    {
+        // Generate SPPM visible points
+        std::vector<common::tool::MemoryArena> perThreadArenas(common::tool::MaxThreadIndex());
+        {
+            common::tool::ProfilePhase _(common::tool::Prof::SPPMCameraPass);
+            common::tool::ParallelFor2D([&](common::math::Vec2i tile)
+            {
+                common::tool::MemoryArena &arena = perThreadArenas[common::tool::ThreadIndex];
+                std::vector<SPPMVisiblePoint> &tileVisiblePoints = threadVisiblePoints[common::tool::ThreadIndex];
+                // Follow camera paths for _tile_ in image for SPPM
+                int tileIndex = tile.y * nTiles.x + tile.x;
+                std::unique_ptr<core::sampler::Sampler> tileSampler = sampler->Clone(tileIndex);
+
+                // Compute _tileBounds_ for SPPM tile
+                int x0 = pixelBounds.point_min.x + tile.x * tileSize;
+                int x1 = (std::min)(x0 + tileSize, pixelBounds.point_max.x);
+                int y0 = pixelBounds.point_min.y + tile.y * tileSize;
+                int y1 = (std::min)(y0 + tileSize, pixelBounds.point_max.y);
+                common::math::Bounds2i tileBounds(common::math::Vec2i(x0, y0), common::math::Vec2i(x1, y1));
+                for (common::math::Vec2i pPixel : tileBounds)
+                {
+                    // Prepare _tileSampler_ for _pPixel_
+                    tileSampler->StartPixel(pPixel);
+                    tileSampler->SetSampleNumber(iter);
+                    common::tool::LookupCacheStartPixel();
+
+                    // Generate camera ray for pixel for SPPM
+                    core::camera::CameraSample cameraSample = tileSampler->GetCameraSample(pPixel);
+                    common::math::RayDifferentialf ray;
+                    core::color::Spectrum beta(camera->GenerateRayDifferential(cameraSample, &ray));
+                    if (beta.IsBlack())
+                    {
+                        continue;
+                    }
+                    ray.ScaleDifferentials(invSqrtSPP);
+
+                    // Follow camera ray path until a visible point is created
+
+                    // Get _SPPMPixel_ for _pPixel_
+                    common::math::Vec2i pPixelO = pPixel - pixelBounds.point_min;
+                    int pixelOffset = pPixelO.x + pPixelO.y * (pixelBounds.point_max.x - pixelBounds.point_min.x);
+                    SPPMPixel &pixel = pixels[pixelOffset];
+                    bool specularBounce = false;
+                    for (int depth = 0; depth < maxDepth; ++depth)
+                    {
+                        core::interaction::SurfaceInteraction isect;
+                        //++totalPhotonSurfaceInteractions;
+                        if (!scene.Intersect(ray, &isect))
+                        {
+                            // Accumulate light contributions for ray with no
+                            // intersection
+                            for (const auto &light : scene.lights)
+                            {
+                                AddRGB(pixel.Ld, beta * light->Le(ray));
+                            }
+                            break;
+                        }
+                        // Process SPPM camera ray intersection
+
+                        // Compute BSDF at SPPM camera ray intersection
+                        isect.ComputeScatteringFunctions(ray, arena, true);
+                        if (!isect.bsdf)
+                        {
+                            ray = isect.SpawnRay(ray.dir);
+                            --depth;
+                            continue;
+                        }
+                        const core::bxdf::BSDF &bsdf = *isect.bsdf;
+
+                        // Accumulate direct illumination at SPPM camera ray
+                        // intersection
+                        common::math::Vec3f wo = -ray.dir;
+                        if (0 == depth || specularBounce)
+                        {
+                            AddRGB(pixel.Ld, beta * isect.Le(wo));
+                        }
+                        AddRGB(pixel.Ld, beta * UniformSampleOneLight(isect, scene, arena, *tileSampler));
+
+                        // Possibly create visible point and end camera path
+                        bool isDiffuse = bsdf.NumComponents(core::bxdf::BxDFType(core::bxdf::BxDFType::BSDF_DIFFUSE
+                            | core::bxdf::BxDFType::BSDF_REFLECTION | core::bxdf::BxDFType::BSDF_TRANSMISSION)) > 0;
+                        bool isGlossy = bsdf.NumComponents(core::bxdf::BxDFType(core::bxdf::BxDFType::BSDF_GLOSSY
+                            | core::bxdf::BxDFType::BSDF_REFLECTION | core::bxdf::BxDFType::BSDF_TRANSMISSION)) > 0;
+                        if (isDiffuse || (isGlossy && maxDepth - 1 == depth))
+                        {
+                            tileVisiblePoints.emplace_back(&pixel, isect.p, wo, &bsdf, beta);
+                            break;
+                        }
+
+                        // Spawn ray from SPPM camera path vertex
+                        if (depth < maxDepth - 1)
+                        {
+                            Float pdf;
+                            common::math::Vec3f wi;
+                            core::bxdf::BxDFType type;
+                            core::color::Spectrum f = bsdf.Sample_f(wo, &wi, tileSampler->Get2D(), &pdf,
+                                core::bxdf::BxDFType::BSDF_ALL, &type);
+                            if (FLOAT_0 == pdf || f.IsBlack())
+                            {
+                                break;
+                            }
+                            specularBounce = (type & core::bxdf::BxDFType::BSDF_SPECULAR) != 0;
+                            beta.MulScaled(f, AbsDot(wi, isect.shading.n) / pdf);
+                            if (beta.y() < static_cast<Float>(0.25F))
+                            {
+                                Float continueProb = (std::min)(FLOAT_1, beta.y());
+                                if (tileSampler->Get1D() > continueProb)
+                                {
+                                    break;
+                                }
+                                beta /= continueProb;
+                            }
+                            ray = static_cast<common::math::RayDifferentialf>(isect.SpawnRay(wi));
+                        }
+                    }
+                }
+            }, nTiles);
+        }
+        //progress.Update();
+        visiblePoints.clear();
+        for (std::vector<SPPMVisiblePoint> &points : threadVisiblePoints)
+        {
+            visiblePoints.insert(visiblePoints.end(), points.begin(), points.end());
+            points.clear();
+        }
+        const int nVisiblePoints = static_cast<int>(visiblePoints.size());
+
+        // Create grid of all SPPM visible points
+        int gridRes[3];
+        common::math::Bounds3f gridBounds;
+        // Allocate grid for SPPM visible points
+        const int hashSize = nPixels;
+        std::vector<std::atomic<SPPMPixelListNode *>> grid(hashSize);
+        {
+            common::tool::ProfilePhase _(common::tool::Prof::SPPMGridConstruction);
+
+            // Compute grid bounds for SPPM visible points; every thread
+            // reduces its own share of the points first
+            const int nThreads = common::tool::MaxThreadIndex();
+            std::vector<common::math::Bounds3f> threadBounds(nThreads);
+            std::vector<Float> threadMaxRadius(nThreads, FLOAT_0);
+            for (common::math::Bounds3f &b : threadBounds)
+            {
+                b.point_min = common::math::Vec3f((std::numeric_limits<Float>::max)());
+                b.point_max = common::math::Vec3f(std::numeric_limits<Float>::lowest());
+            }
+            common::tool::ParallelFor([&](int64_t vpIndex)
+            {
+                const SPPMVisiblePoint &vp = visiblePoints[vpIndex];
+                if (FLOAT_0 == vp.beta[0] && FLOAT_0 == vp.beta[1] && FLOAT_0 == vp.beta[2])
+                {
+                    return;
+                }
+                Float radius = vp.pixel->radius;
+                common::math::Bounds3f vpBound = Expand(common::math::Bounds3f(vp.p), radius);
+                int index = common::tool::ThreadIndex;
+                threadBounds[index] = Union(threadBounds[index], vpBound);
+                threadMaxRadius[index] = (std::max)(threadMaxRadius[index], radius);
+            }, nVisiblePoints, 4096);
+
+            gridBounds = threadBounds[0];
+            Float maxRadius = threadMaxRadius[0];
+            for (int i = 1; i < nThreads; ++i)
+            {
+                gridBounds = Union(gridBounds, threadBounds[i]);
+                maxRadius = (std::max)(maxRadius, threadMaxRadius[i]);
+            }
+
+            // Compute resolution of SPPM grid in each dimension
+            common::math::Vec3f diag = gridBounds.Diagonal();
+            Float maxDiag = diag[MaxDim(diag)];
+            int baseGridRes = maxRadius > FLOAT_0 ? static_cast<int>(maxDiag / maxRadius) : 1;
+            CHECK_GT(baseGridRes, 0);
+            for (int i = 0; i < 3; ++i)
+            {
+                gridRes[i] = (std::max)(static_cast<int>(baseGridRes * diag[i] / maxDiag), 1);
+            }
+
+            // Add visible points to SPPM grid; nodes are pushed onto the
+            // bucket lists with a CAS so no locks are needed
+            common::tool::ParallelFor([&](int64_t vpIndex)
+            {
+                common::tool::MemoryArena &arena = perThreadArenas[common::tool::ThreadIndex];
+                SPPMVisiblePoint &vp = visiblePoints[vpIndex];
+                if (FLOAT_0 != vp.beta[0] || FLOAT_0 != vp.beta[1] || FLOAT_0 != vp.beta[2])
+                {
+                    // Add pixel's visible point to applicable grid cells
+                    Float radius = vp.pixel->radius;
+                    common::math::Vec3i pMin, pMax;
+                    ToGrid(vp.p - common::math::Vec3f(radius, radius, radius), gridBounds, gridRes, &pMin);
+                    ToGrid(vp.p + common::math::Vec3f(radius, radius, radius), gridBounds, gridRes, &pMax);
+                    for (int z = pMin.z; z <= pMax.z; ++z)
+                    {
+                        for (int y = pMin.y; y <= pMax.y; ++y)
+                        {
+                            for (int x = pMin.x; x <= pMax.x; ++x)
+                            {
+                                // Add visible point to grid cell $(x, y, z)$
+                                int h = HashGrid(common::math::Vec3i(x, y, z), hashSize);
+                                SPPMPixelListNode *node = arena.Alloc<SPPMPixelListNode>();
+                                node->vp = &vp;
+
+                                // Atomically add _node_ to the start of
+                                // _grid[h]_'s linked list
+                                node->next = grid[h];
+                                while (!grid[h].compare_exchange_weak(node->next, node))
+                                {
+                                }
+                            }
+                        }
+                    }
+                    //ReportValue(gridCellsPerVisiblePoint, (1 + pMax.x - pMin.x) * (1 + pMax.y - pMin.y) * (1 + pMax.z - pMin.z));
+                }
+            }, nVisiblePoints, 4096);
+        }
+
+        // Trace photons and accumulate contributions
+        {
+            common::tool::ProfilePhase _(common::tool::Prof::SPPMPhotonPass);
+            std::vector<common::tool::MemoryArena> photonShootArenas(common::tool::MaxThreadIndex());
+            common::tool::ParallelFor([&](int64_t photonIndex)
+            {
+                common::tool::MemoryArena &arena = photonShootArenas[common::tool::ThreadIndex];
+                // Follow photon path for _photonIndex_
+                uint64_t haltonIndex = static_cast<uint64_t>(iter) * static_cast<uint64_t>(photonsPerIteration)
+                    + photonIndex;
+                int haltonDim = 0;
+
+                // Choose light to shoot photon from
+                Float lightPdf;
+                Float lightSample = core::sampler::RadicalInverse(haltonDim++, haltonIndex);
+                int lightNum = lightDistr->SampleDiscrete(lightSample, &lightPdf);
+                const std::shared_ptr<core::light::Light> &light = scene.lights[lightNum];
+
+                // Compute sample values for photon ray leaving light source
+                common::math::Vec2f uLight0(core::sampler::RadicalInverse(haltonDim, haltonIndex),
+                    core::sampler::RadicalInverse(haltonDim + 1, haltonIndex));
+                common::math::Vec2f uLight1(core::sampler::RadicalInverse(haltonDim + 2, haltonIndex),
+                    core::sampler::RadicalInverse(haltonDim + 3, haltonIndex));
+                Float uLightTime = common::math::Lerp(core::sampler::RadicalInverse(haltonDim + 4, haltonIndex),
+                    camera->shutterOpen, camera->shutterClose);
+                haltonDim += 5;
+
+                // Generate _photonRay_ from light source and initialize _beta_
+                common::math::Rayf lightRay;
+                common::math::Vec3f nLight;
+                Float pdfPos, pdfDir;
+                core::color::Spectrum Le = light->Sample_Le(uLight0, uLight1, uLightTime, &lightRay, &nLight,
+                    &pdfPos, &pdfDir);
+                if (FLOAT_0 == pdfPos || FLOAT_0 == pdfDir || Le.IsBlack())
+                {
+                    return;
+                }
+                common::math::RayDifferentialf photonRay(lightRay);
+                core::color::Spectrum beta = (AbsDot(nLight, photonRay.dir) * Le) / (lightPdf * pdfPos * pdfDir);
+                if (beta.IsBlack())
+                {
+                    return;
+                }
+
+                // Follow photon path through scene and record intersections
+                core::interaction::SurfaceInteraction isect;
+                for (int depth = 0; depth < maxDepth; ++depth)
+                {
+                    if (!scene.Intersect(photonRay, &isect))
+                    {
+                        break;
+                    }
+                    //++totalPhotonSurfaceInteractions;
+                    if (depth > 0)
+                    {
+                        // Add photon contribution to nearby visible points
+                        common::math::Vec3i photonGridIndex;
+                        if (ToGrid(isect.p, gridBounds, gridRes, &photonGridIndex))
+                        {
+                            int h = HashGrid(photonGridIndex, hashSize);
+                            // Add photon contribution to visible points in
+                            // _grid[h]_
+                            for (SPPMPixelListNode *node = grid[h].load(std::memory_order_relaxed);
+                                nullptr != node; node = node->next)
+                            {
+                                //++visiblePointsChecked;
+                                const SPPMVisiblePoint &vp = *node->vp;
+                                SPPMPixel &pixel = *vp.pixel;
+                                Float radius = pixel.radius;
+                                if (DistanceSquared(vp.p, isect.p) > radius * radius)
+                                {
+                                    continue;
+                                }
+                                // Update _pixel_ $\Phi$ and $M$ for nearby
+                                // photon
+                                common::math::Vec3f wi = -photonRay.dir;
+                                core::color::Spectrum Phi = beta * vp.bsdf->f(vp.wo, wi);
+                                Float rgb[3];
+                                Phi.ToRGB(rgb);
+                                for (int i = 0; i < 3; ++i)
+                                {
+                                    pixel.Phi[i].Add(vp.beta[i] * rgb[i]);
+                                }
+                                ++pixel.M;
+                            }
+                        }
+                    }
+                    // Sample new photon ray direction
+
+                    // Compute BSDF at photon intersection point
+                    isect.ComputeScatteringFunctions(photonRay, arena, true,
+                        core::material::TransportMode::Importance);
+                    if (!isect.bsdf)
+                    {
+                        --depth;
+                        photonRay = isect.SpawnRay(photonRay.dir);
+                        continue;
+                    }
+                    const core::bxdf::BSDF &photonBSDF = *isect.bsdf;
+
+                    // Sample BSDF _fr_ and direction _wi_ for reflected photon
+                    common::math::Vec3f wi, wo = -photonRay.dir;
+                    Float pdf;
+                    core::bxdf::BxDFType flags;
+
+                    // Generate _bsdfSample_ for outgoing photon sample
+                    common::math::Vec2f bsdfSample(core::sampler::RadicalInverse(haltonDim, haltonIndex),
+                        core::sampler::RadicalInverse(haltonDim + 1, haltonIndex));
+                    haltonDim += 2;
+                    core::color::Spectrum fr = photonBSDF.Sample_f(wo, &wi, bsdfSample, &pdf,
+                        core::bxdf::BxDFType::BSDF_ALL, &flags);
+                    if (fr.IsBlack() || FLOAT_0 == pdf)
+                    {
+                        break;
+                    }
+                    core::color::Spectrum bnew = beta * fr * AbsDot(wi, isect.shading.n) / pdf;
+
+                    // Possibly terminate photon path with Russian roulette
+                    Float q = (std::max)(FLOAT_0, FLOAT_1 - bnew.y() / beta.y());
+                    if (core::sampler::RadicalInverse(haltonDim++, haltonIndex) < q)
+                    {
+                        break;
+                    }
+                    beta = bnew / (FLOAT_1 - q);
+                    photonRay = static_cast<common::math::RayDifferentialf>(isect.SpawnRay(wi));
+                }
+                arena.Reset();
+            }, photonsPerIteration, 8192);
+            //progress.Update();
+            //photonPaths += photonsPerIteration;
+        }
+
+        // Update pixel values from this pass's photons
+        {
+            common::tool::ProfilePhase _(common::tool::Prof::SPPMStatsUpdate);
+            common::tool::ParallelFor([&](int64_t i)
+            {
+                SPPMPixel &p = pixels[i];
+                if (p.M > 0)
+                {
+                    // Update pixel photon count, search radius, and $\tau$
+                    // from photons
+                    const Float gamma = static_cast<Float>(2) / static_cast<Float>(3);
+                    Float Nnew = p.N + gamma * p.M;
+                    Float Rnew = p.radius * std::sqrt(Nnew / (p.N + p.M));
+                    Float ratio = (Rnew * Rnew) / (p.radius * p.radius);
+                    for (int j = 0; j < 3; ++j)
+                    {
+                        p.tau[j] = (p.tau[j] + p.Phi[j]) * ratio;
+                        p.Phi[j] = FLOAT_0;
+                    }
+                    p.N = Nnew;
+                    p.radius = Rnew;
+                    p.M = 0;
+                }
+            }, nPixels, 4096);
+        }
+
+        // Periodically store SPPM image in film and write image
+        if (nIterations == iter + 1 || 0 == ((iter + 1) % writeFrequency))
+        {
+            int x0 = pixelBounds.point_min.x;
+            int x1 = pixelBounds.point_max.x;
+            uint64_t Np = static_cast<uint64_t>(iter + 1) * static_cast<uint64_t>(photonsPerIteration);
+            std::unique_ptr<core::color::Spectrum[]> image(new core::color::Spectrum[pixelBounds.Area()]);
+            int offset = 0;
+            for (int y = pixelBounds.point_min.y; y < pixelBounds.point_max.y; ++y)
+            {
+                for (int x = x0; x < x1; ++x)
+                {
+                    // Compute radiance _L_ for SPPM pixel _pixel_
+                    const SPPMPixel &pixel =
+                        pixels[(y - pixelBounds.point_min.y) * (x1 - x0) + (x - x0)];
+                    Float photonScale = FLOAT_1
+                        / (static_cast<Float>(Np) * common::math::PI * pixel.radius * pixel.radius);
+                    Float rgb[3];
+                    for (int j = 0; j < 3; ++j)
+                    {
+                        rgb[j] = pixel.Ld[j] / (iter + 1) + pixel.tau[j] * photonScale;
+                    }
+                    image[offset++] = core::color::Spectrum::FromRGB(rgb, core::color::SpectrumType::Illuminant);
+                }
+            }
+            camera->film->SetImage(image.get());
+            camera->film->WriteImage();
+            /* TODO
+            // Write SPPM radius image, if requested
+            if (getenv("SPPM_RADIUS")) {...}
+            */
+        }
+    }
+    //progress.Done();
+    size_t visiblePointCapacity = visiblePoints.capacity();
+    for (const std::vector<SPPMVisiblePoint> &points : threadVisiblePoints)
+    {
+        visiblePointCapacity += points.capacity();
+    }
+    pixelMemoryBytes += static_cast<int64_t>(visiblePointCapacity * sizeof(SPPMVisiblePoint));
+    common::tool::ReportRenderStats(camera->film->filename);
+}
+
+/* TODO
+Integrator *CreateSPPMIntegrator(const ParamSet &params,
+    std::shared_ptr<const core::camera::Camera> camera)
+{
+    int nIterations =
+        params.FindOneInt("iterations",
+            params.FindOneInt("numiterations", 64));
+    int maxDepth = params.FindOneInt("maxdepth", 5);
+    int photonsPerIter = params.FindOneInt("photonsperiteration", -1);
+    int writeFreq = params.FindOneInt("imagewritefrequency", 1 << 31);
+    Float radius = params.FindOneFloat("radius", 1.f);
+    if (PbrtOptions.quickRender) nIterations = std::max(1, nIterations / 16);
+    return new SPPMIntegrator(camera, nIterations, photonsPerIter, maxDepth,
+        radius, writeFreq);
+}
+*/
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Integrator.h"
+#include "../camera/Camera.h"
+#include "../film/Film.h"
+#include "../sampler/Sampler.h"
+#include "../scene/Scene.h"
+#include "../../common/math/Bounds2.h"
+
+namespace core
+{
+namespace integrator
+{
+
+
+class SPPMIntegrator : public Integrator
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    // _sampler_ drives the camera pass: pixel sample _i_ is used in
+    // iteration _i_, so it has to provide at least _nIterations_ samples
+    // per pixel.
+    SPPMIntegrator(std::shared_ptr<const core::camera::Camera> camera,
+        std::shared_ptr<core::sampler::Sampler> sampler,
+        int nIterations, int photonsPerIteration, int maxDepth,
+        Float initialSearchRadius, int writeFrequency)
+        : camera(camera),
+        sampler(sampler),
+        initialSearchRadius(initialSearchRadius),
+        nIterations(nIterations),
+        maxDepth(maxDepth),
+        photonsPerIteration(photonsPerIteration > 0
+            ? photonsPerIteration : camera->film->croppedPixelBounds.Area()),
+        writeFrequency(writeFrequency)
+    {}
+
+
+    void Render(const core::scene::Scene &scene);
+
+private:
+
+    std::shared_ptr<const core::camera::Camera> camera;
+
+    std::shared_ptr<core::sampler::Sampler> sampler;
+
+    const Float initialSearchRadius;
+
+    const int nIterations;
+
+    const int maxDepth;
+
+    const int photonsPerIteration;
+
+    const int writeFrequency;
+};
+
+/* TODO
+Integrator *CreateSPPMIntegrator(const ParamSet &params,
+    std::shared_ptr<const core::camera::Camera> camera);
+*/
+
+
+}
+}
\ No newline at end of file
@@ -14,9 +14,13 @@
 #include "../scene/Scene.h"
 #include "../sampler/Sampler.h"
 #include "../sampler/Sampling.h"
+#include "../texture/ImageTexture.h"
 #include "../../common/math/RayDifferential.h"
+#include "../../common/tool/LookupCache.h"
 #include "../../common/tool/MemoryArena.h"
 #include "../../common/tool/MultiThread.h"
+#include "../../common/tool/RenderTelemetry.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -24,8 +28,14 @@ namespace integrator
 {
 
 
+STAT_COUNTER("Integrator/Camera rays traced", nCameraRays);
+
+
 void SamplerIntegrator::Render(const core::scene::Scene &scene)
 {
+    common::tool::ProfilePhase p(common::tool::Prof::IntegratorRender);
+    // Image textures are built in the background while the scene is set up
+    core::texture::WaitForImageTextures();
     Preprocess(scene, *sampler);
     // Render image tiles in parallel
 
@@ -36,11 +46,15 @@ void SamplerIntegrator::Render(const core::scene::Scene &scene)
     common::math::Vec2i nTiles((sampleExtent.x + tileSize - 1) / tileSize,
         (sampleExtent.y + tileSize - 1) / tileSize);
     //ProgressReporter reporter(nTiles.x * nTiles.y, "Rendering");
+    common::tool::RenderTelemetry telemetry(nTiles.x * nTiles.y);
 
     {
         common::tool::ParallelFor2D([&](common::math::Vec2i tile)
         {
             // Render section of image corresponding to _tile_
+            common::tool::TileTelemetry tileTelemetry;
+            tileTelemetry.start = telemetry.Seconds();
+            int64_t startRays = telemetry.ThreadRays();
 
             // Allocate _MemoryArena_ for tile
             common::tool::MemoryArena arena;
@@ -64,8 +78,9 @@ void SamplerIntegrator::Render(const core::scene::Scene &scene)
             for (common::math::Vec2i pixel : tileBounds)
             {
                 {
-                    //ProfilePhase pp(Prof::StartPixel);
+                    common::tool::ProfilePhase pp(common::tool::Prof::StartPixel);
                     tileSampler->StartPixel(pixel);
+                    common::tool::LookupCacheStartPixel();
                 }
 
                 // Do this check after the StartPixel() call; this keeps
@@ -87,7 +102,26 @@ void SamplerIntegrator::Render(const core::scene::Scene &scene)
                     Float rayWeight = camera->GenerateRayDifferential(cameraSample, &ray);
                     ray.ScaleDifferentials(FLOAT_1
                         / std::sqrt(static_cast<Float>(tileSampler->samples_per_pixel)));
-                    //++nCameraRays;
+                    ++nCameraRays;
+                    ++tileTelemetry.samples;
+
+                    if (IsSpectral())
+                    {
+                        // Evaluate CIE XYZ along camera ray at sampled wavelengths
+                        Float xyz[3] = {FLOAT_0, FLOAT_0, FLOAT_0};
+                        if (rayWeight > FLOAT_0)
+                        {
+                            LiXYZ(ray, scene, *tileSampler, arena, xyz);
+                        }
+                        if (std::isnan(xyz[0]) || std::isnan(xyz[1]) || std::isnan(xyz[2]) ||
+                            std::isinf(xyz[1]))
+                        {
+                            xyz[0] = xyz[1] = xyz[2] = FLOAT_0;
+                        }
+                        filmTile->AddSampleXYZ(cameraSample.pFilm, xyz, rayWeight);
+                        arena.Reset();
+                        continue;
+                    }
 
                     // Evaluate radiance along camera ray
                     core::color::Spectrum L(FLOAT_0);
@@ -151,15 +185,30 @@ void SamplerIntegrator::Render(const core::scene::Scene &scene)
             // Merge image tile into _Film_
             camera->film->MergeFilmTile(std::move(filmTile));
             //reporter.Update();
+
+            tileTelemetry.bounds = tileBounds;
+            tileTelemetry.threadIndex = common::tool::ThreadIndex;
+            tileTelemetry.rays = telemetry.ThreadRays() - startRays;
+            tileTelemetry.end = telemetry.Seconds();
+            telemetry.RecordTile(seed, tileTelemetry);
         }, nTiles);
         //reporter.Done();
     }
+    telemetry.Finish();
     /* TODO
     LOG(INFO) << "Rendering finished";
     */
 
     // Save final image after rendering
     camera->film->WriteImage();
+    telemetry.Write(camera->film->filename, camera->film->croppedPixelBounds);
+    common::tool::ReportRenderStats(camera->film->filename);
+}
+
+void SamplerIntegrator::LiXYZ(const common::math::RayDifferentialf &ray, const core::scene::Scene &scene,
+    core::sampler::Sampler &sampler, common::tool::MemoryArena &arena, Float xyz[3]) const
+{
+    Li(ray, scene, sampler, arena).ToXYZ(xyz);
 }
 
 core::color::Spectrum SamplerIntegrator::SpecularReflect(
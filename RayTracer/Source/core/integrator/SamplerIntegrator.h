@@ -36,6 +36,16 @@ public:
         core::sampler::Sampler &sampler, common::tool::MemoryArena &arena,
         int depth = 0) const = 0;
 
+    // Hero-wavelength integrators sample their own wavelengths per camera
+    // ray and hand the film CIE XYZ from LiXYZ() instead of a _Spectrum_
+    virtual bool IsSpectral() const
+    {
+        return false;
+    }
+
+    virtual void LiXYZ(const common::math::RayDifferentialf &ray, const core::scene::Scene &scene,
+        core::sampler::Sampler &sampler, common::tool::MemoryArena &arena, Float xyz[3]) const;
+
     core::color::Spectrum SpecularReflect(const common::math::RayDifferentialf &ray,
         const core::interaction::SurfaceInteraction &isect,
         const core::scene::Scene &scene, core::sampler::Sampler &sampler,
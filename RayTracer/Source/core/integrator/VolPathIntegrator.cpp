@@ -0,0 +1,274 @@
+#include "VolPathIntegrator.h"
+#include "LightDistribution.h"
+#include "../bxdf/BxDF.h"
+#include "../bxdf/BSDF.h"
+#include "../bxdf/BSSRDF.h"
+#include "../color/Spectrum.h"
+#include "../interaction/Interaction.h"
+#include "../interaction/SurfaceInteraction.h"
+#include "../interaction/MediumInteraction.h"
+#include "../interaction/MediumBoundaries.h"
+#include "../interaction/Medium.h"
+#include "../light/Light.h"
+#include "../light/AreaLight.h"
+#include "../light/VisibilityTester.h"
+#include "../primitive/Primitive.h"
+#include "../scene/Scene.h"
+#include "../sampler/Sampler.h"
+#include "../sampler/Sampling.h"
+#include "../../common/math/RayDifferential.h"
+#include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/Stats.h"
+
+namespace core
+{
+namespace integrator
+{
+
+
+VolPathIntegrator::VolPathIntegrator(int maxDepth,
+    std::shared_ptr<const core::camera::Camera> camera,
+    std::shared_ptr<core::sampler::Sampler> sampler,
+    const common::math::Bounds2i &pixelBounds, Float rrThreshold,
+    const std::string &lightSampleStrategy)
+    : SamplerIntegrator(camera, sampler, pixelBounds),
+    maxDepth(maxDepth),
+    rrThreshold(rrThreshold),
+    lightSampleStrategy(lightSampleStrategy)
+{}
+
+void VolPathIntegrator::Preprocess(const core::scene::Scene &scene, core::sampler::Sampler &sampler)
+{
+    lightDistribution = CreateLightSampleDistribution(lightSampleStrategy, scene);
+}
+
+core::color::Spectrum VolPathIntegrator::Li(const common::math::RayDifferentialf &r, const core::scene::Scene &scene,
+    core::sampler::Sampler &sampler, common::tool::MemoryArena &arena,
+    int depth) const
+{
+    common::tool::ProfilePhase p(common::tool::Prof::SamplerIntegratorLi);
+    core::color::Spectrum L(FLOAT_0), beta(FLOAT_1);
+    common::math::RayDifferentialf ray(r);
+    bool specularBounce = false;
+    int bounces;
+    // Added after book publication: etaScale tracks the accumulated effect
+    // of radiance scaling due to rays passing through refractive
+    // boundaries (see the derivation on p. 527 of the third edition). We
+    // track this value in order to remove it from beta when we apply
+    // Russian roulette; this is worthwhile, since it lets us sometimes
+    // avoid terminating refracted rays that are about to be refracted back
+    // out of a medium and thus have their beta value increased.
+    Float etaScale = FLOAT_1;
+    core::interaction::MediumBoundaries boundaries;
+
+    for (bounces = 0;; ++bounces)
+    {
+        // Intersect _ray_ with scene and store intersection in _isect_,
+        // together with the medium boundaries crossed in front of it
+        core::interaction::SurfaceInteraction isect;
+        bool foundIntersection = scene.IntersectBoundaries(ray, &isect, &boundaries);
+
+        // Sample the participating medium of each segment, front to back,
+        // until a medium interaction is found
+        core::interaction::MediumInteraction mi;
+        const core::interaction::Medium *medium = ray.medium;
+        Float t0 = FLOAT_0;
+        for (int i = 0; i <= boundaries.count; ++i)
+        {
+            if (i == boundaries.count && !boundaries.complete)
+            {
+                break;
+            }
+            Float t1 = i < boundaries.count ? boundaries.t[i] : ray.t_max;
+            if (medium)
+            {
+                beta *= medium->Sample(common::math::Rayf(ray(t0), ray.dir, t1 - t0, FLOAT_0, ray.time, medium),
+                    sampler, arena, &mi);
+                if (mi.IsValid())
+                {
+                    break;
+                }
+            }
+            if (i < boundaries.count)
+            {
+                medium = boundaries.it[i].GetMedium(ray.dir);
+                t0 = t1;
+            }
+        }
+        if (beta.IsBlack())
+        {
+            break;
+        }
+
+        // Handle an interaction with a medium or a surface
+        if (mi.IsValid())
+        {
+            // Terminate path if maximum depth reached
+            if (bounces >= maxDepth)
+            {
+                break;
+            }
+
+            // Handle scattering at point in medium for volumetric path tracer
+            const core::sampler::Distribution1D *lightDistrib = lightDistribution->Lookup(mi.p);
+            L.AddProduct(beta, UniformSampleOneLight(mi, scene, arena, sampler, true, lightDistrib));
+
+            common::math::Vec3f wo = -ray.dir, wi;
+            mi.phase->Sample_p(wo, &wi, sampler.Get2D());
+            ray = mi.SpawnRay(wi);
+            specularBounce = false;
+        }
+        else if (!boundaries.complete)
+        {
+            // More boundaries lie ahead than were recorded; continue the
+            // ray past the last one without counting a bounce
+            ray = boundaries.it[boundaries.count - 1].SpawnRay(ray.dir);
+            --bounces;
+            continue;
+        }
+        else
+        {
+            //++surfaceInteractions;
+            // Possibly add emitted light at path vertex or from the environment
+            if (0 == bounces || specularBounce)
+            {
+                if (foundIntersection)
+                {
+                    L.AddProduct(beta, isect.Le(-ray.dir));
+                }
+                else
+                {
+                    for (const auto &light : scene.infiniteLights)
+                    {
+                        L.AddProduct(beta, light->Le(ray));
+                    }
+                }
+            }
+
+            // Terminate path if ray escaped or _maxDepth_ was reached
+            if (!foundIntersection || bounces >= maxDepth)
+            {
+                break;
+            }
+
+            // Compute scattering functions and skip over medium boundaries
+            isect.ComputeScatteringFunctions(ray, arena, true);
+            if (!isect.bsdf)
+            {
+                ray = isect.SpawnRay(ray.dir);
+                --bounces;
+                continue;
+            }
+
+            // Sample illumination from lights to find attenuated path
+            // contribution
+            const core::sampler::Distribution1D *lightDistrib = lightDistribution->Lookup(isect.p);
+            L.AddProduct(beta, UniformSampleOneLight(isect, scene, arena, sampler, true, lightDistrib));
+
+            // Sample BSDF to get new path direction
+            common::math::Vec3f wo = -ray.dir, wi;
+            Float pdf;
+            core::bxdf::BxDFType flags;
+            core::color::Spectrum f = isect.bsdf->Sample_f(wo, &wi, sampler.Get2D(), &pdf,
+                core::bxdf::BxDFType::BSDF_ALL, &flags);
+            if (f.IsBlack() || FLOAT_0 == pdf)
+            {
+                break;
+            }
+            beta.MulScaled(f, AbsDot(wi, isect.shading.n) / pdf);
+            CHECK(!std::isinf(beta.y()));
+            specularBounce = (flags & core::bxdf::BxDFType::BSDF_SPECULAR) != 0;
+            if ((flags & core::bxdf::BxDFType::BSDF_SPECULAR) && (flags & core::bxdf::BxDFType::BSDF_TRANSMISSION))
+            {
+                Float eta = isect.bsdf->eta;
+                // Update the term that tracks radiance scaling for refraction
+                // depending on whether the ray is entering or leaving the
+                // medium.
+                etaScale *= (Dot(wo, isect.n) > FLOAT_0) ? (eta * eta) : FLOAT_1 / (eta * eta);
+            }
+            ray = isect.SpawnRay(wi);
+
+            // Account for attenuated subsurface scattering, if applicable
+            if (isect.bssrdf && (flags & core::bxdf::BxDFType::BSDF_TRANSMISSION))
+            {
+                // Importance sample the BSSRDF
+                core::interaction::SurfaceInteraction pi;
+                core::color::Spectrum S = isect.bssrdf->Sample_S(
+                    scene, sampler.Get1D(), sampler.Get2D(), arena, &pi, &pdf);
+                CHECK(!std::isinf(beta.y()));
+                if (S.IsBlack() || FLOAT_0 == pdf)
+                {
+                    break;
+                }
+                beta *= S / pdf;
+
+                // Account for the attenuated direct subsurface scattering
+                // component
+                L.AddProduct(beta, UniformSampleOneLight(pi, scene, arena, sampler, true,
+                    lightDistribution->Lookup(pi.p)));
+
+                // Account for the indirect subsurface scattering component
+                core::color::Spectrum f = pi.bsdf->Sample_f(pi.wo, &wi, sampler.Get2D(), &pdf,
+                    core::bxdf::BxDFType::BSDF_ALL, &flags);
+                if (f.IsBlack() || FLOAT_0 == pdf)
+                {
+                    break;
+                }
+                beta.MulScaled(f, AbsDot(wi, pi.shading.n) / pdf);
+                CHECK(!std::isinf(beta.y()));
+                specularBounce = (flags & core::bxdf::BxDFType::BSDF_SPECULAR) != 0;
+                ray = pi.SpawnRay(wi);
+            }
+        }
+
+        // Possibly terminate the path with Russian roulette
+        // Factor out radiance scaling due to refraction in rrBeta.
+        core::color::Spectrum rrBeta = beta * etaScale;
+        if (rrBeta.MaxComponentValue() < rrThreshold && bounces > 3)
+        {
+            Float q = (std::max)(static_cast<Float>(0.05F), FLOAT_1 - rrBeta.MaxComponentValue());
+            if (sampler.Get1D() < q)
+            {
+                break;
+            }
+            beta /= FLOAT_1 - q;
+            CHECK(!std::isinf(beta.y()));
+        }
+    }
+    //ReportValue(pathLength, bounces);
+    return L;
+}
+
+/* TODO
+VolPathIntegrator *CreateVolPathIntegrator(const ParamSet &params,
+    std::shared_ptr<core::sampler::Sampler> sampler,
+    std::shared_ptr<const core::camera::Camera> camera)
+{
+    int maxDepth = params.FindOneInt("maxdepth", 5);
+    int np;
+    const int *pb = params.FindInt("pixelbounds", &np);
+    common::math::Bounds2i pixelBounds = camera->film->GetSampleBounds();
+    if (pb)
+    {
+        if (np != 4)
+            Error("Expected four values for \"pixelbounds\" parameter. Got %d.",
+                np);
+        else
+        {
+            pixelBounds = Intersect(pixelBounds,
+                common::math::Bounds2i{{pb[0], pb[2]}, {pb[1], pb[3]}});
+            if (0 == pixelBounds.Area())
+                Error("Degenerate \"pixelbounds\" specified.");
+        }
+    }
+    Float rrThreshold = params.FindOneFloat("rrthreshold", 1.);
+    std::string lightStrategy =
+        params.FindOneString("lightsamplestrategy", "spatial");
+    return new VolPathIntegrator(maxDepth, camera, sampler, pixelBounds,
+        rrThreshold, lightStrategy);
+}
+*/
+
+
+}
+}
\ No newline at end of file
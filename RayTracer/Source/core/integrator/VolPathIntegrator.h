@@ -0,0 +1,54 @@
+#pragma once
+
+#include "SamplerIntegrator.h"
+
+namespace core
+{
+namespace integrator
+{
+
+
+// Unidirectional path tracer that also samples scattering inside
+// participating media. Medium boundaries in front of each hit are gathered
+// by a single accelerator traversal (see Scene::IntersectBoundaries), and
+// the current medium is carried from one segment to the next through their
+// MediumInterface.
+class VolPathIntegrator : public SamplerIntegrator
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    VolPathIntegrator(int maxDepth, std::shared_ptr<const core::camera::Camera> camera,
+        std::shared_ptr<core::sampler::Sampler> sampler,
+        const common::math::Bounds2i &pixelBounds, Float rrThreshold = FLOAT_1,
+        const std::string &lightSampleStrategy = "spatial");
+
+
+    void Preprocess(const core::scene::Scene &scene, core::sampler::Sampler &sampler);
+
+    core::color::Spectrum Li(const common::math::RayDifferentialf &ray, const core::scene::Scene &scene,
+        core::sampler::Sampler &sampler, common::tool::MemoryArena &arena, int depth) const;
+
+private:
+
+    const int maxDepth;
+
+    const Float rrThreshold;
+
+    const std::string lightSampleStrategy;
+
+    std::unique_ptr<LightDistribution> lightDistribution;
+};
+
+/* TODO
+VolPathIntegrator *CreateVolPathIntegrator(const ParamSet &params,
+    std::shared_ptr<core::sampler::Sampler> sampler,
+    std::shared_ptr<const core::camera::Camera> camera);
+*/
+
+
+}
+}
\ No newline at end of file
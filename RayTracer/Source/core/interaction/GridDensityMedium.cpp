@@ -0,0 +1,412 @@
+#include "GridDensityMedium.h"
+#include "HenyeyGreenstein.h"
+#include "MediumBoundaries.h"
+#include "MediumInteraction.h"
+#include "../sampler/Sampler.h"
+#include "../../common/math/Bounds3.h"
+#include "../../common/math/Ray.h"
+#include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/Stats.h"
+
+namespace core
+{
+namespace interaction
+{
+
+
+STAT_COUNTER("Media/Grid density Tr() calls", nTrCalls);
+
+
+// Walks the cells of the majorant grid pierced by a medium-space ray with a
+// 3D DDA, handing out one segment per cell along with the cell's majorant.
+class MajorantIterator
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    MajorantIterator(const GridDensityMedium &medium, const common::math::Rayf &ray, Float tMin, Float tMax)
+        : medium(medium), tMin(tMin), tMax(tMax)
+    {
+        const int *res = medium.majorantRes;
+        common::math::Vec3f gridIntersect = ray(tMin);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            Float pos = gridIntersect[axis] * res[axis];
+            Float d = ray.dir[axis];
+            voxel[axis] = common::math::Clamp(static_cast<int>(pos), 0, res[axis] - 1);
+            if (FLOAT_0 == d)
+            {
+                deltaT[axis] = FLOAT_0;
+                nextCrossingT[axis] = (std::numeric_limits<Float>::infinity)();
+                step[axis] = 0;
+                voxelLimit[axis] = -1;
+                continue;
+            }
+            deltaT[axis] = FLOAT_1 / (std::abs(d) * res[axis]);
+            if (d > FLOAT_0)
+            {
+                nextCrossingT[axis] = tMin + (static_cast<Float>(voxel[axis] + 1) - pos) / (d * res[axis]);
+                step[axis] = 1;
+                voxelLimit[axis] = res[axis];
+            }
+            else
+            {
+                nextCrossingT[axis] = tMin + (static_cast<Float>(voxel[axis]) - pos) / (d * res[axis]);
+                step[axis] = -1;
+                voxelLimit[axis] = -1;
+            }
+        }
+    }
+
+
+    bool Next(Float *t0, Float *t1, Float *sigma_maj)
+    {
+        if (tMin >= tMax)
+        {
+            return false;
+        }
+
+        // Find _stepAxis_ for stepping to next voxel and exit point _tVoxelExit_
+        int bits = ((nextCrossingT[0] < nextCrossingT[1]) << 2) + ((nextCrossingT[0] < nextCrossingT[2]) << 1)
+            + ((nextCrossingT[1] < nextCrossingT[2]));
+        const int cmpToAxis[8] = { 2, 1, 2, 1, 2, 2, 0, 0 };
+        int stepAxis = cmpToAxis[bits];
+        Float tVoxelExit = (std::min)(tMax, nextCrossingT[stepAxis]);
+
+        const int *res = medium.majorantRes;
+        *t0 = tMin;
+        *t1 = tVoxelExit;
+        *sigma_maj = medium.majorant[(voxel[2] * res[1] + voxel[1]) * res[0] + voxel[0]];
+
+        // Advance to the next voxel, or finish once the ray leaves the grid
+        tMin = tVoxelExit;
+        if (nextCrossingT[stepAxis] > tMax)
+        {
+            tMin = tMax;
+        }
+        voxel[stepAxis] += step[stepAxis];
+        if (voxel[stepAxis] == voxelLimit[stepAxis])
+        {
+            tMin = tMax;
+        }
+        nextCrossingT[stepAxis] += deltaT[stepAxis];
+
+        return true;
+    }
+
+private:
+
+    const GridDensityMedium &medium;
+    Float tMin, tMax;
+    Float nextCrossingT[3], deltaT[3];
+    int step[3], voxelLimit[3], voxel[3];
+};
+
+
+GridDensityMedium::GridDensityMedium(const core::color::Spectrum &sigma_a, const core::color::Spectrum &sigma_s,
+    Float g, int nx, int ny, int nz, const common::math::Transformf &mediumToWorld, const Float *d)
+    : sigma_a(sigma_a),
+    sigma_s(sigma_s),
+    g(g),
+    nx(nx),
+    ny(ny),
+    nz(nz),
+    WorldToMedium(Inverse(mediumToWorld))
+{
+    CHECK(nx > 0 && ny > 0 && nz > 0);
+
+    // Copy the densities into the blocked layout, padding the last bricks
+    nBlocksX = (nx + BLOCK_MASK) >> LOG_BLOCK_WIDTH;
+    nBlocksY = (ny + BLOCK_MASK) >> LOG_BLOCK_WIDTH;
+    nBlocksZ = (nz + BLOCK_MASK) >> LOG_BLOCK_WIDTH;
+    size_t nBlockedVoxels = static_cast<size_t>(nBlocksX) * nBlocksY * nBlocksZ
+        * BLOCK_WIDTH * BLOCK_WIDTH * BLOCK_WIDTH;
+    density.reset(new Float[nBlockedVoxels]);
+    for (size_t i = 0; i < nBlockedVoxels; ++i)
+    {
+        density[i] = FLOAT_0;
+    }
+    for (int z = 0; z < nz; ++z)
+    {
+        for (int y = 0; y < ny; ++y)
+        {
+            for (int x = 0; x < nx; ++x)
+            {
+                density[BlockedOffset(x, y, z)] = d[(z * ny + y) * nx + x];
+            }
+        }
+    }
+
+    // Precompute values for Monte Carlo sampling of _GridDensityMedium_
+    sigma_t = (sigma_a + sigma_s)[0];
+    for (int i = 1; i < core::color::Spectrum::SAMPLE_NUMBER; ++i)
+    {
+        if (sigma_a[i] + sigma_s[i] != sigma_t)
+        {
+            /* TODO
+            Error("GridDensityMedium requires a spectrally uniform attenuation "
+                "coefficient!");
+            */
+            break;
+        }
+    }
+
+    // Build the majorant grid. A lookup inside a cell interpolates between
+    // voxels up to one position outside of it, so the maximum is taken over
+    // that slightly larger range.
+    majorantRes[0] = (nx + MAJORANT_CELL_WIDTH - 1) / MAJORANT_CELL_WIDTH;
+    majorantRes[1] = (ny + MAJORANT_CELL_WIDTH - 1) / MAJORANT_CELL_WIDTH;
+    majorantRes[2] = (nz + MAJORANT_CELL_WIDTH - 1) / MAJORANT_CELL_WIDTH;
+    const int voxelRes[3] = { nx, ny, nz };
+    majorant.reset(new Float[majorantRes[0] * majorantRes[1] * majorantRes[2]]);
+    for (int cz = 0; cz < majorantRes[2]; ++cz)
+    {
+        for (int cy = 0; cy < majorantRes[1]; ++cy)
+        {
+            for (int cx = 0; cx < majorantRes[0]; ++cx)
+            {
+                const int cell[3] = { cx, cy, cz };
+                int vMin[3], vMax[3];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    // Voxel sample _i_ sits at $(i + 0.5) / n$ in medium space
+                    Float lo = static_cast<Float>(cell[axis]) / majorantRes[axis] * voxelRes[axis] - FLOAT_INV_2;
+                    Float hi = static_cast<Float>(cell[axis] + 1) / majorantRes[axis] * voxelRes[axis]
+                        - FLOAT_INV_2;
+                    vMin[axis] = (std::max)(static_cast<int>(std::floor(lo)), 0);
+                    vMax[axis] = (std::min)(static_cast<int>(std::floor(hi)) + 1, voxelRes[axis] - 1);
+                }
+                Float maxDensity = FLOAT_0;
+                for (int z = vMin[2]; z <= vMax[2]; ++z)
+                {
+                    for (int y = vMin[1]; y <= vMax[1]; ++y)
+                    {
+                        for (int x = vMin[0]; x <= vMax[0]; ++x)
+                        {
+                            maxDensity = (std::max)(maxDensity, density[BlockedOffset(x, y, z)]);
+                        }
+                    }
+                }
+                majorant[(cz * majorantRes[1] + cy) * majorantRes[0] + cx] = sigma_t * maxDensity;
+            }
+        }
+    }
+}
+
+
+Float GridDensityMedium::Density(const common::math::Vec3f &p) const
+{
+    // Compute voxel coordinates and offsets for _p_
+    Float px = p.x * nx - FLOAT_INV_2, py = p.y * ny - FLOAT_INV_2, pz = p.z * nz - FLOAT_INV_2;
+    Float fx = std::floor(px), fy = std::floor(py), fz = std::floor(pz);
+    int x = static_cast<int>(fx), y = static_cast<int>(fy), z = static_cast<int>(fz);
+    Float dx = px - fx, dy = py - fy, dz = pz - fz;
+
+    Float d000, d100, d010, d110, d001, d101, d011, d111;
+    if (x >= 0 && y >= 0 && z >= 0 && x + 1 < nx && y + 1 < ny && z + 1 < nz
+        && (x & BLOCK_MASK) != BLOCK_MASK && (y & BLOCK_MASK) != BLOCK_MASK && (z & BLOCK_MASK) != BLOCK_MASK)
+    {
+        // All eight neighbors are inside one brick
+        const Float *b = &density[BlockedOffset(x, y, z)];
+        const int sy = BLOCK_WIDTH, sz = BLOCK_WIDTH * BLOCK_WIDTH;
+        d000 = b[0];
+        d100 = b[1];
+        d010 = b[sy];
+        d110 = b[sy + 1];
+        d001 = b[sz];
+        d101 = b[sz + 1];
+        d011 = b[sz + sy];
+        d111 = b[sz + sy + 1];
+    }
+    else
+    {
+        d000 = D(common::math::Vec3i(x, y, z));
+        d100 = D(common::math::Vec3i(x + 1, y, z));
+        d010 = D(common::math::Vec3i(x, y + 1, z));
+        d110 = D(common::math::Vec3i(x + 1, y + 1, z));
+        d001 = D(common::math::Vec3i(x, y, z + 1));
+        d101 = D(common::math::Vec3i(x + 1, y, z + 1));
+        d011 = D(common::math::Vec3i(x, y + 1, z + 1));
+        d111 = D(common::math::Vec3i(x + 1, y + 1, z + 1));
+    }
+
+    // Trilinearly interpolate density values to compute local density
+    Float d00 = common::math::Lerp(dx, d000, d100);
+    Float d10 = common::math::Lerp(dx, d010, d110);
+    Float d01 = common::math::Lerp(dx, d001, d101);
+    Float d11 = common::math::Lerp(dx, d011, d111);
+    Float d0 = common::math::Lerp(dy, d00, d10);
+    Float d1 = common::math::Lerp(dy, d01, d11);
+    return common::math::Lerp(dz, d0, d1);
+}
+
+
+bool GridDensityMedium::ToMediumSpace(const common::math::Rayf &r, common::math::Rayf *mRay,
+    Float *tMin, Float *tMax) const
+{
+    // Transform the ray into medium space and compute bounds overlap
+    Float rayLength = Length(r.dir);
+    *mRay = WorldToMedium(common::math::Rayf(r.origin, r.dir / rayLength, r.t_max * rayLength));
+    const common::math::Bounds3f b(common::math::Vec3f(FLOAT_0, FLOAT_0, FLOAT_0),
+        common::math::Vec3f(FLOAT_1, FLOAT_1, FLOAT_1));
+
+    return b.IntersectP(*mRay, tMin, tMax);
+}
+
+Float GridDensityMedium::RatioTrack(const common::math::Rayf &mRay, const Float *s, int nSegments,
+    core::sampler::Sampler &sampler) const
+{
+    // Perform ratio tracking to estimate the transmittance value; empty
+    // majorant cells and the gaps between segments are skipped without
+    // drawing any samples
+    Float Tr = FLOAT_1;
+    MajorantIterator iter(*this, mRay, s[0], s[2 * nSegments - 1]);
+    int segment = 0;
+    Float t0, t1, sigma_maj;
+    while (iter.Next(&t0, &t1, &sigma_maj))
+    {
+        while (segment < nSegments && s[2 * segment + 1] <= t0)
+        {
+            ++segment;
+        }
+        if (FLOAT_0 == sigma_maj)
+        {
+            continue;
+        }
+        // Free-flight distances are memoryless, so tracking restarts at the
+        // start of every segment overlapping the cell
+        for (int i = segment; i < nSegments && s[2 * i] < t1; ++i)
+        {
+            Float t = (std::max)(t0, s[2 * i]);
+            Float tEnd = (std::min)(t1, s[2 * i + 1]);
+            while (true)
+            {
+                t -= std::log(FLOAT_1 - sampler.Get1D()) / sigma_maj;
+                if (t >= tEnd)
+                {
+                    break;
+                }
+                Float sigma = sigma_t * Density(mRay(t));
+                Tr *= FLOAT_1 - (std::max)(FLOAT_0, sigma / sigma_maj);
+
+                // Added after book publication: when transmittance gets low,
+                // start applying Russian roulette to terminate sampling.
+                const Float rrThreshold = static_cast<Float>(0.1F);
+                if (Tr < rrThreshold)
+                {
+                    Float q = (std::max)(static_cast<Float>(0.05F), FLOAT_1 - Tr);
+                    if (sampler.Get1D() < q)
+                    {
+                        return FLOAT_0;
+                    }
+                    Tr /= FLOAT_1 - q;
+                }
+            }
+        }
+    }
+
+    return Tr;
+}
+
+
+core::color::Spectrum GridDensityMedium::Tr(const common::math::Rayf &rWorld, core::sampler::Sampler &sampler) const
+{
+    common::tool::ProfilePhase _(common::tool::Prof::MediumTr);
+    ++nTrCalls;
+    common::math::Rayf ray;
+    Float tMin, tMax;
+    if (!ToMediumSpace(rWorld, &ray, &tMin, &tMax))
+    {
+        return core::color::Spectrum(FLOAT_1);
+    }
+
+    const Float s[2] = { tMin, tMax };
+    return core::color::Spectrum(RatioTrack(ray, s, 1, sampler));
+}
+
+core::color::Spectrum GridDensityMedium::TrSegments(const common::math::Rayf &rWorld, const Float *t, int nSegments,
+    core::sampler::Sampler &sampler) const
+{
+    common::tool::ProfilePhase _(common::tool::Prof::MediumTr);
+    ++nTrCalls;
+    CHECK_LE(nSegments, MediumBoundaries::MAX_BOUNDARIES + 1);
+    common::math::Rayf ray;
+    Float tMin, tMax;
+    if (!ToMediumSpace(rWorld, &ray, &tMin, &tMax))
+    {
+        return core::color::Spectrum(FLOAT_1);
+    }
+
+    // The medium-space ray measures world distance; clip the segments to
+    // the grid and drop those that miss it
+    Float rayLength = Length(rWorld.dir);
+    Float s[2 * (MediumBoundaries::MAX_BOUNDARIES + 1)];
+    int nInside = 0;
+    for (int i = 0; i < nSegments; ++i)
+    {
+        Float s0 = (std::max)(tMin, t[2 * i] * rayLength);
+        Float s1 = (std::min)(tMax, t[2 * i + 1] * rayLength);
+        if (s0 < s1)
+        {
+            s[2 * nInside] = s0;
+            s[2 * nInside + 1] = s1;
+            ++nInside;
+        }
+    }
+    if (0 == nInside)
+    {
+        return core::color::Spectrum(FLOAT_1);
+    }
+
+    return core::color::Spectrum(RatioTrack(ray, s, nInside, sampler));
+}
+
+core::color::Spectrum GridDensityMedium::Sample(const common::math::Rayf &rWorld, core::sampler::Sampler &sampler,
+    common::tool::MemoryArena &arena, MediumInteraction *mi) const
+{
+    common::tool::ProfilePhase _(common::tool::Prof::MediumSample);
+    common::math::Rayf ray;
+    Float tMin, tMax;
+    if (!ToMediumSpace(rWorld, &ray, &tMin, &tMax))
+    {
+        return core::color::Spectrum(FLOAT_1);
+    }
+
+    // Run delta-tracking iterations to sample a medium interaction, using
+    // the local majorant of each cell the ray passes through
+    MajorantIterator iter(*this, ray, tMin, tMax);
+    Float t0, t1, sigma_maj;
+    while (iter.Next(&t0, &t1, &sigma_maj))
+    {
+        if (FLOAT_0 == sigma_maj)
+        {
+            continue;
+        }
+        Float t = t0;
+        while (true)
+        {
+            t -= std::log(FLOAT_1 - sampler.Get1D()) / sigma_maj;
+            if (t >= t1)
+            {
+                break;
+            }
+            if (sigma_t * Density(ray(t)) > sampler.Get1D() * sigma_maj)
+            {
+                // Populate _mi_ with medium interaction information and return
+                common::math::Rayf r(rWorld.origin, Normalize(rWorld.dir));
+                *mi = MediumInteraction(r(t), -rWorld.dir, rWorld.time, this,
+                    ARENA_ALLOC(arena, HenyeyGreenstein)(g));
+                return sigma_s / sigma_t;
+            }
+        }
+    }
+
+    return core::color::Spectrum(FLOAT_1);
+}
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "Medium.h"
+#include "../color/Spectrum.h"
+#include "../../common/math/Transform.h"
+#include "../../common/math/Vec3.h"
+#include <memory>
+
+namespace core
+{
+namespace interaction
+{
+
+
+class GridDensityMedium : public Medium
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    // _d_ holds _nx_ * _ny_ * _nz_ density values in x-fastest order; it is
+    // copied into the blocked layout and not referenced afterwards.
+    GridDensityMedium(const core::color::Spectrum &sigma_a, const core::color::Spectrum &sigma_s, Float g,
+        int nx, int ny, int nz, const common::math::Transformf &mediumToWorld, const Float *d);
+
+
+    // Trilinearly interpolated density at _p_ in medium space ([0,1]^3).
+    Float Density(const common::math::Vec3f &p) const;
+
+    Float D(const common::math::Vec3i &p) const
+    {
+        if (p.x < 0 || p.x >= nx || p.y < 0 || p.y >= ny || p.z < 0 || p.z >= nz)
+        {
+            return FLOAT_0;
+        }
+        return density[BlockedOffset(p.x, p.y, p.z)];
+    }
+
+
+    core::color::Spectrum Tr(const common::math::Rayf &ray, core::sampler::Sampler &sampler) const;
+
+    // Ratio tracks all the segments in one walk of the majorant grid
+    core::color::Spectrum TrSegments(const common::math::Rayf &ray, const Float *t, int nSegments,
+        core::sampler::Sampler &sampler) const;
+
+    core::color::Spectrum Sample(const common::math::Rayf &ray, core::sampler::Sampler &sampler,
+        common::tool::MemoryArena &arena,
+        MediumInteraction *mi) const;
+
+private:
+
+    // Densities are stored in 4x4x4 bricks so that the eight lookups of a
+    // trilinear filter stay within a few cache lines.
+    static constexpr int LOG_BLOCK_WIDTH = 2;
+    static constexpr int BLOCK_WIDTH = 1 << LOG_BLOCK_WIDTH;
+    static constexpr int BLOCK_MASK = BLOCK_WIDTH - 1;
+
+    // Each majorant cell covers this many voxels along every axis.
+    static constexpr int MAJORANT_CELL_WIDTH = 8;
+
+    int BlockedOffset(int x, int y, int z) const
+    {
+        int bx = x >> LOG_BLOCK_WIDTH, by = y >> LOG_BLOCK_WIDTH, bz = z >> LOG_BLOCK_WIDTH;
+        int ox = x & BLOCK_MASK, oy = y & BLOCK_MASK, oz = z & BLOCK_MASK;
+        return (((bz * nBlocksY + by) * nBlocksX + bx) << (3 * LOG_BLOCK_WIDTH))
+            + (((oz << LOG_BLOCK_WIDTH) + oy) << LOG_BLOCK_WIDTH) + ox;
+    }
+
+    // Transforms _ray_ to medium space and clips it against the unit cube.
+    // The returned ray has a unit-length world direction, so its parameter
+    // measures world-space distance.
+    bool ToMediumSpace(const common::math::Rayf &ray, common::math::Rayf *mRay, Float *tMin, Float *tMax) const;
+
+    // Ratio tracking over the majorant grid along the _nSegments_ pieces
+    // [_s[2i]_, _s[2i + 1]_] of an already clipped medium-space ray.
+    Float RatioTrack(const common::math::Rayf &mRay, const Float *s, int nSegments,
+        core::sampler::Sampler &sampler) const;
+
+
+    const core::color::Spectrum sigma_a, sigma_s;
+
+    const Float g;
+
+    const int nx, ny, nz;
+
+    const common::math::Transformf WorldToMedium;
+
+    int nBlocksX, nBlocksY, nBlocksZ;
+
+    std::unique_ptr<Float[]> density;
+
+    Float sigma_t;
+
+    int majorantRes[3];
+
+    // sigma_t times the largest density that any lookup inside the cell
+    // can return.
+    std::unique_ptr<Float[]> majorant;
+
+    friend class MajorantIterator;
+};
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "HenyeyGreenstein.h"
+#include "../../common/math/Vec2.h"
+#include "../../common/math/Vec3.h"
+#include "../../common/tool/Stats.h"
+
+namespace core
+{
+namespace interaction
+{
+
+
+Float HenyeyGreenstein::p(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const
+{
+    common::tool::ProfilePhase _(common::tool::Prof::PhaseFuncEvaluation);
+    return PhaseHG(Dot(wo, wi), g);
+}
+
+Float HenyeyGreenstein::Sample_p(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+    const common::math::Vec2f &u) const
+{
+    common::tool::ProfilePhase _(common::tool::Prof::PhaseFuncSampling);
+    // Compute $\cos \theta$ for Henyey--Greenstein sample
+    Float cosTheta;
+    if (std::abs(g) < static_cast<Float>(1e-3))
+    {
+        cosTheta = FLOAT_1 - FLOAT_2 * u[0];
+    }
+    else
+    {
+        Float sqrTerm = (FLOAT_1 - g * g) / (FLOAT_1 + g - FLOAT_2 * g * u[0]);
+        cosTheta = -(FLOAT_1 + g * g - sqrTerm * sqrTerm) / (FLOAT_2 * g);
+    }
+
+    // Compute direction _wi_ for Henyey--Greenstein sample
+    Float sinTheta = std::sqrt((std::max)(FLOAT_0, FLOAT_1 - cosTheta * cosTheta));
+    Float phi = common::math::TWO_PI * u[1];
+    common::math::Vec3f v1, v2;
+    CoordinateSystem(wo, &v1, &v2);
+    *wi = SphericalDirection(sinTheta, cosTheta, phi, v1, v2, wo);
+
+    return PhaseHG(cosTheta, g);
+}
+
+
+}
+}
\ No newline at end of file
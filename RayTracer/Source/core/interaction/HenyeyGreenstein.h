@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "Medium.h"
+
+namespace core
+{
+namespace interaction
+{
+
+
+class HenyeyGreenstein : public PhaseFunction
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    HenyeyGreenstein(Float g) : g(g)
+    {}
+
+
+    Float p(const common::math::Vec3f &wo, const common::math::Vec3f &wi) const;
+
+    Float Sample_p(const common::math::Vec3f &wo, common::math::Vec3f *wi,
+        const common::math::Vec2f &u) const;
+
+private:
+
+    const Float g;
+};
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "HomogeneousMedium.h"
+#include "HenyeyGreenstein.h"
+#include "MediumInteraction.h"
+#include "../sampler/Sampler.h"
+#include "../../common/math/Ray.h"
+#include "../../common/tool/MemoryArena.h"
+#include "../../common/tool/Stats.h"
+
+namespace core
+{
+namespace interaction
+{
+
+
+core::color::Spectrum HomogeneousMedium::Tr(const common::math::Rayf &ray, core::sampler::Sampler &sampler) const
+{
+    common::tool::ProfilePhase _(common::tool::Prof::MediumTr);
+    return Exp(-sigma_t * (std::min)(ray.t_max * Length(ray.dir), (std::numeric_limits<Float>::max)()));
+}
+
+core::color::Spectrum HomogeneousMedium::TrSegments(const common::math::Rayf &ray, const Float *t, int nSegments,
+    core::sampler::Sampler &sampler) const
+{
+    common::tool::ProfilePhase _(common::tool::Prof::MediumTr);
+    Float length = FLOAT_0;
+    for (int i = 0; i < nSegments; ++i)
+    {
+        length += t[2 * i + 1] - t[2 * i];
+    }
+    return Exp(-sigma_t * (std::min)(length * Length(ray.dir), (std::numeric_limits<Float>::max)()));
+}
+
+core::color::Spectrum HomogeneousMedium::Sample(const common::math::Rayf &ray, core::sampler::Sampler &sampler,
+    common::tool::MemoryArena &arena, MediumInteraction *mi) const
+{
+    common::tool::ProfilePhase _(common::tool::Prof::MediumSample);
+    const int nSamples = core::color::Spectrum::SAMPLE_NUMBER;
+
+    // Sample a channel and distance along the ray
+    int channel = (std::min)(static_cast<int>(sampler.Get1D() * nSamples), nSamples - 1);
+    Float dist = -std::log(FLOAT_1 - sampler.Get1D()) / sigma_t[channel];
+    Float rayLength = Length(ray.dir);
+    Float t = (std::min)(dist / rayLength, ray.t_max);
+    bool sampledMedium = t < ray.t_max;
+    if (sampledMedium)
+    {
+        *mi = MediumInteraction(ray(t), -ray.dir, ray.time, this, ARENA_ALLOC(arena, HenyeyGreenstein)(g));
+    }
+
+    // Compute the transmittance and sampling density
+    core::color::Spectrum Tr = Exp(-sigma_t * (std::min)(t, (std::numeric_limits<Float>::max)()) * rayLength);
+
+    // Return weighting factor for scattering from homogeneous medium
+    core::color::Spectrum density = sampledMedium ? (sigma_t * Tr) : Tr;
+    Float pdf = FLOAT_0;
+    for (int i = 0; i < nSamples; ++i)
+    {
+        pdf += density[i];
+    }
+    pdf *= FLOAT_1 / static_cast<Float>(nSamples);
+    if (FLOAT_0 == pdf)
+    {
+        CHECK(Tr.IsBlack());
+        pdf = FLOAT_1;
+    }
+
+    return sampledMedium ? (Tr * sigma_s / pdf) : (Tr / pdf);
+}
+
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "Medium.h"
+#include "../color/Spectrum.h"
+
+namespace core
+{
+namespace interaction
+{
+
+
+class HomogeneousMedium : public Medium
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    HomogeneousMedium(const core::color::Spectrum &sigma_a, const core::color::Spectrum &sigma_s, Float g)
+        : sigma_a(sigma_a),
+        sigma_s(sigma_s),
+        sigma_t(sigma_s + sigma_a),
+        g(g)
+    {}
+
+
+    core::color::Spectrum Tr(const common::math::Rayf &ray, core::sampler::Sampler &sampler) const;
+
+    // Transmittance is closed-form here, so only the total length matters
+    core::color::Spectrum TrSegments(const common::math::Rayf &ray, const Float *t, int nSegments,
+        core::sampler::Sampler &sampler) const;
+
+    core::color::Spectrum Sample(const common::math::Rayf &ray, core::sampler::Sampler &sampler,
+        common::tool::MemoryArena &arena,
+        MediumInteraction *mi) const;
+
+private:
+
+    const core::color::Spectrum sigma_a, sigma_s, sigma_t;
+
+    const Float g;
+};
+
+
+}
+}
\ No newline at end of file
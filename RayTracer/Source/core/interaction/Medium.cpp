@@ -1,4 +1,7 @@
 #include "Medium.h"
+#include "MediumBoundaries.h"
+#include "../color/Spectrum.h"
+#include "../../common/math/Ray.h"
 
 namespace core
 {
@@ -10,5 +13,76 @@ PhaseFunction::~PhaseFunction()
 {}
 
 
+core::color::Spectrum Medium::TrSegments(const common::math::Rayf &ray, const Float *t, int nSegments,
+    core::sampler::Sampler &sampler) const
+{
+    core::color::Spectrum Tr(FLOAT_1);
+    for (int i = 0; i < nSegments; ++i)
+    {
+        Tr *= this->Tr(common::math::Rayf(ray(t[2 * i]), ray.dir, t[2 * i + 1] - t[2 * i], FLOAT_0, ray.time,
+            this), sampler);
+    }
+    return Tr;
+}
+
+
+core::color::Spectrum MediumBoundaries::Tr(const common::math::Rayf &ray, core::sampler::Sampler &sampler) const
+{
+    // Split the ray into its medium segments up to the last boundary, or
+    // up to its end if not all of them were found
+    const Medium *media[MAX_BOUNDARIES + 1];
+    Float t[2 * (MAX_BOUNDARIES + 1)];
+    int nSegments = 0;
+    const Medium *medium = ray.medium;
+    Float t0 = FLOAT_0;
+    for (int i = 0; i <= count; ++i)
+    {
+        if (i == count && !complete)
+        {
+            break;
+        }
+        Float t1 = i < count ? this->t[i] : ray.t_max;
+        if (nullptr != medium)
+        {
+            media[nSegments] = medium;
+            t[2 * nSegments] = t0;
+            t[2 * nSegments + 1] = t1;
+            ++nSegments;
+        }
+        if (i < count)
+        {
+            medium = it[i].GetMedium(ray.dir);
+            t0 = t1;
+        }
+    }
+
+    // Hand every medium all of its segments in one call
+    core::color::Spectrum Tr(FLOAT_1);
+    bool done[MAX_BOUNDARIES + 1] = {};
+    Float mediumT[2 * (MAX_BOUNDARIES + 1)];
+    for (int i = 0; i < nSegments; ++i)
+    {
+        if (done[i])
+        {
+            continue;
+        }
+        int nMediumSegments = 0;
+        for (int j = i; j < nSegments; ++j)
+        {
+            if (media[j] == media[i])
+            {
+                mediumT[2 * nMediumSegments] = t[2 * j];
+                mediumT[2 * nMediumSegments + 1] = t[2 * j + 1];
+                ++nMediumSegments;
+                done[j] = true;
+            }
+        }
+        Tr *= media[i]->TrSegments(ray, mediumT, nMediumSegments, sampler);
+    }
+
+    return Tr;
+}
+
+
 }
 }
\ No newline at end of file
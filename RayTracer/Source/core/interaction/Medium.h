@@ -48,6 +48,13 @@ public:
 
     virtual core::color::Spectrum Tr(const common::math::Rayf &ray, core::sampler::Sampler &sampler) const = 0;
 
+    // Transmittance along the _nSegments_ pieces [_t[2i]_, _t[2i + 1]_] of
+    // _ray_, which are disjoint and in increasing order. The default calls
+    // Tr() for each piece; media with an acceleration structure override it
+    // to walk the structure once for all of them.
+    virtual core::color::Spectrum TrSegments(const common::math::Rayf &ray, const Float *t, int nSegments,
+        core::sampler::Sampler &sampler) const;
+
     virtual core::color::Spectrum Sample(const common::math::Rayf &ray, core::sampler::Sampler &sampler,
         common::tool::MemoryArena &arena,
         MediumInteraction *mi) const = 0;
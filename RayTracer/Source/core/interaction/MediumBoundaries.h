@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "Interaction.h"
+
+namespace core
+{
+namespace interaction
+{
+
+
+// Medium interfaces (hits on primitives without a material) that a ray
+// crosses in front of its first opaque hit, nearest first. Collecting them
+// during a single traversal lets the caller walk every medium segment of
+// the ray without going back to the root of the accelerator for each one.
+struct MediumBoundaries
+{
+    static constexpr int MAX_BOUNDARIES = 8;
+
+    int count = 0;
+    Float t[MAX_BOUNDARIES];
+    Interaction it[MAX_BOUNDARIES];
+
+    // Parametric distance of the nearest boundary that did not fit
+    Float tDropped = (std::numeric_limits<Float>::max)();
+
+    // Set by Clip(): false when boundaries in front of the hit were
+    // dropped, in which case the caller has to continue the ray past the
+    // last recorded one.
+    bool complete = true;
+
+
+    void Clear()
+    {
+        count = 0;
+        tDropped = (std::numeric_limits<Float>::max)();
+        complete = true;
+    }
+
+    void Insert(Float tHit, const Interaction &hit)
+    {
+        if (MAX_BOUNDARIES == count)
+        {
+            if (tHit >= t[count - 1])
+            {
+                tDropped = (std::min)(tDropped, tHit);
+                return;
+            }
+            tDropped = (std::min)(tDropped, t[--count]);
+        }
+
+        // Keep the list sorted by distance
+        int i = count++;
+        for (; i > 0 && t[i - 1] > tHit; --i)
+        {
+            t[i] = t[i - 1];
+            it[i] = it[i - 1];
+        }
+        t[i] = tHit;
+        it[i] = hit;
+    }
+
+    // Drops boundaries at or beyond the hit at _tMax_
+    void Clip(Float tMax)
+    {
+        while (count > 0 && t[count - 1] >= tMax)
+        {
+            --count;
+        }
+        complete = tDropped >= tMax;
+    }
+
+    // Transmittance of _ray_ through the media between its boundaries, up
+    // to the last one or, when _complete_, up to the end of the ray
+    core::color::Spectrum Tr(const common::math::Rayf &ray, core::sampler::Sampler &sampler) const;
+
+    // Medium the ray travels through after the last recorded boundary
+    const Medium *CurrentMedium(const common::math::Rayf &ray) const
+    {
+        return count > 0 ? it[count - 1].GetMedium(ray.dir) : ray.medium;
+    }
+};
+
+
+}
+}
\ No newline at end of file
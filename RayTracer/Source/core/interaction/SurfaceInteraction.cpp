@@ -3,6 +3,7 @@
 #include "../primitive/Primitive.h"
 #include "../../common/math/RayDifferential.h"
 #include "../../common/math/Transform.h"
+#include "../color/HeroSpectrum.h"
 #include "../color/Spectrum.h"
 #include "../light/AreaLight.h"
 
@@ -145,5 +146,11 @@ color::Spectrum SurfaceInteraction::Le(const common::math::Vec3f &w) const
     return area ? area->L(*this, w) : color::Spectrum(FLOAT_0);
 }
 
+color::HeroSpectrum SurfaceInteraction::Le(const common::math::Vec3f &w, const color::SampledWavelengths &lambda) const
+{
+    const light::AreaLight *area = primitive->GetAreaLight();
+    return area ? area->L(*this, w, lambda) : color::HeroSpectrum(FLOAT_0);
+}
+
 }
 }
\ No newline at end of file
@@ -64,6 +64,8 @@ public:
 
     color::Spectrum Le(const common::math::Vec3f &w) const;
 
+    color::HeroSpectrum Le(const common::math::Vec3f &w, const color::SampledWavelengths &lambda) const;
+
 };
 
 
@@ -1,4 +1,5 @@
 #include "AreaLight.h"
+#include "../color/HeroSpectrum.h"
 
 namespace core
 {
@@ -11,5 +12,12 @@ AreaLight::AreaLight(const common::math::Transformf &LightToWorld, const core::i
 {}
 
 
+color::HeroSpectrum AreaLight::L(const core::interaction::Interaction &intr, const common::math::Vec3f &w,
+    const color::SampledWavelengths &lambda) const
+{
+    return color::HeroSpectrum::FromSpectrum(L(intr, w), lambda, color::SpectrumType::Illuminant);
+}
+
+
 }
 }
\ No newline at end of file
@@ -21,6 +21,10 @@ public:
 
 
     virtual color::Spectrum L(const core::interaction::Interaction &intr, const common::math::Vec3f &w) const = 0;
+
+    // L() at the wavelengths of _lambda_, by default read from its bins
+    virtual color::HeroSpectrum L(const core::interaction::Interaction &intr, const common::math::Vec3f &w,
+        const color::SampledWavelengths &lambda) const;
 };
 
 
@@ -5,6 +5,7 @@
 #include "../bxdf/BxDF.h"
 #include "../sampler/Sampling.h"
 #include "../shape/Triangle.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -23,6 +24,7 @@ DiffuseAreaLight::DiffuseAreaLight(const common::math::Transformf &LightToWorld,
     twoSided(twoSided),
     area(shape->Area())
 {
+    Lemit.ToRGB(rgbEmit);
     // Warn if light has transformation with non-uniform scale, though not
     // for Triangles, since this doesn't matter for them.
     if (WorldToLight.HasScale() && nullptr == dynamic_cast<const core::shape::Triangle *>(shape.get()))
@@ -42,27 +44,51 @@ core::color::Spectrum DiffuseAreaLight::Power() const
     return (twoSided ? FLOAT_2 : FLOAT_1) * Lemit * area * common::math::PI;
 }
 
+bool DiffuseAreaLight::SampleShape(const interaction::Interaction &ref, const common::math::Vec2f &u,
+    common::math::Vec3f *wi, Float *pdf, VisibilityTester *vis, interaction::Interaction *pShape) const
+{
+    *pShape = shape->Sample(ref, u, pdf);
+    pShape->medium_interface = medium_interface;
+    if (FLOAT_0 == *pdf || FLOAT_0 == LengthSquared(pShape->p - ref.p))
+    {
+        *pdf = FLOAT_0;
+        return false;
+    }
+    *wi = Normalize(pShape->p - ref.p);
+    *vis = VisibilityTester(ref, *pShape);
+    return true;
+}
+
 core::color::Spectrum DiffuseAreaLight::Sample_Li(const interaction::Interaction &ref, const common::math::Vec2f &u,
     common::math::Vec3f *wi, Float *pdf,
     VisibilityTester *vis) const
 {
-    //ProfilePhase _(Prof::LightSample);
-    interaction::Interaction pShape = shape->Sample(ref, u, pdf);
-    pShape.medium_interface = medium_interface;
-    if (FLOAT_0 == *pdf || FLOAT_0 == LengthSquared(pShape.p - ref.p))
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
+    interaction::Interaction pShape;
+    if (!SampleShape(ref, u, wi, pdf, vis, &pShape))
     {
-        *pdf = FLOAT_0;
         return core::color::Spectrum(FLOAT_0);
     }
-    *wi = Normalize(pShape.p - ref.p);
-    *vis = VisibilityTester(ref, pShape);
     return L(pShape, -*wi);
 }
 
+core::color::HeroSpectrum DiffuseAreaLight::Sample_Li(const interaction::Interaction &ref,
+    const common::math::Vec2f &u, const core::color::SampledWavelengths &lambda, common::math::Vec3f *wi,
+    Float *pdf, VisibilityTester *vis) const
+{
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
+    interaction::Interaction pShape;
+    if (!SampleShape(ref, u, wi, pdf, vis, &pShape))
+    {
+        return core::color::HeroSpectrum(FLOAT_0);
+    }
+    return L(pShape, -*wi, lambda);
+}
+
 Float DiffuseAreaLight::Pdf_Li(const interaction::Interaction &ref,
     const common::math::Vec3f &wi) const
 {
-    //ProfilePhase _(Prof::LightPdf);
+    common::tool::ProfilePhase _(common::tool::Prof::LightPdf);
     return shape->Pdf(ref, wi);
 }
 
@@ -70,7 +96,7 @@ core::color::Spectrum DiffuseAreaLight::Sample_Le(const common::math::Vec2f &u1,
     Float time, common::math::Rayf *ray, common::math::Vec3f *nLight,
     Float *pdfPos, Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     // Sample a point on the area light's _Shape_, _pShape_
     interaction::Interaction pShape = shape->Sample(u1, pdfPos);
     pShape.medium_interface = medium_interface;
@@ -112,7 +138,7 @@ core::color::Spectrum DiffuseAreaLight::Sample_Le(const common::math::Vec2f &u1,
 void DiffuseAreaLight::Pdf_Le(const common::math::Rayf &ray, const common::math::Vec3f &n, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightPdf);
+    common::tool::ProfilePhase _(common::tool::Prof::LightPdf);
     interaction::Interaction it(ray.origin, n, common::math::Vec3f(), common::math::Vec3f(n), ray.time,
         medium_interface);
     *pdfPos = shape->Pdf(it);
@@ -2,6 +2,7 @@
 
 #include "AreaLight.h"
 #include "../../common/math/Vec3.h"
+#include "../color/HeroSpectrum.h"
 #include "../color/Spectrum.h"
 #include "../interaction/Interaction.h"
 
@@ -30,11 +31,24 @@ public:
         return (twoSided || Dot(intr.n, w) > FLOAT_0) ? Lemit : core::color::Spectrum(FLOAT_0);
     }
 
+    // Upsampled from the emitted RGB at each wavelength
+    core::color::HeroSpectrum L(const interaction::Interaction &intr, const common::math::Vec3f &w,
+        const core::color::SampledWavelengths &lambda) const
+    {
+        return (twoSided || Dot(intr.n, w) > FLOAT_0) ?
+            core::color::HeroSpectrum::FromRGB(rgbEmit, lambda, core::color::SpectrumType::Illuminant) :
+            core::color::HeroSpectrum(FLOAT_0);
+    }
+
     core::color::Spectrum Power() const;
 
     core::color::Spectrum Sample_Li(const interaction::Interaction &ref, const common::math::Vec2f &u, common::math::Vec3f *wo,
         Float *pdf, VisibilityTester *vis) const;
 
+    core::color::HeroSpectrum Sample_Li(const interaction::Interaction &ref, const common::math::Vec2f &u,
+        const core::color::SampledWavelengths &lambda, common::math::Vec3f *wo, Float *pdf,
+        VisibilityTester *vis) const;
+
     Float Pdf_Li(const interaction::Interaction &, const common::math::Vec3f &) const;
 
     core::color::Spectrum Sample_Le(const common::math::Vec2f &u1, const common::math::Vec2f &u2, Float time,
@@ -46,7 +60,15 @@ public:
 
 protected:
 
+    // Picks the point _pShape_ of Sample_Li(), false where it has no
+    // contribution
+    bool SampleShape(const interaction::Interaction &ref, const common::math::Vec2f &u, common::math::Vec3f *wi,
+        Float *pdf, VisibilityTester *vis, interaction::Interaction *pShape) const;
+
+
     const core::color::Spectrum Lemit;
+    // Lemit as RGB, for hero wavelengths
+    Float rgbEmit[3];
 
     std::shared_ptr<core::shape::Shape> shape;
     // Added after book publication: by default, DiffuseAreaLights still
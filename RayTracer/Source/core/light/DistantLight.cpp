@@ -4,6 +4,7 @@
 #include "../../common/math/Vec2.h"
 #include "../bxdf/BxDF.h"
 #include "../sampler/Sampling.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -22,7 +23,7 @@ core::color::Spectrum DistantLight::Sample_Li(const interaction::Interaction &re
     common::math::Vec3f *wi, Float *pdf,
     VisibilityTester *vis) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     *wi = wLight;
     *pdf = FLOAT_1;
     common::math::Vec3f pOutside = ref.p + wLight * (FLOAT_2 * worldRadius);
@@ -44,7 +45,7 @@ core::color::Spectrum DistantLight::Sample_Le(const common::math::Vec2f &u1, con
     Float time, common::math::Rayf *ray, common::math::Vec3f *nLight,
     Float *pdfPos, Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     // Choose point on disk oriented toward infinite light direction
     common::math::Vec3f v1, v2;
     CoordinateSystem(wLight, &v1, &v2);
@@ -63,7 +64,7 @@ core::color::Spectrum DistantLight::Sample_Le(const common::math::Vec2f &u1, con
 void DistantLight::Pdf_Le(const common::math::Rayf &, const common::math::Vec3f &, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightPdf);
+    common::tool::ProfilePhase _(common::tool::Prof::LightPdf);
     *pdfPos = FLOAT_1 / (common::math::PI * worldRadius * worldRadius);
     *pdfDir = FLOAT_0;
 }
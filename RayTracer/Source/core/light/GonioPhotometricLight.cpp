@@ -4,6 +4,7 @@
 #include "../../common/math/Vec2.h"
 #include "../bxdf/BxDF.h"
 #include "../sampler/Sampling.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -15,7 +16,7 @@ core::color::Spectrum GonioPhotometricLight::Sample_Li(const interaction::Intera
     Float *pdf,
     VisibilityTester *vis) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     *wi = Normalize(pLight - ref.p);
     *pdf = FLOAT_1;
     *vis = VisibilityTester(ref, interaction::Interaction(pLight, ref.time, medium_interface));
@@ -41,7 +42,7 @@ core::color::Spectrum GonioPhotometricLight::Sample_Le(const common::math::Vec2f
     common::math::Vec3f *nLight, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     *ray = common::math::Rayf(pLight, sampler::UniformSampleSphere(u1)
         , (std::numeric_limits<Float>::max)(), FLOAT_0, time,
         medium_interface.inside);
@@ -54,7 +55,7 @@ core::color::Spectrum GonioPhotometricLight::Sample_Le(const common::math::Vec2f
 void GonioPhotometricLight::Pdf_Le(const common::math::Rayf &, const common::math::Vec3f &, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightPdf);
+    common::tool::ProfilePhase _(common::tool::Prof::LightPdf);
     *pdfPos = FLOAT_0;
     *pdfDir = sampler::UniformSpherePdf();
 }
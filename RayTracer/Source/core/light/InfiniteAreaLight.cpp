@@ -5,6 +5,7 @@
 #include "../../common/math/RayDifferential.h"
 #include "../bxdf/BxDF.h"
 #include "../sampler/Sampling.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -82,7 +83,7 @@ core::color::Spectrum InfiniteAreaLight::Sample_Li(const interaction::Interactio
     common::math::Vec3f *wi, Float *pdf,
     VisibilityTester *vis) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     // Find $(u,v)$ sample coordinates in infinite light texture
     Float mapPdf;
     common::math::Vec2f uv = distribution->SampleContinuous(u, &mapPdf);
@@ -112,7 +113,7 @@ core::color::Spectrum InfiniteAreaLight::Sample_Li(const interaction::Interactio
 
 Float InfiniteAreaLight::Pdf_Li(const interaction::Interaction &, const common::math::Vec3f &w) const
 {
-    //ProfilePhase _(Prof::LightPdf);
+    common::tool::ProfilePhase _(common::tool::Prof::LightPdf);
     common::math::Vec3f wi = WorldToLight(w);
     Float theta = SphericalTheta(wi), phi = SphericalPhi(wi);
     Float sinTheta = std::sin(theta);
@@ -128,7 +129,7 @@ core::color::Spectrum InfiniteAreaLight::Sample_Le(const common::math::Vec2f &u1
     Float time, common::math::Rayf *ray, common::math::Vec3f *nLight,
     Float *pdfPos, Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     // Compute direction for infinite light sample ray
     common::math::Vec2f u = u1;
 
@@ -161,7 +162,7 @@ core::color::Spectrum InfiniteAreaLight::Sample_Le(const common::math::Vec2f &u1
 void InfiniteAreaLight::Pdf_Le(const common::math::Rayf &ray, const common::math::Vec3f &, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightPdf);
+    common::tool::ProfilePhase _(common::tool::Prof::LightPdf);
     common::math::Vec3f d = -WorldToLight(ray.dir);
     Float theta = SphericalTheta(d), phi = SphericalPhi(d);
     common::math::Vec2f uv(phi * common::math::INV_TWO_PI, theta * common::math::INV_PI);
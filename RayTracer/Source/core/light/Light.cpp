@@ -1,5 +1,6 @@
 #include "Light.h"
 #include "../../common/math/RayDifferential.h"
+#include "../color/HeroSpectrum.h"
 #include "../color/Spectrum.h"
 
 namespace core
@@ -26,6 +27,20 @@ color::Spectrum Light::Le(const common::math::RayDifferentialf &ray) const
     return color::Spectrum(FLOAT_0);
 }
 
+color::HeroSpectrum Light::Sample_Li(const interaction::Interaction &ref, const common::math::Vec2f &u,
+    const color::SampledWavelengths &lambda, common::math::Vec3f *wi, Float *pdf,
+    VisibilityTester *vis) const
+{
+    return color::HeroSpectrum::FromSpectrum(Sample_Li(ref, u, wi, pdf, vis), lambda,
+        color::SpectrumType::Illuminant);
+}
+
+color::HeroSpectrum Light::Le(const common::math::RayDifferentialf &ray,
+    const color::SampledWavelengths &lambda) const
+{
+    return color::HeroSpectrum::FromSpectrum(Le(ray), lambda, color::SpectrumType::Illuminant);
+}
+
 
 }
 }
\ No newline at end of file
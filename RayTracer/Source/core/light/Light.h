@@ -58,6 +58,15 @@ public:
 
     virtual Float Pdf_Li(const interaction::Interaction &ref, const common::math::Vec3f &wi) const = 0;
 
+    // Sample_Li() and Le() at the wavelengths of _lambda_; by default they
+    // read the bins of the dense values
+    virtual color::HeroSpectrum Sample_Li(const interaction::Interaction &ref, const common::math::Vec2f &u,
+        const color::SampledWavelengths &lambda, common::math::Vec3f *wi, Float *pdf,
+        VisibilityTester *vis) const;
+
+    virtual color::HeroSpectrum Le(const common::math::RayDifferentialf &r,
+        const color::SampledWavelengths &lambda) const;
+
     virtual color::Spectrum Sample_Le(const common::math::Vec2f &u1, const common::math::Vec2f &u2, Float time,
         common::math::Rayf *ray, common::math::Vec3f *nLight, Float *pdfPos,
         Float *pdfDir) const = 0;
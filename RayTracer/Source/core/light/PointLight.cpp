@@ -3,6 +3,7 @@
 #include "../../common/math/Constants.h"
 #include "../sampler/Sampling.h"
 #include "../interaction/MediumInteraction.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -21,7 +22,7 @@ color::Spectrum PointLight::Sample_Li(const core::interaction::Interaction &ref,
     common::math::Vec3f *wi, Float *pdf,
     VisibilityTester *vis) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     *wi = Normalize(pLight - ref.p);
     *pdf = FLOAT_1;
     *vis = VisibilityTester(ref, core::interaction::Interaction(pLight, ref.time, medium_interface));
@@ -42,7 +43,7 @@ color::Spectrum PointLight::Sample_Le(const common::math::Vec2f &u1, const commo
     common::math::Rayf *ray, common::math::Vec3f *nLight, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     *ray = common::math::Rayf(pLight, core::sampler::UniformSampleSphere(u1), (std::numeric_limits<Float>::max)(), FLOAT_0, time,
         medium_interface.inside);
     *nLight = (common::math::Vec3f)ray->dir;
@@ -54,7 +55,7 @@ color::Spectrum PointLight::Sample_Le(const common::math::Vec2f &u1, const commo
 void PointLight::Pdf_Le(const common::math::Rayf &, const common::math::Vec3f &, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightPdf);
+    common::tool::ProfilePhase _(common::tool::Prof::LightPdf);
     *pdfPos = FLOAT_0;
     *pdfDir = core::sampler::UniformSpherePdf();
 }
@@ -4,6 +4,7 @@
 #include "../../common/math/Vec2.h"
 #include "../bxdf/BxDF.h"
 #include "../sampler/Sampling.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -56,7 +57,7 @@ core::color::Spectrum ProjectionLight::Sample_Li(const interaction::Interaction
     common::math::Vec3f *wi, Float *pdf,
     VisibilityTester *vis) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     *wi = Normalize(pLight - ref.p);
     *pdf = FLOAT_1;
     *vis = VisibilityTester(ref, interaction::Interaction(pLight, ref.time, medium_interface));
@@ -104,7 +105,7 @@ core::color::Spectrum ProjectionLight::Sample_Le(const common::math::Vec2f &u1,
     Float time, common::math::Rayf *ray, common::math::Vec3f *nLight,
     Float *pdfPos, Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     common::math::Vec3f v = sampler::UniformSampleCone(u1, cosTotalWidth);
     *ray = common::math::Rayf(pLight, LightToWorld(v), (std::numeric_limits<Float>::max)(), FLOAT_0,
         time, medium_interface.inside);
@@ -117,7 +118,7 @@ core::color::Spectrum ProjectionLight::Sample_Le(const common::math::Vec2f &u1,
 void ProjectionLight::Pdf_Le(const common::math::Rayf &ray, const common::math::Vec3f &, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightPdf);
+    common::tool::ProfilePhase _(common::tool::Prof::LightPdf);
     *pdfPos = FLOAT_0;
     *pdfDir = (bxdf::CosTheta(WorldToLight(ray.dir)) >= cosTotalWidth)
         ? sampler::UniformConePdf(cosTotalWidth)
@@ -5,6 +5,7 @@
 #include "../bxdf/BxDF.h"
 #include "../interaction/MediumInteraction.h"
 #include "../sampler/Sampling.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -26,7 +27,7 @@ core::color::Spectrum SpotLight::Sample_Li(const interaction::Interaction &ref,
     common::math::Vec3f *wi, Float *pdf,
     VisibilityTester *vis) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     *wi = Normalize(pLight - ref.p);
     *pdf = FLOAT_1;
     *vis = VisibilityTester(ref, interaction::Interaction(pLight, ref.time, medium_interface));
@@ -64,7 +65,7 @@ core::color::Spectrum SpotLight::Sample_Le(const common::math::Vec2f &u1, const
     common::math::Rayf *ray, common::math::Vec3f *nLight, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightSample);
+    common::tool::ProfilePhase _(common::tool::Prof::LightSample);
     common::math::Vec3f w = sampler::UniformSampleCone(u1, cosTotalWidth);
     *ray = common::math::Rayf(pLight, LightToWorld(w), (std::numeric_limits<Float>::max)(), FLOAT_0
         , time, medium_interface.inside);
@@ -77,7 +78,7 @@ core::color::Spectrum SpotLight::Sample_Le(const common::math::Vec2f &u1, const
 void SpotLight::Pdf_Le(const common::math::Rayf &ray, const common::math::Vec3f &, Float *pdfPos,
     Float *pdfDir) const
 {
-    //ProfilePhase _(Prof::LightPdf);
+    common::tool::ProfilePhase _(common::tool::Prof::LightPdf);
     *pdfPos = FLOAT_0;
     *pdfDir = (bxdf::CosTheta(WorldToLight(ray.dir)) >= cosTotalWidth)
         ? sampler::UniformConePdf(cosTotalWidth)
@@ -4,6 +4,7 @@
 #include "../scene/Scene.h"
 #include "../primitive/Primitive.h"
 #include "../interaction/SurfaceInteraction.h"
+#include "../interaction/MediumBoundaries.h"
 
 namespace core
 {
@@ -20,28 +21,26 @@ color::Spectrum VisibilityTester::Tr(const core::scene::Scene &scene, core::samp
 {
     common::math::Rayf ray(p0.SpawnRayTo(p1));
     color::Spectrum Tr(FLOAT_1);
+    interaction::MediumBoundaries boundaries;
     while (true)
     {
         interaction::SurfaceInteraction isect;
-        bool hitSurface = scene.Intersect(ray, &isect);
+        bool hitSurface = scene.IntersectBoundaries(ray, &isect, &boundaries);
         // Handle opaque surface along ray's path
-        if (hitSurface && isect.primitive->GetMaterial() != nullptr)
+        if (hitSurface && boundaries.complete)
         {
             return color::Spectrum(FLOAT_0);
         }
 
-        // Update transmittance for current ray segment
-        if (ray.medium)
-        {
-            Tr *= ray.medium->Tr(ray, sampler);
-        }
+        // Update transmittance for the medium segments of the ray
+        Tr *= boundaries.Tr(ray, sampler);
 
         // Generate next ray segment or return final transmittance
-        if (!hitSurface)
+        if (boundaries.complete)
         {
             break;
         }
-        ray = isect.SpawnRayTo(p1);
+        ray = boundaries.it[boundaries.count - 1].SpawnRayTo(p1);
     }
 
     return Tr;
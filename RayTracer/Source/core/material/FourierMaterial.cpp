@@ -12,22 +12,11 @@ namespace core
 namespace material
 {
 
-std::map<std::string, std::unique_ptr<core::bxdf::FourierBSDFTable>> FourierMaterial::loadedBSDFs;
-
 FourierMaterial::FourierMaterial(const std::string &filename,
     const std::shared_ptr<core::texture::Texture<Float>> &bumpMap)
-    : bumpMap(bumpMap)
-{
-    if (loadedBSDFs.find(filename) == loadedBSDFs.end())
-    {
-        std::unique_ptr<core::bxdf::FourierBSDFTable> table(new core::bxdf::FourierBSDFTable);
-        /* TODO
-        core::bxdf::FourierBSDFTable::Read(filename, table.get());
-        */
-        loadedBSDFs[filename] = std::move(table);
-    }
-    bsdfTable = loadedBSDFs[filename].get();
-}
+    : bsdfTable(core::bxdf::FourierBSDFTable::Get(filename)),
+    bumpMap(bumpMap)
+{}
 
 void FourierMaterial::ComputeScatteringFunctions(
     core::interaction::SurfaceInteraction *si, common::tool::MemoryArena &arena, TransportMode mode,
@@ -39,11 +28,9 @@ void FourierMaterial::ComputeScatteringFunctions(
         Bump(bumpMap, si);
     }
     si->bsdf = ARENA_ALLOC(arena, core::bxdf::BSDF)(*si);
-    // Checking for zero channels works as a proxy for checking whether the
-    // table was successfully read from the file.
-    if (bsdfTable->nChannels > 0)
+    if (bsdfTable)
     {
-        si->bsdf->Add(ARENA_ALLOC(arena, core::bxdf::FourierBSDF)(*bsdfTable, mode));
+        si->bsdf->Add<core::bxdf::FourierBSDF>(arena, *bsdfTable, mode);
     }
 }
 
@@ -3,7 +3,7 @@
 #include "../../ForwardDeclaration.h"
 #include "Material.h"
 #include "../color/Spectrum.h"
-#include <map>
+#include <string>
 
 namespace core
 {
@@ -29,11 +29,11 @@ public:
 
 private:
 
-    core::bxdf::FourierBSDFTable *bsdfTable;
+    // Shared through FourierBSDFTable::Get(); nullptr if the file couldn't
+    // be read
+    const core::bxdf::FourierBSDFTable *bsdfTable;
 
     std::shared_ptr<core::texture::Texture<Float>> bumpMap;
-
-    static std::map<std::string, std::unique_ptr<core::bxdf::FourierBSDFTable>> loadedBSDFs;
 };
 
 /* TODO
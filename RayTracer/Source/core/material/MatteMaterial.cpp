@@ -13,6 +13,16 @@ namespace material
 {
 
 
+MatteMaterial::MatteMaterial(const std::shared_ptr<core::texture::Texture<core::color::Spectrum>> &Kd,
+    const std::shared_ptr<core::texture::Texture<Float>> &sigma,
+    const std::shared_ptr<core::texture::Texture<Float>> &bumpMap)
+    : Kd(Kd), sigma(sigma), bumpMap(bumpMap)
+{
+    core::texture::TextureCompiler compiler(&textures);
+    KdValue = compiler.Compile(Kd);
+    sigmaValue = compiler.Compile(sigma);
+}
+
 void MatteMaterial::ComputeScatteringFunctions(core::interaction::SurfaceInteraction *si,
     common::tool::MemoryArena &arena,
     TransportMode mode,
@@ -26,17 +36,18 @@ void MatteMaterial::ComputeScatteringFunctions(core::interaction::SurfaceInterac
 
     // Evaluate core::texture::Textures for _MatteMaterial_ material and allocate BRDF
     si->bsdf = ARENA_ALLOC(arena, core::bxdf::BSDF)(*si);
-    core::color::Spectrum r = Kd->Evaluate(*si).Clamp();
-    Float sig = common::math::Clamp(sigma->Evaluate(*si), FLOAT_0, static_cast<Float>(90.0F));
+    core::texture::TextureFrame frame = textures.Execute(*si, arena);
+    core::color::Spectrum r = textures.Value<core::color::Spectrum>(frame, KdValue).Clamp();
+    Float sig = common::math::Clamp(textures.Value<Float>(frame, sigmaValue), FLOAT_0, static_cast<Float>(90.0F));
     if (!r.IsBlack())
     {
         if (FLOAT_0 == sig)
         {
-            si->bsdf->Add(ARENA_ALLOC(arena, core::bxdf::LambertianReflection)(r));
+            si->bsdf->Add<core::bxdf::LambertianReflection>(arena, r);
         }
         else
         {
-            si->bsdf->Add(ARENA_ALLOC(arena, core::bxdf::OrenNayar)(r, sig));
+            si->bsdf->Add<core::bxdf::OrenNayar>(arena, r, sig);
         }
     }
 }
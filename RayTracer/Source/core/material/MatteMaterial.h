@@ -3,6 +3,7 @@
 #include "../../ForwardDeclaration.h"
 #include "Material.h"
 #include "../color/Spectrum.h"
+#include "../texture/TextureProgram.h"
 
 namespace core
 {
@@ -20,9 +21,7 @@ public:
 
     MatteMaterial(const std::shared_ptr<core::texture::Texture<core::color::Spectrum>> &Kd,
         const std::shared_ptr<core::texture::Texture<Float>> &sigma,
-        const std::shared_ptr<core::texture::Texture<Float>> &bumpMap)
-        : Kd(Kd), sigma(sigma), bumpMap(bumpMap)
-    {}
+        const std::shared_ptr<core::texture::Texture<Float>> &bumpMap);
 
 
     void ComputeScatteringFunctions(core::interaction::SurfaceInteraction *si, common::tool::MemoryArena &arena,
@@ -34,6 +33,11 @@ private:
     std::shared_ptr<core::texture::Texture<core::color::Spectrum>> Kd;
 
     std::shared_ptr<core::texture::Texture<Float>> sigma, bumpMap;
+
+    // _Kd_ and _sigma_, flattened; _KdValue_ and _sigmaValue_ are their
+    // operands
+    core::texture::TextureProgram textures;
+    int KdValue, sigmaValue;
 };
 
 /* TODO
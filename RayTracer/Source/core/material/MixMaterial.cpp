@@ -28,11 +28,13 @@ void MixMaterial::ComputeScatteringFunctions(core::interaction::SurfaceInteracti
     int n1 = si->bsdf->NumComponents(), n2 = si2.bsdf->NumComponents();
     for (int i = 0; i < n1; ++i)
     {
-        si->bsdf->bxdfs[i] = ARENA_ALLOC(arena, core::bxdf::ScaledBxDF)(si->bsdf->bxdfs[i], s1);
+        core::bxdf::BSDF::Component &c = si->bsdf->components[i];
+        c.bxdf = ARENA_ALLOC(arena, core::bxdf::ScaledBxDF)(c.bxdf, s1);
+        c.kind = core::bxdf::BxDFKind::Generic;
     }
     for (int i = 0; i < n2; ++i)
     {
-        si->bsdf->Add(ARENA_ALLOC(arena, core::bxdf::ScaledBxDF)(si2.bsdf->bxdfs[i], s2));
+        si->bsdf->Add(ARENA_ALLOC(arena, core::bxdf::ScaledBxDF)(si2.bsdf->components[i].bxdf, s2));
     }
 }
 
@@ -14,6 +14,24 @@ namespace material
 {
 
 
+PlasticMaterial::PlasticMaterial(const std::shared_ptr<core::texture::Texture<core::color::Spectrum>> &Kd,
+    const std::shared_ptr<core::texture::Texture<core::color::Spectrum>> &Ks,
+    const std::shared_ptr<core::texture::Texture<Float>> &roughness,
+    const std::shared_ptr<core::texture::Texture<Float>> &bumpMap,
+    bool remapRoughness)
+    : Kd(Kd),
+    Ks(Ks),
+    roughness(roughness),
+    bumpMap(bumpMap),
+    remapRoughness(remapRoughness)
+{
+    core::texture::TextureCompiler compiler(&textures);
+    KdValue = compiler.Compile(Kd);
+    KsValue = compiler.Compile(Ks);
+    roughnessPart = compiler.BeginPart();
+    roughnessValue = compiler.Compile(roughness);
+}
+
 void PlasticMaterial::ComputeScatteringFunctions(
     core::interaction::SurfaceInteraction *si, common::tool::MemoryArena &arena, TransportMode mode,
     bool allowMultipleLobes) const
@@ -24,28 +42,29 @@ void PlasticMaterial::ComputeScatteringFunctions(
         Bump(bumpMap, si);
     }
     si->bsdf = ARENA_ALLOC(arena, core::bxdf::BSDF)(*si);
+    core::texture::TextureFrame frame = textures.Execute(*si, arena);
     // Initialize diffuse component of plastic material
-    core::color::Spectrum kd = Kd->Evaluate(*si).Clamp();
+    core::color::Spectrum kd = textures.Value<core::color::Spectrum>(frame, KdValue).Clamp();
     if (!kd.IsBlack())
     {
-        si->bsdf->Add(ARENA_ALLOC(arena, core::bxdf::LambertianReflection)(kd));
+        si->bsdf->Add<core::bxdf::LambertianReflection>(arena, kd);
     }
 
     // Initialize specular component of plastic material
-    core::color::Spectrum ks = Ks->Evaluate(*si).Clamp();
+    core::color::Spectrum ks = textures.Value<core::color::Spectrum>(frame, KsValue).Clamp();
     if (!ks.IsBlack())
     {
         core::bxdf::Fresnel *fresnel = ARENA_ALLOC(arena, core::bxdf::FresnelDielectric)(FLOAT_1 + FLOAT_INV_2, FLOAT_1);
         // Create microfacet distribution _distrib_ for plastic material
-        Float rough = roughness->Evaluate(*si);
+        textures.Execute(roughnessPart, *si, frame);
+        Float rough = textures.Value<Float>(frame, roughnessValue);
         if (remapRoughness)
         {
             rough = core::bxdf::distribution::TrowbridgeReitzDistribution::RoughnessToAlpha(rough);
         }
         core::bxdf::distribution::MicrofacetDistribution *distrib =
             ARENA_ALLOC(arena, core::bxdf::distribution::TrowbridgeReitzDistribution)(rough, rough);
-        core::bxdf::BxDF *spec = ARENA_ALLOC(arena, core::bxdf::MicrofacetReflection)(ks, distrib, fresnel);
-        si->bsdf->Add(spec);
+        si->bsdf->Add<core::bxdf::MicrofacetReflection>(arena, ks, distrib, fresnel);
     }
 }
 
@@ -3,6 +3,7 @@
 #include "../../ForwardDeclaration.h"
 #include "Material.h"
 #include "../color/Spectrum.h"
+#include "../texture/TextureProgram.h"
 
 namespace core
 {
@@ -22,13 +23,7 @@ public:
         const std::shared_ptr<core::texture::Texture<core::color::Spectrum>> &Ks,
         const std::shared_ptr<core::texture::Texture<Float>> &roughness,
         const std::shared_ptr<core::texture::Texture<Float>> &bumpMap,
-        bool remapRoughness)
-        : Kd(Kd),
-        Ks(Ks),
-        roughness(roughness),
-        bumpMap(bumpMap),
-        remapRoughness(remapRoughness)
-    {}
+        bool remapRoughness);
 
 
     void ComputeScatteringFunctions(core::interaction::SurfaceInteraction *si, common::tool::MemoryArena &arena,
@@ -42,6 +37,12 @@ private:
     std::shared_ptr<core::texture::Texture<Float>> roughness, bumpMap;
 
     const bool remapRoughness;
+
+    // _Kd_, _Ks_ and _roughness_, flattened; _roughness_ is its own part,
+    // only run where _Ks_ is not black
+    core::texture::TextureProgram textures;
+    int KdValue, KsValue, roughnessValue;
+    int roughnessPart;
 };
 
 /* TODO
@@ -4,6 +4,7 @@
 #include "../shape/Shape.h"
 #include "../interaction/SurfaceInteraction.h"
 #include "../primitive/Primitive.h"
+#include "../../common/tool/Stats.h"
 
 
 namespace core
@@ -72,7 +73,7 @@ void GeometricPrimitive::ComputeScatteringFunctions(
     interaction::SurfaceInteraction *isect, common::tool::MemoryArena &arena, material::TransportMode mode,
     bool allowMultipleLobes) const
 {
-    //ProfilePhase p(Prof::ComputeScatteringFuncs);
+    common::tool::ProfilePhase p(common::tool::Prof::ComputeScatteringFuncs);
     if (material)
     {
         material->ComputeScatteringFunctions(isect, arena, mode,
@@ -0,0 +1,73 @@
+#include "Primitive.h"
+#include "../interaction/MediumBoundaries.h"
+#include "../interaction/SurfaceInteraction.h"
+#include "../../common/math/Bounds3.h"
+#include "../../common/math/Ray.h"
+#include "../../common/math/Vec3.h"
+
+namespace core
+{
+namespace primitive
+{
+
+
+common::math::Bounds3f Primitive::MotionBound(Float time0, Float time1) const
+{
+    return WorldBound();
+}
+
+bool Primitive::IntersectAll(const common::math::Rayf &r, interaction::SurfaceInteraction *isect,
+    const HitFilter &filter) const
+{
+    Float invLength2 = FLOAT_1 / LengthSquared(r.dir);
+    common::math::Rayf ray = r;
+    interaction::SurfaceInteraction hitIsect;
+    while (Intersect(ray, &hitIsect))
+    {
+        // Express the hit in terms of the caller's ray
+        Float tHit = Dot(hitIsect.p - r.origin, r.dir) * invLength2;
+        if (filter(hitIsect, tHit))
+        {
+            *isect = hitIsect;
+            r.t_max = tHit;
+            return true;
+        }
+
+        // Continue just past the rejected hit along the same direction, so
+        // the remaining extent carries over even for unbounded rays
+        ray = hitIsect.SpawnRay(r.dir);
+        ray.t_max = r.t_max - Dot(ray.origin - r.origin, r.dir) * invLength2;
+        if (ray.t_max <= FLOAT_0)
+        {
+            break;
+        }
+    }
+    return false;
+}
+
+bool Primitive::IntersectBoundaries(const common::math::Rayf &r, interaction::SurfaceInteraction *isect,
+    interaction::MediumBoundaries *boundaries) const
+{
+    boundaries->Clear();
+    bool hit = IntersectAll(r, isect, [boundaries](const interaction::SurfaceInteraction &hitIsect, Float tHit)
+    {
+        if (nullptr != hitIsect.primitive->GetMaterial())
+        {
+            return true;
+        }
+        boundaries->Insert(tHit, hitIsect);
+        return false;
+    });
+    boundaries->Clip(r.t_max);
+
+    // The opaque primitive only saw the ray's starting medium
+    if (hit && boundaries->count > 0 && !isect->medium_interface.IsMediumTransition())
+    {
+        isect->medium_interface = interaction::MediumInterface(boundaries->CurrentMedium(r));
+    }
+    return hit;
+}
+
+
+}
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "../../ForwardDeclaration.h"
 #include "../material/Material.h"
+#include <functional>
 
 namespace core
 {
@@ -9,6 +10,13 @@ namespace primitive
 {
 
 
+// Called by Primitive::IntersectAll() for each hit along the ray, in no
+// particular order. Returning true accepts the hit: it is written to the
+// caller's interaction and shortens the ray as Intersect() would. Returning
+// false lets the search go on past it.
+typedef std::function<bool(const interaction::SurfaceInteraction &isect, Float tHit)> HitFilter;
+
+
 class Primitive
 {
 public:
@@ -16,10 +24,26 @@ public:
 
     virtual common::math::Bounds3f WorldBound() const = 0;
 
+    // Bounds of the primitive over the times [time0, time1]; anything that
+    // doesn't move keeps the default, WorldBound()
+    virtual common::math::Bounds3f MotionBound(Float time0, Float time1) const;
+
     virtual bool Intersect(const common::math::Rayf &r, interaction::SurfaceInteraction *) const = 0;
 
     virtual bool IntersectP(const common::math::Rayf &r) const = 0;
 
+    // Reports every hit in front of the nearest accepted one to _filter_.
+    // The default restarts Intersect() just past each rejected hit;
+    // aggregates override it to find them all in a single traversal.
+    virtual bool IntersectAll(const common::math::Rayf &r, interaction::SurfaceInteraction *isect,
+        const HitFilter &filter) const;
+
+    // Like Intersect(), but hits on primitives without a material are
+    // recorded in _boundaries_ instead of ending the search. _isect_ is
+    // only meaningful if _boundaries->complete_ comes back true.
+    bool IntersectBoundaries(const common::math::Rayf &r, interaction::SurfaceInteraction *isect,
+        interaction::MediumBoundaries *boundaries) const;
+
     virtual const light::AreaLight *GetAreaLight() const = 0;
 
     virtual const material::Material *GetMaterial() const = 0;
@@ -0,0 +1,127 @@
+#include "TransformedPrimitive.h"
+#include "../../common/math/Bounds3.h"
+#include "../../common/math/Ray.h"
+#include "../interaction/SurfaceInteraction.h"
+
+
+namespace core
+{
+namespace primitive
+{
+
+
+// Normals map through the transpose of the inverse matrix; _inverse_ holds
+// that matrix by columns, so its columns are the rows needed here
+static common::math::Vec3f ApplyNormal(const common::math::AffineColumns<Float> &inverse,
+    const common::math::Vec3f &n)
+{
+    return common::math::Vec3f(inverse.col[0][0] * n.x + inverse.col[0][1] * n.y + inverse.col[0][2] * n.z
+        , inverse.col[1][0] * n.x + inverse.col[1][1] * n.y + inverse.col[1][2] * n.z
+        , inverse.col[2][0] * n.x + inverse.col[2][1] * n.y + inverse.col[2][2] * n.z);
+}
+
+// Maps the hit found in the primitive's space to world space: the rounding
+// error of the transform is added to the error the point already carries
+static void ToWorld(const common::math::AffineColumns<Float> &toWorld,
+    const common::math::AffineColumns<Float> &toPrimitive, interaction::SurfaceInteraction *isect)
+{
+    const common::math::Vec3f &e = isect->p_error;
+    Float scale = FLOAT_1 + common::math::Gamma(3);
+    isect->p_error = toWorld.PointError(isect->p) + scale * common::math::Vec3f(
+        std::abs(toWorld.col[0][0]) * e.x + std::abs(toWorld.col[1][0]) * e.y + std::abs(toWorld.col[2][0]) * e.z
+        , std::abs(toWorld.col[0][1]) * e.x + std::abs(toWorld.col[1][1]) * e.y + std::abs(toWorld.col[2][1]) * e.z
+        , std::abs(toWorld.col[0][2]) * e.x + std::abs(toWorld.col[1][2]) * e.y + std::abs(toWorld.col[2][2]) * e.z);
+    isect->p = toWorld.ApplyPoint(isect->p);
+    isect->n = Normalize(ApplyNormal(toPrimitive, isect->n));
+    isect->wo = Normalize(toWorld.ApplyVector(isect->wo));
+
+    isect->dp_du = toWorld.ApplyVector(isect->dp_du);
+    isect->dp_dv = toWorld.ApplyVector(isect->dp_dv);
+    isect->dn_du = ApplyNormal(toPrimitive, isect->dn_du);
+    isect->dn_dv = ApplyNormal(toPrimitive, isect->dn_dv);
+
+    isect->shading.n = Faceforward(Normalize(ApplyNormal(toPrimitive, isect->shading.n)), isect->n);
+    isect->shading.dp_du = toWorld.ApplyVector(isect->shading.dp_du);
+    isect->shading.dp_dv = toWorld.ApplyVector(isect->shading.dp_dv);
+    isect->shading.dn_du = ApplyNormal(toPrimitive, isect->shading.dn_du);
+    isect->shading.dn_dv = ApplyNormal(toPrimitive, isect->shading.dn_dv);
+}
+
+
+TransformedPrimitive::TransformedPrimitive(const std::shared_ptr<Primitive> &primitive,
+    const common::math::AnimatedTransformf &primitiveToWorld)
+    : primitive(primitive),
+    primitiveToWorld(primitiveToWorld)
+{}
+
+common::math::Bounds3f TransformedPrimitive::WorldBound() const
+{
+    return primitiveToWorld.MotionBounds(primitive->WorldBound());
+}
+
+common::math::Bounds3f TransformedPrimitive::MotionBound(Float time0, Float time1) const
+{
+    return primitiveToWorld.MotionBounds(primitive->WorldBound(), time0, time1);
+}
+
+bool TransformedPrimitive::Intersect(const common::math::Rayf &r,
+    interaction::SurfaceInteraction *isect) const
+{
+    // Compute the transform at the ray's time, and its inverse along with it
+    common::math::Transformf interpolated;
+    primitiveToWorld.Interpolate(r.time, &interpolated);
+    common::math::AffineColumns<Float> toWorld = common::math::AffineColumns<Float>::FromMat4(interpolated.mat4);
+    common::math::AffineColumns<Float> toPrimitive =
+        common::math::AffineColumns<Float>::FromMat4(interpolated.inv_mat4);
+
+    // Directions are not renormalized, so _t_ means the same in both spaces
+    common::math::Rayf ray = common::math::AnimatedTransformf::Apply(toPrimitive, r);
+    if (!primitive->Intersect(ray, isect))
+    {
+        return false;
+    }
+    r.t_max = ray.t_max;
+    ToWorld(toWorld, toPrimitive, isect);
+    return true;
+}
+
+bool TransformedPrimitive::IntersectP(const common::math::Rayf &r) const
+{
+    common::math::Transformf interpolated;
+    primitiveToWorld.Interpolate(r.time, &interpolated);
+    return primitive->IntersectP(common::math::AnimatedTransformf::Apply(
+        common::math::AffineColumns<Float>::FromMat4(interpolated.inv_mat4), r));
+}
+
+const light::AreaLight *TransformedPrimitive::GetAreaLight() const
+{
+    /* TODO
+    LOG(FATAL) <<
+        "TransformedPrimitive::GetAreaLight() shouldn't be called";
+    */
+    return nullptr;
+}
+
+const material::Material *TransformedPrimitive::GetMaterial() const
+{
+    /* TODO
+    LOG(FATAL) <<
+        "TransformedPrimitive::GetMaterial() shouldn't be called";
+    */
+    return nullptr;
+}
+
+void TransformedPrimitive::ComputeScatteringFunctions(interaction::SurfaceInteraction *isect,
+    common::tool::MemoryArena &arena,
+    material::TransportMode mode,
+    bool allowMultipleLobes) const
+{
+    /* TODO
+    LOG(FATAL) <<
+        "TransformedPrimitive::ComputeScatteringFunctions() shouldn't be called";
+    */
+}
+
+
+}
+}
\ No newline at end of file
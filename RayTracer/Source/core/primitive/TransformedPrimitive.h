@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Primitive.h"
+#include "../../common/math/AnimatedTransform.h"
+
+namespace core
+{
+namespace primitive
+{
+
+
+// Places _primitive_ in the scene through a transform that may change
+// while the shutter is open: instancing, and the only way geometry moves.
+// Rays are mapped into the primitive's space at their own time and the hit
+// is mapped back.
+class TransformedPrimitive : public Primitive
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    TransformedPrimitive(const std::shared_ptr<Primitive> &primitive,
+        const common::math::AnimatedTransformf &primitiveToWorld);
+
+
+    virtual common::math::Bounds3f WorldBound() const;
+
+    // Bounds over the part of the motion between the two times only, so a
+    // motion BVH can fit its per-node boxes to them
+    virtual common::math::Bounds3f MotionBound(Float time0, Float time1) const;
+
+    virtual bool Intersect(const common::math::Rayf &r, interaction::SurfaceInteraction *isect) const;
+
+    virtual bool IntersectP(const common::math::Rayf &r) const;
+
+    // The hit's primitive is the transformed one, so these are never the
+    // ones called
+    const light::AreaLight *GetAreaLight() const;
+
+    const material::Material *GetMaterial() const;
+
+    void ComputeScatteringFunctions(interaction::SurfaceInteraction *isect,
+        common::tool::MemoryArena &arena, material::TransportMode mode,
+        bool allowMultipleLobes) const;
+
+private:
+
+    std::shared_ptr<Primitive> primitive;
+
+    const common::math::AnimatedTransformf primitiveToWorld;
+};
+
+}
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "GlobalSampler.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -8,7 +9,7 @@ namespace sampler
 
 void GlobalSampler::StartPixel(const common::math::Vec2i &p)
 {
-    //ProfilePhase _(Prof::StartPixel);
+    common::tool::ProfilePhase _(common::tool::Prof::StartPixel);
     Sampler::StartPixel(p);
     dimension = 0;
     intervalSampleIndex = GetIndexForSample(0);
@@ -58,7 +59,7 @@ bool GlobalSampler::SetSampleNumber(int64_t sampleNum)
 
 Float GlobalSampler::Get1D()
 {
-    //ProfilePhase _(Prof::GetSample);
+    common::tool::ProfilePhase _(common::tool::Prof::GetSample);
     if (dimension >= arrayStartDim && dimension < arrayEndDim)
     {
         dimension = arrayEndDim;
@@ -69,7 +70,7 @@ Float GlobalSampler::Get1D()
 
 common::math::Vec2f GlobalSampler::Get2D()
 {
-    //ProfilePhase _(Prof::GetSample);
+    common::tool::ProfilePhase _(common::tool::Prof::GetSample);
     if (dimension + 1 >= arrayStartDim && dimension < arrayEndDim)
     {
         dimension = arrayEndDim;
@@ -1,4 +1,5 @@
 #include "PixelSampler.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -30,7 +31,7 @@ bool PixelSampler::SetSampleNumber(int64_t sampleNum)
 
 Float PixelSampler::Get1D()
 {
-    //ProfilePhase _(Prof::GetSample);
+    common::tool::ProfilePhase _(common::tool::Prof::GetSample);
     CHECK_LT(current_pixel_sample_index, samples_per_pixel);
     if (current1DDimension < samples1D.size())
     {
@@ -44,7 +45,7 @@ Float PixelSampler::Get1D()
 
 common::math::Vec2f PixelSampler::Get2D()
 {
-    //ProfilePhase _(Prof::GetSample);
+    common::tool::ProfilePhase _(common::tool::Prof::GetSample);
     CHECK_LT(current1DDimension, samples_per_pixel);
     if (current2DDimension < samples2D.size())
     {
@@ -1,5 +1,6 @@
 #include "StratifiedSampler.h"
 #include "Sampling.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -8,7 +9,7 @@ namespace sampler
 
 void StratifiedSampler::StartPixel(const common::math::Vec2i &p)
 {
-    //ProfilePhase _(Prof::StartPixel);
+    common::tool::ProfilePhase _(common::tool::Prof::StartPixel);
     // Generate single stratified samples for the pixel
     for (size_t i = 0; i < samples1D.size(); ++i)
     {
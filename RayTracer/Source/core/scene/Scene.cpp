@@ -2,9 +2,11 @@
 #include "../../common/math/Ray.h"
 #include "../../common/math/Vec3.h"
 #include "../interaction/SurfaceInteraction.h"
+#include "../interaction/MediumBoundaries.h"
 #include "../color/Spectrum.h"
 #include "../primitive/Primitive.h"
 #include "../light/Light.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -12,6 +14,10 @@ namespace scene
 {
 
 
+STAT_COUNTER("Intersections/Regular ray intersection tests", nIntersectionTests);
+STAT_COUNTER("Intersections/Shadow ray intersection tests", nShadowTests);
+
+
 Scene::Scene(std::shared_ptr<core::primitive::Primitive> aggregate,
     const std::vector<std::shared_ptr<core::light::Light>> &lights)
     : lights(lights), aggregate(aggregate)
@@ -30,41 +36,53 @@ Scene::Scene(std::shared_ptr<core::primitive::Primitive> aggregate,
 
 bool Scene::Intersect(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect) const
 {
-    //++nIntersectionTests;
+    ++nIntersectionTests;
     CHECK_NE(ray.dir, common::math::Vec3f(FLOAT_0, FLOAT_0, FLOAT_0));
     return aggregate->Intersect(ray, isect);
 }
 
 bool Scene::IntersectP(const common::math::Rayf &ray) const
 {
-    //++nShadowTests;
+    ++nShadowTests;
     CHECK_NE(ray.dir, common::math::Vec3f(FLOAT_0, FLOAT_0, FLOAT_0));
     return aggregate->IntersectP(ray);
 }
 
+bool Scene::IntersectAll(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+    const core::primitive::HitFilter &filter) const
+{
+    ++nIntersectionTests;
+    CHECK_NE(ray.dir, common::math::Vec3f(FLOAT_0, FLOAT_0, FLOAT_0));
+    return aggregate->IntersectAll(ray, isect, filter);
+}
+
+bool Scene::IntersectBoundaries(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+    core::interaction::MediumBoundaries *boundaries) const
+{
+    ++nIntersectionTests;
+    CHECK_NE(ray.dir, common::math::Vec3f(FLOAT_0, FLOAT_0, FLOAT_0));
+    return aggregate->IntersectBoundaries(ray, isect, boundaries);
+}
+
 bool Scene::IntersectTr(common::math::Rayf ray, core::sampler::Sampler &sampler, core::interaction::SurfaceInteraction *isect,
     core::color::Spectrum *Tr) const
 {
     *Tr = core::color::Spectrum(FLOAT_1);
+    core::interaction::MediumBoundaries boundaries;
     while (true)
     {
-        bool hitSurface = Intersect(ray, isect);
-        // Accumulate beam transmittance for ray segment
-        if (ray.medium)
-        {
-            *Tr *= ray.medium->Tr(ray, sampler);
-        }
+        bool hitSurface = IntersectBoundaries(ray, isect, &boundaries);
+
+        // Accumulate beam transmittance for the medium segments up to the
+        // hit, or up to the last boundary if not all of them were found
+        *Tr *= boundaries.Tr(ray, sampler);
 
         // Initialize next ray segment or terminate transmittance computation
-        if (!hitSurface)
-        {
-            return false;
-        }
-        if (isect->primitive->GetMaterial() != nullptr)
+        if (boundaries.complete)
         {
-            return true;
+            return hitSurface;
         }
-        ray = isect->SpawnRay(ray.dir);
+        ray = boundaries.it[boundaries.count - 1].SpawnRay(ray.dir);
     }
 }
 
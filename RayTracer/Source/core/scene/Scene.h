@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../ForwardDeclaration.h"
+#include "../primitive/Primitive.h"
 #include "../../common/math/Bounds3.h"
 
 namespace core
@@ -36,6 +37,12 @@ public:
 
     bool IntersectP(const common::math::Rayf &ray) const;
 
+    bool IntersectAll(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+        const core::primitive::HitFilter &filter) const;
+
+    bool IntersectBoundaries(const common::math::Rayf &ray, core::interaction::SurfaceInteraction *isect,
+        core::interaction::MediumBoundaries *boundaries) const;
+
     bool IntersectTr(common::math::Rayf ray, core::sampler::Sampler &sampler, core::interaction::SurfaceInteraction *isect,
         core::color::Spectrum *transmittance) const;
 
@@ -7,6 +7,7 @@
 #include "../../common/math/Vec3.h"
 #include "../../core/interaction/MediumInteraction.h"
 #include "../../core/interaction/SurfaceInteraction.h"
+#include "../../common/tool/Stats.h"
 
 
 namespace core
@@ -15,12 +16,15 @@ namespace shape
 {
 
 
+STAT_COUNTER("Scene/Shapes created", nShapesCreated);
+
+
 Shape::Shape(const common::math::Transformf *object_to_world, const common::math::Transformf *world_to_object
     , bool reverse_orientation)
     : object_to_world(object_to_world), world_to_object(world_to_object)
     , reverse_orientation(reverse_orientation), transform_swaps_handedness(object_to_world->SwapsHandedness())
 {
-    //++nShapesCreated;
+    ++nShapesCreated;
 }
 
 common::math::Bounds3f Shape::WorldBound() const
@@ -8,6 +8,7 @@
 #include "../interaction/MediumInteraction.h"
 #include "../interaction/SurfaceInteraction.h"
 #include "../sampler/Sampling.h"
+#include "../../common/tool/Stats.h"
 #include <array>
 
 namespace core
@@ -16,6 +17,14 @@ namespace shape
 {
 
 
+STAT_COUNTER("Intersections/Ray-triangle intersection tests", nTests);
+STAT_COUNTER("Intersections/Ray-triangle intersections", nHits);
+
+common::tool::StatCounter nMeshes("Scene/Triangle meshes");
+common::tool::StatCounter nTris("Scene/Triangles");
+common::tool::StatCounter triMeshBytes("Memory/Triangle meshes (bytes)");
+
+
 Float Triangle::Area() const
 {
     // Get triangle vertices in _p0_, _p1_, and _p2_
@@ -51,10 +60,8 @@ common::math::Bounds3f Triangle::WorldBound() const
 bool Triangle::Intersect(const common::math::Rayf &ray, Float *t_hit, interaction::SurfaceInteraction *isect
     , bool test_alpha_texture) const
 {
-    /*
-    ProfilePhase p(Prof::TriIntersect);
+    common::tool::ProfilePhase p(common::tool::Prof::TriIntersect);
     ++nTests;
-    */
     // Get triangle vertices in _p0_, _p1_, and _p2_
     const common::math::Vec3f &p0 = mesh->p[v[0]];
     const common::math::Vec3f &p1 = mesh->p[v[1]];
@@ -342,16 +349,14 @@ bool Triangle::Intersect(const common::math::Rayf &ray, Float *t_hit, interactio
         isect->n = isect->shading.n = -isect->n;
     }
     *t_hit = t;
-    //++nHits;
+    ++nHits;
     return true;
 }
 
 bool Triangle::IntersectP(const common::math::Rayf &ray, bool test_alpha_texture) const
 {
-    /*
-    ProfilePhase p(Prof::TriIntersectP);
+    common::tool::ProfilePhase p(common::tool::Prof::TriIntersectP);
     ++nTests;
-    */
     // Get triangle vertices in _p0_, _p1_, and _p2_
     const common::math::Vec3f &p0 = mesh->p[v[0]];
     const common::math::Vec3f &p1 = mesh->p[v[1]];
@@ -508,7 +513,7 @@ bool Triangle::IntersectP(const common::math::Rayf &ray, bool test_alpha_texture
             return false;
         }
     }
-    //++nHits;
+    ++nHits;
     return true;
 }
 
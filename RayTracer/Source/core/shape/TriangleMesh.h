@@ -5,6 +5,7 @@
 #include "../../common/math/Vec3.h"
 #include "../../common/math/Transform.h"
 #include "../texture/Texture.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -12,6 +13,12 @@ namespace shape
 {
 
 
+// Defined in Triangle.cpp
+extern common::tool::StatCounter nMeshes;
+extern common::tool::StatCounter nTris;
+extern common::tool::StatCounter triMeshBytes;
+
+
 struct TriangleMesh
 {
 
@@ -43,14 +50,12 @@ struct TriangleMesh
         , vertice_indices(vertice_indices, vertice_indices + 3 * triangles_number)
         , alpha_mask(alpha_mask), shadow_alpha_mask(shadow_alpha_mask)
     {
-        /*
         ++nMeshes;
         nTris += triangles_number;
         triMeshBytes += sizeof(*this) + this->vertice_indices.size() * sizeof(int) +
             vertices_number * (sizeof(*P) + (N ? sizeof(*N) : 0) +
             (S ? sizeof(*S) : 0) + (UV ? sizeof(*UV) : 0) +
                 (f_indices ? sizeof(*f_indices) : 0));
-        */
 
         // common::math::Transformf mesh vertices to world space
         p.reset(new common::math::Vec3f[vertices_number]);
@@ -36,6 +36,11 @@ public:
             + (st[0]) * (st[1]) * v11;
     }
 
+    int Compile(TextureCompiler &compiler) const
+    {
+        return compiler.Bilerp(mapping.get(), v00, v01, v10, v11);
+    }
+
 private:
 
     std::unique_ptr<TextureMapping2D> mapping;
@@ -27,6 +27,11 @@ public:
         return value;
     }
 
+    int Compile(TextureCompiler &compiler) const
+    {
+        return compiler.Constant(value);
+    }
+
 private:
 
     T value;
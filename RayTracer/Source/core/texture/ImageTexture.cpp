@@ -1,4 +1,5 @@
 #include "ImageTexture.h"
+#include "../../common/tool/Stats.h"
 
 namespace core
 {
@@ -10,26 +11,94 @@ template <typename Tmemory, typename Treturn>
 ImageTexture<Tmemory, Treturn>::ImageTexture(
     std::unique_ptr<TextureMapping2D> mapping, const std::string &filename,
     bool doTrilinear, Float maxAniso, common::tool::ImageWrap wrapMode, Float scale,
-    bool gamma)
+    bool gamma, common::tool::TexelFormat format)
     : mapping(std::move(mapping))
 {
-    mipmap = GetTexture(filename, doTrilinear, maxAniso, wrapMode, scale, gamma);
+    texture = GetTexture(filename, doTrilinear, maxAniso, wrapMode, scale, gamma, format);
 }
 
 template <typename Tmemory, typename Treturn>
-common::tool::MIPMap<Tmemory> *ImageTexture<Tmemory, Treturn>::GetTexture(
+void ImageTexture<Tmemory, Treturn>::WaitForTextures()
+{
+    std::lock_guard<std::mutex> lock(texturesMutex);
+    for (const auto &entry : textures)
+    {
+        if (entry.second->job)
+        {
+            entry.second->job->Wait();
+        }
+    }
+}
+
+template <typename Tmemory, typename Treturn>
+const typename ImageTexture<Tmemory, Treturn>::SharedMIPMap *ImageTexture<Tmemory, Treturn>::GetTexture(
     const std::string &filename, bool doTrilinear, Float maxAniso,
-    common::tool::ImageWrap wrap, Float scale, bool gamma)
+    common::tool::ImageWrap wrap, Float scale, bool gamma, common::tool::TexelFormat format)
 {
     // Return _MIPMap_ from texture cache if present
-    TexInfo texInfo(filename, doTrilinear, maxAniso, wrap, scale, gamma);
+    TexInfo texInfo(filename, doTrilinear, maxAniso, wrap, scale, gamma, format);
+    std::lock_guard<std::mutex> lock(texturesMutex);
     if (textures.find(texInfo) != textures.end())
     {
         return textures[texInfo].get();
     }
+    SharedMIPMap *texture = new SharedMIPMap;
+    textures[texInfo].reset(texture);
 
+    // Pre-tiled textures are used as they are: paged in on demand when the
+    // tile cache is enabled, mapped in place otherwise. Their texels are
+    // stored already converted to _Tmemory_, so _scale_ and _gamma_ were
+    // applied when the file was baked and _format_ is the one it was baked
+    // with.
+    if (common::tool::HasExtension(filename, ".tiled"))
+    {
+        common::tool::MIPMap<Tmemory> *mipmap = nullptr;
+        common::tool::TextureCache *cache = common::tool::GetTextureCache();
+        if (cache)
+        {
+            int textureId = cache->AddTexture(filename);
+            if (textureId >= 0 && common::tool::MIPMap<Tmemory>::IsCompatible(cache->Texture(textureId).header))
+            {
+                mipmap = new common::tool::MIPMap<Tmemory>(cache, textureId, doTrilinear, maxAniso, wrap);
+            }
+        }
+        else
+        {
+            std::shared_ptr<const common::tool::MappedFile> mapping = common::tool::MappedFile::Open(filename);
+            common::tool::TiledTextureHeader header;
+            std::vector<common::tool::TiledTextureLevel> levels;
+            if (mapping && common::tool::ReadTiledTextureHeader(mapping->Data(), mapping->Size(), &header, &levels)
+                && common::tool::MIPMap<Tmemory>::IsCompatible(header))
+            {
+                mipmap = new common::tool::MIPMap<Tmemory>(mapping, doTrilinear, maxAniso, wrap);
+            }
+        }
+        if (mipmap)
+        {
+            texture->mipmap.reset(mipmap);
+            return texture;
+        }
+        /* TODO
+        Warning("%s: not a tiled texture of the expected texel type", filename.c_str());
+        */
+    }
+
+    // Decode and build the pyramid on a worker thread; the MIPMap
+    // constructor spreads its own work over the other threads as well
+    texture->job = common::tool::RunAsync([=]()
+    {
+        texture->mipmap.reset(LoadTexture(filename, doTrilinear, maxAniso, wrap, scale, gamma, format));
+    });
+    return texture;
+}
+
+template <typename Tmemory, typename Treturn>
+common::tool::MIPMap<Tmemory> *ImageTexture<Tmemory, Treturn>::LoadTexture(
+    const std::string &filename, bool doTrilinear, Float maxAniso,
+    common::tool::ImageWrap wrap, Float scale, bool gamma, common::tool::TexelFormat format)
+{
     // Create _MIPMap_ for _filename_
-    //ProfilePhase _(Prof::TextureLoading);
+    common::tool::ProfilePhase _(common::tool::Prof::TextureLoading);
     common::math::Vec2f resolution;
     std::unique_ptr<core::color::RGBSpectrum[]> texels;
     /* TODO
@@ -68,7 +137,7 @@ common::tool::MIPMap<Tmemory> *ImageTexture<Tmemory, Treturn>::GetTexture(
             convertIn(texels[i], &convertedTexels[i], scale, gamma);
         }
         mipmap = new common::tool::MIPMap<Tmemory>(resolution, convertedTexels.get(),
-            doTrilinear, maxAniso, wrap);
+            doTrilinear, maxAniso, wrap, format);
     }
     else
     {
@@ -76,7 +145,6 @@ common::tool::MIPMap<Tmemory> *ImageTexture<Tmemory, Treturn>::GetTexture(
         Tmemory oneVal = scale;
         mipmap = new common::tool::MIPMap<Tmemory>(common::math::Vec2f(FLOAT_1, FLOAT_1), &oneVal);
     }
-    textures[texInfo].reset(mipmap);
     return mipmap;
 }
 
@@ -123,8 +191,15 @@ ImageTexture<Float, Float> *CreateImageFloatTexture(const Transform &tex2world,
     std::string filename = tp.FindFilename("filename");
     bool gamma = tp.FindBool("gamma", HasExtension(filename, ".tga") ||
         HasExtension(filename, ".png"));
+    // 8-bit sRGB sources lose nothing when stored as 8-bit sRGB
+    std::string texelFormat = tp.FindString("texelformat", gamma && 1.f == scale ? "srgb8" : "float");
+    TexelFormat format = TexelFormat::Float;
+    if ("half" == texelFormat)
+        format = TexelFormat::Half;
+    else if ("srgb8" == texelFormat)
+        format = TexelFormat::SRGB8;
     return new ImageTexture<Float, Float>(std::move(map), filename, trilerp,
-        maxAniso, wrapMode, scale, gamma);
+        maxAniso, wrapMode, scale, gamma, format);
 }
 
 ImageTexture<RGBSpectrum, Spectrum> *CreateImageSpectrumTexture(
@@ -169,8 +244,15 @@ ImageTexture<RGBSpectrum, Spectrum> *CreateImageSpectrumTexture(
     std::string filename = tp.FindFilename("filename");
     bool gamma = tp.FindBool("gamma", HasExtension(filename, ".tga") ||
         HasExtension(filename, ".png"));
+    // 8-bit sRGB sources lose nothing when stored as 8-bit sRGB
+    std::string texelFormat = tp.FindString("texelformat", gamma && 1.f == scale ? "srgb8" : "float");
+    TexelFormat format = TexelFormat::Float;
+    if ("half" == texelFormat)
+        format = TexelFormat::Half;
+    else if ("srgb8" == texelFormat)
+        format = TexelFormat::SRGB8;
     return new ImageTexture<RGBSpectrum, Spectrum>(
-        std::move(map), filename, trilerp, maxAniso, wrapMode, scale, gamma);
+        std::move(map), filename, trilerp, maxAniso, wrapMode, scale, gamma, format);
 }
 */
 
@@ -178,5 +260,12 @@ template class ImageTexture<Float, Float>;
 template class ImageTexture<core::color::RGBSpectrum, core::color::Spectrum>;
 
 
+void WaitForImageTextures()
+{
+    ImageTexture<Float, Float>::WaitForTextures();
+    ImageTexture<core::color::RGBSpectrum, core::color::Spectrum>::WaitForTextures();
+}
+
+
 }
 }
\ No newline at end of file
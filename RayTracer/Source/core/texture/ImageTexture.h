@@ -2,11 +2,15 @@
 
 #include "Texture.h"
 #include "TextureMapping2D.h"
+#include "TextureProgram.h"
+#include "../../common/tool/LookupCache.h"
 #include "../../common/tool/MIPMap.h"
+#include "../../common/tool/MultiThread.h"
 #include "../color/Spectrum.h"
 #include "../color/RGBSpectrum.h"
 #include "../interaction/SurfaceInteraction.h"
 #include <map>
+#include <mutex>
 
 namespace core
 {
@@ -21,13 +25,14 @@ struct TexInfo
     ////////////////////////////////////////////////////////////////////////////////
 
     TexInfo(const std::string &filename, bool dt, Float ma, common::tool::ImageWrap wm, Float sc,
-        bool gamma)
+        bool gamma, common::tool::TexelFormat format = common::tool::TexelFormat::Float)
         : filename(filename),
         doTrilinear(dt),
         maxAniso(ma),
         wrapMode(wm),
         scale(sc),
-        gamma(gamma)
+        gamma(gamma),
+        format(format)
     {}
 
 
@@ -37,6 +42,7 @@ struct TexInfo
     common::tool::ImageWrap wrapMode;
     Float scale;
     bool gamma;
+    common::tool::TexelFormat format;
 
     bool operator<(const TexInfo &t2) const
     {
@@ -60,13 +66,17 @@ struct TexInfo
         {
             return !gamma;
         }
+        if (format != t2.format)
+        {
+            return format < t2.format;
+        }
 
         return wrapMode < t2.wrapMode;
     }
 };
 
 template <typename Tmemory, typename Treturn>
-class ImageTexture : public Texture<Treturn>
+class ImageTexture : public Texture<Treturn>, public FilteredTexture<Treturn>
 {
 public:
 
@@ -76,29 +86,61 @@ public:
 
     ImageTexture(std::unique_ptr<TextureMapping2D> m,
         const std::string &filename, bool doTri, Float maxAniso,
-        common::tool::ImageWrap wm, Float scale, bool gamma);
+        common::tool::ImageWrap wm, Float scale, bool gamma,
+        common::tool::TexelFormat format = common::tool::TexelFormat::Float);
 
 
     static void ClearCache()
     {
+        WaitForTextures();
+        std::lock_guard<std::mutex> lock(texturesMutex);
         textures.erase(textures.begin(), textures.end());
     }
 
+    // Returns once every MIPMap queued by the constructors has been built
+    static void WaitForTextures();
+
     Treturn Evaluate(const interaction::SurfaceInteraction &si) const
     {
         common::math::Vec2f dstdx, dstdy;
         common::math::Vec2f st = mapping->Map(si, &dstdx, &dstdy);
-        Tmemory mem = mipmap->Lookup(st, dstdx, dstdy);
+        return Filter(st, dstdx, dstdy);
+    }
+
+    Treturn Filter(const common::math::Vec2f &st, const common::math::Vec2f &dstdx,
+        const common::math::Vec2f &dstdy) const
+    {
+        CHECK(nullptr != texture->mipmap);
+        Tmemory mem = common::tool::FilteredLookupCache<Tmemory>::Lookup(*texture->mipmap, st, dstdx, dstdy);
         Treturn ret;
         convertOut(mem, &ret);
         return ret;
     }
 
+    int Compile(TextureCompiler &compiler) const
+    {
+        return compiler.Image<Treturn>(mapping.get(), this);
+    }
+
 private:
 
-    static common::tool::MIPMap<Tmemory> *GetTexture(const std::string &filename,
+    // A MIPMap shared by every ImageTexture with the same parameters. One
+    // built from an image is built by _job_ on a worker thread, so that
+    // decoding and resampling overlap with the rest of scene setup;
+    // _mipmap_ is only set once the job has run.
+    struct SharedMIPMap
+    {
+        std::unique_ptr<common::tool::MIPMap<Tmemory>> mipmap;
+        std::shared_ptr<common::tool::AsyncJob> job;
+    };
+
+    static const SharedMIPMap *GetTexture(const std::string &filename,
+        bool doTrilinear, Float maxAniso,
+        common::tool::ImageWrap wm, Float scale, bool gamma, common::tool::TexelFormat format);
+
+    static common::tool::MIPMap<Tmemory> *LoadTexture(const std::string &filename,
         bool doTrilinear, Float maxAniso,
-        common::tool::ImageWrap wm, Float scale, bool gamma);
+        common::tool::ImageWrap wm, Float scale, bool gamma, common::tool::TexelFormat format);
 
     static void convertIn(const core::color::RGBSpectrum &from, core::color::RGBSpectrum *to
         , Float scale, bool gamma)
@@ -128,16 +170,25 @@ private:
     }
 
     std::unique_ptr<TextureMapping2D> mapping;
-    common::tool::MIPMap<Tmemory> *mipmap;
-    static std::map<TexInfo, std::unique_ptr<common::tool::MIPMap<Tmemory>>> textures;
+    const SharedMIPMap *texture;
+    static std::map<TexInfo, std::unique_ptr<SharedMIPMap>> textures;
+    static std::mutex texturesMutex;
 };
 
 template <typename Tmemory, typename Treturn>
-std::map<TexInfo, std::unique_ptr<common::tool::MIPMap<Tmemory>>> ImageTexture<Tmemory, Treturn>::textures;
+std::map<TexInfo, std::unique_ptr<typename ImageTexture<Tmemory, Treturn>::SharedMIPMap>>
+    ImageTexture<Tmemory, Treturn>::textures;
+
+template <typename Tmemory, typename Treturn>
+std::mutex ImageTexture<Tmemory, Treturn>::texturesMutex;
 
 extern template class ImageTexture<Float, Float>;
 extern template class ImageTexture<core::color::RGBSpectrum, core::color::Spectrum>;
 
+// Joins the texture loading started while the scene was created; called
+// before rendering starts
+void WaitForImageTextures();
+
 /* TODO
 ImageTexture<Float, Float> *CreateImageFloatTexture(const Transform &tex2world,
     const TextureParams &tp);
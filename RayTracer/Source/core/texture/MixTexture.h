@@ -32,6 +32,11 @@ public:
         return (static_cast<T>(1) - amt) * t1 + amt * t2;
     }
 
+    int Compile(TextureCompiler &compiler) const
+    {
+        return compiler.Mix(tex1, tex2, amount);
+    }
+
 private:
     std::shared_ptr<Texture<T>> tex1, tex2;
     std::shared_ptr<Texture<Float>> amount;
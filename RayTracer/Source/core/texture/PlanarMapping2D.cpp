@@ -18,6 +18,15 @@ common::math::Vec2f PlanarMapping2D::Map(const interaction::SurfaceInteraction &
     return common::math::Vec2f(ds + Dot(vec, vs), dt + Dot(vec, vt));
 }
 
+bool PlanarMapping2D::SameAs(const TextureMapping2D &mapping) const
+{
+    const PlanarMapping2D *planar = dynamic_cast<const PlanarMapping2D *>(&mapping);
+    return nullptr != planar &&
+        vs.x == planar->vs.x && vs.y == planar->vs.y && vs.z == planar->vs.z &&
+        vt.x == planar->vt.x && vt.y == planar->vt.y && vt.z == planar->vt.z &&
+        ds == planar->ds && dt == planar->dt;
+}
+
 
 }
 }
\ No newline at end of file
@@ -27,6 +27,8 @@ public:
     common::math::Vec2f Map(const interaction::SurfaceInteraction &si, common::math::Vec2f *dstdx,
         common::math::Vec2f *dstdy) const;
 
+    bool SameAs(const TextureMapping2D &mapping) const;
+
 private:
 
     const common::math::Vec3f vs, vt;
@@ -29,6 +29,11 @@ public:
         return tex1->Evaluate(si) * tex2->Evaluate(si);
     }
 
+    int Compile(TextureCompiler &compiler) const
+    {
+        return compiler.Scale<T1, T2>(compiler.Compile(tex1), compiler.Compile(tex2));
+    }
+
 private:
 
     std::shared_ptr<Texture<T1>> tex1;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../ForwardDeclaration.h"
+#include "TextureProgram.h"
 
 namespace core
 {
@@ -16,6 +17,13 @@ public:
     {}
 
     virtual T Evaluate(const interaction::SurfaceInteraction &si) const = 0;
+
+    // Emits the instructions computing this texture and returns the operand
+    // holding its value; by default the program calls Evaluate()
+    virtual int Compile(TextureCompiler &compiler) const
+    {
+        return compiler.Call(this);
+    }
 };
 
 
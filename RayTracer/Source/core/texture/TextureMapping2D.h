@@ -16,6 +16,13 @@ public:
 
     virtual common::math::Vec2f Map(const interaction::SurfaceInteraction &si, common::math::Vec2f *dstdx,
         common::math::Vec2f *dstdy) const = 0;
+
+    // Whether Map() returns the same as _mapping_'s everywhere, so that a
+    // TextureProgram maps once for both
+    virtual bool SameAs(const TextureMapping2D &mapping) const
+    {
+        return this == &mapping;
+    }
 };
 
 
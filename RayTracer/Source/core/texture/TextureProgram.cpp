@@ -0,0 +1,341 @@
+#include "TextureProgram.h"
+#include "Texture.h"
+#include "TextureMapping2D.h"
+#include "../interaction/SurfaceInteraction.h"
+#include "../../common/tool/MemoryArena.h"
+
+namespace core
+{
+namespace texture
+{
+
+
+template <typename T>
+struct TypedOps;
+
+template <>
+struct TypedOps<Float>
+{
+    static constexpr TextureOp CALL = TextureOp::CallFloat;
+    static constexpr TextureOp BILERP = TextureOp::BilerpFloat;
+    static constexpr TextureOp MIX = TextureOp::MixFloat;
+    static constexpr TextureOp IMAGE = TextureOp::ImageFloat;
+};
+
+template <>
+struct TypedOps<color::Spectrum>
+{
+    static constexpr TextureOp CALL = TextureOp::CallSpectrum;
+    static constexpr TextureOp BILERP = TextureOp::BilerpSpectrum;
+    static constexpr TextureOp MIX = TextureOp::MixSpectrum;
+    static constexpr TextureOp IMAGE = TextureOp::ImageSpectrum;
+};
+
+static TextureOp ScaleOp(Float *, Float *)
+{
+    return TextureOp::ScaleFloat;
+}
+
+static TextureOp ScaleOp(Float *, color::Spectrum *)
+{
+    return TextureOp::ScaleFloatSpectrum;
+}
+
+static TextureOp ScaleOp(color::Spectrum *, color::Spectrum *)
+{
+    return TextureOp::ScaleSpectrum;
+}
+
+
+template <typename T>
+static T Bilerp(const common::math::Vec2f &st, const T *v)
+{
+    Float s = st[0], t = st[1];
+    return ((FLOAT_1 - s) * (FLOAT_1 - t)) * v[0] + ((FLOAT_1 - s) * t) * v[1] +
+        (s * (FLOAT_1 - t)) * v[2] + (s * t) * v[3];
+}
+
+template <typename T>
+static T Mix(Float amount, const T &t1, const T &t2)
+{
+    return (FLOAT_1 - amount) * t1 + amount * t2;
+}
+
+
+TextureFrame TextureProgram::Execute(const interaction::SurfaceInteraction &si,
+    common::tool::MemoryArena &arena) const
+{
+    TextureFrame frame;
+    frame.floats = arena.Alloc<Float>(floatRegisterNumber, false);
+    frame.spectra = arena.Alloc<color::Spectrum>(spectrumRegisterNumber, false);
+    frame.st = arena.Alloc<common::math::Vec2f>(stRegisterNumber, false);
+    frame.dstdx = arena.Alloc<common::math::Vec2f>(stRegisterNumber, false);
+    frame.dstdy = arena.Alloc<common::math::Vec2f>(stRegisterNumber, false);
+
+    Run(0, parts.empty() ? InstructionNumber() : parts[0], si, frame);
+    return frame;
+}
+
+void TextureProgram::Execute(int part, const interaction::SurfaceInteraction &si,
+    const TextureFrame &frame) const
+{
+    CHECK(part > 0 && part <= static_cast<int>(parts.size()));
+    Run(parts[part - 1], part < static_cast<int>(parts.size()) ? parts[part] : InstructionNumber(), si, frame);
+}
+
+void TextureProgram::Run(int begin, int end, const interaction::SurfaceInteraction &si,
+    const TextureFrame &frame) const
+{
+    for (int i = begin; i < end; ++i)
+    {
+        const TextureInstruction &in = instructions[i];
+        switch (in.op)
+        {
+        case TextureOp::Map:
+            frame.st[in.dst] = mappings[in.a]->Map(si, &frame.dstdx[in.dst], &frame.dstdy[in.dst]);
+            break;
+        case TextureOp::CallFloat:
+            frame.floats[in.dst] = floatCalls[in.a]->Evaluate(si);
+            break;
+        case TextureOp::CallSpectrum:
+            frame.spectra[in.dst] = spectrumCalls[in.a]->Evaluate(si);
+            break;
+        case TextureOp::BilerpFloat:
+            frame.floats[in.dst] = Bilerp(frame.st[in.a], &floatConstants[~in.b]);
+            break;
+        case TextureOp::BilerpSpectrum:
+            frame.spectra[in.dst] = Bilerp(frame.st[in.a], &spectrumConstants[~in.b]);
+            break;
+        case TextureOp::ScaleFloat:
+            frame.floats[in.dst] = Value<Float>(frame, in.a) * Value<Float>(frame, in.b);
+            break;
+        case TextureOp::ScaleFloatSpectrum:
+            frame.spectra[in.dst] = Value<Float>(frame, in.a) * Value<color::Spectrum>(frame, in.b);
+            break;
+        case TextureOp::ScaleSpectrum:
+            frame.spectra[in.dst] = Value<color::Spectrum>(frame, in.a) * Value<color::Spectrum>(frame, in.b);
+            break;
+        case TextureOp::MixFloat:
+            frame.floats[in.dst] = Mix(Value<Float>(frame, in.c), Value<Float>(frame, in.a),
+                Value<Float>(frame, in.b));
+            break;
+        case TextureOp::MixSpectrum:
+            frame.spectra[in.dst] = Mix(Value<Float>(frame, in.c), Value<color::Spectrum>(frame, in.a),
+                Value<color::Spectrum>(frame, in.b));
+            break;
+        case TextureOp::ImageFloat:
+            frame.floats[in.dst] = floatImages[in.b]->Filter(frame.st[in.a], frame.dstdx[in.a], frame.dstdy[in.a]);
+            break;
+        case TextureOp::ImageSpectrum:
+            frame.spectra[in.dst] = spectrumImages[in.b]->Filter(frame.st[in.a], frame.dstdx[in.a],
+                frame.dstdy[in.a]);
+            break;
+        }
+    }
+}
+
+
+template <>
+int &TextureCompiler::RegisterNumber<Float>()
+{
+    return program->floatRegisterNumber;
+}
+
+template <>
+int &TextureCompiler::RegisterNumber<color::Spectrum>()
+{
+    return program->spectrumRegisterNumber;
+}
+
+template <>
+std::vector<Float> &TextureCompiler::Constants<Float>()
+{
+    return program->floatConstants;
+}
+
+template <>
+std::vector<color::Spectrum> &TextureCompiler::Constants<color::Spectrum>()
+{
+    return program->spectrumConstants;
+}
+
+template <>
+std::vector<const Texture<Float> *> &TextureCompiler::Calls<Float>()
+{
+    return program->floatCalls;
+}
+
+template <>
+std::vector<const Texture<color::Spectrum> *> &TextureCompiler::Calls<color::Spectrum>()
+{
+    return program->spectrumCalls;
+}
+
+template <>
+std::vector<const FilteredTexture<Float> *> &TextureCompiler::Images<Float>()
+{
+    return program->floatImages;
+}
+
+template <>
+std::vector<const FilteredTexture<color::Spectrum> *> &TextureCompiler::Images<color::Spectrum>()
+{
+    return program->spectrumImages;
+}
+
+template <typename T>
+int TextureCompiler::Emit(TextureOp op, int a, int b, int c)
+{
+    int dst = RegisterNumber<T>()++;
+    program->instructions.push_back({ op, dst, a, b, c });
+    return dst;
+}
+
+template <typename T>
+int TextureCompiler::Compile(const std::shared_ptr<Texture<T>> &texture)
+{
+    auto iter = compiled.find(texture.get());
+    if (compiled.end() != iter)
+    {
+        return iter->second;
+    }
+    int operand = texture->Compile(*this);
+    compiled[texture.get()] = operand;
+    return operand;
+}
+
+template <typename T>
+int TextureCompiler::Constant(const T &value)
+{
+    std::vector<T> &constants = Constants<T>();
+    constants.push_back(value);
+    return ~static_cast<int>(constants.size() - 1);
+}
+
+template <typename T>
+int TextureCompiler::Call(const Texture<T> *texture)
+{
+    std::vector<const Texture<T> *> &calls = Calls<T>();
+    calls.push_back(texture);
+    return Emit<T>(TypedOps<T>::CALL, static_cast<int>(calls.size() - 1), 0, 0);
+}
+
+int TextureCompiler::Map(const TextureMapping2D *mapping)
+{
+    for (const auto &m : mapped)
+    {
+        if (m.first->SameAs(*mapping))
+        {
+            return m.second;
+        }
+    }
+    program->mappings.push_back(mapping);
+    int dst = program->stRegisterNumber++;
+    program->instructions.push_back({ TextureOp::Map, dst, static_cast<int>(program->mappings.size() - 1), 0, 0 });
+    mapped.push_back(std::make_pair(mapping, dst));
+    return dst;
+}
+
+template <typename T>
+int TextureCompiler::Image(const TextureMapping2D *mapping, const FilteredTexture<T> *texture)
+{
+    std::vector<const FilteredTexture<T> *> &images = Images<T>();
+    images.push_back(texture);
+    return Emit<T>(TypedOps<T>::IMAGE, Map(mapping), static_cast<int>(images.size() - 1), 0);
+}
+
+template <typename T>
+int TextureCompiler::Bilerp(const TextureMapping2D *mapping, const T &v00, const T &v01,
+    const T &v10, const T &v11)
+{
+    // The weights sum to one wherever _st_ lands
+    if (v00 == v01 && v00 == v10 && v00 == v11)
+    {
+        return Constant(v00);
+    }
+    // Corners are consecutive constants, in the order Bilerp() reads them
+    int corners = Constant(v00);
+    Constant(v01);
+    Constant(v10);
+    Constant(v11);
+    return Emit<T>(TypedOps<T>::BILERP, Map(mapping), corners, 0);
+}
+
+template <typename T1, typename T2>
+int TextureCompiler::Scale(int a, int b)
+{
+    if (a < 0 && b < 0)
+    {
+        return Constant<T2>(Constants<T1>()[~a] * Constants<T2>()[~b]);
+    }
+    return Emit<T2>(ScaleOp(static_cast<T1 *>(nullptr), static_cast<T2 *>(nullptr)), a, b, 0);
+}
+
+template <typename T>
+int TextureCompiler::Mix(const std::shared_ptr<Texture<T>> &tex1, const std::shared_ptr<Texture<T>> &tex2,
+    const std::shared_ptr<Texture<Float>> &amount)
+{
+    int c = Compile(amount);
+    if (c < 0)
+    {
+        Float amt = program->floatConstants[~c];
+        if (FLOAT_0 == amt)
+        {
+            return Compile(tex1);
+        }
+        if (FLOAT_1 == amt)
+        {
+            return Compile(tex2);
+        }
+    }
+    int a = Compile(tex1), b = Compile(tex2);
+    if (a < 0 && b < 0 && c < 0)
+    {
+        std::vector<T> &constants = Constants<T>();
+        return Constant<T>(::core::texture::Mix(program->floatConstants[~c], constants[~a], constants[~b]));
+    }
+    return Emit<T>(TypedOps<T>::MIX, a, b, c);
+}
+
+int TextureCompiler::BeginPart()
+{
+    // A part may run without the parts between it and the first, so it
+    // only reuses registers the first part wrote
+    if (program->parts.empty())
+    {
+        firstCompiled = compiled;
+        firstMapped = mapped;
+    }
+    else
+    {
+        compiled = firstCompiled;
+        mapped = firstMapped;
+    }
+    program->parts.push_back(program->InstructionNumber());
+    return static_cast<int>(program->parts.size());
+}
+
+
+template int TextureCompiler::Compile(const std::shared_ptr<Texture<Float>> &);
+template int TextureCompiler::Compile(const std::shared_ptr<Texture<color::Spectrum>> &);
+template int TextureCompiler::Constant(const Float &);
+template int TextureCompiler::Constant(const color::Spectrum &);
+template int TextureCompiler::Call(const Texture<Float> *);
+template int TextureCompiler::Call(const Texture<color::Spectrum> *);
+template int TextureCompiler::Image(const TextureMapping2D *, const FilteredTexture<Float> *);
+template int TextureCompiler::Image(const TextureMapping2D *, const FilteredTexture<color::Spectrum> *);
+template int TextureCompiler::Bilerp(const TextureMapping2D *, const Float &, const Float &,
+    const Float &, const Float &);
+template int TextureCompiler::Bilerp(const TextureMapping2D *, const color::Spectrum &,
+    const color::Spectrum &, const color::Spectrum &, const color::Spectrum &);
+template int TextureCompiler::Scale<Float, Float>(int, int);
+template int TextureCompiler::Scale<Float, color::Spectrum>(int, int);
+template int TextureCompiler::Scale<color::Spectrum, color::Spectrum>(int, int);
+template int TextureCompiler::Mix(const std::shared_ptr<Texture<Float>> &, const std::shared_ptr<Texture<Float>> &,
+    const std::shared_ptr<Texture<Float>> &);
+template int TextureCompiler::Mix(const std::shared_ptr<Texture<color::Spectrum>> &,
+    const std::shared_ptr<Texture<color::Spectrum>> &, const std::shared_ptr<Texture<Float>> &);
+
+
+}
+}
\ No newline at end of file
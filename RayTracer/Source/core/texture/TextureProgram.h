@@ -0,0 +1,209 @@
+#pragma once
+
+#include "../../ForwardDeclaration.h"
+#include "../../common/math/Vec2.h"
+#include "../color/Spectrum.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace core
+{
+namespace texture
+{
+
+
+enum class TextureOp : uint8_t
+{
+    Map,                // st, dstdx, dstdy[dst] = mappings[a]->Map(si)
+    CallFloat,          // floats[dst] = floatCalls[a]->Evaluate(si)
+    CallSpectrum,       // spectra[dst] = spectrumCalls[a]->Evaluate(si)
+    BilerpFloat,        // floats[dst] = corners ~b .. ~b + 3 interpolated at st[a]
+    BilerpSpectrum,
+    ScaleFloat,         // floats[dst] = float a * float b
+    ScaleFloatSpectrum, // spectra[dst] = float a * spectrum b
+    ScaleSpectrum,      // spectra[dst] = spectrum a * spectrum b
+    MixFloat,           // floats[dst] = (1 - float c) * float a + float c * float b
+    MixSpectrum,
+    ImageFloat,         // floats[dst] = floatImages[b]->Filter() at st, dstdx, dstdy[a]
+    ImageSpectrum
+};
+
+
+// Operands name a register of the op's type when non-negative and the
+// constant ~operand otherwise
+struct TextureInstruction
+{
+    TextureOp op;
+    int dst;
+    int a, b, c;
+};
+
+
+// Registers of one TextureProgram::Execute(), allocated from the arena the
+// material builds its BSDF in
+struct TextureFrame
+{
+    Float *floats;
+    color::Spectrum *spectra;
+    common::math::Vec2f *st;
+    common::math::Vec2f *dstdx, *dstdy;
+};
+
+
+// A texture that is a filtered lookup at the coordinates of its mapping
+// (ImageTexture), so that a TextureProgram can map once for all the
+// lookups that share the mapping
+template <typename T>
+class FilteredTexture
+{
+public:
+
+    virtual ~FilteredTexture() = default;
+
+    virtual T Filter(const common::math::Vec2f &st, const common::math::Vec2f &dstdx,
+        const common::math::Vec2f &dstdy) const = 0;
+};
+
+
+// The textures of a material flattened into one instruction list by
+// TextureCompiler: constant subtrees are folded into constants, textures
+// the DAG reaches twice are evaluated once and each distinct mapping maps
+// once. Textures with no instructions of their own are called through
+// Texture::Evaluate().
+class TextureProgram
+{
+public:
+
+    // Allocates the registers and runs the first part
+    TextureFrame Execute(const interaction::SurfaceInteraction &si, common::tool::MemoryArena &arena) const;
+
+    // Runs part _part_ (see TextureCompiler::BeginPart()) on the registers
+    // of _frame_
+    void Execute(int part, const interaction::SurfaceInteraction &si, const TextureFrame &frame) const;
+
+    template <typename T>
+    const T &Value(const TextureFrame &frame, int operand) const;
+
+    int InstructionNumber() const
+    {
+        return static_cast<int>(instructions.size());
+    }
+
+private:
+
+    friend class TextureCompiler;
+
+    void Run(int begin, int end, const interaction::SurfaceInteraction &si, const TextureFrame &frame) const;
+
+
+    std::vector<TextureInstruction> instructions;
+    // First instruction of parts 1, 2, ...
+    std::vector<int> parts;
+    std::vector<Float> floatConstants;
+    std::vector<color::Spectrum> spectrumConstants;
+    int floatRegisterNumber = 0;
+    int spectrumRegisterNumber = 0;
+    int stRegisterNumber = 0;
+
+    // Owned by the textures, which the material keeps alive
+    std::vector<const TextureMapping2D *> mappings;
+    std::vector<const Texture<Float> *> floatCalls;
+    std::vector<const Texture<color::Spectrum> *> spectrumCalls;
+    std::vector<const FilteredTexture<Float> *> floatImages;
+    std::vector<const FilteredTexture<color::Spectrum> *> spectrumImages;
+};
+
+template <>
+inline const Float &TextureProgram::Value<Float>(const TextureFrame &frame, int operand) const
+{
+    return operand >= 0 ? frame.floats[operand] : floatConstants[~operand];
+}
+
+template <>
+inline const color::Spectrum &TextureProgram::Value<color::Spectrum>(const TextureFrame &frame, int operand) const
+{
+    return operand >= 0 ? frame.spectra[operand] : spectrumConstants[~operand];
+}
+
+
+// Emits instructions into a TextureProgram. Texture::Compile() overrides
+// describe their texture with the calls below; everything is instantiated
+// for Float and Spectrum textures.
+class TextureCompiler
+{
+public:
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Construction
+    ////////////////////////////////////////////////////////////////////////////////
+
+    explicit TextureCompiler(TextureProgram *program)
+        : program(program)
+    {}
+
+
+    // Operand holding the value of _texture_
+    template <typename T>
+    int Compile(const std::shared_ptr<Texture<T>> &texture);
+
+    template <typename T>
+    int Constant(const T &value);
+
+    template <typename T>
+    int Call(const Texture<T> *texture);
+
+    // _texture_ filtered at the coordinates of _mapping_
+    template <typename T>
+    int Image(const TextureMapping2D *mapping, const FilteredTexture<T> *texture);
+
+    template <typename T>
+    int Bilerp(const TextureMapping2D *mapping, const T &v00, const T &v01, const T &v10, const T &v11);
+
+    // _a_ * _b_, with _a_ of type _T1_ and _b_ and the result of type _T2_
+    template <typename T1, typename T2>
+    int Scale(int a, int b);
+
+    // Only the textures a constant _amount_ selects are compiled
+    template <typename T>
+    int Mix(const std::shared_ptr<Texture<T>> &tex1, const std::shared_ptr<Texture<T>> &tex2,
+        const std::shared_ptr<Texture<Float>> &amount);
+
+    // Instructions emitted from here on only run when the material asks
+    // for them with TextureProgram::Execute(part, ...); returns _part_
+    int BeginPart();
+
+private:
+
+    // st register of _mapping_, or of an earlier mapping that maps the same
+    int Map(const TextureMapping2D *mapping);
+
+    template <typename T>
+    int Emit(TextureOp op, int a, int b, int c);
+
+    // Register file size, constant pool and called textures of type _T_
+    template <typename T>
+    int &RegisterNumber();
+
+    template <typename T>
+    std::vector<T> &Constants();
+
+    template <typename T>
+    std::vector<const Texture<T> *> &Calls();
+
+    template <typename T>
+    std::vector<const FilteredTexture<T> *> &Images();
+
+
+    TextureProgram *program;
+    std::map<const void *, int> compiled;
+    std::vector<std::pair<const TextureMapping2D *, int>> mapped;
+    // What the first part computed, which is all later parts can share
+    std::map<const void *, int> firstCompiled;
+    std::vector<std::pair<const TextureMapping2D *, int>> firstMapped;
+};
+
+
+}
+}
\ No newline at end of file
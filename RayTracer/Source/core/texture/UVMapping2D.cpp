@@ -22,6 +22,12 @@ common::math::Vec2f UVMapping2D::Map(const interaction::SurfaceInteraction &si,
     return common::math::Vec2f(su * si.uv[0] + du, sv * si.uv[1] + dv);
 }
 
+bool UVMapping2D::SameAs(const TextureMapping2D &mapping) const
+{
+    const UVMapping2D *uv = dynamic_cast<const UVMapping2D *>(&mapping);
+    return nullptr != uv && su == uv->su && sv == uv->sv && du == uv->du && dv == uv->dv;
+}
+
 
 }
 }
\ No newline at end of file
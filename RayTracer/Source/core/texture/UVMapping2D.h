@@ -19,8 +19,10 @@ public:
     UVMapping2D(Float su = FLOAT_1, Float sv = FLOAT_1, Float du = FLOAT_0, Float dv = FLOAT_0);
 
 
-    virtual common::math::Vec2f Map(const interaction::SurfaceInteraction &si, common::math::Vec2f *dstdx,
-        common::math::Vec2f *dstdy) const = 0;
+    common::math::Vec2f Map(const interaction::SurfaceInteraction &si, common::math::Vec2f *dstdx,
+        common::math::Vec2f *dstdy) const;
+
+    bool SameAs(const TextureMapping2D &mapping) const;
 
 private:
     const Float su, sv, du, dv;
@@ -1,16 +1,78 @@
 #include "ForwardDeclaration.h"
+#include "common/tool/LookupCache.h"
+#include "common/tool/MultiThread.h"
+#include "common/tool/Stats.h"
+#include "common/tool/TextureCache.h"
+#include "core/bxdf/distribution/MicrofacetAlbedo.h"
+#include "core/color/HeroSpectrum.h"
+#include "core/color/RGBToSpectrumTable.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 
-int main()
+//     RayTracer [--texturecache MB] [--spectrumtable file.spec]
+//
+// _--texturecache_ is the memory budget of the tiles paged in from .tiled
+// textures; 0 maps the files whole instead. _--spectrumtable_ loads a table
+// baked by SpectrumTableBaker, which then upsamples RGB reflectances in
+// place of the Smits basis spectra.
+int main(int argc, char *argv[])
 {
 #ifdef DEBUG
     common::DebugTools::PrintDebugLog("hello, ray tracer!\n", false);
 #endif
 
+    long textureCacheMB = 1024;
+    const char *spectrumTable = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--texturecache") && i + 1 < argc)
+        {
+            textureCacheMB = atol(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "--spectrumtable") && i + 1 < argc)
+        {
+            spectrumTable = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: RayTracer [--texturecache MB] [--spectrumtable file.spec]\n");
+            return 1;
+        }
+    }
+    if (textureCacheMB < 0)
+    {
+        fprintf(stderr, "RayTracer: the texture cache budget can't be negative\n");
+        return 1;
+    }
+    if (nullptr != spectrumTable && !core::color::LoadRGBToSpectrumTable(spectrumTable))
+    {
+        fprintf(stderr, "RayTracer: \"%s\" is not a spectrum table\n", spectrumTable);
+        return 1;
+    }
+
+    common::tool::ParallelInit();
+    common::tool::InitProfiler();
+    // Image textures filter every lookup exactly; On reuses lookups within a
+    // pixel and Validate measures the error that reuse would cause
+    common::tool::InitLookupCache(common::tool::LookupCacheMode::Off);
+    if (textureCacheMB > 0)
+    {
+        common::tool::InitTextureCache(static_cast<size_t>(textureCacheMB) << 20);
+    }
+    core::bxdf::distribution::MicrofacetAlbedo::Init();
+    core::color::HeroSpectrum::Init();
+
 
 #ifdef DEBUG
     common::DebugTools::PrintDebugLog("Pass Enter:\n", false);
 #endif
 
+    common::tool::CleanupTextureCache();
+    common::tool::CleanupLookupCache();
+    common::tool::CleanupProfiler();
+    common::tool::ParallelCleanup();
+
     return 0;
 }
\ No newline at end of file
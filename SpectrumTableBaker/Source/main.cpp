@@ -0,0 +1,84 @@
+#include "../../RayTracer/Source/ForwardDeclaration.h"
+#include "../../RayTracer/Source/common/math/Constants.h"
+#include "../../RayTracer/Source/common/tool/MultiThread.h"
+#include "../../RayTracer/Source/core/color/RGBToSpectrumTable.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+
+// Fits the sigmoid polynomial table that SampledSpectrum::FromRGB() and
+// HeroSpectrum::FromRGB() use for reflectances in place of the Smits basis
+// spectra once it is loaded, e.g. by RayTracer --spectrumtable.
+//
+//     SpectrumTableBaker [--res n] <output.spec>
+
+
+static void usage(const char *msg = nullptr)
+{
+    if (msg)
+    {
+        fprintf(stderr, "SpectrumTableBaker: %s\n\n", msg);
+    }
+    fprintf(stderr, "usage: SpectrumTableBaker [--res n] <output.spec>\n\n"
+        "    --res       grid resolution along each axis (default %d)\n",
+        core::color::RGBToSpectrumTable::DEFAULT_RESOLUTION);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    int resolution = core::color::RGBToSpectrumTable::DEFAULT_RESOLUTION;
+    std::string output;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--res"))
+        {
+            if (i + 1 == argc)
+            {
+                usage("missing value after --res");
+            }
+            resolution = atoi(argv[++i]);
+            if (resolution < 2)
+            {
+                usage("resolution must be at least 2");
+            }
+        }
+        else if ('-' == argv[i][0])
+        {
+            usage("unknown option");
+        }
+        else if (output.empty())
+        {
+            output = argv[i];
+        }
+        else
+        {
+            usage();
+        }
+    }
+    if (output.empty())
+    {
+        usage();
+    }
+
+    common::tool::ParallelInit();
+    auto start = std::chrono::steady_clock::now();
+    Float maxError;
+    std::unique_ptr<core::color::RGBToSpectrumTable> table =
+        core::color::RGBToSpectrumTable::Optimize(resolution, &maxError);
+    auto end = std::chrono::steady_clock::now();
+    common::tool::ParallelCleanup();
+
+    if (!table->Write(output))
+    {
+        fprintf(stderr, "SpectrumTableBaker: unable to write \"%s\"\n", output.c_str());
+        return 1;
+    }
+    printf("Wrote \"%s\" (%d^3 x 3) in %.2f s, largest CIELAB error %.3f\n", output.c_str(), resolution,
+        std::chrono::duration<double>(end - start).count(), maxError);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "../../RayTracer/Source/ForwardDeclaration.h"
+#include "../../RayTracer/Source/common/math/Constants.h"
+#include "../../RayTracer/Source/common/math/Vec2.h"
+#include "../../RayTracer/Source/common/tool/MIPMap.h"
+#include "../../RayTracer/Source/common/tool/MultiThread.h"
+#include "../../RayTracer/Source/common/tool/TiledTexture.h"
+#include "../../RayTracer/Source/core/color/RGBSpectrum.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Bakes an image into the tiled MIP pyramid format that ImageTexture maps
+// directly (or pages in through the texture cache), so renders skip the
+// resampling and box filtering done by the MIPMap constructor.
+//
+//     TextureBaker [--float] [--scale s] [--gamma | --linear]
+//         [--wrap repeat|black|clamp] [--format float|half|srgb8] <input.pfm|input.ppm> <output.tiled>
+//
+// The texels are converted the same way ImageTexture converts them, so the
+// options have to match the texture's parameters in the scene.
+// Trilinear versus EWA filtering is not part of the baked file; it is picked
+// at lookup time from the texture's "trilinear" parameter, so there is no
+// option for it here.
+
+
+static void usage(const char *msg = nullptr)
+{
+    if (msg)
+    {
+        fprintf(stderr, "TextureBaker: %s\n\n", msg);
+    }
+    fprintf(stderr, "usage: TextureBaker [--float] [--scale s] [--gamma | --linear]\n"
+        "    [--wrap repeat|black|clamp] [--format float|half|srgb8] <input.pfm|input.ppm> <output.tiled>\n\n"
+        "    --float     store a single channel (luminance) for float textures\n"
+        "    --scale     multiply texel values by s (default 1)\n"
+        "    --gamma     source is sRGB encoded (default for .ppm)\n"
+        "    --linear    source is linear (default for .pfm)\n"
+        "    --wrap      wrap mode used when resampling to a power of two\n"
+        "    --format    texel storage: float (default), half or srgb8\n");
+    exit(1);
+}
+
+static bool readToken(FILE *file, char *token, int size)
+{
+    int c = fgetc(file);
+    // Skip whitespace and comments
+    while (EOF != c && (isspace(c) || '#' == c))
+    {
+        if ('#' == c)
+        {
+            while (EOF != c && '\n' != c)
+            {
+                c = fgetc(file);
+            }
+        }
+        c = fgetc(file);
+    }
+    int n = 0;
+    while (EOF != c && !isspace(c) && n < size - 1)
+    {
+        token[n++] = static_cast<char>(c);
+        c = fgetc(file);
+    }
+    token[n] = '\0';
+    return n > 0;
+}
+
+// Reads a binary PPM (P6) or PFM (PF/Pf) image, top row first
+static std::unique_ptr<core::color::RGBSpectrum[]> readImage(const std::string &filename,
+    common::math::Vec2i *resolution)
+{
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (!file)
+    {
+        return nullptr;
+    }
+    char magic[8], width[32], height[32], max[32];
+    if (!readToken(file, magic, sizeof(magic)) || !readToken(file, width, sizeof(width))
+        || !readToken(file, height, sizeof(height)) || !readToken(file, max, sizeof(max)))
+    {
+        fclose(file);
+        return nullptr;
+    }
+    int nx = atoi(width), ny = atoi(height);
+    bool pfm = 0 == strcmp(magic, "PF") || 0 == strcmp(magic, "Pf");
+    if (nx <= 0 || ny <= 0 || (!pfm && 0 != strcmp(magic, "P6")))
+    {
+        fclose(file);
+        return nullptr;
+    }
+    int nChannels = 0 == strcmp(magic, "Pf") ? 1 : 3;
+    std::unique_ptr<core::color::RGBSpectrum[]> texels(new core::color::RGBSpectrum[nx * ny]);
+
+    if (pfm)
+    {
+        // PFM stores scanlines bottom to top; a negative scale means little
+        // endian data
+        float scale = static_cast<float>(atof(max));
+        std::vector<float> data(static_cast<size_t>(nx) * ny * nChannels);
+        if (data.size() != fread(data.data(), sizeof(float), data.size(), file))
+        {
+            fclose(file);
+            return nullptr;
+        }
+        uint32_t one = 1;
+        bool hostLittleEndian = 1 == *reinterpret_cast<uint8_t *>(&one);
+        if ((scale < 0.0F) != hostLittleEndian)
+        {
+            for (float &f : data)
+            {
+                uint8_t *bytes = reinterpret_cast<uint8_t *>(&f);
+                std::swap(bytes[0], bytes[3]);
+                std::swap(bytes[1], bytes[2]);
+            }
+        }
+        for (int y = 0; y < ny; ++y)
+        {
+            for (int x = 0; x < nx; ++x)
+            {
+                const float *src = &data[(static_cast<size_t>(ny - 1 - y) * nx + x) * nChannels];
+                Float rgb[3] = {src[0], src[nChannels > 1 ? 1 : 0], src[nChannels > 1 ? 2 : 0]};
+                texels[y * nx + x] = core::color::RGBSpectrum::FromRGB(rgb);
+            }
+        }
+    }
+    else
+    {
+        int maxValue = atoi(max);
+        if (maxValue <= 0 || maxValue > 255)
+        {
+            fclose(file);
+            return nullptr;
+        }
+        std::vector<uint8_t> data(static_cast<size_t>(nx) * ny * 3);
+        if (data.size() != fread(data.data(), 1, data.size(), file))
+        {
+            fclose(file);
+            return nullptr;
+        }
+        for (int i = 0; i < nx * ny; ++i)
+        {
+            Float rgb[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                rgb[c] = static_cast<Float>(data[3 * i + c]) / maxValue;
+            }
+            texels[i] = core::color::RGBSpectrum::FromRGB(rgb);
+        }
+    }
+    fclose(file);
+    *resolution = common::math::Vec2i(nx, ny);
+    return texels;
+}
+
+// Same conversions as ImageTexture::convertIn()
+static void convertIn(const core::color::RGBSpectrum &from, core::color::RGBSpectrum *to, Float scale, bool gamma)
+{
+    for (int i = 0; i < core::color::RGBSpectrum::SAMPLE_NUMBER; ++i)
+    {
+        (*to)[i] = scale * (gamma ? common::math::InverseGammaCorrect(from[i]) : from[i]);
+    }
+}
+
+static void convertIn(const core::color::RGBSpectrum &from, Float *to, Float scale, bool gamma)
+{
+    *to = scale * (gamma ? common::math::InverseGammaCorrect(from.y()) : from.y());
+}
+
+template <typename T>
+static bool bake(const core::color::RGBSpectrum *texels, const common::math::Vec2i &resolution, Float scale,
+    bool gamma, common::tool::ImageWrap wrapMode, common::tool::TexelFormat format, const std::string &outFilename)
+{
+    // Flip image in y; texture coordinate space has (0,0) at the lower
+    // left corner.
+    std::unique_ptr<T[]> converted(new T[resolution.x * resolution.y]);
+    for (int y = 0; y < resolution.y; ++y)
+    {
+        for (int x = 0; x < resolution.x; ++x)
+        {
+            convertIn(texels[(resolution.y - 1 - y) * resolution.x + x], &converted[y * resolution.x + x],
+                scale, gamma);
+        }
+    }
+    common::tool::MIPMap<T> mipmap(resolution, converted.get(), false, static_cast<Float>(8.0F), wrapMode, format);
+    printf("%d x %d, %d levels\n", mipmap.Width(), mipmap.Height(), mipmap.Levels());
+    return mipmap.WriteTiled(outFilename);
+}
+
+
+int main(int argc, char *argv[])
+{
+    bool singleChannel = false;
+    Float scale = FLOAT_1;
+    int gamma = -1;
+    common::tool::ImageWrap wrapMode = common::tool::ImageWrap::Repeat;
+    common::tool::TexelFormat format = common::tool::TexelFormat::Float;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--float"))
+        {
+            singleChannel = true;
+        }
+        else if (0 == strcmp(argv[i], "--scale"))
+        {
+            if (i + 1 == argc)
+            {
+                usage("missing value after --scale");
+            }
+            scale = static_cast<Float>(atof(argv[++i]));
+        }
+        else if (0 == strcmp(argv[i], "--gamma"))
+        {
+            gamma = 1;
+        }
+        else if (0 == strcmp(argv[i], "--linear"))
+        {
+            gamma = 0;
+        }
+        else if (0 == strcmp(argv[i], "--wrap"))
+        {
+            if (i + 1 == argc)
+            {
+                usage("missing value after --wrap");
+            }
+            std::string wrap = argv[++i];
+            if ("repeat" == wrap)
+            {
+                wrapMode = common::tool::ImageWrap::Repeat;
+            }
+            else if ("black" == wrap)
+            {
+                wrapMode = common::tool::ImageWrap::Black;
+            }
+            else if ("clamp" == wrap)
+            {
+                wrapMode = common::tool::ImageWrap::Clamp;
+            }
+            else
+            {
+                usage("unknown wrap mode");
+            }
+        }
+        else if (0 == strcmp(argv[i], "--format"))
+        {
+            if (i + 1 == argc)
+            {
+                usage("missing value after --format");
+            }
+            std::string name = argv[++i];
+            if ("float" == name)
+            {
+                format = common::tool::TexelFormat::Float;
+            }
+            else if ("half" == name)
+            {
+                format = common::tool::TexelFormat::Half;
+            }
+            else if ("srgb8" == name)
+            {
+                format = common::tool::TexelFormat::SRGB8;
+            }
+            else
+            {
+                usage("unknown texel format");
+            }
+        }
+        else if ('-' == argv[i][0])
+        {
+            usage("unknown option");
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+    if (2 != files.size())
+    {
+        usage();
+    }
+    if (-1 == gamma)
+    {
+        gamma = common::tool::HasExtension(files[0], ".ppm") ? 1 : 0;
+    }
+
+    common::math::Vec2i resolution;
+    std::unique_ptr<core::color::RGBSpectrum[]> texels = readImage(files[0], &resolution);
+    if (!texels)
+    {
+        fprintf(stderr, "TextureBaker: unable to read \"%s\"\n", files[0].c_str());
+        return 1;
+    }
+
+    common::tool::ParallelInit();
+    auto start = std::chrono::steady_clock::now();
+    bool ok = singleChannel
+        ? bake<Float>(texels.get(), resolution, scale, 1 == gamma, wrapMode, format, files[1])
+        : bake<core::color::RGBSpectrum>(texels.get(), resolution, scale, 1 == gamma, wrapMode, format, files[1]);
+    auto end = std::chrono::steady_clock::now();
+    common::tool::ParallelCleanup();
+
+    if (!ok)
+    {
+        fprintf(stderr, "TextureBaker: unable to write \"%s\"\n", files[1].c_str());
+        return 1;
+    }
+    printf("Wrote \"%s\" in %.2f s\n", files[1].c_str(), std::chrono::duration<double>(end - start).count());
+    return 0;
+}
\ No newline at end of file